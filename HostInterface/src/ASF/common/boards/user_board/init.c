@@ -118,7 +118,8 @@ static void _setup_memory_region( void )
  *	START_Addr:-  0x20440000UL
  *	END_Addr:-    0x2045FFFFUL
  */
-	/* SRAM memory region */
+	/* SRAM memory region, absent when the TCMs take the top of the SRAM */
+#if SRAM_SECOND_END_ADDRESS > SRAM_SECOND_START_ADDRESS
 	dw_region_base_addr = SRAM_SECOND_START_ADDRESS
 		| MPU_REGION_VALID
 		| MPU_DEFAULT_SRAM_REGION_2;
@@ -129,6 +130,7 @@ static void _setup_memory_region( void )
 		| MPU_REGION_ENABLE;
 
 	mpu_set_region(dw_region_base_addr, dw_region_attr);
+#endif
 
 #ifdef MPU_HAS_NOCACHE_REGION
 	dw_region_base_addr = SRAM_NOCACHE_START_ADDRESS
@@ -239,9 +241,45 @@ static void _setup_memory_region( void )
 }
 #endif
 
+/* GPNVM bits 7 and 8 (TCM_CONFIG): 2 gives 64 KB each of ITCM and DTCM,
+ * matching the linker script; 0 gives all of the SRAM to the system */
+#define TCM_GPNVM_MASK    (3UL << 7)
+#define TCM_GPNVM_64K     (2UL << 7)
+
+/**
+ * \brief Run a flash controller command, from RAM as the flash can't be
+ * read until the command completes.
+ * \return the command result register
+ */
+RAMFUNC __no_inline static uint32_t efc_command(uint32_t cmd, uint32_t arg)
+{
+	EFC->EEFC_FCR = EEFC_FCR_FKEY_PASSWD | cmd | EEFC_FCR_FARG(arg);
+	while(!(EFC->EEFC_FSR & EEFC_FSR_FRDY)) {};
+	return EFC->EEFC_FRR;
+}
+
+/**
+ * \brief Set the TCM configuration GPNVM bits. They are only read at reset,
+ * so the part is reset once if they have to change; after that this is
+ * just a read, and the GPNVM isn't written on every start.
+ */
+static void tcm_configure(uint32_t config)
+{
+	uint32_t const current = efc_command(EEFC_FCR_FCMD_GGPB, 0) & TCM_GPNVM_MASK;
+
+	if(current == config)
+	{
+		return;
+	}
+	efc_command((config & (1UL << 8)) ? EEFC_FCR_FCMD_SGPB : EEFC_FCR_FCMD_CGPB, 8);
+	efc_command((config & (1UL << 7)) ? EEFC_FCR_FCMD_SGPB : EEFC_FCR_FCMD_CGPB, 7);
+	NVIC_SystemReset();
+}
+
 #ifdef CONF_BOARD_ENABLE_TCM_AT_INIT
 extern char _code_tcm_lma, _sitcm, _eitcm;
 extern char _data_tcm_lma, _sdtcm, _edtcm;
+extern char _sdtcm_bss, _edtcm_bss;
 extern char _svector, _evector;
 
 /** \brief  TCM memory enable
@@ -315,16 +353,13 @@ void board_init(void)
 
 	/* enable the cache */
 	SCB_EnableICache();
+#ifdef CONF_BOARD_ENABLE_CACHE_AT_INIT
 	SCB_EnableDCache();
+#endif
 
 #ifdef CONF_BOARD_ENABLE_TCM_AT_INIT
 	/* TCM configuration */
-	EFC->EEFC_FCR = EEFC_FCR_FKEY_PASSWD
-		| EEFC_FCR_FCMD_SGPB
-		| EEFC_FCR_FARG(8);
-	EFC->EEFC_FCR = EEFC_FCR_FKEY_PASSWD
-		| EEFC_FCR_FCMD_CGPB
-		| EEFC_FCR_FARG(7);
+	tcm_configure(TCM_GPNVM_64K);
 	tcm_enable();
 
 	{
@@ -345,6 +380,13 @@ void board_init(void)
 			*dst++ = *src++;
 		}
 
+		/* zero bss_tcm */
+		dst = &_sdtcm_bss;
+		while(dst < &_edtcm_bss)
+		{
+			*dst++ = 0;
+		}
+
 		/* copy the interrupt vector table to ITCM */
 		dst = &_sitcm;
 		src = &_svector;
@@ -359,12 +401,7 @@ void board_init(void)
 	SCB->VTOR = ((uint32_t)&_sitcm & SCB_VTOR_TBLOFF_Msk);
 #else
 	/* TCM configuration */
-	EFC->EEFC_FCR = EEFC_FCR_FKEY_PASSWD
-		| EEFC_FCR_FCMD_CGPB
-		| EEFC_FCR_FARG(8);
-	EFC->EEFC_FCR = EEFC_FCR_FKEY_PASSWD
-		| EEFC_FCR_FCMD_CGPB
-		| EEFC_FCR_FARG(7);
+	tcm_configure(0);
 	tcm_disable();
 #endif
 
@@ -376,12 +413,33 @@ void board_init(void)
 	ioport_set_pin_dir(LED0_GPIO, IOPORT_DIR_OUTPUT);
 	ioport_set_pin_level(LED0_GPIO, LED0_INACTIVE_LEVEL);
 
+#ifdef CONF_BOARD_GMAC
+	/* configure GMAC RMII pins, taking PD8 from the LED for the PHY
+		management clock */
+	ioport_set_pin_peripheral_mode(GMAC_REFCK_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_TXEN_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_TX0_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_TX1_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_CRSDV_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_RX0_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_RX1_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_RXER_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_MDC_GPIO, GMAC_RMII_FLAGS);
+	ioport_set_pin_peripheral_mode(GMAC_MDIO_GPIO, GMAC_RMII_FLAGS);
+#endif
+
 	/* configure USART1 pins */
 	ioport_set_pin_peripheral_mode(USART1_RXD_GPIO, USART1_RXD_FLAGS);
 	MATRIX->CCFG_SYSIO |= CCFG_SYSIO_SYSIO4;
 	ioport_set_pin_peripheral_mode(USART1_TXD_GPIO, USART1_TXD_FLAGS);
 	ioport_set_pin_peripheral_mode(USART1_SCK_GPIO, USART1_SCK_FLAGS);
 
+#ifdef CONF_BOARD_USART0
+	/* configure USART0 pins */
+	ioport_set_pin_peripheral_mode(USART0_RXD_GPIO, USART0_RXD_FLAGS);
+	ioport_set_pin_peripheral_mode(USART0_TXD_GPIO, USART0_TXD_FLAGS);
+#endif
+
 	/* configure SPI pins */
 	ioport_set_pin_peripheral_mode(SPI0_MISO_GPIO, SPI0_MISO_FLAGS);
 	ioport_set_pin_peripheral_mode(SPI0_MOSI_GPIO, SPI0_MOSI_FLAGS);
@@ -395,6 +453,28 @@ void board_init(void)
 	ioport_set_pin_peripheral_mode(CLK_480_GPIO, CLK_480_FLAGS);
 	ioport_set_pin_peripheral_mode(CLK_600_GPIO, CLK_600_FLAGS);
 
+#ifdef CONF_BOARD_SD
+	/* configure HSMCI pins for the SD card */
+	ioport_set_pin_peripheral_mode(HSMCI_MCCK_GPIO, HSMCI_MCCK_FLAGS);
+	ioport_set_pin_peripheral_mode(HSMCI_MCCDA_GPIO, HSMCI_MCCDA_FLAGS);
+	ioport_set_pin_peripheral_mode(HSMCI_MCDA0_GPIO, HSMCI_MCDA0_FLAGS);
+#endif
+
+#ifdef CONF_BOARD_QSPI
+	/* configure QSPI pins for the serial flash */
+	ioport_set_pin_peripheral_mode(QSPI_QCS_GPIO, QSPI_FLAGS);
+	ioport_set_pin_peripheral_mode(QSPI_QIO0_GPIO, QSPI_FLAGS);
+	ioport_set_pin_peripheral_mode(QSPI_QIO1_GPIO, QSPI_FLAGS);
+	ioport_set_pin_peripheral_mode(QSPI_QIO2_GPIO, QSPI_FLAGS);
+	ioport_set_pin_peripheral_mode(QSPI_QIO3_GPIO, QSPI_FLAGS);
+	ioport_set_pin_peripheral_mode(QSPI_QSCK_GPIO, QSPI_FLAGS);
+#endif
+
+#ifdef CONF_BOARD_USART2
+	/* configure USART2 pins, the SDRAM can't be used as they share pins */
+	ioport_set_pin_peripheral_mode(USART2_RXD_GPIO, USART2_RXD_FLAGS);
+	ioport_set_pin_peripheral_mode(USART2_TXD_GPIO, USART2_TXD_FLAGS);
+#else
 	/* configure SDRAM pins */
 	pio_configure_pin(SDRAM_BA0_PIO, SDRAM_BA0_FLAGS);
 	pio_configure_pin(SDRAM_BA1_PIO, SDRAM_BA1_FLAGS);
@@ -436,4 +516,5 @@ void board_init(void)
 	pio_configure_pin(SDRAM_D14_PIO, SDRAM_D_FLAGS);
 	pio_configure_pin(SDRAM_D15_PIO, SDRAM_D_FLAGS);
 	MATRIX->CCFG_SMCNFCS = CCFG_SMCNFCS_SDRAMEN;
+#endif
 }
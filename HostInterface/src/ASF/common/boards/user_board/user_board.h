@@ -42,6 +42,19 @@
 #define USART1_SCK_GPIO   PIO_PA23_IDX
 #define USART1_SCK_FLAGS  IOPORT_MODE_MUX_A
 
+/* USART0 pins definitions (second data channel link) */
+#define USART0_RXD_GPIO   PIO_PB0_IDX
+#define USART0_RXD_FLAGS  IOPORT_MODE_MUX_C
+#define USART0_TXD_GPIO   PIO_PB1_IDX
+#define USART0_TXD_FLAGS  IOPORT_MODE_MUX_C
+
+/* USART2 pins definitions (third data channel link)
+	Note: these pins are shared with SDRAM_NBS1 and SDRAM_RAS */
+#define USART2_RXD_GPIO   PIO_PD15_IDX
+#define USART2_RXD_FLAGS  IOPORT_MODE_MUX_B
+#define USART2_TXD_GPIO   PIO_PD16_IDX
+#define USART2_TXD_FLAGS  IOPORT_MODE_MUX_B
+
 /* LED definitions */
 #define LED0_GPIO            PIO_PD8_IDX
 #define LED0_ACTIVE_LEVEL    IOPORT_PIN_LEVEL_LOW
@@ -71,6 +84,11 @@
 #define TC_CLK_480_CHAN      0
 #define TC_CLK_600_ID        ID_TC2
 #define TC_CLK_600_CHAN      2
+/* TIMER_CLOCK1 of the sync timers is PCK6, run from the UPLL so the sync
+	frequencies don't depend on MCK: 480 MHz / 10 = 48 MHz */
+#define TC_CLK_PCK           PMC_PCK_6
+#define TC_CLK_PCK_PRES      PMC_PCK_PRES(9)
+#define TC_CLK_PCK_HZ        48000000UL
 
 /* 1 Hz timer */
 #define TC_1HZ               TC1
@@ -116,6 +134,12 @@
 /* XDMAC channels */
 #define DMA_CHANNEL_RX 1
 #define DMA_CHANNEL_TX 2
+#define DMA_CHANNEL_LINK1_RX 3
+#define DMA_CHANNEL_LINK1_TX 4
+#define DMA_CHANNEL_LINK2_RX 5
+#define DMA_CHANNEL_LINK2_TX 6
+#define DMA_CHANNEL_SD 7
+#define DMA_CHANNEL_QSPI 8
 
 /* SPI0 pins definition */
 #define SPI0_MISO_GPIO       PIO_PD20_IDX
@@ -133,6 +157,37 @@
 #define SPI0_SPCK_GPIO       PIO_PD22_IDX
 #define SPI0_SPCK_FLAGS      IOPORT_MODE_MUX_B
 
+/* GMAC RMII pins definition. GMDC shares PD8 with LED0, which goes dark
+	when the GMAC is used */
+#define GMAC_RMII_FLAGS      IOPORT_MODE_MUX_A
+#define GMAC_REFCK_GPIO      PIO_PD0_IDX
+#define GMAC_TXEN_GPIO       PIO_PD1_IDX
+#define GMAC_TX0_GPIO        PIO_PD2_IDX
+#define GMAC_TX1_GPIO        PIO_PD3_IDX
+#define GMAC_CRSDV_GPIO      PIO_PD4_IDX
+#define GMAC_RX0_GPIO        PIO_PD5_IDX
+#define GMAC_RX1_GPIO        PIO_PD6_IDX
+#define GMAC_RXER_GPIO       PIO_PD7_IDX
+#define GMAC_MDC_GPIO        PIO_PD8_IDX
+#define GMAC_MDIO_GPIO       PIO_PD9_IDX
+
+/* HSMCI pins definition, SD card slot A with a one bit bus */
+#define HSMCI_MCCK_GPIO      PIO_PA25_IDX
+#define HSMCI_MCCK_FLAGS     IOPORT_MODE_MUX_D
+#define HSMCI_MCCDA_GPIO     PIO_PA28_IDX
+#define HSMCI_MCCDA_FLAGS    IOPORT_MODE_MUX_C
+#define HSMCI_MCDA0_GPIO     PIO_PA30_IDX
+#define HSMCI_MCDA0_FLAGS    IOPORT_MODE_MUX_C
+
+/* QSPI pins definition, serial NOR flash */
+#define QSPI_FLAGS           IOPORT_MODE_MUX_A
+#define QSPI_QCS_GPIO        PIO_PA11_IDX
+#define QSPI_QIO0_GPIO       PIO_PA13_IDX
+#define QSPI_QIO1_GPIO       PIO_PA12_IDX
+#define QSPI_QIO2_GPIO       PIO_PA17_IDX
+#define QSPI_QIO3_GPIO       PIO_PD31_IDX
+#define QSPI_QSCK_GPIO       PIO_PA14_IDX
+
 /* board SDRAM size for AS4C32M16SB */
 #define BOARD_SDRAM_SIZE     (64 * 1024 * 1024)
 
@@ -44,22 +44,42 @@
 
 #ifdef UDI_CDC_LOW_RATE
 #  ifdef USB_DEVICE_HS_SUPPORT
-#    define UDI_CDC_TX_BUFFERS     (UDI_CDC_DATA_EPS_HS_SIZE)
+#    ifndef UDI_CDC_TX_BUFFERS
+#      define UDI_CDC_TX_BUFFERS   (UDI_CDC_DATA_EPS_HS_SIZE)
+#    endif
 #    define UDI_CDC_RX_BUFFERS     (UDI_CDC_DATA_EPS_HS_SIZE)
 #  else
-#    define UDI_CDC_TX_BUFFERS     (UDI_CDC_DATA_EPS_FS_SIZE)
+#    ifndef UDI_CDC_TX_BUFFERS
+#      define UDI_CDC_TX_BUFFERS   (UDI_CDC_DATA_EPS_FS_SIZE)
+#    endif
 #    define UDI_CDC_RX_BUFFERS     (UDI_CDC_DATA_EPS_FS_SIZE)
 #  endif
 #else
 #  ifdef USB_DEVICE_HS_SUPPORT
-#    define UDI_CDC_TX_BUFFERS     (UDI_CDC_DATA_EPS_HS_SIZE)
+#    ifndef UDI_CDC_TX_BUFFERS
+#      define UDI_CDC_TX_BUFFERS   (UDI_CDC_DATA_EPS_HS_SIZE)
+#    endif
 #    define UDI_CDC_RX_BUFFERS     (UDI_CDC_DATA_EPS_HS_SIZE)
 #  else
-#    define UDI_CDC_TX_BUFFERS     (5*UDI_CDC_DATA_EPS_FS_SIZE)
+#    ifndef UDI_CDC_TX_BUFFERS
+#      define UDI_CDC_TX_BUFFERS   (5*UDI_CDC_DATA_EPS_FS_SIZE)
+#    endif
 #    define UDI_CDC_RX_BUFFERS     (5*UDI_CDC_DATA_EPS_FS_SIZE)
 #  endif
 #endif
 
+//! Number of TX buffers per port. One is filled by the application while
+//! the others wait to be sent, full buffers are sent back to back.
+#ifndef UDI_CDC_TX_QUEUE_DEPTH
+#  define UDI_CDC_TX_QUEUE_DEPTH   2
+#endif
+#if (UDI_CDC_TX_QUEUE_DEPTH < 2) || (UDI_CDC_TX_QUEUE_DEPTH > 255)
+#  error UDI_CDC_TX_QUEUE_DEPTH must be between 2 and 255
+#endif
+#if UDI_CDC_TX_BUFFERS > 0xFFFF
+#  error UDI_CDC_TX_BUFFERS must fit the 16 bit buffer counts
+#endif
+
 #ifndef UDI_CDC_TX_EMPTY_NOTIFY
 #  define UDI_CDC_TX_EMPTY_NOTIFY(port)
 #endif
@@ -199,6 +219,15 @@ static void udi_cdc_data_sent(udd_ep_status_t status, iram_size_t n, udd_ep_id_t
  */
 static void udi_cdc_tx_send(uint8_t port);
 
+/**
+ * \brief Queue the buffer being filled for sending and move on to the next
+ * Must be called with interrupts disabled, and with less than
+ * UDI_CDC_TX_QUEUE_DEPTH - 1 buffers queued.
+ *
+ * \param port       Communication port number to manage
+ */
+static void udi_cdc_tx_close(uint8_t port);
+
 //@}
 
 //@}
@@ -219,15 +248,17 @@ static volatile uint8_t udi_cdc_nb_comm_enabled = 0;
 
 /**
  * \name Variables to manage RX/TX transfer requests
- * Two buffers for each sense are used to optimize the speed.
+ * Two RX buffers and UDI_CDC_TX_QUEUE_DEPTH TX buffers are used to optimize
+ * the speed.
  */
 //@{
 
 //! Status of CDC DATA interfaces
 static volatile uint8_t udi_cdc_nb_data_enabled = 0;
 static volatile bool udi_cdc_data_running = false;
-//! Buffer to receive data
-COMPILER_WORD_ALIGNED static uint8_t udi_cdc_rx_buf[UDI_CDC_PORT_NB][2][UDI_CDC_RX_BUFFERS];
+//! Buffer to receive data, cache line aligned as the USB DMA writes it
+//! with the data cache on (the buffer sizes are multiples of 32 bytes)
+COMPILER_ALIGNED(32) static uint8_t udi_cdc_rx_buf[UDI_CDC_PORT_NB][2][UDI_CDC_RX_BUFFERS];
 //! Data available in RX buffers
 static volatile uint16_t udi_cdc_rx_buf_nb[UDI_CDC_PORT_NB][2];
 //! Give the current RX buffer used (rx0 if 0, rx1 if 1)
@@ -240,18 +271,22 @@ static volatile bool udi_cdc_rx_trans_ongoing[UDI_CDC_PORT_NB];
 //! Define a transfer halted
 #define  UDI_CDC_TRANS_HALTED    2
 
-//! Buffer to send data
-COMPILER_WORD_ALIGNED static uint8_t udi_cdc_tx_buf[UDI_CDC_PORT_NB][2][UDI_CDC_TX_BUFFERS];
+//! Buffers to send data, filled and sent in turn
+COMPILER_WORD_ALIGNED static uint8_t udi_cdc_tx_buf[UDI_CDC_PORT_NB][UDI_CDC_TX_QUEUE_DEPTH][UDI_CDC_TX_BUFFERS];
 //! Data available in TX buffers
-static uint16_t udi_cdc_tx_buf_nb[UDI_CDC_PORT_NB][2];
-//! Give current TX buffer used (tx0 if 0, tx1 if 1)
+static uint16_t udi_cdc_tx_buf_nb[UDI_CDC_PORT_NB][UDI_CDC_TX_QUEUE_DEPTH];
+//! Give current TX buffer filled by the application
 static volatile uint8_t udi_cdc_tx_buf_sel[UDI_CDC_PORT_NB];
+//! Give oldest TX buffer waiting to be sent (or being sent)
+static volatile uint8_t udi_cdc_tx_buf_send[UDI_CDC_PORT_NB];
+//! Number of TX buffers waiting to be sent (or being sent)
+static volatile uint8_t udi_cdc_tx_buf_queued[UDI_CDC_PORT_NB];
+//! Signal the application is copying into the current buffer
+static volatile bool udi_cdc_tx_buf_writing[UDI_CDC_PORT_NB];
 //! Value of SOF during last TX transfer
 static uint16_t udi_cdc_tx_sof_num[UDI_CDC_PORT_NB];
 //! Signal a transfer on-going
 static volatile bool udi_cdc_tx_trans_ongoing[UDI_CDC_PORT_NB];
-//! Signal that both buffer content data to send
-static volatile bool udi_cdc_tx_both_buf_to_send[UDI_CDC_PORT_NB];
 
 //@}
 
@@ -325,10 +360,11 @@ bool udi_cdc_data_enable(void)
 
 	// Initialize TX management
 	udi_cdc_tx_trans_ongoing[port] = false;
-	udi_cdc_tx_both_buf_to_send[port] = false;
 	udi_cdc_tx_buf_sel[port] = 0;
-	udi_cdc_tx_buf_nb[port][0] = 0;
-	udi_cdc_tx_buf_nb[port][1] = 0;
+	udi_cdc_tx_buf_send[port] = 0;
+	udi_cdc_tx_buf_queued[port] = 0;
+	udi_cdc_tx_buf_writing[port] = false;
+	memset(udi_cdc_tx_buf_nb[port], 0, sizeof(udi_cdc_tx_buf_nb[port]));
 	udi_cdc_tx_sof_num[port] = 0;
 	udi_cdc_tx_send(port);
 
@@ -678,8 +714,11 @@ static void udi_cdc_data_sent(udd_ep_status_t status, iram_size_t n, udd_ep_id_t
 		// Abort transfer
 		return;
 	}
-	udi_cdc_tx_buf_nb[port][(udi_cdc_tx_buf_sel[port]==0)?1:0] = 0;
-	udi_cdc_tx_both_buf_to_send[port] = false;
+	// Release the buffer sent, it becomes free for the application
+	udi_cdc_tx_buf_nb[port][udi_cdc_tx_buf_send[port]] = 0;
+	udi_cdc_tx_buf_send[port] = (udi_cdc_tx_buf_send[port] + 1)
+			% UDI_CDC_TX_QUEUE_DEPTH;
+	udi_cdc_tx_buf_queued[port]--;
 	udi_cdc_tx_trans_ongoing[port] = false;
 
 	if (n != 0) {
@@ -701,40 +740,53 @@ static void udi_cdc_tx_send(uint8_t port)
 	port = 0;
 #endif
 
+#ifdef UDI_CDC_TX_DIRECT
+	if (UDI_CDC_TX_DIRECT(port)) {
+		return; // The application drives the IN endpoint itself
+	}
+#endif
+
+	flags = cpu_irq_save(); // to protect the TX queue
 	if (udi_cdc_tx_trans_ongoing[port]) {
-		return; // Already on going or wait next SOF to send next data
+		cpu_irq_restore(flags);
+		return; // Already on going, the next buffer follows on its end
 	}
-	if (udd_is_high_speed()) {
-		if (udi_cdc_tx_sof_num[port] == udd_get_micro_frame_number()) {
-			return; // Wait next SOF to send next data
-		}
-	}else{
-		if (udi_cdc_tx_sof_num[port] == udd_get_frame_number()) {
-			return; // Wait next SOF to send next data
-		}
+	if ((udi_cdc_tx_buf_nb[port][udi_cdc_tx_buf_sel[port]] == UDI_CDC_TX_BUFFERS)
+			&& (!udi_cdc_tx_buf_writing[port])
+			&& (udi_cdc_tx_buf_queued[port] < (UDI_CDC_TX_QUEUE_DEPTH - 1))) {
+		// A full buffer left behind while the queue was full
+		udi_cdc_tx_close(port);
 	}
-
-	flags = cpu_irq_save(); // to protect udi_cdc_tx_buf_sel
-	buf_sel_trans = udi_cdc_tx_buf_sel[port];
-	if (udi_cdc_tx_buf_nb[port][buf_sel_trans] == 0) {
-		sof_zlp_counter++;
-		if (((!udd_is_high_speed()) && (sof_zlp_counter < 100))
-				|| (udd_is_high_speed() && (sof_zlp_counter < 800))) {
+	if (udi_cdc_tx_buf_queued[port] == 0) {
+		// No full buffer is waiting, the partly filled buffer
+		// is sent at most once per (micro) frame
+		if (udd_is_high_speed()) {
+			if (udi_cdc_tx_sof_num[port] == udd_get_micro_frame_number()) {
+				cpu_irq_restore(flags);
+				return; // Wait next SOF to send next data
+			}
+		}else{
+			if (udi_cdc_tx_sof_num[port] == udd_get_frame_number()) {
+				cpu_irq_restore(flags);
+				return; // Wait next SOF to send next data
+			}
+		}
+		if (udi_cdc_tx_buf_writing[port]) {
 			cpu_irq_restore(flags);
-			return;
+			return; // Being filled, wait next SOF
+		}
+		if (udi_cdc_tx_buf_nb[port][udi_cdc_tx_buf_sel[port]] == 0) {
+			sof_zlp_counter++;
+			if (((!udd_is_high_speed()) && (sof_zlp_counter < 100))
+					|| (udd_is_high_speed() && (sof_zlp_counter < 800))) {
+				cpu_irq_restore(flags);
+				return;
+			}
 		}
+		udi_cdc_tx_close(port);
 	}
 	sof_zlp_counter = 0;
-
-	if (!udi_cdc_tx_both_buf_to_send[port]) {
-		// Send current Buffer
-		// and switch the current buffer
-		udi_cdc_tx_buf_sel[port] = (buf_sel_trans==0)?1:0;
-	}else{
-		// Send the other Buffer
-		// and no switch the current buffer
-		buf_sel_trans = (buf_sel_trans==0)?1:0;
-	}
+	buf_sel_trans = udi_cdc_tx_buf_send[port];
 	udi_cdc_tx_trans_ongoing[port] = true;
 	cpu_irq_restore(flags);
 
@@ -769,6 +821,16 @@ static void udi_cdc_tx_send(uint8_t port)
 }
 
 
+static void udi_cdc_tx_close(uint8_t port)
+{
+	uint8_t buf_sel = (udi_cdc_tx_buf_sel[port] + 1) % UDI_CDC_TX_QUEUE_DEPTH;
+
+	udi_cdc_tx_buf_queued[port]++;
+	udi_cdc_tx_buf_nb[port][buf_sel] = 0;
+	udi_cdc_tx_buf_sel[port] = buf_sel;
+}
+
+
 //---------------------------------------------
 //------- Application interface
 
@@ -1004,28 +1066,29 @@ iram_size_t udi_cdc_multi_get_free_tx_buffer(uint8_t port)
 {
 	irqflags_t flags;
 	iram_size_t buf_sel_nb, retval;
-	uint8_t buf_sel;
+	bool b_send = false;
 
 #if UDI_CDC_PORT_NB == 1 // To optimize code
 	port = 0;
 #endif
 
 	flags = cpu_irq_save();
-	buf_sel = udi_cdc_tx_buf_sel[port];
-	buf_sel_nb = udi_cdc_tx_buf_nb[port][buf_sel];
-	if (buf_sel_nb == UDI_CDC_TX_BUFFERS) {
-		if ((!udi_cdc_tx_trans_ongoing[port])
-			&& (!udi_cdc_tx_both_buf_to_send[port])) {
-			/* One buffer is full, but the other buffer is not used.
-			 * (not used = transfer on-going)
-			 * then move to the other buffer to store data */
-			udi_cdc_tx_both_buf_to_send[port] = true;
-			udi_cdc_tx_buf_sel[port] = (buf_sel == 0)? 1 : 0;
-			buf_sel_nb = 0;
-		}
+	buf_sel_nb = udi_cdc_tx_buf_nb[port][udi_cdc_tx_buf_sel[port]];
+	if ((buf_sel_nb == UDI_CDC_TX_BUFFERS)
+			&& (udi_cdc_tx_buf_queued[port] < (UDI_CDC_TX_QUEUE_DEPTH - 1))) {
+		/* The current buffer is full and a free one is available,
+		 * queue the full one and move on to the free one */
+		udi_cdc_tx_close(port);
+		buf_sel_nb = 0;
+		b_send = true;
 	}
-	retval = UDI_CDC_TX_BUFFERS - buf_sel_nb;  
+	retval = UDI_CDC_TX_BUFFERS - buf_sel_nb;
 	cpu_irq_restore(flags);
+
+	if (b_send) {
+		// Don't wait for the next SOF to send a full buffer
+		udi_cdc_tx_send(port);
+	}
 	return retval;
 }
 
@@ -1110,7 +1173,8 @@ udi_cdc_write_buf_loop_wait:
 		goto udi_cdc_write_buf_loop_wait;
 	}
 
-	// Write values
+	// Write values. The copy is done with interrupts enabled, the flag
+	// keeps the SOF from sending the buffer while it is being filled
 	flags = cpu_irq_save();
 	buf_sel = udi_cdc_tx_buf_sel[port];
 	buf_nb = udi_cdc_tx_buf_nb[port][buf_sel];
@@ -1118,10 +1182,19 @@ udi_cdc_write_buf_loop_wait:
 	if (copy_nb > size) {
 		copy_nb = size;
 	}
+	udi_cdc_tx_buf_writing[port] = true;
+	cpu_irq_restore(flags);
+
 	memcpy(&udi_cdc_tx_buf[port][buf_sel][buf_nb], ptr_buf, copy_nb);
+
+	flags = cpu_irq_save();
 	udi_cdc_tx_buf_nb[port][buf_sel] = buf_nb + copy_nb;
+	udi_cdc_tx_buf_writing[port] = false;
 	cpu_irq_restore(flags);
 
+	// Queue the buffer straight away once it is full
+	udi_cdc_multi_get_free_tx_buffer(port);
+
 	// Update buffer pointer
 	ptr_buf = ptr_buf + copy_nb;
 	size -= copy_nb;
@@ -100,6 +100,7 @@
 
 #define INNER_NORMAL_WB_RWA_TYPE(x)   (( 0x04 << MPU_RASR_TEX_Pos ) | ( DISABLE  << MPU_RASR_C_Pos ) | ( ENABLE  << MPU_RASR_B_Pos )  | ( x << MPU_RASR_S_Pos ))
 #define INNER_NORMAL_WB_NWA_TYPE(x)   (( 0x04 << MPU_RASR_TEX_Pos ) | ( ENABLE  << MPU_RASR_C_Pos )  | ( ENABLE  << MPU_RASR_B_Pos )  | ( x << MPU_RASR_S_Pos ))
+#define INNER_OUTER_NORMAL_NOCACHE_TYPE(x)  (( 0x01 << MPU_RASR_TEX_Pos ) | ( DISABLE  << MPU_RASR_C_Pos ) | ( DISABLE  << MPU_RASR_B_Pos ) | ( x << MPU_RASR_S_Pos ))
 #define STRONGLY_ORDERED_SHAREABLE_TYPE      (( 0x00 << MPU_RASR_TEX_Pos ) | ( DISABLE << MPU_RASR_C_Pos ) | ( DISABLE << MPU_RASR_B_Pos ))     // DO not care //
 #define SHAREABLE_DEVICE_TYPE                (( 0x00 << MPU_RASR_TEX_Pos ) | ( DISABLE << MPU_RASR_C_Pos ) | ( ENABLE  << MPU_RASR_B_Pos ))     // DO not care //
 
@@ -137,7 +138,9 @@
 /******* SRAM memory macros ***************************/
 
 #define SRAM_START_ADDRESS                  0x20400000UL
-#define SRAM_END_ADDRESS                    0x2045FFFFUL
+/* system SRAM left once 64 KB each of ITCM and DTCM are taken from it
+   (GPNVM TCM_CONFIG); the linker script uses the same layout */
+#define SRAM_END_ADDRESS                    0x2043FFFFUL
 
 #if defined MPU_HAS_NOCACHE_REGION
 #define NOCACHE_SRAM_REGION_SIZE            0x1000
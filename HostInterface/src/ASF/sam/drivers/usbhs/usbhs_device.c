@@ -39,6 +39,7 @@
 #include "udd.h"
 #include "usbhs_otg.h"
 #include "usbhs_device.h"
+#include "dma_buf.h"
 #include <string.h>
 
 #ifndef UDD_NO_SLEEP_MGR
@@ -102,7 +103,7 @@
 #define dbg_print(...)
 
 #ifdef UDD_EP_DMA_SUPPORTED
-// for DCache
+// for DCache: the maintenance is shared with the XDMAC users (dma_buf.c)
 /**
  * \brief Flush content in DCache to physical memory
  * \param addr The memory address to flush
@@ -110,26 +111,7 @@
  */
 static void _dcache_flush(void *addr, uint32_t dsize)
 {
-#ifdef CONF_BOARD_ENABLE_CACHE_AT_INIT
-	int32_t op_size = dsize;
-	uint32_t op_addr = (uint32_t) addr;
-	int32_t linesize = 32U;                // in Cortex-M7 size of cache line is fixed to 8 words (32 bytes)
-	if (op_addr & (linesize - 1)) {
-		op_size += op_addr & (linesize - 1);
-		op_addr &= ~(linesize - 1);
-	}
-	__ISB();
-	__DSB();
-
-	while (op_size > 0) {
-		SCB->DCCMVAC = op_addr;
-		op_addr += linesize;
-		op_size -= linesize;
-	}
-
-	__DSB();
-	__ISB();
-#endif
+	DmaBufClean(addr, dsize);
 }
 
 /**
@@ -139,23 +121,7 @@ static void _dcache_flush(void *addr, uint32_t dsize)
  */
 static void _dcache_invalidate_prepare(void *addr, uint32_t dsize)
 {
-#ifdef CONF_BOARD_ENABLE_CACHE_AT_INIT
-	int32_t op_size = dsize;
-	uint32_t op_addr = (uint32_t) addr;
-	int32_t linesize = 32U;                // in Cortex-M7 size of cache line is fixed to 8 words (32 bytes)
-	uint32_t addr1 = op_addr;
-	uint32_t addr2 = op_addr + op_size;
-	if (addr1 & (linesize - 1) || addr2 & (linesize - 1)) {
-		addr1 &= ~(linesize - 1);
-		addr2 &= ~(linesize - 1);
-		__ISB();
-		__DSB();
-		SCB->DCCIMVAC = addr1;
-		SCB->DCCIMVAC = addr2;
-		__DSB();
-		__ISB();
-	}
-#endif
+	DmaBufPrepareRead(addr, dsize);
 }
 
 /**
@@ -165,27 +131,7 @@ static void _dcache_invalidate_prepare(void *addr, uint32_t dsize)
  */
 static void _dcache_invalidate(void *addr, uint32_t dsize)
 {
-#ifdef CONF_BOARD_ENABLE_CACHE_AT_INIT
-	int32_t op_size = dsize;
-	uint32_t op_addr = (uint32_t)addr;
-	int32_t linesize = 32U;                // in Cortex-M7 size of cache line is fixed to 8 words (32 bytes)
-	if (op_addr & (linesize - 1)) {
-		op_size += op_addr & (linesize - 1);
-		op_addr &= ~(linesize - 1);
-	}
-	__ISB();
-	__DSB();
-
-	while (op_size > 0) {
-		/* D-Cache Invalidate by MVA to PoC */
-		*(volatile uint32_t *)(0xE000EF5C) = op_addr;
-		op_addr += linesize;
-		op_size -= linesize;
-	}
-
-	__DSB();
-	__ISB();
-#endif
+	DmaBufInvalidate(addr, dsize);
 }
 #endif
 
@@ -351,8 +351,9 @@ static inline void xdmac_channel_enable(Xdmac *xdmac, uint32_t channel_num)
 	Assert(xdmac);
 	Assert(channel_num < XDMACCHID_NUMBER);
 
-	/* Update DCache before DMA transmit */
-	SCB_CleanInvalidateDCache();
+	/* the data cache isn't maintained here: cleaning and invalidating all
+		of it on every enable is costly and still doesn't cover linked list
+		transfers. Channel users maintain their buffers (dma_buf.h) */
 
 	xdmac->XDMAC_GE = (XDMAC_GE_EN0 << channel_num);
 }
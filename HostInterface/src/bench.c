@@ -0,0 +1,216 @@
+/** ***************************************************************************
+File Name:  bench.c
+
+Project:    Platform 4
+
+Purpose:    Throughput benchmarks for the data channel processing routines
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdio.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "bench.h"
+#include "crc.h"
+#include "frame.h"
+
+
+/* Module Definitions */
+
+/* size of the block the CRC routines are run over */
+#define BENCH_CRC_SIZE      4096
+/* payload size of the frames pushed through the parser */
+#define BENCH_FRAME_PAYLOAD 1000
+#define BENCH_FRAMES        8
+/* chunk size the frame stream is fed in, one receive ring segment */
+#define BENCH_CHUNK         512
+/* number of passes, the best is kept to reject interrupt noise */
+#define BENCH_PASSES        4
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+/* Module Variable Declarations */
+
+/* benchmark data: a block of pseudo-random bytes, and the same data framed */
+static uint8_t aucBenchData[BENCH_FRAMES * (BENCH_FRAME_PAYLOAD + FRAME_OVERHEAD)];
+static tFrameParser stBenchParser;
+
+/* result sink, stops the compiler discarding the work being timed */
+static volatile uint32_t ulBenchSink;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               BenchRun
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of results written to pstResults
+	Caveats / Effect:   Overwrites the benchmark buffers, takes a few ms
+
+	Description:
+	Times the bytewise and slicing CRC routines and the frame parser using the
+	supplied cycle counter. pstResults must hold BENCH_RESULTS entries. The
+	best of several passes is reported for each routine.
+*/
+uint32_t BenchRun(tBenchCycles pfnCycles, tBenchResult *pstResults)
+{
+	static char const * const apcNames[BENCH_RESULTS] = {
+		"crc32 bytewise",
+		"crc32 slice-by-8",
+		"crc16 bytewise",
+		"crc16 slice-by-8",
+		"frame parser"
+	};
+	uint32_t ulSeed = 0x12345678UL;
+	uint32_t ulStream = 0;
+	uint32_t i;
+	uint32_t j;
+
+	/* fill the block with a simple LCG sequence */
+	for(i = 0; i < BENCH_CRC_SIZE; i++)
+	{
+		ulSeed = ulSeed * 1664525UL + 1013904223UL;
+		aucBenchData[i] = (uint8_t)(ulSeed >> 24);
+	}
+
+	for(i = 0; i < BENCH_RESULTS; i++)
+	{
+		pstResults[i].pcName = apcNames[i];
+		pstResults[i].ulBytes = BENCH_CRC_SIZE;
+		pstResults[i].ulCycles = UINT32_MAX;
+	}
+
+	for(j = 0; j < BENCH_PASSES; j++)
+	{
+		uint32_t ulStart;
+		uint32_t ulCycles[4];
+
+		ulStart = pfnCycles();
+		ulBenchSink = Crc32Bytewise(CRC32_INIT, aucBenchData, BENCH_CRC_SIZE);
+		ulCycles[0] = pfnCycles() - ulStart;
+
+		ulStart = pfnCycles();
+		ulBenchSink = Crc32(CRC32_INIT, aucBenchData, BENCH_CRC_SIZE);
+		ulCycles[1] = pfnCycles() - ulStart;
+
+		ulStart = pfnCycles();
+		ulBenchSink = Crc16Bytewise(CRC16_INIT, aucBenchData, BENCH_CRC_SIZE);
+		ulCycles[2] = pfnCycles() - ulStart;
+
+		ulStart = pfnCycles();
+		ulBenchSink = Crc16(CRC16_INIT, aucBenchData, BENCH_CRC_SIZE);
+		ulCycles[3] = pfnCycles() - ulStart;
+
+		for(i = 0; i < 4; i++)
+		{
+			if(ulCycles[i] < pstResults[i].ulCycles)
+			{
+				pstResults[i].ulCycles = ulCycles[i];
+			}
+		}
+	}
+
+	/* frame the start of the block back-to-back, working from the back so
+		each payload is still intact when it is framed */
+	for(i = BENCH_FRAMES; i-- > 0;)
+	{
+		uint8_t *pucFrame = &aucBenchData[i * (BENCH_FRAME_PAYLOAD + FRAME_OVERHEAD)];
+
+		FrameBuild(pucFrame, (uint16_t)i, &aucBenchData[i * BENCH_FRAME_PAYLOAD],
+			BENCH_FRAME_PAYLOAD);
+	}
+	ulStream = BENCH_FRAMES * (BENCH_FRAME_PAYLOAD + FRAME_OVERHEAD);
+	pstResults[4].ulBytes = ulStream;
+
+	for(j = 0; j < BENCH_PASSES; j++)
+	{
+		uint32_t const ulStart = pfnCycles();
+		uint32_t ulCycles;
+
+		FrameParserInit(&stBenchParser);
+		for(i = 0; i < ulStream;)
+		{
+			uint32_t const ulChunk =
+				(ulStream - i < BENCH_CHUNK) ? ulStream - i : BENCH_CHUNK;
+			uint32_t ulUsed = 0;
+
+			while(ulUsed < ulChunk)
+			{
+				ulUsed += FrameParserFeed(&stBenchParser, &aucBenchData[i + ulUsed],
+					ulChunk - ulUsed);
+			}
+			i += ulChunk;
+		}
+		ulCycles = pfnCycles() - ulStart;
+		ulBenchSink = stBenchParser.ulFrames;
+
+		if(ulCycles < pstResults[4].ulCycles)
+		{
+			pstResults[4].ulCycles = ulCycles;
+		}
+	}
+
+	return BENCH_RESULTS;
+}
+
+/** ***************************************************************************
+	Name:               BenchFormat
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Length of the formatted line
+	Caveats / Effect:   None
+
+	Description:
+	Formats one result as a text line giving cycles/byte and bytes/cycle, both
+	to two decimal places (integer arithmetic only).
+*/
+uint32_t BenchFormat(tBenchResult const *pstResult, char *pcDst, uint32_t ulSize)
+{
+	uint32_t const ulCpb = (uint32_t)(((uint64_t)pstResult->ulCycles * 100)
+		/ pstResult->ulBytes);
+	uint32_t const ulBpc = (uint32_t)(((uint64_t)pstResult->ulBytes * 100)
+		/ (pstResult->ulCycles ? pstResult->ulCycles : 1));
+	int const iLen = snprintf(pcDst, ulSize,
+		"%-18s %6lu bytes %8lu cycles %3lu.%02lu cycles/byte %3lu.%02lu bytes/cycle\r\n",
+		pstResult->pcName,
+		(unsigned long)pstResult->ulBytes,
+		(unsigned long)pstResult->ulCycles,
+		(unsigned long)(ulCpb / 100), (unsigned long)(ulCpb % 100),
+		(unsigned long)(ulBpc / 100), (unsigned long)(ulBpc % 100));
+
+	if(iLen < 0)
+	{
+		return 0;
+	}
+	return ((uint32_t)iLen < ulSize) ? (uint32_t)iLen : ulSize - 1;
+}
+
+
+/* Module Function Implementations */
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,57 @@
+/** ***************************************************************************
+File Name:  bench.h
+
+Project:    Platform 4
+
+Purpose:    Throughput benchmarks for the data channel processing routines
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* number of results produced by BenchRun() */
+#define BENCH_RESULTS 5
+
+
+/* Module Type Definitions */
+
+/* free-running cycle counter, DWT->CYCCNT on target or a TSC on a host */
+typedef uint32_t (*tBenchCycles)(void);
+
+/* result of one benchmark */
+typedef struct
+{
+	char const *pcName;
+	uint32_t ulBytes;
+	uint32_t ulCycles;
+} tBenchResult;
+
+
+/* Global Function Declarations */
+
+uint32_t BenchRun(tBenchCycles pfnCycles, tBenchResult *pstResults);
+uint32_t BenchFormat(tBenchResult const *pstResult, char *pcDst, uint32_t ulSize);
+
+
+#endif /* BENCH_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,257 @@
+/** ***************************************************************************
+File Name:  ber.c
+
+Project:    Platform 4
+
+Purpose:    Bit error rate test: continuous PRBS transmission and result
+            reporting
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdio.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "ber.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* microblock control for every descriptor in the chain: fetch the next view 1
+	descriptor, take the new source, keep the destination (USART THR) */
+#define BER_TX_DESC_UBC (XDMAC_UBC_NVIEW_NDV1 \
+	| XDMAC_UBC_NDE_FETCH_EN \
+	| XDMAC_UBC_NSEN_UPDATED \
+	| XDMAC_UBC_NDEN_UNCHANGED \
+	| XDMAC_UBC_UBLEN(BER_TX_SEGMENT_SIZE))
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+/* Module Variable Declarations */
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               BerTxInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 for an unsupported PRBS order or if
+	                    the descriptors can't be allocated
+	Caveats / Effect:   The XDMAC channel must be disabled
+
+	Description:
+	Pre-fills every transmit segment with the start of the sequence, builds
+	the circular descriptor chain and programs the channel configuration.
+	ulDstAddr is the peripheral transmit holding register and ulPerId its
+	XDMAC hardware interface ID.
+*/
+int BerTxInit(tBerTx *pstTx, uint32_t ulOrder, uint32_t ulChannel,
+	uint32_t ulDstAddr, uint32_t ulPerId)
+{
+	lld_view1 *pastDesc = pstTx->pastDesc;
+	uint32_t i;
+
+	if(!pastDesc)
+	{
+		pastDesc = DmaBufAllocNoCache(BER_TX_SEGMENTS * sizeof(lld_view1));
+	}
+
+	memset(pstTx, 0, sizeof(*pstTx));
+	pstTx->pastDesc = pastDesc;
+	if(!pastDesc || PrbsInit(&pstTx->stGen, ulOrder))
+	{
+		return -1;
+	}
+	pstTx->ulOrder = ulOrder;
+	pstTx->ulChannel = ulChannel;
+
+	for(i = 0; i < BER_TX_SEGMENTS; i++)
+	{
+		PrbsFill(&pstTx->stGen, pstTx->aaucData[i], BER_TX_SEGMENT_SIZE);
+		pastDesc[i].mbr_nda = (uint32_t)&pastDesc[(i + 1) % BER_TX_SEGMENTS];
+		pastDesc[i].mbr_ubc = BER_TX_DESC_UBC;
+		pastDesc[i].mbr_sa  = (uint32_t)pstTx->aaucData[i];
+		pastDesc[i].mbr_da  = ulDstAddr;
+	}
+	DmaBufClean(pastDesc, BER_TX_SEGMENTS * sizeof(lld_view1));
+	DmaBufClean(pstTx->aaucData, sizeof(pstTx->aaucData));
+
+	xdmac_channel_set_config(XDMAC, ulChannel, XDMAC_CC_TYPE_PER_TRAN
+		| XDMAC_CC_DSYNC_MEM2PER
+		| XDMAC_CC_SWREQ_HWR_CONNECTED
+		| XDMAC_CC_CSIZE_CHK_1
+		| XDMAC_CC_DWIDTH_BYTE
+		| XDMAC_CC_SIF_AHB_IF1
+		| XDMAC_CC_DIF_AHB_IF1
+		| XDMAC_CC_SAM_INCREMENTED_AM
+		| XDMAC_CC_DAM_FIXED_AM
+		| XDMAC_CC_PERID(ulPerId));
+	xdmac_channel_set_block_control(XDMAC, ulChannel, 0);
+	xdmac_channel_set_datastride_mempattern(XDMAC, ulChannel, 0);
+	xdmac_channel_set_source_microblock_stride(XDMAC, ulChannel, 0);
+	xdmac_channel_set_destination_microblock_stride(XDMAC, ulChannel, 0);
+
+	xdmac_enable_interrupt(XDMAC, ulChannel);
+	xdmac_channel_enable_interrupt(XDMAC, ulChannel, XDMAC_CIE_BIE);
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               BerTxStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Starts transmitting. The sequence is sent back-to-back until
+	BerTxStop() is called.
+*/
+void BerTxStart(tBerTx *pstTx)
+{
+	xdmac_channel_get_interrupt_status(XDMAC, pstTx->ulChannel);
+
+	xdmac_channel_set_microblock_control(XDMAC, pstTx->ulChannel, 0);
+	xdmac_channel_set_descriptor_addr(XDMAC, pstTx->ulChannel,
+		(uint32_t)&pstTx->pastDesc[0], 0);
+	xdmac_channel_set_descriptor_control(XDMAC, pstTx->ulChannel,
+		XDMAC_CNDC_NDE_DSCR_FETCH_EN
+		| XDMAC_CNDC_NDVIEW_NDV1
+		| XDMAC_CNDC_NDSUP_SRC_PARAMS_UPDATED
+		| XDMAC_CNDC_NDDUP_DST_PARAMS_UPDATED);
+	xdmac_channel_enable(XDMAC, pstTx->ulChannel);
+}
+
+/** ***************************************************************************
+	Name:               BerTxStop
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Blocks until the channel has flushed
+
+	Description:
+	Stops transmitting.
+*/
+void BerTxStop(tBerTx *pstTx)
+{
+	xdmac_channel_disable(XDMAC, pstTx->ulChannel);
+	while(xdmac_channel_get_status(XDMAC) & (1UL << pstTx->ulChannel)) {};
+}
+
+/** ***************************************************************************
+	Name:               BerTxSegmentDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the XDMAC ISR only
+
+	Description:
+	Refills every segment the DMA has finished with. The active segment is
+	taken from the channel's next descriptor address rather than by counting
+	interrupts, so a late interrupt covering two segments is handled too.
+*/
+TCM_CODE void BerTxSegmentDone(tBerTx *pstTx)
+{
+	XdmacChid const volatile *pstChan = &XDMAC->XDMAC_CHID[pstTx->ulChannel];
+	uint32_t const ulNext = ((pstChan->XDMAC_CNDA & XDMAC_CNDA_NDA_Msk)
+		- (uint32_t)&pstTx->pastDesc[0]) / sizeof(lld_view1);
+	uint32_t const ulActive = (ulNext + BER_TX_SEGMENTS - 1) % BER_TX_SEGMENTS;
+
+	while(pstTx->ulNextFill != ulActive)
+	{
+		PrbsFill(&pstTx->stGen, pstTx->aaucData[pstTx->ulNextFill],
+			BER_TX_SEGMENT_SIZE);
+		DmaBufClean(pstTx->aaucData[pstTx->ulNextFill], BER_TX_SEGMENT_SIZE);
+		pstTx->ulNextFill = (pstTx->ulNextFill + 1) % BER_TX_SEGMENTS;
+		pstTx->ulSegCount++;
+	}
+}
+
+/** ***************************************************************************
+	Name:               BerFormat
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Length of the formatted report
+	Caveats / Effect:   None
+
+	Description:
+	Formats a one line test report: sequence, bytes sent and received over
+	the last reporting interval, the running bit (Mbit) and error counts, the
+	bit error rate, slips and bytes received out of sync. The BER is printed
+	with integer arithmetic as the console printf has no floating point.
+*/
+uint32_t BerFormat(tPrbsCheck const *pstCheck, uint32_t ulOrder,
+	uint32_t ulTxBytes, uint32_t ulRxBytes, char *pcDst, uint32_t ulSize)
+{
+	uint64_t ullNum = pstCheck->ullErrors;
+	uint32_t ulExp = 0;
+	uint32_t ulMant = 0;
+	int iLen;
+
+	/* scale errors/bits to M.MMe-X */
+	if(ullNum && pstCheck->ullBits)
+	{
+		while(ullNum < pstCheck->ullBits)
+		{
+			ullNum *= 10;
+			ulExp++;
+		}
+		ulMant = (uint32_t)((ullNum * 100) / pstCheck->ullBits);
+	}
+
+	iLen = snprintf(pcDst, ulSize,
+		"PRBS-%lu %s tx %lu B rx %lu B Mbit %lu errors %lu ber %lu.%02lue-%lu"
+		" slips %lu unlocked %lu\r\n",
+		(unsigned long)ulOrder,
+		pstCheck->ucLocked ? "locked" : "unlocked",
+		(unsigned long)ulTxBytes,
+		(unsigned long)ulRxBytes,
+		(unsigned long)(pstCheck->ullBits / 1000000UL),
+		(unsigned long)pstCheck->ullErrors,
+		(unsigned long)(ulMant / 100), (unsigned long)(ulMant % 100),
+		(unsigned long)ulExp,
+		(unsigned long)pstCheck->ulSlips,
+		(unsigned long)pstCheck->ulUnlockedBytes);
+
+	if(iLen < 0)
+	{
+		return 0;
+	}
+	return ((uint32_t)iLen < ulSize) ? (uint32_t)iLen : ulSize - 1;
+}
+
+
+/* Module Function Implementations */
+
+
+/***********************  E N D   O F   F I L E  *****************************/
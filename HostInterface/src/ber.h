@@ -0,0 +1,78 @@
+/** ***************************************************************************
+File Name:  ber.h
+
+Project:    Platform 4
+
+Purpose:    Bit error rate test: continuous PRBS transmission and result
+            reporting
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef BER_H
+#define BER_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "dma_buf.h"
+#include "prbs.h"
+
+
+/* Module Definitions */
+
+/* transmit segments, refilled with the sequence as each one is sent */
+#ifndef BER_TX_SEGMENTS
+#define BER_TX_SEGMENTS 4
+#endif
+#ifndef BER_TX_SEGMENT_SIZE
+#define BER_TX_SEGMENT_SIZE 1024
+#endif
+
+
+/* Module Type Definitions */
+
+/* PRBS transmitter: a circular XDMAC descriptor chain over BER_TX_SEGMENTS
+	buffers, each refilled by the ISR once the DMA has moved past it */
+typedef struct
+{
+	uint8_t aaucData[BER_TX_SEGMENTS][BER_TX_SEGMENT_SIZE] DMA_BUF_ALIGNED;
+	/* descriptor chain, in non-cacheable memory (DmaBufAllocNoCache) */
+	lld_view1 *pastDesc;
+	tPrbs stGen;
+	uint32_t ulOrder;
+	uint32_t ulChannel;
+	/* next segment due to be refilled */
+	uint32_t ulNextFill;
+	/* free-running count of segments sent */
+	volatile uint32_t ulSegCount;
+} tBerTx;
+
+
+/* Global Function Declarations */
+
+int BerTxInit(tBerTx *pstTx, uint32_t ulOrder, uint32_t ulChannel,
+	uint32_t ulDstAddr, uint32_t ulPerId);
+void BerTxStart(tBerTx *pstTx);
+void BerTxStop(tBerTx *pstTx);
+void BerTxSegmentDone(tBerTx *pstTx);
+uint32_t BerFormat(tPrbsCheck const *pstCheck, uint32_t ulOrder,
+	uint32_t ulTxBytes, uint32_t ulRxBytes, char *pcDst, uint32_t ulSize);
+
+
+#endif /* BER_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,395 @@
+/** ***************************************************************************
+File Name:  bridge.c
+
+Project:    Platform 4
+
+Purpose:    Zero-copy bridge from a link's receive DMA ring to a USB CDC bulk
+            IN endpoint
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "bridge.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void BridgePollBurst(tBridge *pstBridge);
+static void BridgeSent(udd_ep_status_t status, iram_size_t nb_transfered,
+	udd_ep_id_t ep);
+
+
+/* Module Variable Declarations */
+
+/* CDC data IN endpoint of each port */
+static udd_ep_id_t const aucBridgeEp[UDI_CDC_PORT_NB] = {
+	UDI_CDC_DATA_EP_IN_0,
+#if UDI_CDC_PORT_NB > 1
+	UDI_CDC_DATA_EP_IN_1,
+#endif
+#if UDI_CDC_PORT_NB > 2
+	UDI_CDC_DATA_EP_IN_2,
+#endif
+};
+
+static tBridge astBridge[UDI_CDC_PORT_NB];
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               BridgeStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The link's ring must only be read by the bridge from
+	                    now on; udi_cdc stops using the port's IN endpoint
+
+	Description:
+	Bridges a link to a CDC port: the received byte stream is sent to the host
+	directly out of the receive DMA ring by BridgePoll(), without copying.
+	With a burst buffer (pstBurst not NULL) the data goes through it instead,
+	so it survives the host not reading for a while.
+*/
+void BridgeStart(uint8_t ucPort, tLink *pstLink, tBurst *pstBurst)
+{
+	tBridge *pstBridge = &astBridge[ucPort];
+	irqflags_t flags = cpu_irq_save();
+	/* the port may already have been opened by the host */
+	uint8_t const ucEnabled = pstBridge->ucEnabled;
+
+	memset(pstBridge, 0, sizeof(*pstBridge));
+	pstBridge->ucEp = aucBridgeEp[ucPort];
+	pstBridge->ucEnabled = ucEnabled;
+	pstBridge->ucOpened = ucEnabled;
+	pstBridge->pstBurst = pstBurst;
+	pstBridge->pstLink = pstLink;
+	cpu_irq_restore(flags);
+}
+
+/** ***************************************************************************
+	Name:               BridgePoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the main program loop
+
+	Description:
+	Starts the next bulk IN transfer when the previous one has finished. The
+	transfer points straight at the received data in the ring, and the read
+	count only moves past it in BridgeSent() once the USB DMA has read it.
+	Nothing holds the receive DMA off that span though: it keeps running
+	round the whole ring, so a host that takes longer than one lap of the
+	ring (RX_RING_SIZE bytes at the line rate) to read a transfer gets newer
+	data in it, which BridgeSent() counts in ulLapped. Only whole
+	ring segments are sent while data is flowing; once the line has gone
+	idle at the end of a queued packet, everything up to that point goes out,
+	so transfers stay large.
+	While the host hasn't opened the port received data is thrown away, so
+	the host doesn't get a burst of stale data when it does.
+	With a burst buffer, see BridgePollBurst().
+*/
+void BridgePoll(uint8_t ucPort)
+{
+	tBridge *pstBridge = &astBridge[ucPort];
+	tLink *pstLink = pstBridge->pstLink;
+	tRxRing *pstRing;
+	uint8_t const *pucData;
+	uint32_t ulLen;
+	uint32_t ulEnd;
+
+	if(pstBridge->pstBurst)
+	{
+		BridgePollBurst(pstBridge);
+		return;
+	}
+	if(!pstLink || pstBridge->ulInFlight)
+	{
+		return;
+	}
+	pstRing = &pstLink->stRxRing;
+
+	/* packets that have been sent right up to their end are finished */
+	while(LinkRxPacket(pstLink, &ulEnd)
+		&& ((int32_t)(ulEnd - pstRing->ulReadCount) <= 0))
+	{
+		LinkRxPacketDone(pstLink);
+	}
+
+	ulLen = RxRingPeek(pstRing, &pucData);
+
+	if(!pstBridge->ucEnabled)
+	{
+		RxRingConsume(pstRing, ulLen);
+		pstBridge->ulDiscarded += ulLen;
+		return;
+	}
+
+	if(LinkRxPacket(pstLink, &ulEnd))
+	{
+		/* the line went idle at ulEnd, send everything up to there. If the
+			packet wraps around the ring the next poll sends the rest */
+		if(ulLen > ulEnd - pstRing->ulReadCount)
+		{
+			ulLen = ulEnd - pstRing->ulReadCount;
+		}
+	}
+	else
+	{
+		/* trim to a segment boundary of the ring */
+		ulLen -= (uint32_t)(pucData - pstRing->aucData + ulLen)
+			% RX_RING_SEGMENT_SIZE;
+	}
+	if(ulLen == 0)
+	{
+		return;
+	}
+
+	pstBridge->ulInFlight = ulLen;
+	if(!udd_ep_run(pstBridge->ucEp, false, (uint8_t *)pucData, ulLen,
+		BridgeSent))
+	{
+		/* endpoint halted or not configured, try again later */
+		pstBridge->ulInFlight = 0;
+		return;
+	}
+	pstBridge->ulTransfers++;
+}
+
+/** ***************************************************************************
+	Name:               BridgeGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Bridge state of a port
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to the bridge statistics.
+*/
+tBridge const *BridgeGet(uint8_t ucPort)
+{
+	return &astBridge[ucPort];
+}
+
+/** ***************************************************************************
+	Name:               BridgeOwnsPort
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             true if the bridge drives the port's IN endpoint
+	Caveats / Effect:   Called by udi_cdc (UDI_CDC_TX_DIRECT)
+
+	Description:
+	Keeps udi_cdc from starting its own transfers (including the idle zero
+	length packets) on an endpoint the bridge is using.
+*/
+bool BridgeOwnsPort(uint8_t ucPort)
+{
+	return astBridge[ucPort].pstLink != NULL;
+}
+
+/** ***************************************************************************
+	Name:               BridgeEnable
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             true, the port may be enabled
+	Caveats / Effect:   Called by udi_cdc (UDI_CDC_ENABLE_EXT)
+
+	Description:
+	The host has configured the port, bridged data may flow.
+*/
+bool BridgeEnable(uint8_t ucPort)
+{
+	astBridge[ucPort].ucEnabled = 1;
+	astBridge[ucPort].ucOpened = 1;
+	return true;
+}
+
+/** ***************************************************************************
+	Name:               BridgeDisable
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Called by udi_cdc (UDI_CDC_DISABLE_EXT)
+
+	Description:
+	The host has gone away; any running transfer is aborted by the USB stack
+	and comes back through BridgeSent().
+*/
+void BridgeDisable(uint8_t ucPort)
+{
+	astBridge[ucPort].ucEnabled = 0;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               BridgePollBurst
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Main program loop only
+
+	Description:
+	BridgePoll() for a port fed through a burst buffer. The receive ring is
+	emptied into the buffer on every call, whatever the host is doing, and
+	the next transfer takes everything the buffer holds up to BURST_USB_MAX,
+	so a backlog built up while the host was suspended or re-enumerating
+	drains at full speed. Data is only thrown away before the host first
+	opens the port; after that it is held until the host is back.
+*/
+static void BridgePollBurst(tBridge *pstBridge)
+{
+	tBurst *pstBurst = pstBridge->pstBurst;
+	uint8_t const *pucData;
+	uint32_t ulLen;
+	uint32_t ulEnd;
+
+	BurstFill(pstBurst);
+
+	if(pstBridge->ulInFlight)
+	{
+		return;
+	}
+
+	/* the packet ends are of no use to the host, drop those sent */
+	while(BurstPacket(pstBurst, &ulEnd)
+		&& ((int32_t)(ulEnd - pstBurst->ulReadCount) <= 0))
+	{
+		BurstPacketDone(pstBurst);
+	}
+
+	ulLen = BurstPeek(pstBurst, &pucData);
+
+	if(!pstBridge->ucEnabled)
+	{
+		if(!pstBridge->ucOpened)
+		{
+			BurstConsume(pstBurst, ulLen);
+			pstBridge->ulDiscarded += ulLen;
+		}
+		return;
+	}
+
+	if(ulLen > BURST_USB_MAX)
+	{
+		ulLen = BURST_USB_MAX;
+	}
+	if(ulLen == 0)
+	{
+		return;
+	}
+
+	pstBridge->ulInFlight = ulLen;
+	if(!udd_ep_run(pstBridge->ucEp, false, (uint8_t *)pucData, ulLen,
+		BridgeSent))
+	{
+		/* endpoint halted or not configured, try again later */
+		pstBridge->ulInFlight = 0;
+		return;
+	}
+	pstBridge->ulTransfers++;
+}
+
+/** ***************************************************************************
+	Name:               BridgeSent
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   USB ISR
+
+	Description:
+	Bulk IN transfer completion. The ring's read count moves past the span
+	the transfer was reading from, whether or not the transfer completed. If
+	the receive DMA has by now written more than a lap of the ring past the
+	start of that span, the USB DMA may have sent some of it after it was
+	written over; the transfer is counted in ulLapped rather than in
+	ulBytes, as the host got newer data than it asked for. As the write
+	count only grows, a transfer that passes this check was read intact.
+	Burst buffer data is only released once it has gone out; the USB driver
+	doesn't say how much of an aborted transfer did, so all of it is sent
+	again.
+*/
+static void BridgeSent(udd_ep_status_t status, iram_size_t nb_transfered,
+	udd_ep_id_t ep)
+{
+	uint32_t i;
+
+	for(i = 0; i < UDI_CDC_PORT_NB; i++)
+	{
+		tBridge *pstBridge = &astBridge[i];
+
+		if((pstBridge->ucEp == ep) && pstBridge->ulInFlight)
+		{
+			if(status != UDD_EP_TRANSFER_OK)
+			{
+				pstBridge->ulAborts++;
+			}
+			if(!pstBridge->pstBurst)
+			{
+				tRxRing *pstRing = &pstBridge->pstLink->stRxRing;
+
+				if(status == UDD_EP_TRANSFER_OK)
+				{
+					if((int32_t)(RxRingGetWriteCount(pstRing)
+						- pstRing->ulReadCount) > (int32_t)RX_RING_SIZE)
+					{
+						pstBridge->ulLapped++;
+					}
+					else
+					{
+						pstBridge->ulBytes += nb_transfered;
+					}
+				}
+				RxRingConsume(pstRing, pstBridge->ulInFlight);
+			}
+			else if(status == UDD_EP_TRANSFER_OK)
+			{
+				pstBridge->ulBytes += nb_transfered;
+				BurstConsume(pstBridge->pstBurst, pstBridge->ulInFlight);
+			}
+			pstBridge->ulInFlight = 0;
+			break;
+		}
+	}
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
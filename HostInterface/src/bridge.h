@@ -0,0 +1,78 @@
+/** ***************************************************************************
+File Name:  bridge.h
+
+Project:    Platform 4
+
+Purpose:    Zero-copy bridge from a link's receive DMA ring to a USB CDC bulk
+            IN endpoint
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "burst.h"
+#include "link.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* bridge state of one CDC port */
+typedef struct
+{
+	/* link whose receive ring feeds the port, NULL if not bridged, and the
+		burst buffer the data goes through, NULL if it is sent straight out
+		of the ring */
+	tLink *pstLink;
+	tBurst *pstBurst;
+	/* CDC data IN endpoint of the port */
+	udd_ep_id_t ucEp;
+	/* the host has the port open, and has opened it at least once */
+	volatile uint8_t ucEnabled;
+	volatile uint8_t ucOpened;
+	/* bytes of the ring or burst buffer handed to the endpoint, 0 if no
+		transfer is running */
+	volatile uint32_t ulInFlight;
+	/* statistics. ulLapped counts ring transfers the receive DMA may have
+		written over before the USB DMA read them, whose bytes aren't in
+		ulBytes */
+	uint32_t ulTransfers;
+	volatile uint32_t ulBytes;
+	volatile uint32_t ulAborts;
+	volatile uint32_t ulLapped;
+	uint32_t ulDiscarded;
+} tBridge;
+
+
+/* Global Function Declarations */
+
+void BridgeStart(uint8_t ucPort, tLink *pstLink, tBurst *pstBurst);
+void BridgePoll(uint8_t ucPort);
+tBridge const *BridgeGet(uint8_t ucPort);
+
+/* BridgeOwnsPort(), BridgeEnable() and BridgeDisable() are the udi_cdc hooks
+	and are declared in conf_usb.h */
+
+
+#endif /* BRIDGE_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
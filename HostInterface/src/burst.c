@@ -0,0 +1,327 @@
+/** ***************************************************************************
+File Name:  burst.c
+
+Project:    Platform 4
+
+Purpose:    Burst buffer: holds a link's received data in the external SDRAM
+            while whatever forwards it stalls, and hands it on in order
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "burst.h"
+#include "dma_buf.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void BurstCopy(tBurst *pstBurst, uint8_t const *pucData,
+	uint32_t ulLen);
+static void BurstMarkEnd(tBurst *pstBurst);
+
+
+/* Module Variable Declarations */
+
+static tBurst astBurst[LINK_COUNT];
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               BurstStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             The link's burst buffer
+	Caveats / Effect:   The SDRAM must be up (SdramInit()). The link's ring
+	                    must only be read by BurstFill() from now on
+
+	Description:
+	Sets up the burst buffer of link ulIndex in its share of the SDRAM,
+	empty. BurstFill() moves the received data into it and the consumer
+	takes it out with BurstPeek() and BurstConsume(), much as it would from
+	the receive ring.
+*/
+tBurst *BurstStart(uint32_t ulIndex, tLink *pstLink)
+{
+	tBurst *pstBurst = &astBurst[ulIndex];
+	uint8_t *const pucBase = (uint8_t *)BOARD_SDRAM_ADDR
+		+ ulIndex * BURST_LINK_SPAN;
+
+	memset(pstBurst, 0, sizeof(*pstBurst));
+	pstBurst->pstLink = pstLink;
+	pstBurst->pucData = pucBase;
+	pstBurst->pulPktEnd = (uint32_t *)(pucBase + BURST_SIZE);
+	return pstBurst;
+}
+
+/** ***************************************************************************
+	Name:               BurstFill
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the main program loop, whether or not the
+	                    consumer is stalled
+
+	Description:
+	Empties the link's receive ring into the burst buffer, noting where each
+	packet ended. The ring only holds a few milliseconds of data; the burst
+	buffer holds seconds of it. While data is flowing only whole ring
+	segments are moved, and once the line has gone idle at the end of a
+	queued packet everything up to that point, so the consumer sees data
+	arrive in the same steps it would from the ring.
+	When the buffer is full the newest data is dropped, so what it holds
+	stays in one piece.
+*/
+void BurstFill(tBurst *pstBurst)
+{
+	tLink *pstLink = pstBurst->pstLink;
+	tRxRing *pstRing = &pstLink->stRxRing;
+	uint8_t const *pucData;
+	uint32_t ulLen;
+	uint32_t ulEnd;
+
+	for(;;)
+	{
+		uint8_t ucPktEnd = 0;
+
+		ulLen = RxRingPeek(pstRing, &pucData);
+
+		if(LinkRxPacket(pstLink, &ulEnd))
+		{
+			/* the line went idle at ulEnd, move everything up to there. A
+				packet the ring has already skipped past (overrun) just
+				ends here */
+			if((int32_t)(ulEnd - pstRing->ulReadCount) <= 0)
+			{
+				ulLen = 0;
+				ucPktEnd = 1;
+			}
+			else if(ulLen >= ulEnd - pstRing->ulReadCount)
+			{
+				ulLen = ulEnd - pstRing->ulReadCount;
+				ucPktEnd = 1;
+			}
+		}
+		else
+		{
+			/* trim to a segment boundary of the ring */
+			ulLen -= (uint32_t)(pucData - pstRing->aucData + ulLen)
+				% RX_RING_SEGMENT_SIZE;
+		}
+
+		if((ulLen == 0) && !ucPktEnd)
+		{
+			return;
+		}
+
+		BurstCopy(pstBurst, pucData, ulLen);
+		RxRingConsume(pstRing, ulLen);
+		if(ucPktEnd)
+		{
+			LinkRxPacketDone(pstLink);
+			BurstMarkEnd(pstBurst);
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               BurstPeek
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of contiguous bytes available at *ppucData
+	Caveats / Effect:   None
+
+	Description:
+	Returns the largest contiguous run of data in the buffer. Data wrapping
+	past the end of the buffer is returned by the next call once the first
+	part has been consumed. The data has been written back from the cache,
+	so a DMA can read it directly.
+*/
+uint32_t BurstPeek(tBurst *pstBurst, uint8_t const **ppucData)
+{
+	uint32_t const ulRead = pstBurst->ulReadCount;
+	uint32_t const ulOffset = ulRead % BURST_SIZE;
+	uint32_t const ulLen = pstBurst->ulWriteCount - ulRead;
+
+	*ppucData = &pstBurst->pucData[ulOffset];
+	return (ulLen < BURST_SIZE - ulOffset) ? ulLen : (BURST_SIZE - ulOffset);
+}
+
+/** ***************************************************************************
+	Name:               BurstConsume
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   May be called from an ISR, by the one consumer
+
+	Description:
+	Releases ulLen bytes previously returned by BurstPeek().
+*/
+void BurstConsume(tBurst *pstBurst, uint32_t ulLen)
+{
+	pstBurst->ulReadCount += ulLen;
+}
+
+/** ***************************************************************************
+	Name:               BurstPacket
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             1 if a packet end is queued, 0 if not
+	Caveats / Effect:   Main program loop only
+
+	Description:
+	Returns in *pulEnd the oldest packet end, as a free-running byte count for
+	comparison with ulReadCount. It stays queued until BurstPacketDone().
+*/
+int BurstPacket(tBurst const *pstBurst, uint32_t *pulEnd)
+{
+	if(pstBurst->ulPktTail == pstBurst->ulPktHead)
+	{
+		return 0;
+	}
+	*pulEnd = pstBurst->pulPktEnd[pstBurst->ulPktTail % BURST_PKT_ENDS];
+	return 1;
+}
+
+/** ***************************************************************************
+	Name:               BurstPacketDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Main program loop only; a packet end must be queued
+
+	Description:
+	Removes the oldest packet end once the data up to it has been dealt with.
+*/
+void BurstPacketDone(tBurst *pstBurst)
+{
+	pstBurst->ulPktTail++;
+}
+
+/** ***************************************************************************
+	Name:               BurstGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Burst buffer of a link
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to the burst buffer statistics.
+*/
+tBurst const *BurstGet(uint32_t ulIndex)
+{
+	return &astBurst[ulIndex];
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               BurstCopy
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Appends ulLen bytes to the buffer, or drops them all if they don't fit.
+	The copy is written back from the cache before it is made visible to
+	the consumer.
+*/
+static void BurstCopy(tBurst *pstBurst, uint8_t const *pucData,
+	uint32_t ulLen)
+{
+	uint32_t const ulUsed = pstBurst->ulWriteCount - pstBurst->ulReadCount;
+	uint32_t const ulOffset = pstBurst->ulWriteCount % BURST_SIZE;
+	uint32_t ulFirst;
+
+	if(ulLen == 0)
+	{
+		return;
+	}
+	if(ulLen > BURST_SIZE - ulUsed)
+	{
+		pstBurst->ulLostBytes += ulLen;
+		return;
+	}
+
+	ulFirst = (ulLen < BURST_SIZE - ulOffset) ? ulLen : (BURST_SIZE - ulOffset);
+	memcpy(&pstBurst->pucData[ulOffset], pucData, ulFirst);
+	DmaBufClean(&pstBurst->pucData[ulOffset], ulFirst);
+	if(ulFirst < ulLen)
+	{
+		memcpy(pstBurst->pucData, pucData + ulFirst, ulLen - ulFirst);
+		DmaBufClean(pstBurst->pucData, ulLen - ulFirst);
+	}
+
+	pstBurst->ulWriteCount += ulLen;
+	if(ulUsed + ulLen > pstBurst->ulHighWater)
+	{
+		pstBurst->ulHighWater = ulUsed + ulLen;
+	}
+}
+
+/** ***************************************************************************
+	Name:               BurstMarkEnd
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Queues a packet end at the current end of the data. When the queue is
+	full the end is forgotten, and the packet runs on into the next one.
+*/
+static void BurstMarkEnd(tBurst *pstBurst)
+{
+	if(pstBurst->ulPktHead - pstBurst->ulPktTail >= BURST_PKT_ENDS)
+	{
+		pstBurst->ulPktOverflows++;
+		return;
+	}
+	pstBurst->pulPktEnd[pstBurst->ulPktHead % BURST_PKT_ENDS] =
+		pstBurst->ulWriteCount;
+	pstBurst->ulPktHead++;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,88 @@
+/** ***************************************************************************
+File Name:  burst.h
+
+Project:    Platform 4
+
+Purpose:    Burst buffer: holds a link's received data in the external SDRAM
+            while whatever forwards it stalls, and hands it on in order
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef BURST_H
+#define BURST_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "conf_burst.h"
+#include "link.h"
+
+
+/* Module Definitions */
+
+/* SDRAM taken by each link: its data followed by its 32 bit packet ends */
+#define BURST_LINK_SPAN      (BURST_SIZE + BURST_PKT_ENDS * 4UL)
+
+#if (BURST_SIZE & (BURST_SIZE - 1)) || (BURST_PKT_ENDS & (BURST_PKT_ENDS - 1))
+#error "BURST_SIZE and BURST_PKT_ENDS must be powers of two"
+#endif
+#if LINK_COUNT * BURST_LINK_SPAN > BOARD_SDRAM_SIZE
+#error "the burst buffers of all links don't fit in the SDRAM"
+#endif
+
+
+/* Module Type Definitions */
+
+/* burst buffer of one link. The data is a byte stream, like the receive
+	ring it is copied from, with the ends of the received packets kept
+	alongside it. ulWriteCount and ulPktHead are only written by BurstFill()
+	(main loop), ulReadCount and ulPktTail only by the consumer; all are
+	free-running counts */
+typedef struct
+{
+	/* link whose receive ring fills the buffer */
+	tLink *pstLink;
+	/* BURST_SIZE bytes of data and BURST_PKT_ENDS packet ends, in the
+		SDRAM */
+	uint8_t *pucData;
+	uint32_t *pulPktEnd;
+	uint32_t ulWriteCount;
+	volatile uint32_t ulReadCount;
+	uint32_t ulPktHead;
+	uint32_t ulPktTail;
+	/* statistics: the most data ever held, bytes dropped because the buffer
+		was full, and packet ends that didn't fit */
+	uint32_t ulHighWater;
+	uint32_t ulLostBytes;
+	uint32_t ulPktOverflows;
+} tBurst;
+
+
+/* Global Function Declarations */
+
+tBurst *BurstStart(uint32_t ulIndex, tLink *pstLink);
+void BurstFill(tBurst *pstBurst);
+uint32_t BurstPeek(tBurst *pstBurst, uint8_t const **ppucData);
+void BurstConsume(tBurst *pstBurst, uint32_t ulLen);
+int BurstPacket(tBurst const *pstBurst, uint32_t *pulEnd);
+void BurstPacketDone(tBurst *pstBurst);
+tBurst const *BurstGet(uint32_t ulIndex);
+
+
+#endif /* BURST_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -41,4 +41,29 @@
 #define CONF_BOARD_UART_CONSOLE
 #define CONF_BOARD_USB_PORT
 
+// Run with the data cache on; DMA buffers are kept coherent by dma_buf.c
+#define CONF_BOARD_ENABLE_CACHE_AT_INIT
+
+// MPU memory map, with the top 4 KB of SRAM non-cacheable for DMA
+// descriptors (the linker script reserves it as .ram_nocache)
+#define CONF_BOARD_CONFIG_MPU_AT_INIT
+#define MPU_HAS_NOCACHE_REGION
+
+// 64 KB each of ITCM and DTCM for the ISRs and receive path (tcm.h)
+#define CONF_BOARD_ENABLE_TCM_AT_INIT
+
+// Additional data channel links (see conf_link.h)
+//#define CONF_BOARD_USART0
+//#define CONF_BOARD_USART2
+
+// Ethernet over the RMII PHY (see conf_net.h); its management clock takes
+// the LED pin
+//#define CONF_BOARD_GMAC
+
+// SD card on the HSMCI (see conf_rec.h)
+//#define CONF_BOARD_SD
+
+// Serial NOR flash on the QSPI (see conf_qlog.h)
+//#define CONF_BOARD_QSPI
+
 #endif /* CONF_BOARD_H_INCLUDED */
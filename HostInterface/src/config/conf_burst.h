@@ -0,0 +1,41 @@
+/** ***************************************************************************
+File Name:  conf_burst.h
+
+Project:    Platform 4
+
+Purpose:    Burst buffer configuration: the share of the external SDRAM
+            each link's received data is held in while its consumer stalls
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CONF_BURST_H
+#define CONF_BURST_H
+
+/* received data held for each link, a power of two. 16 MB is at least 8
+	seconds at 14.4 Mbaud. Link N's buffer starts N * BURST_LINK_SPAN (burst.h)
+	into the SDRAM */
+#define BURST_SIZE                (16UL * 1024 * 1024)
+
+/* packet ends remembered for each link, a power of two. They are kept in
+	the SDRAM after the data, so a long stall doesn't merge packets */
+#define BURST_PKT_ENDS            65536
+
+/* largest USB transfer out of a burst buffer. Once the host is back a
+	backlog drains in transfers of this size */
+#define BURST_USB_MAX             (64UL * 1024)
+
+#endif /* CONF_BURST_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -60,13 +60,19 @@
 //#define CONFIG_SYSCLK_PRES          SYSCLK_PRES_3
 
 // ===== System Clock (MCK) Division Options     (Fmck = Fhclk / (SYSCLK_DIV))
-#define CONFIG_SYSCLK_DIV            1
+#define CONFIG_SYSCLK_DIV            2
 
 // ===== PLL0 (A) Options   (Fpll = (Fclk * PLL_mul) / PLL_div)
 // Use mul and div effective values here.
+// 230.4 MHz is the fastest PLLA that divides exactly to the default 14.4
+// Mbaud of the links (LINK_BAUD in conf_link.h). For a 300 MHz core use
+// 75 / 4 instead; the links then run at 15 Mbaud from the UPLL, or another
+// rate in the clock plan in link.c, and both ends of each link must change.
 #define CONFIG_PLL0_SOURCE          PLL_SRC_MAINCK_XTAL
-#define CONFIG_PLL0_MUL             36
+#define CONFIG_PLL0_MUL             72
 #define CONFIG_PLL0_DIV             5
+//#define CONFIG_PLL0_MUL             75
+//#define CONFIG_PLL0_DIV             4
 
 // ===== UPLL (UTMI) Hardware fixed at 480 MHz.
 
@@ -80,11 +86,15 @@
 // - XTAL frequency: 16 MHz
 // - System clock source: PLLA
 // - System clock prescaler: 1
-// - System clock divider: 1
-// - PLLA source: BYPASS
-// - PLLA output: BYPASS * 36 / 5
-// - Processor clock: 16 * 36 / 5 / 1 = 115.2 MHz
-// - System clock: 115.2 / 1 = 115.2 MHz
+// - System clock divider: 2
+// - PLLA source: XTAL
+// - PLLA output: XTAL * 72 / 5
+// - Processor clock: 16 * 72 / 5 / 1 = 230.4 MHz
+// - System clock: 230.4 / 2 = 115.2 MHz
+// ===== Target frequency (Link USARTs)
+// - The USARTs are clocked from PCK4, not MCK, see the clock plan in link.c
+// - PCK4 source: UPLL (480 MHz) or PLLA (230.4 MHz), divided down to 8 * baud
+// - 14.4 Mbaud: PLLA / 2 = 115.2 MHz
 // ===== Target frequency (USB Clock)
 // - USB clock source: UPLL
 // - USB clock divider: 1 (not divided)
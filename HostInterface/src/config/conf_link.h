@@ -0,0 +1,106 @@
+/** ***************************************************************************
+File Name:  conf_link.h
+
+Project:    Platform 4
+
+Purpose:    Data channel link configuration: which USARTs carry Manchester
+            links and the XDMAC channels serving each of them
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CONF_LINK_H
+#define CONF_LINK_H
+
+/* number of links in use, 1 to 3. Links are numbered from 0 and link 0 is
+	always present. The pins of links 1 and 2 are only set up by board_init()
+	if CONF_BOARD_USART0 / CONF_BOARD_USART2 are defined in conf_board.h
+	Note: USART2 shares its pins with the SDRAM controller */
+#define LINK_COUNT           1
+
+/* default line rate of every link. The USARTs are clocked from PCK4 rather
+	than MCK, so only the rates in the clock plan in link.c are available; all
+	links share PCK4 and so run at the same rate. 14.4 Mbaud needs the
+	230.4 MHz PLLA of conf_clock.h */
+#define LINK_BAUD            14400000UL
+
+/* Manchester framing of every character. The transmitter sends a preamble
+	of LINK_MAN_PREAMBLE_LEN bit periods (0 to 15) of LINK_MAN_PREAMBLE_PATTERN
+	(LINK_MAN_PP_x) and then the start frame delimiter, and the receiver only
+	accepts a character after the same preamble and delimiter, so the decoder
+	is locked before the first data bit and line settling can't produce or
+	swallow characters. Both ends of a link must use the same settings.
+	The preamble is sent ahead of every character, so each bit period of it
+	costs throughput; the data sync delimiter is itself 3 bit periods long.
+	A preamble changes the format on the wire: units without one can't
+	receive from this end or be received by it, and 4 bit periods cost a
+	quarter of the byte rate. It is off (0) by default, which is what units
+	that predate it use; only turn it on at both ends of a link together,
+	and 0 brings back the 2 byte lead in (TX_LEAD_IN in main.c) */
+#define LINK_MAN_PP_ALL_ONE       0
+#define LINK_MAN_PP_ALL_ZERO      1
+#define LINK_MAN_PP_ZERO_ONE      2
+#define LINK_MAN_PP_ONE_ZERO      3
+#define LINK_MAN_PREAMBLE_LEN     0
+#define LINK_MAN_PREAMBLE_PATTERN LINK_MAN_PP_ALL_ONE
+
+/* start frame delimiter: LINK_MAN_SFD_DATA_SYNC, a 3 bit period pattern that
+	breaks the Manchester coding rules so it can't occur in data, or
+	LINK_MAN_SFD_ONE_BIT, a plain start bit */
+#define LINK_MAN_SFD_DATA_SYNC    0
+#define LINK_MAN_SFD_ONE_BIT      1
+#define LINK_MAN_SFD              LINK_MAN_SFD_DATA_SYNC
+
+/* Manchester drift compensation, for clocks that wander against the far
+	end's. It needs 16x oversampling, i.e. PCK4 = 16 * baud <= MCK, which
+	rules out the rates above 7.5 Mbaud in the clock plan */
+#define LINK_MAN_DRIFT            0
+
+/* shortest idle time the far end leaves between transmissions, in
+	microseconds. The receiver timeout that marks the end of a packet is set
+	to half of it, so a packet is complete a few microseconds after its last
+	character rather than after a fixed 65535 bit periods */
+#define LINK_FRAME_GAP_US         10
+
+/* link 0: USART1 */
+#define LINK0_USART          USART1
+#define LINK0_USART_ID       ID_USART1
+#define LINK0_IRQn           USART1_IRQn
+#define LINK0_HANDLER        USART1_Handler
+#define LINK0_DMA_RX         DMA_CHANNEL_RX
+#define LINK0_DMA_TX         DMA_CHANNEL_TX
+#define LINK0_HWID_RX        XDMAC_CHANNEL_HWID_USART1_RX
+#define LINK0_HWID_TX        XDMAC_CHANNEL_HWID_USART1_TX
+
+/* link 1: USART0 */
+#define LINK1_USART          USART0
+#define LINK1_USART_ID       ID_USART0
+#define LINK1_IRQn           USART0_IRQn
+#define LINK1_HANDLER        USART0_Handler
+#define LINK1_DMA_RX         DMA_CHANNEL_LINK1_RX
+#define LINK1_DMA_TX         DMA_CHANNEL_LINK1_TX
+#define LINK1_HWID_RX        XDMAC_CHANNEL_HWID_USART0_RX
+#define LINK1_HWID_TX        XDMAC_CHANNEL_HWID_USART0_TX
+
+/* link 2: USART2 */
+#define LINK2_USART          USART2
+#define LINK2_USART_ID       ID_USART2
+#define LINK2_IRQn           USART2_IRQn
+#define LINK2_HANDLER        USART2_Handler
+#define LINK2_DMA_RX         DMA_CHANNEL_LINK2_RX
+#define LINK2_DMA_TX         DMA_CHANNEL_LINK2_TX
+#define LINK2_HWID_RX        XDMAC_CHANNEL_HWID_USART2_RX
+#define LINK2_HWID_TX        XDMAC_CHANNEL_HWID_USART2_TX
+
+#endif /* CONF_LINK_H */
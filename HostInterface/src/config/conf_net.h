@@ -0,0 +1,52 @@
+/** ***************************************************************************
+File Name:  conf_net.h
+
+Project:    Platform 4
+
+Purpose:    Ethernet configuration: addresses, UDP streaming destination,
+            PHY and descriptor ring sizes
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CONF_NET_H
+#define CONF_NET_H
+
+/* MAC address of the board. Locally administered; give every board on a
+	network its own */
+#define NET_MAC_ADDR              { 0x02, 0x4F, 0x53, 0x00, 0x00, 0x01 }
+
+/* IPv4 address, netmask and default gateway, most significant byte first */
+#define NET_IP_ADDR               NET_IP(192, 168, 1, 50)
+#define NET_IP_MASK               NET_IP(255, 255, 255, 0)
+#define NET_IP_GATEWAY            NET_IP(192, 168, 1, 1)
+
+/* received link data is streamed to this host, link N to UDP port
+	NET_UDP_PORT + N, from the same source port. NET_IP(255, 255, 255, 255)
+	broadcasts it on the local network instead */
+#define NET_UDP_DEST_ADDR         NET_IP(192, 168, 1, 10)
+#define NET_UDP_PORT              5000
+
+/* address of the PHY on the management interface */
+#define NET_PHY_ADDR              0
+
+/* receive buffers of NET_RX_BUF_SIZE bytes, each holding a whole frame, and
+	transmit descriptors. A frame sent from the link rings takes two
+	transmit descriptors, its headers and its payload */
+#define NET_RX_DESCS              8
+#define NET_TX_DESCS              16
+
+#endif /* CONF_NET_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,59 @@
+/** ***************************************************************************
+File Name:  conf_pps.h
+
+Project:    Platform 4
+
+Purpose:    PPS time base configuration: PPS source, the limits used to
+            accept PPS edges, the servo lock thresholds and the PPS output
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CONF_PPS_H
+#define CONF_PPS_H
+
+/* PPS input routed to TIOA7 by PIN_PPS_SELECT: PPS_SELECT_GPS or
+	PPS_SELECT_EXT */
+#define PPS_SOURCE                PPS_SELECT_GPS
+
+/* largest error of a PPS edge against the measured second, in parts per
+	million of the time since the last accepted edge. Edges further out are
+	counted as glitches and ignored */
+#define PPS_TOLERANCE_PPM         200
+
+/* seconds without an accepted edge before the PPS counts as lost. The time
+	base then holds over on its last frequency and drift estimate, and the
+	next edge that doesn't fit them is taken as a new reference */
+#define PPS_LOST_SECONDS          3
+
+/* the servo reports lock (PPS_LOCK_IND) once PPS_LOCK_EDGES edges in a row
+	are within PPS_LOCK_NS of the disciplined time, and drops it on the first
+	edge further out than four times that */
+#define PPS_LOCK_NS               1000
+#define PPS_LOCK_EDGES            8
+
+/* while acquiring, a phase error larger than this is stepped out at once
+	instead of being slewed */
+#define PPS_STEP_NS               10000
+
+/* PPS output on TIOA8: a PPS_OUT_WIDTH_MS long pulse rising at the start of
+	every second of the disciplined time, once the servo has locked. It
+	carries on through holdover and stops while the servo is acquiring or
+	free running */
+#define PPS_OUT_ENABLE            1
+#define PPS_OUT_WIDTH_MS          100
+
+#endif /* CONF_PPS_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
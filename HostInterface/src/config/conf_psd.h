@@ -0,0 +1,48 @@
+/** ***************************************************************************
+File Name:  conf_psd.h
+
+Project:    Platform 4
+
+Purpose:    Spectrum configuration: the samples in the frame payloads and
+            how they are reduced to power spectral densities
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CONF_PSD_H
+#define CONF_PSD_H
+
+/* frame payloads are signed 16 bit little endian samples at this rate,
+	which the far end doesn't send; it only scales the densities to per Hz */
+#define PSD_SAMPLE_RATE_HZ        48000UL
+
+/* samples per FFT segment, a power of two from 32 to 4096. The spectra
+	have PSD_FFT_SIZE / 2 + 1 bins, PSD_SAMPLE_RATE_HZ / PSD_FFT_SIZE apart */
+#define PSD_FFT_SIZE              1024
+
+/* samples each segment shares with the one before it. Half the segment
+	suits the Hann window; 0 gives back to back segments */
+#define PSD_OVERLAP               (PSD_FFT_SIZE / 2)
+
+/* segments averaged into each spectrum. A spectrum goes out every
+	(PSD_FFT_SIZE - PSD_OVERLAP) * PSD_AVERAGES samples */
+#define PSD_AVERAGES              64
+
+/* finished spectra of each link that can wait for the USB host; with none
+	free a new one is dropped */
+#define PSD_OUT_BUFS              2
+
+#endif /* CONF_PSD_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,50 @@
+/** ***************************************************************************
+File Name:  conf_qlog.h
+
+Project:    Platform 4
+
+Purpose:    Flash log configuration: the QSPI serial NOR flash and the part
+            of it the post-mortem log is kept in
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CONF_QLOG_H
+#define CONF_QLOG_H
+
+/* QSPI clock, the highest rate at or below this MCK divides down to. Reads
+	use the dual output fast read (3Bh), which serial NOR flashes support
+	without their quad mode having to be enabled first */
+#define QSPI_CLOCK_HZ             50000000UL
+
+/* XDMAC channel of the page programs */
+#define QSPI_DMA_CHANNEL          DMA_CHANNEL_QSPI
+
+/* the log is kept in QLOG_SECTORS 4 KB sectors from QLOG_FIRST_SECTOR,
+	whatever was there is erased. QLOG_SECTORS 0 takes the rest of the
+	flash; at least 3 are needed, one is always kept erased ahead */
+#define QLOG_FIRST_SECTOR         0
+#define QLOG_SECTORS              0
+
+/* 256 byte pages staged in memory. One is filled while the rest wait for
+	the flash; with none free new records are dropped */
+#define QLOG_PAGE_BUFS            4
+
+/* a partly filled page goes to the flash once it is this old, so little is
+	lost to a reset when the log is quiet */
+#define QLOG_FLUSH_SECONDS        5
+
+#endif /* CONF_QLOG_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,57 @@
+/** ***************************************************************************
+File Name:  conf_rec.h
+
+Project:    Platform 4
+
+Purpose:    SD card recorder configuration: card clock, the part of the card
+            recorded to, the log layout and the staging buffers
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CONF_REC_H
+#define CONF_REC_H
+
+/* HSMCI clock after identification. Cards that support high speed mode are
+	switched to it and clocked at SD_HS_CLOCK_HZ instead. The bus is one bit
+	wide (MCDA2 shares PA26 with the 600 kHz sync output) */
+#define SD_CLOCK_HZ               25000000UL
+#define SD_HS_CLOCK_HZ            50000000UL
+
+/* XDMAC channel of the card writes */
+#define SD_DMA_CHANNEL            DMA_CHANNEL_SD
+
+/* the card is recorded to as a raw partition from block REC_FIRST_BLOCK up
+	to REC_BENCH_BLOCKS before its end; whatever was there is overwritten.
+	The last REC_BENCH_BLOCKS blocks are scratch space for RecBench() */
+#define REC_FIRST_BLOCK           2048
+#define REC_BENCH_BLOCKS          8192
+
+/* the log is written in chunks of REC_CHUNK_BLOCKS blocks, each as one
+	multi-block write, and every REC_INDEX_CHUNKS chunks (see rec.h) are
+	followed by an index block */
+#define REC_CHUNK_BLOCKS          32
+
+/* chunks staged in memory. One is filled while the rest wait for the card,
+	which rides out write stalls of up to (REC_STAGES - 1) chunks' worth of
+	received data */
+#define REC_STAGES                6
+
+/* a partly filled chunk goes to the card once it is this old, so a quiet
+	link doesn't leave data in memory */
+#define REC_FLUSH_SECONDS         2
+
+#endif /* CONF_REC_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -45,8 +45,13 @@
  */
 
 //! Device definition (mandatory)
+//! The device is a composite (CDC through an IAD on interfaces 0 and 1,
+//! vendor bulk on interface 2), so it must not use the plain CDC PID: the
+//! INF binds that to the whole device, and usbser.sys would take the vendor
+//! interface as well. atmel_devices_cdc.inf binds this PID's MI_00 only,
+//! leaving interface 2 to WinUSB or libusb (tools/stream_reader.c)
 #define  USB_DEVICE_VENDOR_ID             USB_VID_ATMEL
-#define  USB_DEVICE_PRODUCT_ID            USB_PID_ATMEL_ASF_CDC
+#define  USB_DEVICE_PRODUCT_ID            USB_PID_ATMEL_ASF_VENDOR_CLASS
 #define  USB_DEVICE_MAJOR_VERSION         1
 #define  USB_DEVICE_MINOR_VERSION         0
 #define  USB_DEVICE_POWER                 100 // Consumption on Vbus line (mA)
@@ -110,8 +115,10 @@
 #define  UDI_CDC_PORT_NB 1
 
 //! Interface callback definition
-#define  UDI_CDC_ENABLE_EXT(port) true
-#define  UDI_CDC_DISABLE_EXT(port) UNUSED(port)
+#define  UDI_CDC_ENABLE_EXT(port) BridgeEnable(port)
+extern bool BridgeEnable(uint8_t port);
+#define  UDI_CDC_DISABLE_EXT(port) BridgeDisable(port)
+extern void BridgeDisable(uint8_t port);
 #define  UDI_CDC_RX_NOTIFY(port)
 #define  UDI_CDC_TX_EMPTY_NOTIFY(port)
 #define  UDI_CDC_SET_CODING_EXT(port,cfg)
@@ -133,9 +140,21 @@
 // #define  UDI_CDC_SET_RTS_EXT(port,set) my_callback_cdc_set_rts(port,set)
 // extern void my_callback_cdc_set_rts(uint8_t port, bool b_enable);
 
+//! The application sends the IN data of a port itself with udd_ep_run()
+//! (see bridge.c), udi_cdc leaves the endpoint alone while this is true
+#define  UDI_CDC_TX_DIRECT(port) BridgeOwnsPort(port)
+extern bool BridgeOwnsPort(uint8_t port);
+
 //! Define it when the transfer CDC Device to Host is a low rate (<512000 bauds)
 //! to reduce CDC buffers size
-#define  UDI_CDC_LOW_RATE
+// #define  UDI_CDC_LOW_RATE
+
+//! Device to host buffering: UDI_CDC_TX_QUEUE_DEPTH buffers per port of
+//! UDI_CDC_TX_BUFFERS bytes each. Full buffers are sent back to back without
+//! waiting for the next micro-frame, so keep the size a multiple of the high
+//! speed packet size (512).
+#define  UDI_CDC_TX_BUFFERS               (4*UDI_CDC_DATA_EPS_HS_SIZE)
+#define  UDI_CDC_TX_QUEUE_DEPTH           4
 
 //! Default configuration of communication port
 #define  UDI_CDC_DEFAULT_RATE             115200
@@ -146,13 +165,74 @@
 //@}
 
 
+/**
+ * Configuration of the vendor bulk streaming interface (usb_stream.c)
+ * @{
+ */
+#define  USB_STREAM_EP_IN                 (4 | USB_EP_DIR_IN)
+#define  USB_STREAM_EP_OUT                (5 | USB_EP_DIR_OUT)
+#define  USB_STREAM_IFACE_NUMBER          2
+//@}
+
+
+/**
+ * Description of Composite Device
+ * @{
+ */
+//! USB Interfaces descriptor structure
+#define UDI_COMPOSITE_DESC_T \
+	usb_iad_desc_t udi_cdc_iad; \
+	udi_cdc_comm_desc_t udi_cdc_comm; \
+	udi_cdc_data_desc_t udi_cdc_data; \
+	tUsbStreamDesc usb_stream
+
+//! USB Interfaces descriptor value for Full Speed
+#define UDI_COMPOSITE_DESC_FS \
+	.udi_cdc_iad               = UDI_CDC_IAD_DESC_0, \
+	.udi_cdc_comm              = UDI_CDC_COMM_DESC_0, \
+	.udi_cdc_data              = UDI_CDC_DATA_DESC_0_FS, \
+	.usb_stream                = USB_STREAM_DESC_FS
+
+//! USB Interfaces descriptor value for High Speed
+#define UDI_COMPOSITE_DESC_HS \
+	.udi_cdc_iad               = UDI_CDC_IAD_DESC_0, \
+	.udi_cdc_comm              = UDI_CDC_COMM_DESC_0, \
+	.udi_cdc_data              = UDI_CDC_DATA_DESC_0_HS, \
+	.usb_stream                = USB_STREAM_DESC_HS
+
+//! USB Interface APIs
+#define UDI_COMPOSITE_API \
+	&udi_api_cdc_comm, \
+	&udi_api_cdc_data, \
+	&udi_api_stream
+
+//! Endpoint control size
+#define  USB_DEVICE_EP_CTRL_SIZE          64
+
+//! CDC endpoints and interfaces
+#define  UDI_CDC_DATA_EP_IN_0             (1 | USB_EP_DIR_IN)  // TX
+#define  UDI_CDC_DATA_EP_OUT_0            (2 | USB_EP_DIR_OUT) // RX
+#define  UDI_CDC_COMM_EP_0                (3 | USB_EP_DIR_IN)  // Notify endpoint
+#define  UDI_CDC_COMM_IFACE_NUMBER_0      0
+#define  UDI_CDC_DATA_IFACE_NUMBER_0      1
+
+//! Total number of interfaces and endpoints (CDC + stream)
+#define  USB_DEVICE_NB_INTERFACE          3
+#define  USB_DEVICE_MAX_EP                5
+//@}
+
+
 /**
  * USB Device Driver Configuration
  * @{
  */
+//! The bulk endpoints are double banked, except the little used CDC OUT
+//! endpoint, to keep all the endpoints within the 4 KB of USBHS DPRAM
+#define  UDD_BULK_NB_BANK(ep)             (((ep) == 2) ? 1 : 2)
 //@}
 
 //! The includes of classes and other headers must be done at the end of this file to avoid compile error
-#include "udi_cdc_conf.h"
+#include "udi_cdc.h"
+#include "usb_stream.h"
 
 #endif // _CONF_USB_H_
@@ -0,0 +1,275 @@
+/** ***************************************************************************
+File Name:  crc.c
+
+Project:    Platform 4
+
+Purpose:    Cyclic redundancy check routines for data channel integrity
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "crc.h"
+
+
+/* Module Definitions */
+
+#define CRC32_POLY_REFLECTED 0xEDB88320UL
+#define CRC16_POLY           0x1021
+
+/* number of bytes processed per slicing step */
+#define CRC_SLICES 8
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static inline uint32_t LoadLe32(uint8_t const *pucData);
+
+
+/* Module Variable Declarations */
+
+/* slicing tables: entry [k][b] is the CRC contribution of byte b followed by
+	k zero bytes. Row 0 is the classic bytewise table. Built by CrcInit() so
+	they can live in zero-initialized (TCM) RAM rather than flash */
+static uint32_t aaulCrc32Table[CRC_SLICES][256] CRC_TABLE_ATTR;
+static uint16_t aausCrc16Table[CRC_SLICES][256] CRC_TABLE_ATTR;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               CrcInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Must be called before any other CRC routine
+
+	Description:
+	Builds the CRC-32 and CRC-16 slicing tables.
+*/
+void CrcInit(void)
+{
+	uint32_t i;
+	uint32_t k;
+
+	for(i = 0; i < 256; i++)
+	{
+		uint32_t ulCrc = i;
+		uint16_t usCrc = (uint16_t)(i << 8);
+
+		for(k = 0; k < 8; k++)
+		{
+			ulCrc = (ulCrc & 1) ? (ulCrc >> 1) ^ CRC32_POLY_REFLECTED : ulCrc >> 1;
+			usCrc = (usCrc & 0x8000) ? (uint16_t)(usCrc << 1) ^ CRC16_POLY
+				: (uint16_t)(usCrc << 1);
+		}
+		aaulCrc32Table[0][i] = ulCrc;
+		aausCrc16Table[0][i] = usCrc;
+	}
+
+	/* extend each entry by one zero byte per row */
+	for(k = 1; k < CRC_SLICES; k++)
+	{
+		for(i = 0; i < 256; i++)
+		{
+			uint32_t const ulPrev = aaulCrc32Table[k - 1][i];
+			uint16_t const usPrev = aausCrc16Table[k - 1][i];
+
+			aaulCrc32Table[k][i] = (ulPrev >> 8) ^ aaulCrc32Table[0][ulPrev & 0xFF];
+			aausCrc16Table[k][i] = (uint16_t)(usPrev << 8)
+				^ aausCrc16Table[0][usPrev >> 8];
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               Crc32
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Updated CRC-32
+	Caveats / Effect:   None
+
+	Description:
+	Computes the IEEE 802.3 CRC-32 of a block of data, eight bytes per step.
+	The calculation can be split across several calls (e.g. one per DMA
+	segment) by passing the result of the previous call as ulCrc; start with
+	CRC32_INIT. The pre/post inversion is handled internally.
+*/
+CRC_CODE_ATTR uint32_t Crc32(uint32_t ulCrc, void const *pvData, uint32_t ulLen)
+{
+	uint8_t const *pucData = pvData;
+
+	ulCrc = ~ulCrc;
+
+	/* bring the pointer up to word alignment for the slicing loop */
+	while(ulLen && ((uintptr_t)pucData & 3))
+	{
+		ulCrc = aaulCrc32Table[0][(ulCrc ^ *pucData++) & 0xFF] ^ (ulCrc >> 8);
+		ulLen--;
+	}
+
+	while(ulLen >= CRC_SLICES)
+	{
+		uint32_t const ulOne = LoadLe32(pucData) ^ ulCrc;
+		uint32_t const ulTwo = LoadLe32(pucData + 4);
+
+		ulCrc = aaulCrc32Table[7][ulOne & 0xFF]
+			^ aaulCrc32Table[6][(ulOne >> 8) & 0xFF]
+			^ aaulCrc32Table[5][(ulOne >> 16) & 0xFF]
+			^ aaulCrc32Table[4][ulOne >> 24]
+			^ aaulCrc32Table[3][ulTwo & 0xFF]
+			^ aaulCrc32Table[2][(ulTwo >> 8) & 0xFF]
+			^ aaulCrc32Table[1][(ulTwo >> 16) & 0xFF]
+			^ aaulCrc32Table[0][ulTwo >> 24];
+		pucData += CRC_SLICES;
+		ulLen -= CRC_SLICES;
+	}
+
+	while(ulLen--)
+	{
+		ulCrc = aaulCrc32Table[0][(ulCrc ^ *pucData++) & 0xFF] ^ (ulCrc >> 8);
+	}
+
+	return ~ulCrc;
+}
+
+/** ***************************************************************************
+	Name:               Crc32Bytewise
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Updated CRC-32
+	Caveats / Effect:   None
+
+	Description:
+	One table lookup per byte version of Crc32(), kept as a reference and for
+	benchmarking. Same arguments and result as Crc32().
+*/
+uint32_t Crc32Bytewise(uint32_t ulCrc, void const *pvData, uint32_t ulLen)
+{
+	uint8_t const *pucData = pvData;
+
+	ulCrc = ~ulCrc;
+	while(ulLen--)
+	{
+		ulCrc = aaulCrc32Table[0][(ulCrc ^ *pucData++) & 0xFF] ^ (ulCrc >> 8);
+	}
+
+	return ~ulCrc;
+}
+
+/** ***************************************************************************
+	Name:               Crc16
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Updated CRC-16
+	Caveats / Effect:   None
+
+	Description:
+	Computes the CRC-16/CCITT-FALSE of a block of data, eight bytes per step.
+	Start with CRC16_INIT and pass the result back in to continue.
+*/
+CRC_CODE_ATTR uint16_t Crc16(uint16_t usCrc, void const *pvData, uint32_t ulLen)
+{
+	uint8_t const *pucData = pvData;
+
+	while(ulLen >= CRC_SLICES)
+	{
+		/* the first two bytes combine with the running CRC */
+		usCrc ^= (uint16_t)((pucData[0] << 8) | pucData[1]);
+		usCrc = aausCrc16Table[7][usCrc >> 8]
+			^ aausCrc16Table[6][usCrc & 0xFF]
+			^ aausCrc16Table[5][pucData[2]]
+			^ aausCrc16Table[4][pucData[3]]
+			^ aausCrc16Table[3][pucData[4]]
+			^ aausCrc16Table[2][pucData[5]]
+			^ aausCrc16Table[1][pucData[6]]
+			^ aausCrc16Table[0][pucData[7]];
+		pucData += CRC_SLICES;
+		ulLen -= CRC_SLICES;
+	}
+
+	while(ulLen--)
+	{
+		usCrc = (uint16_t)(usCrc << 8) ^ aausCrc16Table[0][(usCrc >> 8) ^ *pucData++];
+	}
+
+	return usCrc;
+}
+
+/** ***************************************************************************
+	Name:               Crc16Bytewise
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Updated CRC-16
+	Caveats / Effect:   None
+
+	Description:
+	One table lookup per byte version of Crc16(), kept as a reference and for
+	benchmarking.
+*/
+uint16_t Crc16Bytewise(uint16_t usCrc, void const *pvData, uint32_t ulLen)
+{
+	uint8_t const *pucData = pvData;
+
+	while(ulLen--)
+	{
+		usCrc = (uint16_t)(usCrc << 8) ^ aausCrc16Table[0][(usCrc >> 8) ^ *pucData++];
+	}
+
+	return usCrc;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               LoadLe32
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             32 bit little endian value at pucData
+	Caveats / Effect:   None
+
+	Description:
+	Word load for the slicing loop. The slicing tables assume a little endian
+	load, which is what both the Cortex-M7 and x86 hosts do natively.
+*/
+static inline uint32_t LoadLe32(uint8_t const *pucData)
+{
+	uint32_t ulValue;
+
+	memcpy(&ulValue, pucData, sizeof(ulValue));
+	return ulValue;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,67 @@
+/** ***************************************************************************
+File Name:  crc.h
+
+Project:    Platform 4
+
+Purpose:    Cyclic redundancy check routines for data channel integrity
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CRC_H
+#define CRC_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* starting values for a new calculation. Each routine returns the running
+	value to pass back in when the data is processed in several pieces */
+#define CRC32_INIT 0x00000000UL
+#define CRC16_INIT 0xFFFF
+
+/* placement of the lookup tables and the slicing loops. These default to the
+	TCMs when they are enabled (tcm.h) and can be overridden by the build */
+#ifndef CRC_TABLE_ATTR
+#define CRC_TABLE_ATTR TCM_BSS
+#endif
+#ifndef CRC_CODE_ATTR
+#define CRC_CODE_ATTR TCM_CODE
+#endif
+
+
+/* Module Type Definitions */
+
+/* Global Function Declarations */
+
+void CrcInit(void);
+
+/* CRC-32 (IEEE 802.3): reflected, polynomial 0x04C11DB7, inverted in and
+	out. Crc32() slices 8 bytes per step, Crc32Bytewise() is the reference */
+uint32_t Crc32(uint32_t ulCrc, void const *pvData, uint32_t ulLen);
+uint32_t Crc32Bytewise(uint32_t ulCrc, void const *pvData, uint32_t ulLen);
+
+/* CRC-16/CCITT-FALSE: polynomial 0x1021, MSB first, no final inversion */
+uint16_t Crc16(uint16_t usCrc, void const *pvData, uint32_t ulLen);
+uint16_t Crc16Bytewise(uint16_t usCrc, void const *pvData, uint32_t ulLen);
+
+
+#endif /* CRC_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,283 @@
+/** ***************************************************************************
+File Name:  dma_buf.c
+
+Project:    Platform 4
+
+Purpose:    DMA buffer allocation and data cache maintenance, so the XDMAC and
+            USB DMA can work alongside the Cortex-M7 data cache
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stddef.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "dma_buf.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+#if (DMA_BUF_POOL_SIZE % DMA_BUF_LINE) != 0
+#error "DMA_BUF_POOL_SIZE must be a multiple of DMA_BUF_LINE"
+#endif
+
+/* the non-cacheable pool is the SRAM set aside by the MPU, which the linker
+	script keeps free for the .ram_nocache section. Without that region the
+	allocations come out of the cacheable pool, and the callers' cache
+	maintenance keeps them coherent */
+#ifdef MPU_HAS_NOCACHE_REGION
+#define DMA_BUF_NOCACHE_SIZE NOCACHE_SRAM_REGION_SIZE
+#endif
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void *DmaBufTake(uint8_t *pucPool, uint32_t *pulUsed, uint32_t ulPoolSize,
+	uint32_t ulSize);
+
+
+/* Module Variable Declarations */
+
+static uint8_t aucPool[DMA_BUF_POOL_SIZE] DMA_BUF_ALIGNED;
+static uint32_t ulPoolUsed = 0;
+
+#ifdef MPU_HAS_NOCACHE_REGION
+static uint8_t aucNoCachePool[DMA_BUF_NOCACHE_SIZE]
+	__attribute__((section(".ram_nocache"))) DMA_BUF_ALIGNED;
+static uint32_t ulNoCacheUsed = 0;
+#endif
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               DmaBufAlloc
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Buffer, or NULL if the pool is exhausted
+	Caveats / Effect:   Buffers can't be freed; allocate at initialization
+
+	Description:
+	Allocates a cacheable buffer that starts on a cache line and is padded
+	to a whole number of lines, so cache maintenance on it never touches
+	another variable. The CPU works on it at full speed; use DmaBufClean()
+	before the DMA reads it and DmaBufPrepareRead()/DmaBufInvalidate()
+	around the DMA writing it.
+*/
+void *DmaBufAlloc(uint32_t ulSize)
+{
+	return DmaBufTake(aucPool, &ulPoolUsed, sizeof(aucPool), ulSize);
+}
+
+/** ***************************************************************************
+	Name:               DmaBufAllocNoCache
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Buffer, or NULL if the pool is exhausted
+	Caveats / Effect:   Buffers can't be freed; allocate at initialization
+
+	Description:
+	Allocates a buffer from the non-cacheable SRAM region, for small
+	structures shared with the DMA such as linked list descriptors, where
+	per-access maintenance would cost more than the cache saves. Callers
+	still clean the buffer after writing it, which is free when it really is
+	non-cacheable and keeps it correct when the region isn't configured.
+*/
+void *DmaBufAllocNoCache(uint32_t ulSize)
+{
+#ifdef MPU_HAS_NOCACHE_REGION
+	return DmaBufTake(aucNoCachePool, &ulNoCacheUsed, sizeof(aucNoCachePool),
+		ulSize);
+#else
+	return DmaBufAlloc(ulSize);
+#endif
+}
+
+/** ***************************************************************************
+	Name:               DmaBufClean
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Writes any cached changes to a buffer back to memory, before a DMA
+	transfer reads it. The buffer doesn't need to be line aligned.
+*/
+TCM_CODE void DmaBufClean(void const *pvAddr, uint32_t ulSize)
+{
+#ifdef CONF_BOARD_ENABLE_CACHE_AT_INIT
+	uint32_t ulAddr = (uint32_t)pvAddr & ~(uint32_t)(DMA_BUF_LINE - 1);
+	uint32_t const ulEnd = (uint32_t)pvAddr + ulSize;
+
+	if(ulSize == 0)
+	{
+		return;
+	}
+
+	__DSB();
+	for(; ulAddr < ulEnd; ulAddr += DMA_BUF_LINE)
+	{
+		SCB->DCCMVAC = ulAddr;
+	}
+	__DSB();
+	__ISB();
+#else
+	UNUSED(pvAddr);
+	UNUSED(ulSize);
+#endif
+}
+
+/** ***************************************************************************
+	Name:               DmaBufPrepareRead
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Readies a buffer for the DMA to write into. Partial lines at either end
+	are written back and dropped now, so neither a later eviction nor
+	DmaBufInvalidate() can lose the neighbouring data or the DMA's. Not
+	needed for DmaBufAlloc() buffers or others aligned and padded to lines.
+*/
+void DmaBufPrepareRead(void const *pvAddr, uint32_t ulSize)
+{
+#ifdef CONF_BOARD_ENABLE_CACHE_AT_INIT
+	uint32_t const ulStart = (uint32_t)pvAddr;
+	uint32_t const ulEnd = ulStart + ulSize;
+
+	if(ulSize == 0)
+	{
+		return;
+	}
+
+	__DSB();
+	if(ulStart & (DMA_BUF_LINE - 1))
+	{
+		SCB->DCCIMVAC = ulStart & ~(uint32_t)(DMA_BUF_LINE - 1);
+	}
+	if(ulEnd & (DMA_BUF_LINE - 1))
+	{
+		SCB->DCCIMVAC = ulEnd & ~(uint32_t)(DMA_BUF_LINE - 1);
+	}
+	__DSB();
+	__ISB();
+#else
+	UNUSED(pvAddr);
+	UNUSED(ulSize);
+#endif
+}
+
+/** ***************************************************************************
+	Name:               DmaBufInvalidate
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Don't write to lines shared with the buffer while the
+	                    DMA is running
+
+	Description:
+	Drops any cached copy of a buffer after the DMA has written to it, so the
+	CPU reads the new data. Whole lines are invalidated; a partial line at
+	either end is cleaned and invalidated instead, so a neighbouring variable
+	written while the DMA ran isn't lost. That write-back would in turn
+	overwrite the DMA's data in the shared line, hence the caveat.
+*/
+TCM_CODE void DmaBufInvalidate(void const *pvAddr, uint32_t ulSize)
+{
+#ifdef CONF_BOARD_ENABLE_CACHE_AT_INIT
+	uint32_t ulAddr = (uint32_t)pvAddr & ~(uint32_t)(DMA_BUF_LINE - 1);
+	uint32_t const ulStart = (uint32_t)pvAddr;
+	uint32_t const ulEnd = ulStart + ulSize;
+
+	if(ulSize == 0)
+	{
+		return;
+	}
+
+	__DSB();
+	for(; ulAddr < ulEnd; ulAddr += DMA_BUF_LINE)
+	{
+		if((ulAddr < ulStart) || (ulAddr + DMA_BUF_LINE > ulEnd))
+		{
+			SCB->DCCIMVAC = ulAddr;
+		}
+		else
+		{
+			/* D-cache invalidate by MVA to PoC, misnamed in this CMSIS */
+			SCB->DCIMVAU = ulAddr;
+		}
+	}
+	__DSB();
+	__ISB();
+#else
+	UNUSED(pvAddr);
+	UNUSED(ulSize);
+#endif
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               DmaBufTake
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Buffer, or NULL if the pool is exhausted
+	Caveats / Effect:   None
+
+	Description:
+	Carves a line aligned, line padded buffer off the front of a pool.
+*/
+static void *DmaBufTake(uint8_t *pucPool, uint32_t *pulUsed, uint32_t ulPoolSize,
+	uint32_t ulSize)
+{
+	irqflags_t flags;
+	void *pvBuf = NULL;
+
+	ulSize = DMA_BUF_PAD(ulSize);
+
+	flags = cpu_irq_save();
+	if((ulSize != 0) && (ulSize <= ulPoolSize - *pulUsed))
+	{
+		pvBuf = &pucPool[*pulUsed];
+		*pulUsed += ulSize;
+	}
+	cpu_irq_restore(flags);
+
+	return pvBuf;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,65 @@
+/** ***************************************************************************
+File Name:  dma_buf.h
+
+Project:    Platform 4
+
+Purpose:    DMA buffer allocation and data cache maintenance, so the XDMAC and
+            USB DMA can work alongside the Cortex-M7 data cache
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef DMA_BUF_H
+#define DMA_BUF_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+/* kept free of asf.h, as the USB driver includes this file too */
+#include "compiler.h"
+#include "conf_board.h"
+
+
+/* Module Definitions */
+
+/* Cortex-M7 data cache line size, fixed at 8 words */
+#define DMA_BUF_LINE 32
+
+/* alignment for statically allocated DMA buffers. A buffer the DMA writes
+	must also be padded to a whole number of lines (DMA_BUF_PAD), so no
+	other variable shares its first or last cache line */
+#define DMA_BUF_ALIGNED COMPILER_ALIGNED(DMA_BUF_LINE)
+#define DMA_BUF_PAD(ulSize) \
+	(((ulSize) + DMA_BUF_LINE - 1) & ~(uint32_t)(DMA_BUF_LINE - 1))
+
+/* cacheable DMA buffer pool, for DmaBufAlloc() */
+#ifndef DMA_BUF_POOL_SIZE
+#define DMA_BUF_POOL_SIZE 4096
+#endif
+
+
+/* Global Function Declarations */
+
+void *DmaBufAlloc(uint32_t ulSize);
+void *DmaBufAllocNoCache(uint32_t ulSize);
+
+void DmaBufClean(void const *pvAddr, uint32_t ulSize);
+void DmaBufPrepareRead(void const *pvAddr, uint32_t ulSize);
+void DmaBufInvalidate(void const *pvAddr, uint32_t ulSize);
+
+
+#endif /* DMA_BUF_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
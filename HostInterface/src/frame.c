@@ -0,0 +1,406 @@
+/** ***************************************************************************
+File Name:  frame.c
+
+Project:    Platform 4
+
+Purpose:    Data channel framing: frame construction and an incremental
+            byte-stream parser
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "crc.h"
+#include "frame.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* parser stages */
+#define FRAME_STATE_SYNC     0
+#define FRAME_STATE_HEADER   1
+#define FRAME_STATE_BODY     2
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static int FrameParserStep(tFrameParser *pstParser, uint8_t const *pucData,
+	uint32_t ulLen, uint32_t *pulTaken);
+static void FrameParserResync(tFrameParser *pstParser);
+static void FrameParserRestart(tFrameParser *pstParser);
+
+
+/* Module Variable Declarations */
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               FrameBuild
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Total frame length in bytes
+	Caveats / Effect:   pucDst must hold ulLen + FRAME_OVERHEAD bytes
+
+	Description:
+	Builds a complete frame around a payload. The payload may already be in
+	place at pucDst + FRAME_HEADER_SIZE, in which case it isn't copied.
+*/
+uint32_t FrameBuild(uint8_t *pucDst, uint16_t usSeq, void const *pvPayload,
+	uint32_t ulLen)
+{
+	uint32_t ulCrc;
+
+	pucDst[0] = FRAME_SYNC0;
+	pucDst[1] = FRAME_SYNC1;
+	pucDst[2] = (uint8_t)ulLen;
+	pucDst[3] = (uint8_t)(ulLen >> 8);
+	pucDst[4] = (uint8_t)usSeq;
+	pucDst[5] = (uint8_t)(usSeq >> 8);
+	if(pvPayload != &pucDst[FRAME_HEADER_SIZE])
+	{
+		memmove(&pucDst[FRAME_HEADER_SIZE], pvPayload, ulLen);
+	}
+
+	ulCrc = Crc32(0, &pucDst[FRAME_SYNC_SIZE],
+		FRAME_HEADER_SIZE - FRAME_SYNC_SIZE + ulLen);
+	pucDst += FRAME_HEADER_SIZE + ulLen;
+	pucDst[0] = (uint8_t)ulCrc;
+	pucDst[1] = (uint8_t)(ulCrc >> 8);
+	pucDst[2] = (uint8_t)(ulCrc >> 16);
+	pucDst[3] = (uint8_t)(ulCrc >> 24);
+
+	return ulLen + FRAME_OVERHEAD;
+}
+
+/** ***************************************************************************
+	Name:               FrameParserInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Resets a parser and its statistics.
+*/
+void FrameParserInit(tFrameParser *pstParser)
+{
+	memset(pstParser, 0, sizeof(*pstParser));
+	FrameParserRestart(pstParser);
+}
+
+/** ***************************************************************************
+	Name:               FrameParserFeed
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of bytes of pucData consumed
+	Caveats / Effect:   Invalidates the previously returned frame
+
+	Description:
+	Pushes a chunk of the received byte stream through the parser. Chunks may
+	be of any size and split frames anywhere. Parsing stops as soon as the
+	last byte of a valid frame has been consumed, in which case
+	FrameParserReady() is set and the frame can be read with the accessors in
+	frame.h until the next call; the caller then feeds the rest of the chunk.
+	A sync word in noise or in a payload can start a frame that then fails
+	its length or CRC check, by which time the real frame behind it may be
+	buffered. Those bytes are gone from the caller, so the parser goes back
+	over them itself, from the byte after the false sync word, before taking
+	any more of pucData. A frame found there can be returned with none of
+	pucData consumed, so the caller keeps calling, with an empty chunk if it
+	has nothing more, until no frame is returned.
+*/
+TCM_CODE uint32_t FrameParserFeed(tFrameParser *pstParser, uint8_t const *pucData,
+	uint32_t ulLen)
+{
+	uint32_t ulUsed = 0;
+
+	/* the last frame has been dealt with, start looking for the next */
+	if(pstParser->ucReady)
+	{
+		FrameParserRestart(pstParser);
+	}
+
+	while(!pstParser->ucReady)
+	{
+		uint32_t ulTaken;
+		int iResult;
+
+		if(pstParser->ulReplayPos < pstParser->ulReplayEnd)
+		{
+			iResult = FrameParserStep(pstParser,
+				&pstParser->aucBuf[pstParser->ulReplayPos],
+				pstParser->ulReplayEnd - pstParser->ulReplayPos, &ulTaken);
+			pstParser->ulReplayPos += ulTaken;
+		}
+		else if(ulUsed < ulLen)
+		{
+			iResult = FrameParserStep(pstParser, &pucData[ulUsed],
+				ulLen - ulUsed, &ulTaken);
+			ulUsed += ulTaken;
+		}
+		else
+		{
+			break;
+		}
+
+		if(iResult != 0)
+		{
+			FrameParserResync(pstParser);
+		}
+	}
+
+	return ulUsed;
+}
+
+/** ***************************************************************************
+	Name:               FrameParserIdle
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Non-zero if there are bytes to parse again
+	Caveats / Effect:   None
+
+	Description:
+	Tells the parser the line has gone idle. Any partially received frame can
+	no longer complete, so it is dropped rather than being allowed to swallow
+	the start of the next frame. It may have started at a false sync word,
+	so as after a failed check the bytes after that are parsed again, by
+	calls to FrameParserFeed() with an empty chunk, before the caller
+	tells the parser about the idle line once more.
+*/
+TCM_CODE int FrameParserIdle(tFrameParser *pstParser)
+{
+	if(!pstParser->ucReady && (pstParser->ucState != FRAME_STATE_SYNC))
+	{
+		pstParser->ulTruncated++;
+		FrameParserResync(pstParser);
+	}
+	return FrameParserPending(pstParser) != 0;
+}
+
+/** ***************************************************************************
+	Name:               FrameParserRemaining
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Bytes still needed to complete the current frame, 0 if
+	                    none is being assembled
+	Caveats / Effect:   None
+
+	Description:
+	Once the header has been parsed this is exact, as the length field gives
+	the size of the rest of the frame; before that it only counts the rest of
+	the header, a lower bound.
+*/
+uint32_t FrameParserRemaining(tFrameParser const *pstParser)
+{
+	if(pstParser->ucReady || (pstParser->ucState == FRAME_STATE_SYNC))
+	{
+		return 0;
+	}
+	return pstParser->ulNeed - pstParser->ulHave;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               FrameParserStep
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0, or -1 if the frame being assembled failed its
+	                    length or CRC check
+	Caveats / Effect:   pucData may point into the parser's own buffer, at or
+	                    after aucBuf[ulHave]
+
+	Description:
+	Takes the next bytes of the stream, at least one unless a false first
+	sync byte has to be examined again, and returns how many in *pulTaken.
+	Each call hunts for a sync word, or copies as much of the current stage
+	as ulLen holds and checks the stage once it is complete; a good frame
+	sets ucReady.
+*/
+static TCM_CODE int FrameParserStep(tFrameParser *pstParser,
+	uint8_t const *pucData, uint32_t ulLen, uint32_t *pulTaken)
+{
+	*pulTaken = 0;
+
+	if(pstParser->ucState == FRAME_STATE_SYNC)
+	{
+		if(pstParser->ulHave == 0)
+		{
+			/* hunt for the first sync byte */
+			uint8_t const *pucSync = memchr(pucData, FRAME_SYNC0, ulLen);
+
+			if(!pucSync)
+			{
+				pstParser->ulSkipped += ulLen;
+				*pulTaken = ulLen;
+				return 0;
+			}
+			pstParser->ulSkipped += (uint32_t)(pucSync - pucData);
+			*pulTaken = (uint32_t)(pucSync - pucData) + 1;
+			pstParser->aucBuf[0] = FRAME_SYNC0;
+			pstParser->ulHave = 1;
+		}
+		else if(pucData[0] == FRAME_SYNC1)
+		{
+			pstParser->aucBuf[1] = FRAME_SYNC1;
+			pstParser->ulHave = FRAME_SYNC_SIZE;
+			pstParser->ulNeed = FRAME_HEADER_SIZE;
+			pstParser->ucState = FRAME_STATE_HEADER;
+			*pulTaken = 1;
+		}
+		else
+		{
+			/* false start; the current byte is examined again as a
+				possible first sync byte */
+			pstParser->ulSkipped++;
+			pstParser->ulHave = 0;
+		}
+		return 0;
+	}
+
+	/* copy as much of the current stage as there is */
+	{
+		uint32_t ulCopy = pstParser->ulNeed - pstParser->ulHave;
+
+		if(ulCopy > ulLen)
+		{
+			ulCopy = ulLen;
+		}
+		memmove(&pstParser->aucBuf[pstParser->ulHave], pucData, ulCopy);
+		pstParser->ulHave += ulCopy;
+		*pulTaken = ulCopy;
+	}
+
+	if(pstParser->ulHave < pstParser->ulNeed)
+	{
+		return 0;
+	}
+
+	if(pstParser->ucState == FRAME_STATE_HEADER)
+	{
+		uint32_t const ulPayload = FrameGetLength(pstParser);
+
+		if(ulPayload > FRAME_MAX_PAYLOAD)
+		{
+			pstParser->ulLenErrors++;
+			return -1;
+		}
+		pstParser->ulNeed = ulPayload + FRAME_OVERHEAD;
+		pstParser->ucState = FRAME_STATE_BODY;
+	}
+	else
+	{
+		uint8_t const *pucCrc =
+			&pstParser->aucBuf[pstParser->ulNeed - FRAME_CRC_SIZE];
+		uint32_t const ulCrc = (uint32_t)pucCrc[0]
+			| ((uint32_t)pucCrc[1] << 8)
+			| ((uint32_t)pucCrc[2] << 16)
+			| ((uint32_t)pucCrc[3] << 24);
+		uint16_t const usSeq = FrameGetSeq(pstParser);
+
+		if(ulCrc != Crc32(0, &pstParser->aucBuf[FRAME_SYNC_SIZE],
+			pstParser->ulNeed - FRAME_SYNC_SIZE - FRAME_CRC_SIZE))
+		{
+			pstParser->ulCrcErrors++;
+			return -1;
+		}
+
+		/* good frame; account for any frames missed in between */
+		if(pstParser->ucSeqValid)
+		{
+			pstParser->ulSeqLost += (uint16_t)(usSeq - pstParser->usNextSeq);
+		}
+		pstParser->usNextSeq = usSeq + 1;
+		pstParser->ucSeqValid = 1;
+		pstParser->ulFrames++;
+		pstParser->ucReady = 1;
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               FrameParserResync
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Only when the frame being assembled is given up
+
+	Description:
+	The bytes after its sync word, followed by any that were still to
+	be parsed again from an earlier failure, are moved together at the start
+	of the buffer and become the bytes to go back over, from the first that
+	could be a sync byte. The parser then hunts for a sync word in them.
+*/
+static TCM_CODE void FrameParserResync(tFrameParser *pstParser)
+{
+	uint32_t const ulEnd = pstParser->ulHave
+		+ (pstParser->ulReplayEnd - pstParser->ulReplayPos);
+	uint8_t const *pucSync;
+
+	memmove(&pstParser->aucBuf[pstParser->ulHave],
+		&pstParser->aucBuf[pstParser->ulReplayPos],
+		pstParser->ulReplayEnd - pstParser->ulReplayPos);
+	pucSync = memchr(&pstParser->aucBuf[1], FRAME_SYNC0, ulEnd - 1);
+
+	pstParser->ulReplayPos = pucSync
+		? (uint32_t)(pucSync - pstParser->aucBuf) : ulEnd;
+	pstParser->ulReplayEnd = ulEnd;
+	FrameParserRestart(pstParser);
+}
+
+/** ***************************************************************************
+	Name:               FrameParserRestart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Returns the parser to hunting for a sync word, keeping its statistics.
+*/
+static TCM_CODE void FrameParserRestart(tFrameParser *pstParser)
+{
+	pstParser->ulHave = 0;
+	pstParser->ulNeed = 0;
+	pstParser->ucState = FRAME_STATE_SYNC;
+	pstParser->ucReady = 0;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
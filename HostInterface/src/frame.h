@@ -0,0 +1,110 @@
+/** ***************************************************************************
+File Name:  frame.h
+
+Project:    Platform 4
+
+Purpose:    Data channel framing: frame construction and an incremental
+            byte-stream parser
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef FRAME_H
+#define FRAME_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* Frame layout, multi-byte fields are little endian:
+	offset 0        sync word (FRAME_SYNC0, FRAME_SYNC1)
+	offset 2        payload length in bytes
+	offset 4        sequence number
+	offset 6        payload
+	offset 6+len    CRC-32 of everything following the sync word */
+#define FRAME_SYNC0          0xEB
+#define FRAME_SYNC1          0x90
+#define FRAME_SYNC_SIZE      2
+#define FRAME_HEADER_SIZE    6
+#define FRAME_CRC_SIZE       4
+#define FRAME_OVERHEAD       (FRAME_HEADER_SIZE + FRAME_CRC_SIZE)
+
+/* largest payload accepted by the parser */
+#ifndef FRAME_MAX_PAYLOAD
+#define FRAME_MAX_PAYLOAD    1024
+#endif
+
+#define FRAME_MAX_SIZE       (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+
+
+/* Module Type Definitions */
+
+/* incremental frame parser state */
+typedef struct
+{
+	/* frame being assembled: header, payload and CRC */
+	uint8_t aucBuf[FRAME_MAX_SIZE];
+	/* bytes held in aucBuf, and bytes needed to complete the current stage */
+	uint32_t ulHave;
+	uint32_t ulNeed;
+	/* parser stage, FRAME_STATE_x in frame.c */
+	uint8_t ucState;
+	/* a complete, valid frame is held in aucBuf */
+	uint8_t ucReady;
+	/* bytes received after a false sync word, aucBuf[ulReplayPos] to
+		aucBuf[ulReplayEnd - 1], which are parsed again before any new data */
+	uint32_t ulReplayPos;
+	uint32_t ulReplayEnd;
+	/* next expected sequence number, once one has been seen */
+	uint8_t ucSeqValid;
+	uint16_t usNextSeq;
+	/* statistics */
+	uint32_t ulFrames;
+	uint32_t ulCrcErrors;
+	uint32_t ulLenErrors;
+	uint32_t ulTruncated;
+	uint32_t ulSeqLost;
+	uint32_t ulSkipped;
+} tFrameParser;
+
+
+/* Global Function Declarations */
+
+uint32_t FrameBuild(uint8_t *pucDst, uint16_t usSeq, void const *pvPayload,
+	uint32_t ulLen);
+
+void FrameParserInit(tFrameParser *pstParser);
+uint32_t FrameParserFeed(tFrameParser *pstParser, uint8_t const *pucData,
+	uint32_t ulLen);
+int FrameParserIdle(tFrameParser *pstParser);
+uint32_t FrameParserRemaining(tFrameParser const *pstParser);
+
+/* accessors for the frame held by the parser, valid while ucReady is set */
+#define FrameParserReady(pstParser)   ((pstParser)->ucReady)
+/* bytes already consumed that the parser has still to go back over; the
+	frame held ended this many bytes before the last byte consumed */
+#define FrameParserPending(pstParser) \
+	((pstParser)->ulReplayEnd - (pstParser)->ulReplayPos)
+#define FrameGetPayload(pstParser)    (&(pstParser)->aucBuf[FRAME_HEADER_SIZE])
+#define FrameGetLength(pstParser) \
+	((uint32_t)(pstParser)->aucBuf[2] | ((uint32_t)(pstParser)->aucBuf[3] << 8))
+#define FrameGetSeq(pstParser) \
+	((uint16_t)((pstParser)->aucBuf[4] | ((pstParser)->aucBuf[5] << 8)))
+
+
+#endif /* FRAME_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
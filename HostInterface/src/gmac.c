@@ -0,0 +1,470 @@
+/** ***************************************************************************
+File Name:  gmac.c
+
+Project:    Platform 4
+
+Purpose:    Ethernet MAC driver: RMII PHY management, and the receive and
+            transmit descriptor rings of the GMAC DMA
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "dma_buf.h"
+#include "gmac.h"
+
+
+/* Module Definitions */
+
+/* IEEE 802.3 clause 22 PHY registers and bits */
+#define PHY_BMCR             0
+#define PHY_BMCR_RESET       0x8000
+#define PHY_BMCR_ANENABLE    0x1000
+#define PHY_BMCR_ANRESTART   0x0200
+#define PHY_BMSR             1
+#define PHY_BMSR_LINK        0x0004
+#define PHY_ANAR             4
+#define PHY_ANLPAR           5
+#define PHY_AN_100FULL       0x0100
+#define PHY_AN_100HALF       0x0080
+#define PHY_AN_10FULL        0x0040
+
+/* the MDC clock must stay below 2.5 MHz */
+#define GMAC_MDC_HZ_MAX      2500000UL
+
+/* PHY register reads to wait for its reset, at about 30 us each */
+#define GMAC_PHY_RESET_READS 1000
+
+/* PHY maintenance operations */
+#define GMAC_MAN_WRITE       1
+#define GMAC_MAN_READ        2
+
+/* interrupts that wake the main loop, and those that stop the
+	transmitter */
+#define GMAC_IRQ_WAKE        (GMAC_IER_RCOMP | GMAC_IER_TCOMP)
+#define GMAC_IRQ_TX_FAULT    (GMAC_IER_RLEX | GMAC_IER_TFC | GMAC_IER_HRESP)
+#define GMAC_IRQ_RX_ERROR    (GMAC_IER_ROVR | GMAC_IER_RXUBR)
+
+/* priority queues 1 to 5, which we don't use */
+#define GMAC_PRIORITY_QUEUES 5
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static uint32_t GmacMdcDivider(void);
+static uint16_t GmacPhyRead(uint32_t ulReg);
+static void GmacPhyWrite(uint32_t ulReg, uint16_t usValue);
+
+
+/* Module Variable Declarations */
+
+static tGmac stGmac;
+
+/* receive buffers, one frame each; only ever written by the DMA */
+static uint8_t aucGmacRxBufs[NET_RX_DESCS * GMAC_RX_BUF_SIZE] DMA_BUF_ALIGNED;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               GmacInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the descriptors can't be allocated
+	Caveats / Effect:   Enables the GMAC interrupt; the RMII pins must be set
+	                    up (CONF_BOARD_GMAC)
+
+	Description:
+	Brings up the GMAC in RMII mode with the MAC address pucMac, receiving our
+	own and broadcast frames into the receive ring, and starts the PHY
+	autonegotiating. The link comes up later, see GmacCheckLink().
+	pfnTxDone is called from GmacPoll() for every frame sent with
+	GmacSend().
+*/
+int GmacInit(uint8_t const *pucMac, tGmacTxDone pfnTxDone)
+{
+	Gmac *pstGmac = GMAC;
+	tGmacDesc *pastDesc;
+	uint32_t i;
+
+	/* the rings and a spare receive and transmit descriptor for the unused
+		priority queues */
+	pastDesc = DmaBufAllocNoCache((NET_RX_DESCS + NET_TX_DESCS + 2)
+		* sizeof(tGmacDesc));
+	if(!pastDesc)
+	{
+		return -1;
+	}
+
+	memset(&stGmac, 0, sizeof(stGmac));
+	stGmac.pfnTxDone = pfnTxDone;
+
+	sysclk_enable_peripheral_clock(ID_GMAC);
+
+	/* quiesce, and clear anything left over */
+	pstGmac->GMAC_NCR = 0;
+	pstGmac->GMAC_IDR = 0xFFFFFFFF;
+	pstGmac->GMAC_TSR = 0xFFFFFFFF;
+	pstGmac->GMAC_RSR = 0xFFFFFFFF;
+	(void)pstGmac->GMAC_ISR;
+	pstGmac->GMAC_NCR = GMAC_NCR_CLRSTAT;
+
+	/* 1536 byte frames without their FCS, our address and broadcasts. The
+		link starts out at 100 Mbit/s full duplex until the PHY says
+		otherwise */
+	pstGmac->GMAC_NCFGR = GMAC_NCFGR_SPD | GMAC_NCFGR_FD | GMAC_NCFGR_MAXFS
+		| GMAC_NCFGR_RFCS | GMAC_NCFGR_CLK(GmacMdcDivider());
+	pstGmac->GMAC_UR = GMAC_UR_RMII;
+	/* the transmit packet buffer holds whole frames, so the GMAC can fill
+		in the IP and UDP checksums before sending them */
+	pstGmac->GMAC_DCFGR = GMAC_DCFGR_FBLDO_INCR4 | GMAC_DCFGR_RXBMS_FULL
+		| GMAC_DCFGR_TXPBMS | GMAC_DCFGR_TXCOEN
+		| GMAC_DCFGR_DRBS(GMAC_RX_BUF_SIZE / 64);
+
+	pstGmac->GMAC_SA[0].GMAC_SAB = (uint32_t)pucMac[0]
+		| ((uint32_t)pucMac[1] << 8) | ((uint32_t)pucMac[2] << 16)
+		| ((uint32_t)pucMac[3] << 24);
+	pstGmac->GMAC_SA[0].GMAC_SAT = (uint32_t)pucMac[4]
+		| ((uint32_t)pucMac[5] << 8);
+
+	/* rings, in non-cacheable memory; nothing in the cache may be written
+		back over received data */
+	DmaBufInvalidate(aucGmacRxBufs, sizeof(aucGmacRxBufs));
+	GmacRxRingInit(&stGmac.stRx, pastDesc, NET_RX_DESCS, aucGmacRxBufs,
+		GMAC_RX_BUF_SIZE);
+	GmacTxRingInit(&stGmac.stTx, &pastDesc[NET_RX_DESCS], NET_TX_DESCS);
+	pstGmac->GMAC_RBQB = (uint32_t)stGmac.stRx.pastDesc;
+	pstGmac->GMAC_TBQB = (uint32_t)stGmac.stTx.pastDesc;
+
+	/* the priority queues are always active in the DMA; park them on a
+		descriptor that never holds a buffer */
+	pastDesc = &pastDesc[NET_RX_DESCS + NET_TX_DESCS];
+	pastDesc[0].ulAddr = GMAC_RX_OWN | GMAC_RX_WRAP;
+	pastDesc[0].ulStatus = 0;
+	pastDesc[1].ulAddr = 0;
+	pastDesc[1].ulStatus = GMAC_TX_USED | GMAC_TX_WRAP;
+	for(i = 0; i < GMAC_PRIORITY_QUEUES; i++)
+	{
+		pstGmac->GMAC_RBQBAPQ[i] = (uint32_t)&pastDesc[0];
+		pstGmac->GMAC_TBQBAPQ[i] = (uint32_t)&pastDesc[1];
+	}
+
+	pstGmac->GMAC_NCR = GMAC_NCR_MPE | GMAC_NCR_RXEN | GMAC_NCR_TXEN;
+
+	/* reset the PHY and let it autonegotiate. The reset takes well under
+		the GMAC_PHY_RESET_READS polls; a PHY that isn't there reads as all
+		ones and is given up on */
+	GmacPhyWrite(PHY_BMCR, PHY_BMCR_RESET);
+	for(i = 0; (i < GMAC_PHY_RESET_READS)
+		&& (GmacPhyRead(PHY_BMCR) & PHY_BMCR_RESET); i++)
+	{
+	}
+	GmacPhyWrite(PHY_BMCR, PHY_BMCR_ANENABLE | PHY_BMCR_ANRESTART);
+
+	pstGmac->GMAC_IER = GMAC_IRQ_WAKE | GMAC_IRQ_TX_FAULT | GMAC_IRQ_RX_ERROR;
+	NVIC_EnableIRQ(GMAC_IRQn);
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               GmacPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the main program loop
+
+	Description:
+	Reports the frames the DMA has finished sending through pfnTxDone. After
+	a transmit error the transmitter is restarted from the start of an empty
+	ring, failing the frames that were still queued.
+*/
+void GmacPoll(void)
+{
+	Gmac *pstGmac = GMAC;
+
+	if(stGmac.ucTxFault)
+	{
+		stGmac.ucTxFault = 0;
+		pstGmac->GMAC_NCR &= ~GMAC_NCR_TXEN;
+		pstGmac->GMAC_TSR = 0xFFFFFFFF;
+		GmacTxRingFlush(&stGmac.stTx, stGmac.pfnTxDone);
+		pstGmac->GMAC_TBQB = (uint32_t)stGmac.stTx.pastDesc;
+		pstGmac->GMAC_NCR |= GMAC_NCR_TXEN;
+		return;
+	}
+
+	GmacTxRingReclaim(&stGmac.stTx, stGmac.pfnTxDone);
+}
+
+/** ***************************************************************************
+	Name:               GmacCheckLink
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Waits for a few PHY register reads
+
+	Description:
+	Follows the PHY link state, and sets the MAC to the speed and duplex the
+	PHY negotiated when the link comes up. Call about once a second.
+*/
+void GmacCheckLink(void)
+{
+	Gmac *pstGmac = GMAC;
+	uint16_t usCommon;
+	uint32_t ulCfg;
+
+	/* the link status bit latches low, the second read is the current
+		state */
+	(void)GmacPhyRead(PHY_BMSR);
+	if(!(GmacPhyRead(PHY_BMSR) & PHY_BMSR_LINK))
+	{
+		stGmac.ucLinkUp = 0;
+		return;
+	}
+	if(stGmac.ucLinkUp)
+	{
+		return;
+	}
+
+	usCommon = GmacPhyRead(PHY_ANAR) & GmacPhyRead(PHY_ANLPAR);
+	stGmac.ucSpeed100 = (usCommon & (PHY_AN_100FULL | PHY_AN_100HALF)) != 0;
+	stGmac.ucFullDuplex = (usCommon & PHY_AN_100FULL)
+		|| (!stGmac.ucSpeed100 && (usCommon & PHY_AN_10FULL));
+	stGmac.ucLinkUp = 1;
+
+	ulCfg = pstGmac->GMAC_NCFGR & ~(GMAC_NCFGR_SPD | GMAC_NCFGR_FD);
+	if(stGmac.ucSpeed100)
+	{
+		ulCfg |= GMAC_NCFGR_SPD;
+	}
+	if(stGmac.ucFullDuplex)
+	{
+		ulCfg |= GMAC_NCFGR_FD;
+	}
+	pstGmac->GMAC_NCFGR = ulCfg;
+}
+
+/** ***************************************************************************
+	Name:               GmacSend
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the transmit ring is full
+	Caveats / Effect:   The buffers must be cleaned from the data cache and
+	                    stay untouched until pfnTxDone is called for pvTag
+
+	Description:
+	Queues a frame made of ulBufs buffers, without copying them, and starts
+	the transmitter on it. The GMAC adds the padding and the FCS.
+*/
+int GmacSend(tGmacTxBuf const *pastBufs, uint32_t ulBufs, void *pvTag)
+{
+	if(GmacTxRingQueue(&stGmac.stTx, pastBufs, ulBufs, pvTag) != 0)
+	{
+		return -1;
+	}
+	GMAC->GMAC_NCR |= GMAC_NCR_TSTART;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               GmacReceive
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Length of the next received frame, 0 if there is none
+	Caveats / Effect:   The frame must be released with GmacReceiveDone()
+
+	Description:
+	Returns the oldest received frame, without its FCS, in its receive
+	buffer.
+*/
+uint32_t GmacReceive(uint8_t **ppucFrame)
+{
+	uint32_t const ulLen = GmacRxRingPeek(&stGmac.stRx, ppucFrame);
+
+	if(ulLen)
+	{
+		DmaBufInvalidate(*ppucFrame, ulLen);
+	}
+	return ulLen;
+}
+
+/** ***************************************************************************
+	Name:               GmacReceiveDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Gives the buffer of the frame returned by GmacReceive() back to the DMA.
+*/
+void GmacReceiveDone(void)
+{
+	GmacRxRingRelease(&stGmac.stRx);
+}
+
+/** ***************************************************************************
+	Name:               GmacGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Driver state
+	Caveats / Effect:   None
+
+	Description:
+	Gives read access to the link state and the statistics.
+*/
+tGmac const *GmacGet(void)
+{
+	return &stGmac;
+}
+
+/** ***************************************************************************
+	Name:               GMAC_Handler
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   ISR
+
+	Description:
+	Received and transmitted frames only wake the main loop, which does the
+	work by polling. A transmit error stops the transmitter until GmacPoll()
+	restarts it; receive overruns and a full ring are counted.
+*/
+void GMAC_Handler(void)
+{
+	Gmac *pstGmac = GMAC;
+	/* reading the status clears it */
+	uint32_t const ulIsr = pstGmac->GMAC_ISR;
+
+	if(ulIsr & GMAC_IRQ_TX_FAULT)
+	{
+		stGmac.ucTxFault = 1;
+	}
+	if(ulIsr & GMAC_ISR_ROVR)
+	{
+		stGmac.ulRxOverruns++;
+	}
+	if(ulIsr & GMAC_ISR_RXUBR)
+	{
+		stGmac.ulRxNoBuffer++;
+	}
+	pstGmac->GMAC_RSR = GMAC_RSR_BNA | GMAC_RSR_REC | GMAC_RSR_RXOVR
+		| GMAC_RSR_HNO;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               GmacMdcDivider
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             GMAC_NCFGR_CLK value for the peripheral clock
+	Caveats / Effect:   None
+
+	Description:
+	Picks the smallest MCK divider that keeps MDC within the PHY's limit.
+*/
+static uint32_t GmacMdcDivider(void)
+{
+	static uint8_t const aucDiv[] = { 8, 16, 32, 48, 64, 96 };
+	uint32_t const ulMck = sysclk_get_peripheral_hz();
+	uint32_t i;
+
+	for(i = 0; i < sizeof(aucDiv) - 1; i++)
+	{
+		if(ulMck / aucDiv[i] <= GMAC_MDC_HZ_MAX)
+		{
+			break;
+		}
+	}
+	return i;
+}
+
+/** ***************************************************************************
+	Name:               GmacPhyRead
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Value of PHY register ulReg
+	Caveats / Effect:   Waits for the management frame, about 30 us
+
+	Description:
+	Reads a PHY register over the management interface.
+*/
+static uint16_t GmacPhyRead(uint32_t ulReg)
+{
+	Gmac *pstGmac = GMAC;
+
+	pstGmac->GMAC_MAN = GMAC_MAN_CLTTO | GMAC_MAN_OP(GMAC_MAN_READ)
+		| GMAC_MAN_WTN(2) | GMAC_MAN_PHYA(NET_PHY_ADDR) | GMAC_MAN_REGA(ulReg);
+	while(!(pstGmac->GMAC_NSR & GMAC_NSR_IDLE))
+	{
+	}
+	return (uint16_t)(pstGmac->GMAC_MAN & GMAC_MAN_DATA_Msk);
+}
+
+/** ***************************************************************************
+	Name:               GmacPhyWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Waits for the management frame, about 30 us
+
+	Description:
+	Writes a PHY register over the management interface.
+*/
+static void GmacPhyWrite(uint32_t ulReg, uint16_t usValue)
+{
+	Gmac *pstGmac = GMAC;
+
+	pstGmac->GMAC_MAN = GMAC_MAN_CLTTO | GMAC_MAN_OP(GMAC_MAN_WRITE)
+		| GMAC_MAN_WTN(2) | GMAC_MAN_PHYA(NET_PHY_ADDR) | GMAC_MAN_REGA(ulReg)
+		| GMAC_MAN_DATA(usValue);
+	while(!(pstGmac->GMAC_NSR & GMAC_NSR_IDLE))
+	{
+	}
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,80 @@
+/** ***************************************************************************
+File Name:  gmac.h
+
+Project:    Platform 4
+
+Purpose:    Ethernet MAC driver: RMII PHY management, and the receive and
+            transmit descriptor rings of the GMAC DMA
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef GMAC_H
+#define GMAC_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "conf_net.h"
+#include "gmac_ring.h"
+
+
+/* Module Definitions */
+
+/* receive buffer size, a multiple of 64 bytes holding the largest frame
+	the GMAC accepts (GMAC_NCFGR_MAXFS) */
+#define GMAC_RX_BUF_SIZE     1536
+
+#if NET_TX_DESCS > GMAC_TX_DESCS_MAX
+#error "NET_TX_DESCS exceeds GMAC_TX_DESCS_MAX"
+#endif
+
+
+/* Module Type Definitions */
+
+/* driver state */
+typedef struct
+{
+	tGmacRxRing stRx;
+	tGmacTxRing stTx;
+	/* completion of every transmitted frame */
+	tGmacTxDone pfnTxDone;
+	/* the PHY reports a link, and the speed and duplex it negotiated */
+	uint8_t ucLinkUp;
+	uint8_t ucSpeed100;
+	uint8_t ucFullDuplex;
+	/* the transmitter stopped on an error (ISR) */
+	volatile uint8_t ucTxFault;
+	/* statistics (ISR) */
+	volatile uint32_t ulRxOverruns;
+	volatile uint32_t ulRxNoBuffer;
+} tGmac;
+
+
+/* Global Function Declarations */
+
+int GmacInit(uint8_t const *pucMac, tGmacTxDone pfnTxDone);
+void GmacPoll(void);
+void GmacCheckLink(void);
+int GmacSend(tGmacTxBuf const *pastBufs, uint32_t ulBufs, void *pvTag);
+uint32_t GmacReceive(uint8_t **ppucFrame);
+void GmacReceiveDone(void);
+tGmac const *GmacGet(void);
+
+
+#endif /* GMAC_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,402 @@
+/** ***************************************************************************
+File Name:  gmac_ring.c
+
+Project:    Platform 4
+
+Purpose:    GMAC receive and transmit buffer descriptor rings: ownership
+            handover with the DMA, independent of the GMAC registers
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stddef.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "gmac_ring.h"
+
+
+/* Module Definitions */
+
+/* orders descriptor writes against each other as the DMA sees them */
+#define GMAC_RING_BARRIER()       __sync_synchronize()
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void GmacRxRingAdvance(tGmacRxRing *pstRing);
+static void GmacTxRingFinish(tGmacTxRing *pstRing);
+
+
+/* Module Variable Declarations */
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               GmacRxRingInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The GMAC receiver must be disabled
+
+	Description:
+	Hands ulCount descriptors, each with its ulBufSize byte part of pucBufs,
+	to the DMA. The buffers must be word aligned and ulBufSize a multiple of
+	64 bytes, as the GMAC counts its receive buffer size in those.
+*/
+void GmacRxRingInit(tGmacRxRing *pstRing, tGmacDesc *pastDesc, uint32_t ulCount,
+	uint8_t *pucBufs, uint32_t ulBufSize)
+{
+	uint32_t i;
+
+	memset(pstRing, 0, sizeof(*pstRing));
+	pstRing->pastDesc = pastDesc;
+	pstRing->pucBufs = pucBufs;
+	pstRing->ulCount = ulCount;
+	pstRing->ulBufSize = ulBufSize;
+
+	for(i = 0; i < ulCount; i++)
+	{
+		pastDesc[i].ulStatus = 0;
+		pastDesc[i].ulAddr = ((uint32_t)(uintptr_t)&pucBufs[i * ulBufSize]
+			& GMAC_RX_ADDR_MSK) | ((i == ulCount - 1) ? GMAC_RX_WRAP : 0);
+	}
+	GMAC_RING_BARRIER();
+}
+
+/** ***************************************************************************
+	Name:               GmacRxRingPeek
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Length of the next received frame, 0 if there is none
+	Caveats / Effect:   None
+
+	Description:
+	Returns the oldest received frame in *ppucFrame, without its FCS. It stays
+	valid until GmacRxRingRelease(). Frames spread over more than one buffer
+	can only be longer than the largest frame we accept, so they are dropped
+	here along the way.
+*/
+uint32_t GmacRxRingPeek(tGmacRxRing *pstRing, uint8_t **ppucFrame)
+{
+	while(1)
+	{
+		tGmacDesc *pstDesc = &pstRing->pastDesc[pstRing->ulHead];
+		uint32_t ulStatus;
+
+		if(!(pstDesc->ulAddr & GMAC_RX_OWN))
+		{
+			return 0;
+		}
+		/* read the status only once the DMA has handed the buffer over */
+		GMAC_RING_BARRIER();
+		ulStatus = pstDesc->ulStatus;
+
+		if((ulStatus & (GMAC_RX_SOF | GMAC_RX_EOF))
+			== (GMAC_RX_SOF | GMAC_RX_EOF))
+		{
+			*ppucFrame = &pstRing->pucBufs[pstRing->ulHead * pstRing->ulBufSize];
+			return ulStatus & GMAC_RX_LEN_MSK;
+		}
+
+		if(ulStatus & GMAC_RX_SOF)
+		{
+			pstRing->ulDropped++;
+		}
+		GmacRxRingAdvance(pstRing);
+	}
+}
+
+/** ***************************************************************************
+	Name:               GmacRxRingRelease
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Only after GmacRxRingPeek() returned a frame
+
+	Description:
+	Gives the buffer of the frame returned by GmacRxRingPeek() back to the
+	DMA and moves on to the next one.
+*/
+void GmacRxRingRelease(tGmacRxRing *pstRing)
+{
+	pstRing->ulFrames++;
+	GmacRxRingAdvance(pstRing);
+}
+
+/** ***************************************************************************
+	Name:               GmacTxRingInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The GMAC transmitter must be idle; ulCount must not
+	                    exceed GMAC_TX_DESCS_MAX
+
+	Description:
+	Marks every descriptor as belonging to software, so the DMA stops at the
+	first one until a frame is queued.
+*/
+void GmacTxRingInit(tGmacTxRing *pstRing, tGmacDesc *pastDesc, uint32_t ulCount)
+{
+	uint32_t i;
+
+	memset(pstRing, 0, sizeof(*pstRing));
+	pstRing->pastDesc = pastDesc;
+	pstRing->ulCount = ulCount;
+
+	for(i = 0; i < ulCount; i++)
+	{
+		pastDesc[i].ulAddr = 0;
+		pastDesc[i].ulStatus = GMAC_TX_USED
+			| ((i == ulCount - 1) ? GMAC_TX_WRAP : 0);
+	}
+	GMAC_RING_BARRIER();
+}
+
+/** ***************************************************************************
+	Name:               GmacTxRingFree
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of descriptors free for new frames
+	Caveats / Effect:   None
+
+	Description:
+	One descriptor is always kept back, so the DMA finds a descriptor that
+	belongs to software after the last queued frame even when the ring is
+	full.
+*/
+uint32_t GmacTxRingFree(tGmacTxRing const *pstRing)
+{
+	return pstRing->ulCount - 1 - pstRing->ulBusy;
+}
+
+/** ***************************************************************************
+	Name:               GmacTxRingQueue
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if there aren't enough free
+	                    descriptors
+	Caveats / Effect:   The buffers must stay untouched until the frame is
+	                    reclaimed; the transmitter still has to be started
+
+	Description:
+	Queues a frame made of ulBufs buffers, one descriptor each, without
+	copying them. The descriptors after the first are filled in before the
+	first is handed to the DMA, so the DMA never sees half a frame. pvTag is
+	returned with the completion by GmacTxRingReclaim().
+*/
+int GmacTxRingQueue(tGmacTxRing *pstRing, tGmacTxBuf const *pastBufs,
+	uint32_t ulBufs, void *pvTag)
+{
+	uint32_t const ulFirst = pstRing->ulHead;
+	uint32_t ulFirstStatus = 0;
+	uint32_t i;
+
+	if((ulBufs == 0) || (ulBufs > GmacTxRingFree(pstRing)))
+	{
+		return -1;
+	}
+
+	/* last buffer first, the first buffer's descriptor goes last */
+	for(i = ulBufs; i > 0; i--)
+	{
+		uint32_t const ulIndex = (ulFirst + i - 1) % pstRing->ulCount;
+		tGmacDesc *pstDesc = &pstRing->pastDesc[ulIndex];
+		uint32_t const ulStatus = (pastBufs[i - 1].ulLen & GMAC_TX_LEN_MSK)
+			| ((i == ulBufs) ? GMAC_TX_LAST : 0)
+			| ((ulIndex == pstRing->ulCount - 1) ? GMAC_TX_WRAP : 0);
+
+		pstDesc->ulAddr = (uint32_t)(uintptr_t)pastBufs[i - 1].pvData;
+		if(i > 1)
+		{
+			pstDesc->ulStatus = ulStatus;
+		}
+		else
+		{
+			ulFirstStatus = ulStatus;
+		}
+	}
+
+	pstRing->aucDescs[ulFirst] = (uint8_t)ulBufs;
+	pstRing->apvTag[ulFirst] = pvTag;
+	pstRing->ulHead = (ulFirst + ulBufs) % pstRing->ulCount;
+	pstRing->ulBusy += ulBufs;
+
+	GMAC_RING_BARRIER();
+	pstRing->pastDesc[ulFirst].ulStatus = ulFirstStatus;
+	GMAC_RING_BARRIER();
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               GmacTxRingReclaim
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of frames reclaimed
+	Caveats / Effect:   Calls pfnDone for each of them
+
+	Description:
+	Takes back the descriptors of the frames the DMA has finished with, in
+	order. The GMAC only marks the first descriptor of a frame as used once
+	it is sent, with any error status, so the rest are marked here.
+*/
+uint32_t GmacTxRingReclaim(tGmacTxRing *pstRing, tGmacTxDone pfnDone)
+{
+	uint32_t ulFrames = 0;
+
+	while(pstRing->ulBusy)
+	{
+		uint32_t const ulStatus = pstRing->pastDesc[pstRing->ulTail].ulStatus;
+		void *pvTag = pstRing->apvTag[pstRing->ulTail];
+
+		if(!(ulStatus & GMAC_TX_USED))
+		{
+			break;
+		}
+
+		GmacTxRingFinish(pstRing);
+		if(ulStatus & GMAC_TX_ERR_MSK)
+		{
+			pstRing->ulErrors++;
+			pfnDone(pvTag, -1);
+		}
+		else
+		{
+			pstRing->ulFrames++;
+			pfnDone(pvTag, 0);
+		}
+		ulFrames++;
+	}
+
+	return ulFrames;
+}
+
+/** ***************************************************************************
+	Name:               GmacTxRingFlush
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The GMAC transmitter must be stopped; it restarts from
+	                    the first descriptor of the ring
+
+	Description:
+	Recovers from a transmit error, after which the GMAC goes back to the
+	start of the ring. Frames already sent are reclaimed as usual, the rest
+	fail, and the ring starts over empty, keeping its counts.
+*/
+void GmacTxRingFlush(tGmacTxRing *pstRing, tGmacTxDone pfnDone)
+{
+	uint32_t ulFrames;
+	uint32_t ulErrors;
+
+	GmacTxRingReclaim(pstRing, pfnDone);
+
+	while(pstRing->ulBusy)
+	{
+		void *pvTag = pstRing->apvTag[pstRing->ulTail];
+
+		GmacTxRingFinish(pstRing);
+		pstRing->ulErrors++;
+		pfnDone(pvTag, -1);
+	}
+
+	/* the counts run on over the flush, which the errors led to */
+	ulFrames = pstRing->ulFrames;
+	ulErrors = pstRing->ulErrors;
+	GmacTxRingInit(pstRing, pstRing->pastDesc, pstRing->ulCount);
+	pstRing->ulFrames = ulFrames;
+	pstRing->ulErrors = ulErrors;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               GmacRxRingAdvance
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Gives the buffer at the head back to the DMA and moves on to the next.
+*/
+static void GmacRxRingAdvance(tGmacRxRing *pstRing)
+{
+	tGmacDesc *pstDesc = &pstRing->pastDesc[pstRing->ulHead];
+
+	/* everything read from the buffer before the DMA may write it again */
+	GMAC_RING_BARRIER();
+	pstDesc->ulAddr &= (uint32_t)~GMAC_RX_OWN;
+	if(++pstRing->ulHead >= pstRing->ulCount)
+	{
+		pstRing->ulHead = 0;
+	}
+}
+
+/** ***************************************************************************
+	Name:               GmacTxRingFinish
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Returns every descriptor of the frame at the tail to software and moves
+	the tail past it.
+*/
+static void GmacTxRingFinish(tGmacTxRing *pstRing)
+{
+	uint32_t const ulDescs = pstRing->aucDescs[pstRing->ulTail];
+	uint32_t i;
+
+	for(i = 0; i < ulDescs; i++)
+	{
+		uint32_t const ulIndex = (pstRing->ulTail + i) % pstRing->ulCount;
+
+		pstRing->pastDesc[ulIndex].ulStatus = GMAC_TX_USED
+			| ((ulIndex == pstRing->ulCount - 1) ? GMAC_TX_WRAP : 0);
+	}
+	pstRing->ulTail = (pstRing->ulTail + ulDescs) % pstRing->ulCount;
+	pstRing->ulBusy -= ulDescs;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,130 @@
+/** ***************************************************************************
+File Name:  gmac_ring.h
+
+Project:    Platform 4
+
+Purpose:    GMAC receive and transmit buffer descriptor rings: ownership
+            handover with the DMA, independent of the GMAC registers
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef GMAC_RING_H
+#define GMAC_RING_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* largest number of transmit descriptors, for the per descriptor
+	bookkeeping of tGmacTxRing */
+#ifndef GMAC_TX_DESCS_MAX
+#define GMAC_TX_DESCS_MAX         32
+#endif
+
+/* receive descriptor, address word: the buffer holds received data and
+	belongs to software, the descriptor is the last of the ring, buffer
+	address */
+#define GMAC_RX_OWN               0x00000001UL
+#define GMAC_RX_WRAP              0x00000002UL
+#define GMAC_RX_ADDR_MSK          0xFFFFFFFCUL
+/* receive descriptor, status word: start and end of frame in this buffer,
+	frame length */
+#define GMAC_RX_SOF               (1UL << 14)
+#define GMAC_RX_EOF               (1UL << 15)
+#define GMAC_RX_LEN_MSK           0x00001FFFUL
+
+/* transmit descriptor, status word: the buffer belongs to software, the
+	descriptor is the last of the ring, transmission errors reported in the
+	first descriptor of a frame, the buffer ends the frame, buffer length */
+#define GMAC_TX_USED              (1UL << 31)
+#define GMAC_TX_WRAP              (1UL << 30)
+#define GMAC_TX_ERR_MSK           ((1UL << 29) | (1UL << 27) | (1UL << 26))
+#define GMAC_TX_LAST              (1UL << 15)
+#define GMAC_TX_LEN_MSK           0x00003FFFUL
+
+
+/* Module Type Definitions */
+
+/* buffer descriptor, shared with the GMAC DMA */
+typedef struct
+{
+	volatile uint32_t ulAddr;
+	volatile uint32_t ulStatus;
+} tGmacDesc;
+
+/* one buffer of a frame to transmit */
+typedef struct
+{
+	void const *pvData;
+	uint32_t ulLen;
+} tGmacTxBuf;
+
+/* completion of a transmitted frame, with the tag it was queued with;
+	iStatus is 0, or -1 if it couldn't be sent */
+typedef void (*tGmacTxDone)(void *pvTag, int iStatus);
+
+/* receive ring: every descriptor has a buffer of ulBufSize bytes, large
+	enough for a whole frame. ulHead is the next descriptor the DMA fills */
+typedef struct
+{
+	tGmacDesc *pastDesc;
+	uint8_t *pucBufs;
+	uint32_t ulCount;
+	uint32_t ulBufSize;
+	uint32_t ulHead;
+	/* statistics: frames received, and frames dropped because they didn't
+		fit a buffer */
+	uint32_t ulFrames;
+	uint32_t ulDropped;
+} tGmacRxRing;
+
+/* transmit ring. ulHead is the next descriptor to queue to, ulTail the
+	first one still with the DMA and ulBusy the number in use. Each queued
+	frame keeps its descriptor count and tag at its first descriptor */
+typedef struct
+{
+	tGmacDesc *pastDesc;
+	uint32_t ulCount;
+	uint32_t ulHead;
+	uint32_t ulTail;
+	uint32_t ulBusy;
+	uint8_t aucDescs[GMAC_TX_DESCS_MAX];
+	void *apvTag[GMAC_TX_DESCS_MAX];
+	/* statistics: frames sent, and frames that failed */
+	uint32_t ulFrames;
+	uint32_t ulErrors;
+} tGmacTxRing;
+
+
+/* Global Function Declarations */
+
+void GmacRxRingInit(tGmacRxRing *pstRing, tGmacDesc *pastDesc, uint32_t ulCount,
+	uint8_t *pucBufs, uint32_t ulBufSize);
+uint32_t GmacRxRingPeek(tGmacRxRing *pstRing, uint8_t **ppucFrame);
+void GmacRxRingRelease(tGmacRxRing *pstRing);
+
+void GmacTxRingInit(tGmacTxRing *pstRing, tGmacDesc *pastDesc, uint32_t ulCount);
+uint32_t GmacTxRingFree(tGmacTxRing const *pstRing);
+int GmacTxRingQueue(tGmacTxRing *pstRing, tGmacTxBuf const *pastBufs,
+	uint32_t ulBufs, void *pvTag);
+uint32_t GmacTxRingReclaim(tGmacTxRing *pstRing, tGmacTxDone pfnDone);
+void GmacTxRingFlush(tGmacTxRing *pstRing, tGmacTxDone pfnDone);
+
+
+#endif /* GMAC_RING_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,893 @@
+/** ***************************************************************************
+File Name:  link.c
+
+Project:    Platform 4
+
+Purpose:    Data channel links: one Manchester USART with its own receive
+            DMA ring, transmit DMA channel, frame parser and statistics
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "dma_buf.h"
+#include "link.h"
+#include "prof.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* programmable clock feeding every link USART (US_MR_USCLKS_PCK) */
+#define LINK_PCK             PMC_PCK_4
+
+/* PCK4 sources */
+#define LINK_UPLL_HZ         480000000UL
+#define LINK_PLLA_HZ         ((uint32_t)BOARD_FREQ_MAINCK_XTAL \
+	* CONFIG_PLL0_MUL / CONFIG_PLL0_DIV)
+
+/* the links run with CD = 1, so PCK4 = oversampling * baud. Manchester
+	drift compensation only works with 16x oversampling; otherwise 8x keeps
+	PCK4 low enough for the fastest rates */
+#if LINK_MAN_DRIFT
+#define LINK_OVERSAMPLING    16
+#else
+#define LINK_OVERSAMPLING    8
+#endif
+
+#if (LINK_MAN_PREAMBLE_LEN < 0) || (LINK_MAN_PREAMBLE_LEN > 15)
+#error "LINK_MAN_PREAMBLE_LEN must be 0 to 15"
+#endif
+
+/* Manchester start frame delimiter, US_MR */
+#if LINK_MAN_SFD == LINK_MAN_SFD_ONE_BIT
+#define LINK_MAN_MR          (US_MR_MAN | US_MR_ONEBIT)
+#else
+#define LINK_MAN_MR          US_MR_MAN
+#endif
+
+/* Manchester preamble and decoder setup, US_MAN. Both directions use the
+	same preamble, so the receiver expects exactly what the far end sends */
+#define LINK_MAN_CONFIG      (US_MAN_ONE | US_MAN_RXIDLEV \
+	| US_MAN_TX_PL(LINK_MAN_PREAMBLE_LEN) \
+	| US_MAN_TX_PP(LINK_MAN_PREAMBLE_PATTERN) \
+	| US_MAN_RX_PL(LINK_MAN_PREAMBLE_LEN) \
+	| US_MAN_RX_PP(LINK_MAN_PREAMBLE_PATTERN) \
+	| (LINK_MAN_DRIFT ? US_MAN_DRIFT : 0))
+
+/* bit periods of one character on the line: preamble, start frame
+	delimiter, 8 data bits and the stop bit. Frames are timed from the start
+	of their packet at this rate, as the far end sends each packet back to
+	back from DMA */
+#define LINK_CHAR_BITS       (LINK_MAN_PREAMBLE_LEN \
+	+ ((LINK_MAN_SFD == LINK_MAN_SFD_ONE_BIT) ? 1 : 3) + 8 + 1)
+
+
+/* Module Type Definitions */
+
+/* one entry of the link clock plan */
+typedef struct
+{
+	uint32_t ulBaud;
+	/* PCK4 source, PMC_PCK_CSS_x, its frequency and the PCK4 divider (1 to
+		256) for 8x oversampling; 16x uses half the divider */
+	uint32_t ulSource;
+	uint32_t ulSourceHz;
+	uint32_t ulDiv;
+} tLinkClock;
+
+
+/* Module Function Declarations */
+
+static tLinkClock const *LinkClockFind(uint32_t ulBaud, uint32_t *pulDiv);
+static void LinkInit(tLink *pstLink, uint32_t ulIndex, uint32_t ulBaud,
+	uint32_t ulClockHz);
+static uint32_t LinkRxTimeout(uint32_t ulBaud);
+static void LinkFeed(tLink *pstLink, tLinkFrameHandler pfnFrame,
+	uint32_t ulEnd, uint32_t ulStart, uint64_t ullStartTicks);
+static void LinkUsartIsr(tLink *pstLink);
+
+
+/* Module Variable Declarations */
+
+/* hardware resources of each link, from conf_link.h */
+static tLinkConfig const astLinkConfig[LINK_COUNT] = {
+	{
+		LINK0_USART, LINK0_USART_ID, LINK0_IRQn,
+		LINK0_DMA_RX, LINK0_DMA_TX, LINK0_HWID_RX, LINK0_HWID_TX
+	},
+#if LINK_COUNT > 1
+	{
+		LINK1_USART, LINK1_USART_ID, LINK1_IRQn,
+		LINK1_DMA_RX, LINK1_DMA_TX, LINK1_HWID_RX, LINK1_HWID_TX
+	},
+#endif
+#if LINK_COUNT > 2
+	{
+		LINK2_USART, LINK2_USART_ID, LINK2_IRQn,
+		LINK2_DMA_RX, LINK2_DMA_TX, LINK2_HWID_RX, LINK2_HWID_TX
+	},
+#endif
+};
+
+static tLink astLinks[LINK_COUNT];
+
+/* supported link rates. The Manchester decoder needs an exact bit clock and
+	the fractional baud rate generator only gives an average, so each rate is
+	divided straight from the UPLL or PLLA; LinkClockFind() rejects any entry
+	that doesn't divide out exactly with the current conf_clock.h. The PLLA
+	entries are for the 230.4 MHz and 300 MHz PLLA of conf_clock.h */
+static tLinkClock const astLinkClockPlan[] = {
+	{ 18750000UL, PMC_PCK_CSS_PLLA_CLK, LINK_PLLA_HZ,  2 },
+	{ 15000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ,  4 },
+	{ 14400000UL, PMC_PCK_CSS_PLLA_CLK, LINK_PLLA_HZ,  2 },
+	{ 12500000UL, PMC_PCK_CSS_PLLA_CLK, LINK_PLLA_HZ,  3 },
+	{ 12000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ,  5 },
+	{ 10000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ,  6 },
+	{  9600000UL, PMC_PCK_CSS_PLLA_CLK, LINK_PLLA_HZ,  3 },
+	{  7500000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ,  8 },
+	{  7200000UL, PMC_PCK_CSS_PLLA_CLK, LINK_PLLA_HZ,  4 },
+	{  6000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ, 10 },
+	{  5000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ, 12 },
+	{  4000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ, 15 },
+	{  3000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ, 20 },
+	{  2000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ, 30 },
+	{  1000000UL, PMC_PCK_CSS_UPLL_CLK, LINK_UPLL_HZ, 60 },
+};
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               LinksInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if ulBaud isn't in the clock plan
+	Caveats / Effect:   The XDMAC clock must be enabled; enables the USART
+	                    interrupts and the UPLL
+
+	Description:
+	Brings up every configured link: USART in Manchester mode at ulBaud,
+	receive DMA ring running, transmit channel ready for LinkTransmit().
+	The USARTs are clocked from PCK4, set up here from the clock plan, so the
+	link rate is independent of MCK.
+*/
+int LinksInit(uint32_t ulBaud)
+{
+	uint32_t ulDiv;
+	tLinkClock const *pstClock = LinkClockFind(ulBaud, &ulDiv);
+	uint32_t i;
+
+	if(!pstClock)
+	{
+		return -1;
+	}
+
+	/* PCK4 = source / div = oversampling * baud */
+	if(pstClock->ulSource == PMC_PCK_CSS_UPLL_CLK)
+	{
+		pmc_enable_upll_clock();
+		pmc_switch_pck_to_upllck(LINK_PCK, PMC_PCK_PRES(ulDiv - 1));
+	}
+	else
+	{
+		pmc_switch_pck_to_pllack(LINK_PCK, PMC_PCK_PRES(ulDiv - 1));
+	}
+	pmc_enable_pck(LINK_PCK);
+
+	for(i = 0; i < LINK_COUNT; i++)
+	{
+		LinkInit(&astLinks[i], i, ulBaud, pstClock->ulSourceHz / ulDiv);
+	}
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               LinkGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Link ulIndex, NULL if it doesn't exist
+	Caveats / Effect:   None
+
+	Description:
+	Returns a link by its index.
+*/
+tLink *LinkGet(uint32_t ulIndex)
+{
+	if(ulIndex >= LINK_COUNT)
+	{
+		return NULL;
+	}
+	return &astLinks[ulIndex];
+}
+
+/** ***************************************************************************
+	Name:               LinkTransmit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the previous transmission is still
+	                    in progress
+	Caveats / Effect:   pvData must stay untouched until the transfer is done
+
+	Description:
+	Starts a one shot DMA transmission of ulLen bytes out the link. The
+	transfer holds a WFI sleep lock until its end of block interrupt.
+*/
+int LinkTransmit(tLink *pstLink, void const *pvData, uint32_t ulLen)
+{
+	uint32_t const ulChannel = pstLink->pstConfig->ulTxChannel;
+
+	if(xdmac_channel_get_status(XDMAC) & (1UL << ulChannel))
+	{
+		pstLink->ulTxBusy++;
+		return -1;
+	}
+
+	/* the DMA reads memory, not the data cache */
+	DmaBufClean(pvData, ulLen);
+
+	pstLink->stTxConfig.mbr_ubc = ulLen;
+	pstLink->stTxConfig.mbr_sa  = (uint32_t)pvData;
+	xdmac_configure_transfer(XDMAC, ulChannel, &pstLink->stTxConfig);
+	if(!pstLink->ucTxSleepLock)
+	{
+		sleepmgr_lock_mode(SLEEPMGR_SLEEP_WFI);
+		pstLink->ucTxSleepLock = 1;
+	}
+	xdmac_channel_enable_interrupt(XDMAC, ulChannel, XDMAC_CIE_BIE);
+	xdmac_enable_interrupt(XDMAC, ulChannel);
+	/* the first character goes out as soon as the channel is enabled */
+	pstLink->ullTxTicks = PpsTicks();
+	xdmac_channel_enable(XDMAC, ulChannel);
+	pstLink->ulTxFrames++;
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               LinkTxBusy
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Non-zero while a transmission is in progress
+	Caveats / Effect:   None
+
+	Description:
+	Tells whether LinkTransmit() would be refused, so a caller can leave the
+	buffer of the running transfer alone.
+*/
+int LinkTxBusy(tLink const *pstLink)
+{
+	return (xdmac_channel_get_status(XDMAC)
+		& (1UL << pstLink->pstConfig->ulTxChannel)) != 0;
+}
+
+/** ***************************************************************************
+	Name:               LinkTxTime
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Time byte ulOffset of the last transmission went out
+	Caveats / Effect:   None
+
+	Description:
+	Returns the PPS time of a byte of the last LinkTransmit() transfer. The
+	transfer is stamped from the time base as its DMA channel is enabled, and
+	later bytes add their offset at the character rate of the line. The
+	stamp marks the start of a character, as LinkFrameTime() does on the
+	receiving side.
+*/
+tPpsTime LinkTxTime(tLink const *pstLink, uint32_t ulOffset)
+{
+	return PpsTime(pstLink->ullTxTicks
+		+ (((uint64_t)ulOffset * pstLink->ulCharTicks) >> 16));
+}
+
+/** ***************************************************************************
+	Name:               LinkPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Pushes everything the DMA has written so far through the link's frame
+	parser, calling pfnFrame for each frame as soon as its last byte is parsed.
+	Each queued packet is parsed up to its end and then the parser is told
+	the line went idle there, so a frame cut short in one packet can't
+	swallow the start of the next however many packets have queued up. The
+	ring keeps receiving while this runs.
+	Each frame is timed from the arrival of the first byte of its packet,
+	see LinkFrameTime().
+	The packet still arriving is only parsed up to where the DMA had got to
+	when its start was read: the USART ISR may close it and start the next
+	one at any moment, and bytes past that point may already belong to the
+	next packet, which is parsed once it is queued. If the ISR queued a
+	packet after the queue was last found empty, the start it left is that
+	of the packet after it, so the queue is drained again first.
+*/
+void LinkPoll(tLink *pstLink, tLinkFrameHandler pfnFrame)
+{
+	for(;;)
+	{
+		tPktDesc const *pstPacket;
+		uint32_t ulEnd;
+		irqflags_t flags;
+		uint32_t ulStart;
+		uint32_t ulWrite;
+		uint64_t ullStartTicks;
+
+		while((pstPacket = LinkRxPacket(pstLink, &ulEnd)) != NULL)
+		{
+			if(pstPacket->ulStatus)
+			{
+				pstLink->ulRxErrors++;
+			}
+			/* the line went idle at the end of the packet, which may leave
+				bytes after a false sync word to parse again */
+			do
+			{
+				LinkFeed(pstLink, pfnFrame, ulEnd, pstLink->ulRxPktEnd,
+					pstPacket->ullTicks);
+			} while(FrameParserIdle(&pstLink->stParser));
+			LinkRxPacketDone(pstLink);
+		}
+
+		/* then the packet still arriving, whose start the USART ISR may be
+			updating */
+		flags = cpu_irq_save();
+		if(PktQueueCount(&pstLink->stRxPackets) != 0)
+		{
+			cpu_irq_restore(flags);
+			continue;
+		}
+		ulStart = pstLink->ulRxPktStart;
+		ulWrite = RxRingGetWriteCount(&pstLink->stRxRing);
+		ullStartTicks = pstLink->ucRxPktStamped
+			? pstLink->ullRxPktTicks : PpsTicks();
+		cpu_irq_restore(flags);
+
+		LinkFeed(pstLink, pfnFrame, ulWrite, ulStart, ullStartTicks);
+		return;
+	}
+}
+
+/** ***************************************************************************
+	Name:               LinkArmWake
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if the link is idle, -1 if it has data to process
+	Caveats / Effect:   Call with interrupts masked, just before sleeping
+
+	Description:
+	Checks that everything received on the link has been dealt with, and if
+	so enables the USART RXRDY interrupt so the first character of the next
+	packet wakes the core. The DMA takes the character itself; the interrupt
+	only serves as a wake up and is disabled again by the USART ISR. Without
+	it a packet shorter than a ring segment would only be seen once the
+	receiver timed out.
+	The link also counts as busy while the header of a partly received frame
+	says only a few more bytes are to come (LINK_WAKE_SPIN_BYTES): the main
+	loop then completes the frame as its last byte lands, rather than taking
+	a wake up for each of them.
+*/
+int LinkArmWake(tLink *pstLink)
+{
+	tRxRing *pstRing = &pstLink->stRxRing;
+
+	/* link down, there is nothing to wait for */
+	if(!pstRing->pastDesc)
+	{
+		return 0;
+	}
+
+	if(PktQueueCount(&pstLink->stRxPackets)
+		|| (RxRingGetWriteCount(pstRing) != pstRing->ulReadCount))
+	{
+		return -1;
+	}
+
+	{
+		uint32_t const ulRemaining = FrameParserRemaining(&pstLink->stParser);
+
+		if((ulRemaining != 0) && (ulRemaining <= LINK_WAKE_SPIN_BYTES))
+		{
+			return -1;
+		}
+	}
+
+	usart_enable_interrupt(pstLink->pstConfig->pstUsart, US_IER_RXRDY);
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               LinkRxPacket
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Oldest complete packet, NULL if none are queued
+	Caveats / Effect:   Main program loop only
+
+	Description:
+	Returns the packet at the front of the receive queue, and in *pulEnd the
+	free-running ring byte count at which it ends, for comparison with the
+	ring's ulReadCount. The packet stays queued until LinkRxPacketDone().
+*/
+tPktDesc const *LinkRxPacket(tLink *pstLink, uint32_t *pulEnd)
+{
+	tPktDesc const *pstPacket = PktQueuePeek(&pstLink->stRxPackets);
+
+	if(pstPacket)
+	{
+		*pulEnd = pstLink->ulRxPktEnd + pstPacket->ulLen;
+	}
+	return pstPacket;
+}
+
+/** ***************************************************************************
+	Name:               LinkRxPacketDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Main program loop only; a packet must be queued
+
+	Description:
+	Removes the packet at the front of the receive queue once its data has
+	been dealt with.
+*/
+void LinkRxPacketDone(tLink *pstLink)
+{
+	pstLink->ulRxPktEnd += PktQueuePeek(&pstLink->stRxPackets)->ulLen;
+	PktQueuePop(&pstLink->stRxPackets);
+}
+
+/** ***************************************************************************
+	Name:               LinkFrameTime
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Time the first byte of the current frame arrived
+	Caveats / Effect:   Only valid in the LinkPoll() frame handler
+
+	Description:
+	Returns the PPS time of the frame being handled. The USART ISR stamps the
+	first byte of every packet from the time base, less the character time
+	RXRDY waits for, so the stamp marks the start of the first character; a
+	frame further into the packet adds its offset at the character rate of
+	the line.
+	The stamp is late by the latency of the USART interrupt, which no
+	correction can remove: up to the longest run of another handler of the
+	same or a higher NVIC priority (every handler but the USB one), or of a
+	section with interrupts masked, plus about 12 core cycles of entry. The
+	worst case is therefore the largest such ISR time the profiler reports
+	(prof.h); the tick itself adds up to one period of PPS_TICK_HZ.
+*/
+tPpsTime LinkFrameTime(tLink const *pstLink)
+{
+	return PpsTime(pstLink->ullFrameTicks);
+}
+
+/** ***************************************************************************
+	Name:               LinkErrors
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Running count of corrupt or truncated frames
+	Caveats / Effect:   None
+
+	Description:
+	Totals the parser error counters of a link.
+*/
+uint32_t LinkErrors(tLink const *pstLink)
+{
+	return pstLink->stParser.ulCrcErrors
+		+ pstLink->stParser.ulLenErrors
+		+ pstLink->stParser.ulTruncated;
+}
+
+/** ***************************************************************************
+	Name:               LinkDmaIsr
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the XDMAC ISR only
+
+	Description:
+	Services the link's receive ring channel, and releases the sleep lock of a
+	finished LinkTransmit() transfer. The XDMAC has a single interrupt for all
+	channels, so XDMAC_Handler calls this for every link. The transmit
+	channel is only looked at while a LinkTransmit() transfer holds the lock,
+	as the bit error rate test reuses it with its own interrupt handling.
+*/
+TCM_CODE void LinkDmaIsr(tLink *pstLink)
+{
+	/* is this the end of block (segment complete) interrupt? */
+	if(xdmac_channel_get_interrupt_status(XDMAC,
+		pstLink->pstConfig->ulRxChannel) & XDMAC_CIS_BIS)
+	{
+		RxRingSegmentDone(&pstLink->stRxRing);
+	}
+
+	if(pstLink->ucTxSleepLock
+		&& (xdmac_channel_get_interrupt_status(XDMAC,
+			pstLink->pstConfig->ulTxChannel) & XDMAC_CIS_BIS))
+	{
+		pstLink->ucTxSleepLock = 0;
+		sleepmgr_unlock_mode(SLEEPMGR_SLEEP_WFI);
+	}
+}
+
+/** ***************************************************************************
+	Name:               LINKn_HANDLER
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   ISR
+
+	Description:
+	USART interrupt of each link, see conf_link.h for the vector names.
+*/
+TCM_CODE void LINK0_HANDLER(void)
+{
+	uint32_t ulProfStart;
+
+	PROF_START(ulProfStart);
+	LinkUsartIsr(&astLinks[0]);
+	PROF_END(PROF_SITE_LINK0_ISR, ulProfStart);
+}
+
+#if LINK_COUNT > 1
+TCM_CODE void LINK1_HANDLER(void)
+{
+	uint32_t ulProfStart;
+
+	PROF_START(ulProfStart);
+	LinkUsartIsr(&astLinks[1]);
+	PROF_END(PROF_SITE_LINK1_ISR, ulProfStart);
+}
+#endif
+
+#if LINK_COUNT > 2
+TCM_CODE void LINK2_HANDLER(void)
+{
+	uint32_t ulProfStart;
+
+	PROF_START(ulProfStart);
+	LinkUsartIsr(&astLinks[2]);
+	PROF_END(PROF_SITE_LINK2_ISR, ulProfStart);
+}
+#endif
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               LinkClockFind
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Clock plan entry for ulBaud, NULL if there is none
+	Caveats / Effect:   None
+
+	Description:
+	Looks up a link rate in the clock plan and checks that it is exact: the
+	source must divide down to exactly LINK_OVERSAMPLING * ulBaud, and the
+	resulting PCK4 may not be faster than MCK, which the USARTs require. The
+	PCK4 divider for LINK_OVERSAMPLING is returned in *pulDiv.
+*/
+static tLinkClock const *LinkClockFind(uint32_t ulBaud, uint32_t *pulDiv)
+{
+	uint32_t const ulMck = sysclk_get_peripheral_hz();
+	uint32_t i;
+
+	for(i = 0; i < sizeof(astLinkClockPlan) / sizeof(astLinkClockPlan[0]); i++)
+	{
+		tLinkClock const *pstClock = &astLinkClockPlan[i];
+		uint32_t const ulDiv = pstClock->ulDiv * 8 / LINK_OVERSAMPLING;
+		uint32_t ulPck;
+
+		if((pstClock->ulBaud != ulBaud)
+			|| ((pstClock->ulDiv * 8) % LINK_OVERSAMPLING != 0)
+			|| (ulDiv < 1) || (ulDiv > 256))
+		{
+			continue;
+		}
+
+		ulPck = pstClock->ulSourceHz / ulDiv;
+		if((ulPck * ulDiv == pstClock->ulSourceHz)
+			&& (ulPck == ulBaud * LINK_OVERSAMPLING)
+			&& (ulPck <= ulMck))
+		{
+			*pulDiv = ulDiv;
+			return pstClock;
+		}
+	}
+
+	return NULL;
+}
+
+/** ***************************************************************************
+	Name:               LinkInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Initializes one link from its entry in astLinkConfig[]. ulClockHz is the
+	PCK4 frequency.
+*/
+static void LinkInit(tLink *pstLink, uint32_t ulIndex, uint32_t ulBaud,
+	uint32_t ulClockHz)
+{
+	tLinkConfig const *pstConfig = &astLinkConfig[ulIndex];
+	Usart *pstUsart = pstConfig->pstUsart;
+	sam_usart_opt_t stSettings = {
+		0,
+		US_MR_CHRL_8_BIT,
+		US_MR_PAR_NO,
+		US_MR_NBSTOP_1_BIT,
+		US_MR_CHMODE_NORMAL,
+		0
+	};
+
+	memset(pstLink, 0, sizeof(*pstLink));
+	pstLink->pstConfig = pstConfig;
+	pstLink->ulIndex = ulIndex;
+	pstLink->ulCharTicks = (uint32_t)((((uint64_t)PPS_TICK_HZ * LINK_CHAR_BITS)
+		<< 16) / ulBaud);
+
+	/* XDMAC USART transmission channel config, without descriptors */
+	xdmac_channel_set_descriptor_control(XDMAC, pstConfig->ulTxChannel,
+		XDMAC_CNDC_NDE_DSCR_FETCH_DIS);
+	pstLink->stTxConfig.mbr_da  = (uint32_t)&pstUsart->US_THR;
+	pstLink->stTxConfig.mbr_cfg = XDMAC_CC_TYPE_PER_TRAN
+		| XDMAC_CC_DSYNC_MEM2PER
+		| XDMAC_CC_SWREQ_HWR_CONNECTED
+		| XDMAC_CC_CSIZE_CHK_1
+		| XDMAC_CC_DWIDTH_BYTE
+		| XDMAC_CC_SIF_AHB_IF1
+		| XDMAC_CC_DIF_AHB_IF1
+		| XDMAC_CC_SAM_INCREMENTED_AM
+		| XDMAC_CC_DAM_FIXED_AM
+		| XDMAC_CC_PERID(pstConfig->ulTxPerId);
+
+	/* XDMAC USART reception ring, started once and left running. It only
+		fails if the non-cacheable DMA pool is too small for its descriptors,
+		in which case the link is left down */
+	FrameParserInit(&pstLink->stParser);
+	PktQueueInit(&pstLink->stRxPackets);
+	if(RxRingInit(&pstLink->stRxRing, pstConfig->ulRxChannel,
+		(uint32_t)&pstUsart->US_RHR, pstConfig->ulRxPerId))
+	{
+		return;
+	}
+	RxRingStart(&pstLink->stRxRing);
+
+	/* configure USART */
+	stSettings.baudrate = ulBaud;
+	sysclk_enable_peripheral_clock(pstConfig->ulUsartId);
+	usart_init_rs232(pstUsart, &stSettings, ulClockHz);
+	pstUsart->US_MR |= US_MR_USCLKS_PCK; // Baud clock from PCK4
+	pstUsart->US_MR |= LINK_MAN_MR; // Enable Manchester encoder, SFD
+	pstUsart->US_MAN = LINK_MAN_CONFIG; // Preamble, drift compensation
+	usart_set_rx_timeout(pstUsart, LinkRxTimeout(ulBaud));
+	usart_enable_interrupt(pstUsart, US_IER_TIMEOUT | US_IER_RXRDY);
+	usart_enable_tx(pstUsart);
+	usart_enable_rx(pstUsart);
+	usart_start_rx_timeout(pstUsart);
+	NVIC_EnableIRQ(pstConfig->eIrq);
+}
+
+/** ***************************************************************************
+	Name:               LinkRxTimeout
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Receiver timeout in bit periods
+	Caveats / Effect:   None
+
+	Description:
+	Converts half of LINK_FRAME_GAP_US to bit periods at ulBaud, clamped to
+	LINK_RX_TIMEOUT_MIN and the size of the USART timeout counter.
+*/
+static uint32_t LinkRxTimeout(uint32_t ulBaud)
+{
+	uint32_t const ulTimeout =
+		(uint32_t)(((uint64_t)ulBaud * LINK_FRAME_GAP_US) / 2000000);
+
+	if(ulTimeout < LINK_RX_TIMEOUT_MIN)
+	{
+		return LINK_RX_TIMEOUT_MIN;
+	}
+	if(ulTimeout > US_RTOR_TO_Msk)
+	{
+		return US_RTOR_TO_Msk;
+	}
+	return ulTimeout;
+}
+
+/** ***************************************************************************
+	Name:               LinkFeed
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Pushes received data through the link's frame parser until the ring's
+	read count reaches ulEnd or the data runs out, calling pfnFrame for each
+	frame as soon as its last byte is parsed, including frames the parser
+	finds going back over bytes after a false sync word. The data belongs to the packet
+	whose first byte is at ring byte count ulStart and arrived at time base
+	tick count ullStartTicks, which times the frames.
+*/
+static void LinkFeed(tLink *pstLink, tLinkFrameHandler pfnFrame,
+	uint32_t ulEnd, uint32_t ulStart, uint64_t ullStartTicks)
+{
+	tRxRing *pstRing = &pstLink->stRxRing;
+	uint8_t const *pucData = NULL;
+
+	for(;;)
+	{
+		uint32_t ulLen = 0;
+
+		/* signed, as an overrun can move the read count past ulEnd */
+		if((int32_t)(ulEnd - pstRing->ulReadCount) > 0)
+		{
+			ulLen = RxRingPeek(pstRing, &pucData);
+			if(ulLen > ulEnd - pstRing->ulReadCount)
+			{
+				ulLen = ulEnd - pstRing->ulReadCount;
+			}
+		}
+		RxRingConsume(pstRing,
+			FrameParserFeed(&pstLink->stParser, pucData, ulLen));
+
+		if(FrameParserReady(&pstLink->stParser))
+		{
+			/* bytes from the start of the packet to the start of the frame */
+			int32_t const lOffset = (int32_t)(pstRing->ulReadCount - ulStart
+				- FrameParserPending(&pstLink->stParser)
+				- FrameGetLength(&pstLink->stParser) - FRAME_OVERHEAD);
+
+			pstLink->ullFrameTicks = ullStartTicks;
+			if(lOffset > 0)
+			{
+				pstLink->ullFrameTicks +=
+					((uint64_t)lOffset * pstLink->ulCharTicks) >> 16;
+			}
+			pfnFrame(pstLink);
+		}
+		else if(ulLen == 0)
+		{
+			/* the data and any bytes the parser went back over are done */
+			break;
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               LinkUsartIsr
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the link's USART ISR only
+
+	Description:
+	The USART interrupt fires on the first character of each packet, which
+	is stamped from the time base, on the first character after
+	LinkArmWake(), which only needs to wake the core, and when the RX timeout
+	expires. The timeout signals the end of the transmission, so everything
+	the DMA has written since the last timeout is queued for the main program
+	loop as one packet, along with the time of its first byte and any
+	receiver errors. If the queue is full the packet is merged into the next
+	one. The RX DMA ring is left running so the next packet can start
+	arriving straight away.
+*/
+static TCM_CODE void LinkUsartIsr(tLink *pstLink)
+{
+	Usart *pstUsart = pstLink->pstConfig->pstUsart;
+	uint32_t const ul_status = usart_get_status(pstUsart);
+
+	/* first character of a packet, or after the main loop went to sleep
+		(see LinkArmWake()) */
+	if(usart_get_interrupt_mask(pstUsart) & US_IMR_RXRDY)
+	{
+		usart_disable_interrupt(pstUsart, US_IDR_RXRDY);
+		if(!pstLink->ucRxPktStamped)
+		{
+			/* RXRDY rises once the whole first character is in, so it
+				started a character time earlier */
+			pstLink->ullRxPktTicks = PpsTicks() - (pstLink->ulCharTicks >> 16);
+			pstLink->ucRxPktStamped = 1;
+		}
+	}
+
+	/* is this a timeout interrupt? */
+	if(ul_status & US_IER_TIMEOUT)
+	{
+		/* reset the RX timeout, it will reactivate when the next character is
+			received */
+		usart_start_rx_timeout(pstUsart);
+		pstLink->ulIdleCount++;
+
+		/* queue the packet for the main program loop */
+		{
+			uint32_t const ulEnd = RxRingGetWriteCount(&pstLink->stRxRing);
+			tPktDesc stPacket;
+
+			stPacket.pucData =
+				&pstLink->stRxRing.aucData[pstLink->ulRxPktStart % RX_RING_SIZE];
+			stPacket.ulLen = ulEnd - pstLink->ulRxPktStart;
+			stPacket.ullTicks = pstLink->ucRxPktStamped
+				? pstLink->ullRxPktTicks : PpsTicks();
+			pstLink->ulRxPktStatus |= ul_status
+				& (US_CSR_OVRE | US_CSR_FRAME | US_CSR_PARE | US_CSR_MANERR);
+			stPacket.ulStatus = pstLink->ulRxPktStatus;
+			if(stPacket.ulStatus)
+			{
+				usart_reset_status(pstUsart);
+			}
+
+			if((stPacket.ulLen != 0)
+				&& (PktQueuePush(&pstLink->stRxPackets, &stPacket) == 0))
+			{
+				/* stamp the first character of the next packet */
+				pstLink->ulRxPktStart = ulEnd;
+				pstLink->ulRxPktStatus = 0;
+				pstLink->ucRxPktStamped = 0;
+				usart_enable_interrupt(pstUsart, US_IER_RXRDY);
+			}
+		}
+	}
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
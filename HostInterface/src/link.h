@@ -0,0 +1,140 @@
+/** ***************************************************************************
+File Name:  link.h
+
+Project:    Platform 4
+
+Purpose:    Data channel links: one Manchester USART with its own receive
+            DMA ring, transmit DMA channel, frame parser and statistics
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef LINK_H
+#define LINK_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "conf_link.h"
+#include "frame.h"
+#include "pkt_queue.h"
+#include "pps.h"
+#include "rx_ring.h"
+
+
+/* Module Definitions */
+
+#if (LINK_COUNT < 1) || (LINK_COUNT > 3)
+#error "LINK_COUNT must be 1, 2 or 3"
+#endif
+
+/* shortest receiver timeout, in bit periods. The timeout marking the end of
+	a transmission is derived from LINK_FRAME_GAP_US and the line rate, but
+	is kept above a few character times so a brief stall of the far end's
+	transmit DMA doesn't split a frame */
+#ifndef LINK_RX_TIMEOUT_MIN
+#define LINK_RX_TIMEOUT_MIN 48
+#endif
+
+/* when no more than this many bytes of a partly received frame are still
+	to come, the main loop waits for them instead of sleeping, as they are
+	due within a few character times */
+#ifndef LINK_WAKE_SPIN_BYTES
+#define LINK_WAKE_SPIN_BYTES 16
+#endif
+
+
+/* Module Type Definitions */
+
+/* fixed hardware resources of a link */
+typedef struct
+{
+	Usart *pstUsart;
+	uint32_t ulUsartId;
+	IRQn_Type eIrq;
+	/* XDMAC channels and the matching peripheral hardware interface IDs */
+	uint32_t ulRxChannel;
+	uint32_t ulTxChannel;
+	uint32_t ulRxPerId;
+	uint32_t ulTxPerId;
+} tLinkConfig;
+
+/* link state */
+typedef struct
+{
+	tLinkConfig const *pstConfig;
+	/* index of the link, 0 to LINK_COUNT - 1 */
+	uint32_t ulIndex;
+	/* continuously running receive DMA ring, and the parser it feeds */
+	tRxRing stRxRing;
+	tFrameParser stParser;
+	/* one shot transmit DMA configuration, the source is set per transfer */
+	xdmac_channel_config_t stTxConfig;
+	/* a LinkTransmit() transfer is running and holds a sleep lock */
+	volatile uint8_t ucTxSleepLock;
+	/* time base ticks when the last LinkTransmit() transfer was started,
+		see LinkTxTime() */
+	uint64_t ullTxTicks;
+	/* packets delimited by the receiver timeout (line idle), queued by the
+		USART ISR. Packets follow each other in the ring, so ulRxPktStart
+		(USART ISR) is where the current one started and ulRxPktEnd (main
+		loop) is where the one at the front of the queue starts, both as
+		free-running ring byte counts. ulRxPktStatus collects the receiver
+		errors of the current packet and ullRxPktTicks is the time its first
+		byte arrived, once ucRxPktStamped is set (USART ISR) */
+	tPktQueue stRxPackets;
+	uint32_t ulRxPktStart;
+	uint32_t ulRxPktEnd;
+	uint32_t ulRxPktStatus;
+	uint64_t ullRxPktTicks;
+	volatile uint8_t ucRxPktStamped;
+	/* time base ticks per character on the line, 16.16 fixed point, and the
+		time the first byte of the frame passed to the frame handler arrived,
+		see LinkFrameTime() */
+	uint32_t ulCharTicks;
+	uint64_t ullFrameTicks;
+	/* statistics; ulRxErrors counts the packets that arrived with receiver
+		errors (overrun, framing, parity or Manchester), see tPktDesc */
+	uint32_t ulTxFrames;
+	uint32_t ulTxBusy;
+	uint32_t ulRxErrors;
+	volatile uint32_t ulIdleCount;
+} tLink;
+
+/* called by LinkPoll() for every valid frame, which can be read with the
+	frame.h accessors on pstLink->stParser */
+typedef void (*tLinkFrameHandler)(tLink *pstLink);
+
+
+/* Global Function Declarations */
+
+int LinksInit(uint32_t ulBaud);
+tLink *LinkGet(uint32_t ulIndex);
+int LinkTransmit(tLink *pstLink, void const *pvData, uint32_t ulLen);
+int LinkTxBusy(tLink const *pstLink);
+tPpsTime LinkTxTime(tLink const *pstLink, uint32_t ulOffset);
+void LinkPoll(tLink *pstLink, tLinkFrameHandler pfnFrame);
+int LinkArmWake(tLink *pstLink);
+tPktDesc const *LinkRxPacket(tLink *pstLink, uint32_t *pulEnd);
+void LinkRxPacketDone(tLink *pstLink);
+tPpsTime LinkFrameTime(tLink const *pstLink);
+uint32_t LinkErrors(tLink const *pstLink);
+void LinkDmaIsr(tLink *pstLink);
+
+
+#endif /* LINK_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
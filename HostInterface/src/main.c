@@ -20,6 +20,7 @@ Modified:   $Id$
 ******************************************************************************/
 
 /* System Include Files */
+#include <stdio.h>
 #include <string.h>
 
 /* Local Include Files */
@@ -27,6 +28,26 @@ Modified:   $Id$
 #include "conf_board.h"
 #include "conf_clock.h"
 #include "conf_example.h"
+#include "bench.h"
+#include "ber.h"
+#include "bridge.h"
+#include "burst.h"
+#include "crc.h"
+#include "frame.h"
+#include "link.h"
+#include "net.h"
+#include "pps.h"
+#include "pps_out.h"
+#include "prof.h"
+#include "psd.h"
+#include "qlog.h"
+#include "qspi.h"
+#include "rec.h"
+#include "sd.h"
+#include "sdram.h"
+#include "tcm.h"
+#include "tsync.h"
+#include "udp_bridge.h"
 
 
 /* Module Definitions */
@@ -36,47 +57,284 @@ Modified:   $Id$
 	USB COM port, otherwise the program locks up */
 #define USB_ENABLE 0
 
+/* prefix each payload sent out the USB COM port with the PPS time the first
+	byte of its frame arrived, as "<seconds>.<nanoseconds> " */
+#define FRAME_TIME_ENABLE 1
+
+/* stream the raw received data of the links straight out the USB COM ports
+	(link N to port N) from the receive DMA rings, instead of parsing it and
+	forwarding the frame payloads (requires USB_ENABLE) */
+#define USB_BRIDGE_ENABLE 0
+
+/* run the CRC/frame parser benchmarks at startup and print the results out
+	the USB COM port (requires USB_ENABLE) */
+#define BENCHMARK_ENABLE 0
+
+/* replace the 1 Hz framed test data with a continuous PRBS bit error rate
+	test, reporting once a second out the USB COM port (if USB_ENABLE) */
+#define BER_TEST_ENABLE 0
+/* test sequence: PRBS_7, PRBS_15 or PRBS_23 */
+#define BER_PRBS_ORDER PRBS_15
+
+/* report the run time statistics of the ISRs and main loop out the USB COM
+	port every PROF_REPORT_PERIOD seconds, each report covering the period
+	since the last (requires USB_ENABLE; the instrumentation itself is
+	switched by PROF_ENABLE in prof.h) */
+#define PROF_REPORT_ENABLE 0
+#define PROF_REPORT_PERIOD 10
+
+/* report the PPS servo state, phase error, frequency error and drift out
+	the USB COM port once a second (requires USB_ENABLE) */
+#define PPS_REPORT_ENABLE 0
+
+/* exchange time sync messages with the far end of link TSYNC_LINK,
+	measuring the path delay and the offset of its clock from ours
+	(TSYNC_ROLE TSYNC_MASTER), or of ours from its (TSYNC_SLAVE).
+	TSYNC_ASYMMETRY_NS is the path delay out minus the path delay back, which
+	the exchange can't measure. The results go out with the PPS report.
+	The messages share the link with the data, so the far end must expect
+	them */
+#define TSYNC_ENABLE 0
+#define TSYNC_ROLE TSYNC_MASTER
+#define TSYNC_LINK 0
+#define TSYNC_ASYMMETRY_NS 0
+
+/* bring up the Ethernet port (conf_net.h): answer ARP and ping, and find
+	the UDP destination (requires CONF_BOARD_GMAC) */
+#define ETH_ENABLE 0
+
+/* stream the raw received data of every link out the Ethernet port as UDP
+	datagrams, link N to port NET_UDP_PORT + N, straight from the receive DMA
+	rings instead of parsing it (requires ETH_ENABLE) */
+#define UDP_BRIDGE_ENABLE 0
+
+/* pass the bridged data (USB_BRIDGE_ENABLE, UDP_BRIDGE_ENABLE) through a
+	burst buffer in the external SDRAM (conf_burst.h), which holds seconds of
+	it while the USB host or the network stalls instead of the few
+	milliseconds the receive rings do. The SDRAM shares pins with USART2
+	(CONF_BOARD_USART2) */
+#define BURST_ENABLE 0
+
+/* record every received frame payload to the SD card, whether or not it
+	also goes out over USB (requires CONF_BOARD_SD; see conf_rec.h) */
+#define RECORD_ENABLE 0
+
+/* measure the SD card's write throughput and worst write stall at startup
+	and print them out the USB COM port (requires USB_ENABLE and
+	CONF_BOARD_SD) */
+#define SD_BENCH_ENABLE 0
+#define SD_BENCH_BYTES (16UL * 1024 * 1024)
+
+/* keep a post-mortem log in the QSPI flash (conf_qlog.h): the reset cause
+	at startup, the link and PPS statistics every LOG_STATS_PERIOD seconds,
+	and an event with the start of the parser's frame buffer when a link
+	sees corrupt or truncated frames, at most one a second per link
+	(requires CONF_BOARD_QSPI) */
+#define LOG_ENABLE 0
+#define LOG_STATS_PERIOD 10
+#define LOG_SNIPPET_SIZE 64
+
+/* print the log left by the previous runs out the USB COM port at startup
+	(requires USB_ENABLE and LOG_ENABLE) */
+#define LOG_DUMP_ENABLE 0
+
+/* reduce the frame payloads of every link, taken as 16 bit samples, to
+	averaged power spectral densities (Welch, see conf_psd.h) and send them
+	out the USB vendor bulk interface (usb_stream.h), a few percent of the
+	raw data rate. The payloads stop going out the USB COM port unless
+	PSD_RAW_ENABLE is set as well (requires USB_ENABLE) */
+#define PSD_ENABLE 0
+#define PSD_RAW_ENABLE 0
+
 /* enable the down-stream power supply
 	Note: DO NOT ENABLE if the TX/RX signals are connected together! */
 #define DOWN_STREAM_POWER_ENABLE 0
 
-/* character that marks the start of a data packet */
-#define SYNC_CHAR '*'
-/* length of the packet preamble/sync pattern */
-#define SYNC_SEQ_LEN 3
-/* size of the data block being sent */
-#define BUFFER_SIZE sizeof(acTxBuffer)
+/* number of filler bytes sent ahead of each frame. Without a Manchester
+	preamble the receiver usually loses the first character of a
+	transmission while it locks on */
+#if LINK_MAN_PREAMBLE_LEN > 0
+#define TX_LEAD_IN 0
+#else
+#define TX_LEAD_IN 2
+#endif
 
-#define TEST_DATA "  *Lorem ipsum dolor sit amet, consectetur adipiscing elit,"\
+#define TEST_DATA "Lorem ipsum dolor sit amet, consectetur adipiscing elit,"\
 	" sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut en"\
 	"im ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut ali"\
 	"quip ex ea commodo consequat. Duis aute irure dolor in reprehenderit in v"\
 	"oluptate velit esse cillum dolore eu fugiat nulla pariatur. Excepteur sin"\
 	"t occaecat cupidatat non proident, sunt in culpa qui officia deserunt mol"\
-	"lit anim id est laborum.\r\n";
+	"lit anim id est laborum.\r\n"
+
+/* size of the test payload */
+#define TEST_DATA_SIZE (sizeof(TEST_DATA) - 1)
+
+#if USB_BRIDGE_ENABLE && !USB_ENABLE
+#error "USB_BRIDGE_ENABLE requires USB_ENABLE"
+#endif
+#if USB_BRIDGE_ENABLE && BER_TEST_ENABLE
+#error "the bit error rate test reads the receive rings itself, it can't be bridged"
+#endif
+#if PROF_REPORT_ENABLE && (!USB_ENABLE || USB_BRIDGE_ENABLE)
+#error "PROF_REPORT_ENABLE needs the USB COM port to itself"
+#endif
+#if PPS_REPORT_ENABLE && (!USB_ENABLE || USB_BRIDGE_ENABLE)
+#error "PPS_REPORT_ENABLE needs the USB COM port to itself"
+#endif
+#if PSD_ENABLE && (!USB_ENABLE || USB_BRIDGE_ENABLE)
+#error "PSD_ENABLE requires USB_ENABLE, and frames to parse"
+#endif
+#if TSYNC_ENABLE && BER_TEST_ENABLE
+#error "the bit error rate test has the links to itself, time sync can't share them"
+#endif
+#if TSYNC_ENABLE && USB_BRIDGE_ENABLE && (TSYNC_LINK < UDI_CDC_PORT_NB)
+#error "time sync needs the frame parser of TSYNC_LINK, it can't be bridged"
+#endif
+#if ETH_ENABLE && !defined(CONF_BOARD_GMAC)
+#error "ETH_ENABLE requires CONF_BOARD_GMAC for the RMII pins"
+#endif
+#if UDP_BRIDGE_ENABLE && !ETH_ENABLE
+#error "UDP_BRIDGE_ENABLE requires ETH_ENABLE"
+#endif
+#if UDP_BRIDGE_ENABLE && (USB_BRIDGE_ENABLE || BER_TEST_ENABLE || TSYNC_ENABLE)
+#error "the UDP bridge reads every receive ring itself, it can't share them"
+#endif
+#if BURST_ENABLE && !(USB_BRIDGE_ENABLE || UDP_BRIDGE_ENABLE)
+#error "BURST_ENABLE requires USB_BRIDGE_ENABLE or UDP_BRIDGE_ENABLE"
+#endif
+#if BURST_ENABLE && defined(CONF_BOARD_USART2)
+#error "BURST_ENABLE needs the SDRAM, whose pins CONF_BOARD_USART2 takes"
+#endif
+#if (RECORD_ENABLE || SD_BENCH_ENABLE) && !defined(CONF_BOARD_SD)
+#error "RECORD_ENABLE and SD_BENCH_ENABLE require CONF_BOARD_SD for the HSMCI pins"
+#endif
+#if SD_BENCH_ENABLE && !USB_ENABLE
+#error "SD_BENCH_ENABLE requires USB_ENABLE"
+#endif
+#if LOG_ENABLE && !defined(CONF_BOARD_QSPI)
+#error "LOG_ENABLE requires CONF_BOARD_QSPI for the flash pins"
+#endif
+#if LOG_DUMP_ENABLE && !(LOG_ENABLE && USB_ENABLE)
+#error "LOG_DUMP_ENABLE requires LOG_ENABLE and USB_ENABLE"
+#endif
 
 
 /* Module Type Definitions */
 
+#if LOG_ENABLE
+/* flash log records (LOG_ENABLE), as they are in memory */
+typedef struct
+{
+	/* RSTC_SR.RSTTYP of the reset we came out of */
+	uint32_t ulResetType;
+	/* the flash, and the wear of the log's sectors */
+	uint32_t ulJedecId;
+	uint32_t ulMinErases;
+	uint32_t ulMaxErases;
+} tLogBoot;
+
+typedef struct
+{
+	uint32_t ulPpsState;
+	int32_t lPhaseNs;
+	int32_t lFreqPpb;
+	/* log records dropped so far */
+	uint32_t ulLogDropped;
+	struct
+	{
+		uint32_t ulFrames;
+		uint32_t ulCrcErrors;
+		uint32_t ulLenErrors;
+		uint32_t ulTruncated;
+		uint32_t ulSeqLost;
+		uint32_t ulOverruns;
+		uint32_t ulLostBytes;
+		/* receive packet queue overflows and deepest backlog, and packets
+			with receiver errors */
+		uint32_t ulPktOverflows;
+		uint32_t ulPktHighWater;
+		uint32_t ulRxErrors;
+	} astLink[LINK_COUNT];
+} tLogStats;
+
+typedef struct
+{
+	uint32_t ulLink;
+	uint32_t ulCrcErrors;
+	uint32_t ulLenErrors;
+	uint32_t ulTruncated;
+	uint8_t aucSnippet[LOG_SNIPPET_SIZE];
+} tLogEvent;
+#endif
+
 /* Module Function Declarations */
 
 static void InitHardware(void);
+static void IdleSleep(void);
+static void ProcessFrame(tLink *pstLink);
+#if TSYNC_ENABLE
+static int TsyncTransmit(void *pvContext, uint8_t const *pucMsg,
+	uint32_t ulLen, uint64_t *pullTxTime);
+#endif
+#if BER_TEST_ENABLE
+static void ReportBer(uint32_t ulLink);
+#endif
+#if PROF_REPORT_ENABLE
+static void ReportProf(void);
+#endif
+#if PPS_REPORT_ENABLE
+static void ReportPps(void);
+#endif
+#if BENCHMARK_ENABLE
+static uint32_t BenchCycles(void);
+static void RunBenchmark(void);
+#endif
+#if SD_BENCH_ENABLE
+static void RunSdBenchmark(void);
+#endif
+#if LOG_ENABLE
+static void LogBoot(void);
+static void LogStats(void);
+static void LogEvents(void);
+#endif
+#if LOG_DUMP_ENABLE
+static void DumpLog(void);
+#endif
 
 
 /* Module Variable Declarations */
 
-/* transmit buffer */
-static const char acTxBuffer[] = TEST_DATA;
-/* receive buffer */
-static volatile char acRxBuffer[BUFFER_SIZE] = { 0 };
-
-/* DMA configuration structures */
-static xdmac_channel_config_t stTxConfig;
-static xdmac_channel_config_t stRxConfig;
+#if BER_TEST_ENABLE
+/* bit error rate test transmitter and receive checker of each link */
+static tBerTx astBerTx[LINK_COUNT];
+static tPrbsCheck astBerCheck[LINK_COUNT];
+static uint32_t aulBerRxBytes[LINK_COUNT];
+static volatile char cBerReportDue = 0;
+#else
+/* transmit buffer of each link: lead-in followed by a framed copy of
+	TEST_DATA */
+static uint8_t aaucTxBuffer[LINK_COUNT][TX_LEAD_IN + TEST_DATA_SIZE + FRAME_OVERHEAD];
+static uint16_t ausTxSeq[LINK_COUNT];
+#endif
+#if TSYNC_ENABLE
+/* time sync exchange on TSYNC_LINK and the transmit buffer of its messages,
+	framed like the test data */
+static tTsync stTsync;
+static uint8_t aucTsyncTxBuffer[TX_LEAD_IN + TSYNC_MSG_MAX + FRAME_OVERHEAD];
+#endif
 
 /* state/signaling variables */
 static volatile char cLastRxSuccess = 0;
-static volatile char cNewDataReceved = 0;
+#if PROF_REPORT_ENABLE
+static volatile char cProfReportDue = 0;
+#endif
+#if PPS_REPORT_ENABLE
+static volatile char cPpsReportDue = 0;
+#endif
+#if LOG_ENABLE
+static volatile char cLogStatsDue = 0;
+#endif
 
 
 /* Global Variables (Must be justified!) */
@@ -97,68 +355,166 @@ static volatile char cNewDataReceved = 0;
 */
 int main(void)
 {
+#if !BER_TEST_ENABLE
+	uint32_t ulLastErrors = 0;
+#endif
+#if USB_BRIDGE_ENABLE || UDP_BRIDGE_ENABLE
+	uint32_t ulLastBridged = 0;
+#endif
+	uint32_t ulProfStart;
+	uint32_t i;
+
 	/* system initialization */
 	sysclk_init();
 	board_init();
-	SCB_DisableDCache();
+	CrcInit();
 	InitHardware();
 
+#if BENCHMARK_ENABLE
+	RunBenchmark();
+#endif
+#if SD_BENCH_ENABLE
+	RunSdBenchmark();
+#endif
+#if LOG_DUMP_ENABLE
+	/* before the first QlogPoll(), which starts erasing the oldest sector */
+	DumpLog();
+#endif
+
 	while(1)
 	{
-		char *pcBuffer;
+		PROF_START(ulProfStart);
+
+#if ETH_ENABLE
+		/* answer received frames, release sent ones, and once a second follow
+			the PHY link and the destination's address */
+		NetPoll(PPS_TIME_SECONDS(PpsNow()));
+#endif
+
+#if BER_TEST_ENABLE
+		/* check everything the DMA has written so far against the test
+			sequence */
+		for(i = 0; i < LINK_COUNT; i++)
+		{
+			tRxRing *pstRing = &LinkGet(i)->stRxRing;
+			uint8_t const *pucData;
+			uint32_t ulLen;
+
+			while((ulLen = RxRingPeek(pstRing, &pucData)) != 0)
+			{
+				PrbsCheck(&astBerCheck[i], pucData, ulLen);
+				RxRingConsume(pstRing, ulLen);
+				aulBerRxBytes[i] += ulLen;
+			}
+		}
+
+		if(cBerReportDue)
+		{
+			cBerReportDue = 0;
+			for(i = 0; i < LINK_COUNT; i++)
+			{
+				ReportBer(i);
+			}
+		}
+#else
+		uint32_t ulErrors = 0;
+#if USB_BRIDGE_ENABLE || UDP_BRIDGE_ENABLE
+		uint32_t ulBridged = 0;
+#endif
+
+		/* push everything received on each link through its frame parser.
+			Frames are handled as soon as their last byte is parsed, and the
+			rings keep receiving while we do this */
+		for(i = 0; i < LINK_COUNT; i++)
+		{
+#if USB_BRIDGE_ENABLE
+			/* bridged links go to the host as they are */
+			if(i < UDI_CDC_PORT_NB)
+			{
+				BridgePoll(i);
+				ulBridged += BridgeGet(i)->ulBytes;
+				/* data the ring wrote over while it was being sent */
+				ulErrors += BridgeGet(i)->ulLapped;
+				continue;
+			}
+#endif
+#if UDP_BRIDGE_ENABLE
+			/* bridged links go out the Ethernet port as they are */
+			UdpBridgePoll(i);
+			ulBridged += UdpBridgeGet(i)->ulBytes;
+			continue;
+#endif
+			{
+				uint32_t ulPollStart;
+
+				PROF_START(ulPollStart);
+				LinkPoll(LinkGet(i), ProcessFrame);
+				PROF_END(PROF_SITE_LINK_POLL, ulPollStart);
+			}
+			ulErrors += LinkErrors(LinkGet(i));
+		}
+
+#if TSYNC_ENABLE
+		/* start the next exchange when it is due, retry a message the link
+			was busy for */
+		TsyncPoll(&stTsync, PpsNow());
+#endif
 
-		/* wait for a data packet to arrive */
-		while(!cNewDataReceved) {};
-		cNewDataReceved = 0;
+#if RECORD_ENABLE
+		/* keep the card writing staged frames */
+		RecPoll(PpsNow());
+#endif
 
-		/* find the sync char in the RX buffer, which indicates the start of a
-			message */
-		pcBuffer = (char*)memchr((void*)acRxBuffer, SYNC_CHAR, BUFFER_SIZE) + 1;
+#if LOG_ENABLE
+		/* note link errors while the parsers still hold the data, the
+			statistics when they are due, and keep the flash writing */
+		LogEvents();
+		if(cLogStatsDue)
+		{
+			cLogStatsDue = 0;
+			LogStats();
+		}
+		QlogPoll(PpsNow());
+#endif
 
-		/* verify the sync char was found, and that the received message
-			matches the sent message */
-		if(pcBuffer
-			&& !memcmp(acTxBuffer+SYNC_SEQ_LEN, pcBuffer, BUFFER_SIZE-SYNC_SEQ_LEN))
+#if USB_BRIDGE_ENABLE || UDP_BRIDGE_ENABLE
+		/* bridged data reached the host, signal success */
+		if(ulBridged != ulLastBridged)
 		{
-			/* the message was good, signal success */
+			ulLastBridged = ulBridged;
 			cLastRxSuccess = 1;
 			ioport_set_pin_level(LED0_GPIO, LED0_ACTIVE_LEVEL);
 		}
-		else
+#endif
+
+		/* any corrupt or truncated frame, signal failure */
+		if(ulErrors != ulLastErrors)
 		{
-			/* bad message, signal failure */
+			ulLastErrors = ulErrors;
 			cLastRxSuccess = 0;
 			ioport_set_pin_level(LED0_GPIO, LED0_INACTIVE_LEVEL);
 		}
+#endif
 
-#if USB_ENABLE
+		PROF_END(PROF_SITE_MAIN_LOOP, ulProfStart);
+
+#if PROF_REPORT_ENABLE
+		if(cProfReportDue)
 		{
-			/* if USB is enabled, print the received data out the USB virtual
-				serial port */
-			unsigned int i;
-			for(i = 0; i < BUFFER_SIZE - SYNC_SEQ_LEN; i++)
-			{
-				while(!udi_cdc_is_tx_ready()) {};
-				if(pcBuffer[i] != '\0')
-				{
-					udi_cdc_putc(pcBuffer[i]);
-				}
-			}
+			cProfReportDue = 0;
+			ReportProf();
 		}
 #endif
-
-		/* now the packet has been processed, prepare to receive the next */
+#if PPS_REPORT_ENABLE
+		if(cPpsReportDue)
 		{
-			/* ensure the USART Receive Holding Register is empty */
-			uint32_t dummy;
-			usart_read(USART1, &dummy);
-			UNUSED(dummy);
+			cPpsReportDue = 0;
+			ReportPps();
 		}
-		/* clear the RX buffer */
-		memset((void*)acRxBuffer, 0, BUFFER_SIZE);
-		/* restart the RX DMA to receive the next incoming message */
-		xdmac_configure_transfer(XDMAC, DMA_CHANNEL_RX, &stRxConfig);
-		xdmac_channel_enable(XDMAC, DMA_CHANNEL_RX);
+#endif
+
+		/* nothing left to do until the next interrupt */
+		IdleSleep();
 	}
 
 	/* we should never get here */
@@ -175,17 +531,51 @@ int main(void)
 	Caveats / Effect:   ISR
 
 	Description:
-	This is a 1 Hz ISR, driven by timer 1 channel 0. It re-starts the TX DMA
-	channel and clears the status LED if no data has come in over the last
-	second.
+	This is a 1 Hz ISR, driven by timer 1 channel 0. It builds the next test
+	frame for each link, re-starts their TX DMA channels and clears the status
+	LED if no data has come in over the last second. In the bit error rate test the sequence
+	is sent continuously, so it only requests a progress report.
+	It also schedules the run time statistics report (PROF_REPORT_ENABLE),
+	the PPS servo report (PPS_REPORT_ENABLE) and the statistics records of
+	the flash log (LOG_ENABLE).
 */
-void TC3_Handler(void)
+TCM_CODE void TC3_Handler(void)
 {
-	uint32_t const status = tc_get_status(TC1, 0);
+	uint32_t ulProfStart;
+	uint32_t status;
+
+	PROF_START(ulProfStart);
+	status = tc_get_status(TC1, 0);
 
 	/* make sure we are servicing the right interrupt */
 	if(status & TC_SR_CPCS)
 	{
+#if PROF_REPORT_ENABLE
+		static uint32_t ulProfSeconds = 0;
+
+		if(++ulProfSeconds >= PROF_REPORT_PERIOD)
+		{
+			ulProfSeconds = 0;
+			cProfReportDue = 1;
+		}
+#endif
+#if PPS_REPORT_ENABLE
+		cPpsReportDue = 1;
+#endif
+#if LOG_ENABLE
+		{
+			static uint32_t ulLogSeconds = 0;
+
+			if(++ulLogSeconds >= LOG_STATS_PERIOD)
+			{
+				ulLogSeconds = 0;
+				cLogStatsDue = 1;
+			}
+		}
+#endif
+#if BER_TEST_ENABLE
+		cBerReportDue = 1;
+#else
 		/* was data successfully received over the last second? */
 		if(!cLastRxSuccess)
 		{
@@ -193,14 +583,38 @@ void TC3_Handler(void)
 			ioport_set_pin_level(LED0_GPIO, LED0_INACTIVE_LEVEL);
 		}
 		cLastRxSuccess = 0;
-		/* start the TX DMA to begin the next packet transmission */
-		xdmac_configure_transfer(XDMAC, DMA_CHANNEL_TX, &stTxConfig);
-		xdmac_channel_enable(XDMAC, DMA_CHANNEL_TX);
+		/* frame the test data with the next sequence number, and start the
+			TX DMA to begin its transmission. While a time sync frame is still
+			going out the test frame waits for the next second; the sequence
+			number is only used up by a frame that goes out, so the far end
+			doesn't count a frame that was never sent as lost */
+		{
+			uint32_t i;
+
+			for(i = 0; i < LINK_COUNT; i++)
+			{
+				tLink *pstLink = LinkGet(i);
+
+				if(!LinkTxBusy(pstLink))
+				{
+					FrameBuild(&aaucTxBuffer[i][TX_LEAD_IN], ausTxSeq[i],
+						TEST_DATA, TEST_DATA_SIZE);
+					if(LinkTransmit(pstLink, aaucTxBuffer[i],
+						sizeof(aaucTxBuffer[i])) == 0)
+					{
+						ausTxSeq[i]++;
+					}
+				}
+			}
+		}
+#endif
 	}
+
+	PROF_END(PROF_SITE_TC3_ISR, ulProfStart);
 }
 
 /** ***************************************************************************
-	Name:               USART1_Handler
+	Name:               XDMAC_Handler
 
 	Creator:            Tristan Losier
 	Last Changed By:    Tristan Losier
@@ -209,64 +623,740 @@ void TC3_Handler(void)
 	Caveats / Effect:   ISR
 
 	Description:
-	This ISR fires when the USART RX timeout expires. This signals the end of
-	the transmission, so we use the opportunity to stop the RX DMA transaction
-	and signal the main program loop to deal with the received data.
+	This ISR fires each time a link's RX DMA ring fills a segment. The channel
+	moves on to the next segment by itself, so all we do is account for the
+	segment for overrun detection; the main program loop drains the rings by
+	polling.
+	In the bit error rate test it also fires as each TX segment is sent, so
+	it can be refilled with the next part of the sequence.
 */
-void USART1_Handler(void)
+TCM_CODE void XDMAC_Handler(void)
 {
-	uint32_t const ul_status = usart_get_status(USART1);
-
-	/* is this a timeout interrupt? */
-	if(ul_status & US_IER_TIMEOUT)
-	{
-		/* reset the RX timeout, it will reactivate when the next character is
-			received */
-		usart_start_rx_timeout(USART1);
-		/* stop the RX DMA */
-		xdmac_channel_disable(XDMAC, DMA_CHANNEL_RX);
-		/* wait for the DMA to finish writing any buffered data */
-		while(xdmac_channel_get_status(XDMAC) & XDMAC_GS_ST2) {};
-		/* signal the main program loop to process the received packet */
-		cNewDataReceved = 1;
+	uint32_t ulProfStart;
+	uint32_t i;
+
+	PROF_START(ulProfStart);
+
+	for(i = 0; i < LINK_COUNT; i++)
+	{
+		LinkDmaIsr(LinkGet(i));
+
+#if BER_TEST_ENABLE
+		if(xdmac_channel_get_interrupt_status(XDMAC, astBerTx[i].ulChannel)
+			& XDMAC_CIS_BIS)
+		{
+			BerTxSegmentDone(&astBerTx[i]);
+		}
+#endif
 	}
+
+	PROF_END(PROF_SITE_XDMAC_ISR, ulProfStart);
 }
 
+
+/* Module Function Implementations */
+
+#if BER_TEST_ENABLE
 /** ***************************************************************************
-	Name:               XDMAC_Handler
+	Name:               ReportBer
 
 	Creator:            Tristan Losier
 	Last Changed By:    Tristan Losier
 
 	Output:             None
-	Caveats / Effect:   ISR
+	Caveats / Effect:   None
+
+	Description:
+	Reports the bit error rate test progress of a link out the USB virtual
+	serial port, along with the bytes sent and received since the last report
+	(i.e. the throughput, as this runs once a second). The status LED shows
+	whether the checker of link 0 is locked to the sequence.
+*/
+static void ReportBer(uint32_t ulLink)
+{
+	static uint32_t aulLastTxSegs[LINK_COUNT];
+	static uint32_t aulLastRxBytes[LINK_COUNT];
+	uint32_t const ulTxSegs = astBerTx[ulLink].ulSegCount;
+	uint32_t const ulTxBytes =
+		(ulTxSegs - aulLastTxSegs[ulLink]) * BER_TX_SEGMENT_SIZE;
+	uint32_t const ulRxBytes = aulBerRxBytes[ulLink] - aulLastRxBytes[ulLink];
+
+	aulLastTxSegs[ulLink] = ulTxSegs;
+	aulLastRxBytes[ulLink] = aulBerRxBytes[ulLink];
+
+#if USB_ENABLE
+	{
+		char acLine[168];
+		uint32_t ulLen = (uint32_t)snprintf(acLine, sizeof(acLine),
+			"link %lu ", (unsigned long)ulLink);
+
+		ulLen += BerFormat(&astBerCheck[ulLink], BER_PRBS_ORDER,
+			ulTxBytes, ulRxBytes, &acLine[ulLen], sizeof(acLine) - ulLen);
+
+		if(udi_cdc_is_tx_ready())
+		{
+			udi_cdc_write_buf(acLine, ulLen);
+		}
+	}
+#else
+	UNUSED(ulTxBytes);
+	UNUSED(ulRxBytes);
+#endif
+
+	if(ulLink == 0)
+	{
+		ioport_set_pin_level(LED0_GPIO, astBerCheck[0].ucLocked
+			? LED0_ACTIVE_LEVEL : LED0_INACTIVE_LEVEL);
+	}
+}
+#endif
+
+#if PROF_REPORT_ENABLE
+/** ***************************************************************************
+	Name:               ReportProf
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Clears the statistics
 
 	Description:
-	This ISR fires when the RX DMA channel finishes a transaction. This won't
-	normally happen as the first character sent is usually lost, causing the
-	DMA channel to hang waiting for the lost byte (and thus the need for the
-	USART timeout interrupt). But if the whole packet gets through, we can use
-	this interrupt to restart the USART timeout and signal the main program
-	loop to deal with the received data.
+	Reports the run time statistics of every instrumented site out the USB
+	virtual serial port, then starts a new reporting period. Times are in core
+	clock cycles; the histogram buckets are log2 of the run time.
 */
-void XDMAC_Handler(void)
+static void ReportProf(void)
 {
-	uint32_t const status =
-		xdmac_channel_get_interrupt_status(XDMAC, DMA_CHANNEL_RX);
+	static uint32_t ulLastCycles = 0;
+	uint32_t const ulCycles = PROF_CYCLES();
+	/* the cycle counter stops while the core sleeps, so the cycles counted
+		over the period give the fraction of time spent awake */
+	uint32_t const ulAwake = (uint32_t)(((uint64_t)(ulCycles - ulLastCycles)
+		* 10000) / ((uint64_t)sysclk_get_cpu_hz() * PROF_REPORT_PERIOD));
+	char acLine[256];
+	uint32_t ulLen;
+	uint32_t i;
+
+	ulLastCycles = ulCycles;
+	if(!udi_cdc_is_tx_ready())
+	{
+		return;
+	}
 
-	/* is this the transaction complete interrupt? */
-	if(status & XDMAC_CIS_BIS)
+	ulLen = (uint32_t)snprintf(acLine, sizeof(acLine),
+		"awake %lu.%02lu%%, cycles at %lu Hz: runs min/avg/max, start interval min/max, histogram\r\n",
+		(unsigned long)(ulAwake / 100), (unsigned long)(ulAwake % 100),
+		(unsigned long)sysclk_get_cpu_hz());
+	udi_cdc_write_buf(acLine, ulLen);
+
+	for(i = 0; i < PROF_SITES; i++)
 	{
-		/* reset the RX timeout, it will reactivate when the next character is
-			received */
-		usart_start_rx_timeout(USART1);
-		/* signal the main program loop to process the received packet */
-		cNewDataReceved = 1;
+		ulLen = ProfFormat(i, acLine, sizeof(acLine));
+		udi_cdc_write_buf(acLine, ulLen);
 	}
+
+	ProfReset();
 }
+#endif
 
+#if PPS_REPORT_ENABLE
+/** ***************************************************************************
+	Name:               ReportPps
 
-/* Module Function Implementations */
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Reports the PPS time and the servo estimates out the USB virtual serial
+	port: state, phase error of the last edge, crystal frequency error and
+	drift, and the edge, glitch, step and holdover counts, followed by the time
+	sync results (TSYNC_ENABLE).
+*/
+static void ReportPps(void)
+{
+	static char const * const apcStates[] = {
+		"free", "acquire", "locked", "holdover"
+	};
+	tPps const *pstPps = PpsGet();
+	tPpsTime const tNow = PpsNow();
+	char acLine[192];
+	uint32_t ulLen;
+
+	if(!udi_cdc_is_tx_ready())
+	{
+		return;
+	}
+
+	ulLen = (uint32_t)snprintf(acLine, sizeof(acLine),
+		"pps %lu.%09lu %s phase %ld ns freq %ld ppb drift %ld ppt/s edges %lu glitches %lu steps %lu holdover %lu s\r\n",
+		(unsigned long)PPS_TIME_SECONDS(tNow), (unsigned long)PPS_TIME_NS(tNow),
+		apcStates[pstPps->ucState], (long)pstPps->lPhaseNs,
+		(long)pstPps->lFreqPpb, (long)pstPps->lDriftPpt,
+		(unsigned long)pstPps->ulEdges, (unsigned long)pstPps->ulGlitches,
+		(unsigned long)pstPps->ulSteps, (unsigned long)pstPps->ulHoldover);
+	if(ulLen >= sizeof(acLine))
+	{
+		ulLen = sizeof(acLine) - 1;
+	}
+	udi_cdc_write_buf(acLine, ulLen);
+
+#if PPS_OUT_ENABLE
+	ulLen = (uint32_t)snprintf(acLine, sizeof(acLine),
+		"pps out %lu pulses %lu skipped\r\n",
+		(unsigned long)PpsOutGetStats()->ulPulses,
+		(unsigned long)PpsOutGetStats()->ulSkipped);
+	udi_cdc_write_buf(acLine, ulLen);
+#endif
+#if TSYNC_ENABLE
+	if(stTsync.ucValid)
+	{
+		ulLen = (uint32_t)snprintf(acLine, sizeof(acLine),
+			"tsync offset %lld ns delay %lld ns exchanges %lu timeouts %lu rejected %lu\r\n",
+			(long long)stTsync.llOffsetNs, (long long)stTsync.llDelayNs,
+			(unsigned long)stTsync.ulExchanges,
+			(unsigned long)stTsync.ulTimeouts,
+			(unsigned long)stTsync.ulRejected);
+		udi_cdc_write_buf(acLine, ulLen);
+	}
+#endif
+}
+#endif
+
+#if BENCHMARK_ENABLE
+/** ***************************************************************************
+	Name:               BenchCycles
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Current core cycle count
+	Caveats / Effect:   None
+
+	Description:
+	Cycle counter for the benchmarks, reads the DWT cycle counter started by
+	ProfInit().
+*/
+static uint32_t BenchCycles(void)
+{
+	return PROF_CYCLES();
+}
+
+/** ***************************************************************************
+	Name:               RunBenchmark
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Blocks until a USB serial console is connected
+
+	Description:
+	Runs the processing benchmarks with interrupts masked and prints the
+	results out the USB virtual serial port.
+*/
+static void RunBenchmark(void)
+{
+	tBenchResult astResults[BENCH_RESULTS];
+	uint32_t ulCount;
+	uint32_t i;
+
+	cpu_irq_disable();
+	ulCount = BenchRun(BenchCycles, astResults);
+	cpu_irq_enable();
+
+	for(i = 0; i < ulCount; i++)
+	{
+		char acLine[96];
+		uint32_t const ulLen = BenchFormat(&astResults[i], acLine, sizeof(acLine));
+
+		while(!udi_cdc_is_tx_ready()) {};
+		udi_cdc_write_buf(acLine, ulLen);
+	}
+}
+#endif
+
+#if SD_BENCH_ENABLE
+/** ***************************************************************************
+	Name:               RunSdBenchmark
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Blocks until a USB serial console is connected and
+	                    SD_BENCH_BYTES have been written to the card
+
+	Description:
+	Writes SD_BENCH_BYTES to the card in recorder sized chunks and prints
+	the card, the throughput and the slowest write out the USB virtual
+	serial port. The recorder keeps up as long as the throughput is well
+	above the link rate and the slowest write is shorter than the time it
+	takes the link to fill the staging chunks.
+*/
+static void RunSdBenchmark(void)
+{
+	tSd const *pstSd = SdGet();
+	tRecBench stResult;
+	char acLine[160];
+	int iLen;
+
+	if(!pstSd->ucReady)
+	{
+		iLen = snprintf(acLine, sizeof(acLine), "SD: no card\r\n");
+	}
+	else if(RecBench(SD_BENCH_BYTES, &stResult) != 0)
+	{
+		iLen = snprintf(acLine, sizeof(acLine), "SD: benchmark failed\r\n");
+	}
+	else
+	{
+		/* kB/ms is MB/s, to three places */
+		uint32_t const ulRate = (uint32_t)((uint64_t)stResult.ulBytes * 1000
+			/ 1024 / ((stResult.ulElapsedUs / 1000) ? (stResult.ulElapsedUs / 1000) : 1));
+
+		iLen = snprintf(acLine, sizeof(acLine), "SD: %lu MB card at %lu kHz%s,"
+			" %lu KB in %lu ms = %lu.%03lu MB/s, worst write %lu us,"
+			" %lu errors\r\n",
+			(unsigned long)(pstSd->ulBlocks / 2048),
+			(unsigned long)(pstSd->ulClockHz / 1000),
+			pstSd->ucHighSpeed ? " high speed" : "",
+			(unsigned long)(stResult.ulBytes / 1024),
+			(unsigned long)(stResult.ulElapsedUs / 1000),
+			(unsigned long)(ulRate / 1000), (unsigned long)(ulRate % 1000),
+			(unsigned long)stResult.ulMaxWriteUs,
+			(unsigned long)stResult.ulErrors);
+	}
+
+	while(!udi_cdc_is_tx_ready()) {};
+	udi_cdc_write_buf(acLine, (iLen > 0) ? (iram_size_t)iLen : 0);
+}
+#endif
+
+#if LOG_ENABLE
+/** ***************************************************************************
+	Name:               LogBoot
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call once, after QlogStart()
+
+	Description:
+	Logs the startup, with the cause of the reset (RSTC_SR.RSTTYP: power on,
+	backup, watchdog, software or the reset pin) and the wear of the log.
+*/
+static void LogBoot(void)
+{
+	tLogBoot stBoot;
+
+	stBoot.ulResetType = (RSTC->RSTC_SR & RSTC_SR_RSTTYP_Msk)
+		>> RSTC_SR_RSTTYP_Pos;
+	stBoot.ulJedecId = QspiGet()->ulJedecId;
+	stBoot.ulMinErases = QlogGet()->ulMinErases;
+	stBoot.ulMaxErases = QlogGet()->ulMaxErases;
+	QlogWrite(QLOG_TYPE_BOOT, PpsNow(), &stBoot, sizeof(stBoot));
+}
+
+/** ***************************************************************************
+	Name:               LogStats
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Logs the PPS servo and each link's counters, so the log shows how things
+	stood up to LOG_STATS_PERIOD seconds before a reset.
+*/
+static void LogStats(void)
+{
+	tPps const *pstPps = PpsGet();
+	tLogStats stStats;
+	uint32_t i;
+
+	stStats.ulPpsState = pstPps->ucState;
+	stStats.lPhaseNs = pstPps->lPhaseNs;
+	stStats.lFreqPpb = pstPps->lFreqPpb;
+	stStats.ulLogDropped = QlogGet()->ulDropped;
+	for(i = 0; i < LINK_COUNT; i++)
+	{
+		tLink const *pstLink = LinkGet(i);
+
+		stStats.astLink[i].ulFrames = pstLink->stParser.ulFrames;
+		stStats.astLink[i].ulCrcErrors = pstLink->stParser.ulCrcErrors;
+		stStats.astLink[i].ulLenErrors = pstLink->stParser.ulLenErrors;
+		stStats.astLink[i].ulTruncated = pstLink->stParser.ulTruncated;
+		stStats.astLink[i].ulSeqLost = pstLink->stParser.ulSeqLost;
+		stStats.astLink[i].ulOverruns = pstLink->stRxRing.ulOverruns;
+		stStats.astLink[i].ulLostBytes = pstLink->stRxRing.ulLostBytes;
+		stStats.astLink[i].ulPktOverflows = pstLink->stRxPackets.ulOverflows;
+		stStats.astLink[i].ulPktHighWater = pstLink->stRxPackets.ulHighWater;
+		stStats.astLink[i].ulRxErrors = pstLink->ulRxErrors;
+	}
+	QlogWrite(QLOG_TYPE_STATS, PpsNow(), &stStats, sizeof(stStats));
+}
+
+/** ***************************************************************************
+	Name:               LogEvents
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the main program loop, after LinkPoll()
+
+	Description:
+	Logs a link seeing a corrupt, wrong length or truncated frame, with the
+	start of the parser's frame buffer, which still holds the bad frame the
+	parser gave up on. A burst of errors gives one event a second; the
+	counters in the event say how many there were.
+*/
+static void LogEvents(void)
+{
+	static uint32_t aulLastErrors[LINK_COUNT];
+	static uint32_t aulLastSecond[LINK_COUNT];
+	tPpsTime const tNow = PpsNow();
+	uint32_t i;
+
+	for(i = 0; i < LINK_COUNT; i++)
+	{
+		tLink const *pstLink = LinkGet(i);
+		tFrameParser const *pstParser = &pstLink->stParser;
+		uint32_t const ulErrors = pstParser->ulCrcErrors
+			+ pstParser->ulLenErrors + pstParser->ulTruncated;
+		tLogEvent stEvent;
+
+		if((ulErrors == aulLastErrors[i])
+			|| (aulLastSecond[i] == PPS_TIME_SECONDS(tNow)))
+		{
+			continue;
+		}
+		aulLastErrors[i] = ulErrors;
+		aulLastSecond[i] = PPS_TIME_SECONDS(tNow);
+
+		stEvent.ulLink = pstLink->ulIndex;
+		stEvent.ulCrcErrors = pstParser->ulCrcErrors;
+		stEvent.ulLenErrors = pstParser->ulLenErrors;
+		stEvent.ulTruncated = pstParser->ulTruncated;
+		memcpy(stEvent.aucSnippet, pstParser->aucBuf, sizeof(stEvent.aucSnippet));
+		QlogWrite(QLOG_TYPE_EVENT, tNow, &stEvent, sizeof(stEvent));
+	}
+}
+#endif
+
+#if LOG_DUMP_ENABLE
+/** ***************************************************************************
+	Name:               DumpLog
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Blocks until a USB serial console is connected and
+	                    the whole log has been printed. Call before the
+	                    first QlogPoll()
+
+	Description:
+	Prints every record in the log, oldest first, out the USB virtual serial
+	port: one line per record, event snippets in hex.
+*/
+static void DumpLog(void)
+{
+	static tQlogRecord stRecord;
+	tQlogCursor stCursor;
+	char acLine[256];
+	int iRead;
+
+	QlogReadStart(&stCursor);
+	while((iRead = QlogRead(&stCursor, &stRecord)) != 0)
+	{
+		int iLen;
+		uint32_t i;
+
+		if(iRead < 0)
+		{
+			/* nothing is programming yet, so the flash stopped answering */
+			iLen = snprintf(acLine, sizeof(acLine), "log: flash read failed\r\n");
+			while(!udi_cdc_is_tx_ready()) {};
+			udi_cdc_write_buf(acLine, (iLen > 0) ? (iram_size_t)iLen : 0);
+			break;
+		}
+
+		iLen = snprintf(acLine, sizeof(acLine), "log %lu.%09lu ",
+			(unsigned long)PPS_TIME_SECONDS(stRecord.tTime),
+			(unsigned long)(((stRecord.tTime & 0xFFFFFFFFULL) * 1000000000ULL) >> 32));
+		if((stRecord.ucType == QLOG_TYPE_BOOT)
+			&& (stRecord.usLen == sizeof(tLogBoot)))
+		{
+			tLogBoot stBoot;
+
+			memcpy(&stBoot, stRecord.aucData, sizeof(stBoot));
+			iLen += snprintf(&acLine[iLen], sizeof(acLine) - iLen,
+				"boot reset %lu flash %06lx erases %lu-%lu",
+				(unsigned long)stBoot.ulResetType,
+				(unsigned long)stBoot.ulJedecId,
+				(unsigned long)stBoot.ulMinErases,
+				(unsigned long)stBoot.ulMaxErases);
+		}
+		else if((stRecord.ucType == QLOG_TYPE_STATS)
+			&& (stRecord.usLen == sizeof(tLogStats)))
+		{
+			tLogStats stStats;
+
+			memcpy(&stStats, stRecord.aucData, sizeof(stStats));
+			iLen += snprintf(&acLine[iLen], sizeof(acLine) - iLen,
+				"stats pps %lu phase %ld ns freq %ld ppb dropped %lu",
+				(unsigned long)stStats.ulPpsState, (long)stStats.lPhaseNs,
+				(long)stStats.lFreqPpb, (unsigned long)stStats.ulLogDropped);
+			for(i = 0; i < LINK_COUNT; i++)
+			{
+				while(!udi_cdc_is_tx_ready()) {};
+				udi_cdc_write_buf(acLine, (iLen > 0) ? (iram_size_t)iLen : 0);
+				iLen = snprintf(acLine, sizeof(acLine),
+					"\r\n  link %lu: %lu frames %lu crc %lu len %lu trunc"
+					" %lu seq %lu overruns %lu lost %lu rx errors"
+					" queue %lu overflows %lu deep",
+					(unsigned long)i,
+					(unsigned long)stStats.astLink[i].ulFrames,
+					(unsigned long)stStats.astLink[i].ulCrcErrors,
+					(unsigned long)stStats.astLink[i].ulLenErrors,
+					(unsigned long)stStats.astLink[i].ulTruncated,
+					(unsigned long)stStats.astLink[i].ulSeqLost,
+					(unsigned long)stStats.astLink[i].ulOverruns,
+					(unsigned long)stStats.astLink[i].ulLostBytes,
+					(unsigned long)stStats.astLink[i].ulRxErrors,
+					(unsigned long)stStats.astLink[i].ulPktOverflows,
+					(unsigned long)stStats.astLink[i].ulPktHighWater);
+			}
+		}
+		else if((stRecord.ucType == QLOG_TYPE_EVENT)
+			&& (stRecord.usLen == sizeof(tLogEvent)))
+		{
+			tLogEvent stEvent;
+
+			memcpy(&stEvent, stRecord.aucData, sizeof(stEvent));
+			iLen += snprintf(&acLine[iLen], sizeof(acLine) - iLen,
+				"link %lu errors crc %lu len %lu trunc %lu\r\n  ",
+				(unsigned long)stEvent.ulLink,
+				(unsigned long)stEvent.ulCrcErrors,
+				(unsigned long)stEvent.ulLenErrors,
+				(unsigned long)stEvent.ulTruncated);
+			for(i = 0; (i < LOG_SNIPPET_SIZE) && (iLen > 0)
+				&& ((uint32_t)iLen + 3 < sizeof(acLine)); i++)
+			{
+				iLen += snprintf(&acLine[iLen], sizeof(acLine) - iLen, "%02x",
+					stEvent.aucSnippet[i]);
+			}
+		}
+		else
+		{
+			iLen += snprintf(&acLine[iLen], sizeof(acLine) - iLen,
+				"type %u, %u bytes", stRecord.ucType, stRecord.usLen);
+		}
+		if((iLen < 0) || ((uint32_t)iLen > sizeof(acLine) - 3))
+		{
+			iLen = sizeof(acLine) - 3;
+		}
+		acLine[iLen++] = '\r';
+		acLine[iLen++] = '\n';
+		while(!udi_cdc_is_tx_ready()) {};
+		udi_cdc_write_buf(acLine, (iram_size_t)iLen);
+	}
+}
+#endif
+
+/** ***************************************************************************
+	Name:               IdleSleep
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Returns after the next interrupt has been serviced, or
+	                    straight away if there is work to do
+
+	Description:
+	Puts the core in WFI sleep once the main program loop has nothing left to
+	do. Every source of work is an interrupt: DMA segments, receiver timeouts,
+	the first character of a packet (LinkArmWake()), the 1 Hz timer and USB.
+	Interrupts stay masked from the final check through the WFI; a pending
+	interrupt still wakes the core and is taken as soon as they are unmasked.
+	sleepmgr_enter_sleep() unmasks them before the WFI, so an interrupt
+	arriving in between would be serviced and then slept through.
+	Only WFI sleep is used, whatever the sleep locks allow, as the links must
+	keep receiving. The time from leaving the WFI until the main loop resumes,
+	including the ISRs that woke the core, is recorded as PROF_SITE_WAKE.
+*/
+static void IdleSleep(void)
+{
+	uint32_t ulWake;
+	uint32_t i;
+
+	cpu_irq_disable();
+
+	if(sleepmgr_get_sleep_mode() == SLEEPMGR_ACTIVE)
+	{
+		cpu_irq_enable();
+		return;
+	}
+#if BER_TEST_ENABLE
+	if(cBerReportDue)
+	{
+		cpu_irq_enable();
+		return;
+	}
+#endif
+#if PROF_REPORT_ENABLE
+	if(cProfReportDue)
+	{
+		cpu_irq_enable();
+		return;
+	}
+#endif
+#if PPS_REPORT_ENABLE
+	if(cPpsReportDue)
+	{
+		cpu_irq_enable();
+		return;
+	}
+#endif
+#if LOG_ENABLE
+	if(cLogStatsDue)
+	{
+		cpu_irq_enable();
+		return;
+	}
+#endif
+	for(i = 0; i < LINK_COUNT; i++)
+	{
+		if(LinkArmWake(LinkGet(i)) != 0)
+		{
+			cpu_irq_enable();
+			return;
+		}
+	}
+
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+	__DSB();
+	__WFI();
+
+	PROF_START(ulWake);
+	cpu_irq_enable();
+	PROF_END(PROF_SITE_WAKE, ulWake);
+}
+
+/** ***************************************************************************
+	Name:               ProcessFrame
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Deals with a valid frame from a link's receive parser. The CRC has already
+	been checked, so the frame is good; signal success and forward the payload.
+	Time sync messages are stamped with the frame time and kept back.
+	With PSD_ENABLE the payload goes into the link's spectrum.
+*/
+static void ProcessFrame(tLink *pstLink)
+{
+	tFrameParser *pstParser = &pstLink->stParser;
+
+	cLastRxSuccess = 1;
+	ioport_set_pin_level(LED0_GPIO, LED0_ACTIVE_LEVEL);
+
+#if TSYNC_ENABLE
+	if((pstLink == LinkGet(TSYNC_LINK)) && TsyncIsMessage(
+		FrameGetPayload(pstParser), FrameGetLength(pstParser)))
+	{
+		TsyncReceive(&stTsync, FrameGetPayload(pstParser),
+			FrameGetLength(pstParser), LinkFrameTime(pstLink));
+		return;
+	}
+#endif
+
+#if RECORD_ENABLE
+	/* a copy of the payload goes to the SD card, dropped if the card has
+		fallen too far behind */
+	RecWrite(pstLink->ulIndex, LinkFrameTime(pstLink),
+		FrameGetPayload(pstParser), FrameGetLength(pstParser));
+#endif
+
+#if PSD_ENABLE
+	PsdWrite(pstLink->ulIndex, FrameGetSeq(pstParser), LinkFrameTime(pstLink),
+		FrameGetPayload(pstParser), FrameGetLength(pstParser));
+#endif
+
+#if USB_ENABLE && (!PSD_ENABLE || PSD_RAW_ENABLE)
+#if FRAME_TIME_ENABLE
+	{
+		tPpsTime const tTime = LinkFrameTime(pstLink);
+		char acTime[24];
+		int iLen = snprintf(acTime, sizeof(acTime), "%lu.%09lu ",
+			(unsigned long)PPS_TIME_SECONDS(tTime),
+			(unsigned long)PPS_TIME_NS(tTime));
+
+		udi_cdc_write_buf(acTime, (iLen > 0) ? (iram_size_t)iLen : 0);
+	}
+#endif
+	/* if USB is enabled, send the payload out the USB virtual serial port */
+	udi_cdc_write_buf(FrameGetPayload(pstParser), FrameGetLength(pstParser));
+#else
+	UNUSED(pstParser);
+#endif
+}
+
+#if TSYNC_ENABLE
+/** ***************************************************************************
+	Name:               TsyncTransmit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the link is busy
+	Caveats / Effect:   Masks interrupts while the transmission is started
+
+	Description:
+	Sends a time sync message out TSYNC_LINK as a frame, and returns the time
+	the first byte of the frame went out. The test frames of TC3_Handler share
+	the link and its sequence numbers, so this runs with interrupts masked;
+	that also keeps the transmit stamp next to the start of the transfer.
+*/
+static int TsyncTransmit(void *pvContext, uint8_t const *pucMsg,
+	uint32_t ulLen, uint64_t *pullTxTime)
+{
+	tLink *pstLink = (tLink *)pvContext;
+	irqflags_t const flags = cpu_irq_save();
+	int iResult = -1;
+
+	/* the buffer may still be going out */
+	if(!LinkTxBusy(pstLink))
+	{
+		uint32_t const ulFrameLen = FrameBuild(&aucTsyncTxBuffer[TX_LEAD_IN],
+			ausTxSeq[pstLink->ulIndex], pucMsg, ulLen);
+
+		iResult = LinkTransmit(pstLink, aucTsyncTxBuffer,
+			TX_LEAD_IN + ulFrameLen);
+		if(iResult == 0)
+		{
+			ausTxSeq[pstLink->ulIndex]++;
+			*pullTxTime = LinkTxTime(pstLink, TX_LEAD_IN);
+		}
+	}
+
+	cpu_irq_restore(flags);
+	return iResult;
+}
+#endif
 
 /** ***************************************************************************
 	Name:               InitHardware
@@ -282,6 +1372,17 @@ void XDMAC_Handler(void)
 */
 static void InitHardware(void)
 {
+#if BURST_ENABLE
+	uint8_t ucBurst;
+#endif
+
+	/* start the cycle counter behind the run time statistics, before any of
+		the instrumented interrupts are enabled */
+	ProfInit();
+
+	/* the USB driver and the DMA transfers take sleep locks from here on */
+	sleepmgr_init();
+
 	/* switch SLCK to external crystal */
 	osc_enable(OSC_SLCK_32K_XTAL);
 	osc_wait_ready(OSC_SLCK_32K_XTAL);
@@ -290,14 +1391,26 @@ static void InitHardware(void)
 #if USB_ENABLE
 	udc_start();
 #endif
+#if PSD_ENABLE
+	PsdInit();
+#endif
+
+	/* clock the power supply sync timers from PCK6 */
+	pmc_enable_upll_clock();
+	pmc_switch_pck_to_upllck(TC_CLK_PCK, TC_CLK_PCK_PRES);
+	pmc_enable_pck(TC_CLK_PCK);
+
+	/* PPS time base, also clocked from PCK6; the links stamp received
+		packets from it */
+	PpsInit();
 
 #if DOWN_STREAM_POWER_ENABLE
 	/* configure timer 0, channel 0, to produce a 480 kHz synchronization
 		signal for the down-stream power supply */
 	sysclk_enable_peripheral_clock(TC_CLK_480_ID);
-	tc_init(TC_CLK, TC_CLK_480_CHAN, TC_CMR_TCCLKS_TIMER_CLOCK2|TC_CMR_WAVE|TC_CMR_WAVSEL_UP_RC|TC_CMR_BCPC_CLEAR|TC_CMR_BCPB_SET);
-	tc_write_rc(TC_CLK, TC_CLK_480_CHAN, 30);
-	tc_write_rb(TC_CLK, TC_CLK_480_CHAN, 15);
+	tc_init(TC_CLK, TC_CLK_480_CHAN, TC_CMR_TCCLKS_TIMER_CLOCK1|TC_CMR_WAVE|TC_CMR_WAVSEL_UP_RC|TC_CMR_BCPC_CLEAR|TC_CMR_BCPB_SET);
+	tc_write_rc(TC_CLK, TC_CLK_480_CHAN, TC_CLK_PCK_HZ / 480000);
+	tc_write_rb(TC_CLK, TC_CLK_480_CHAN, TC_CLK_PCK_HZ / 480000 / 2);
 	tc_start(TC_CLK, TC_CLK_480_CHAN);
 
 	/* turn on the power supply */
@@ -307,83 +1420,116 @@ static void InitHardware(void)
 	/* configure timer 0, channel 2, to produce a 600 kHz synchronization
 		signal for the main power supply */
 	sysclk_enable_peripheral_clock(TC_CLK_600_ID);
-	tc_init(TC_CLK, TC_CLK_600_CHAN, TC_CMR_TCCLKS_TIMER_CLOCK2|TC_CMR_WAVE|TC_CMR_WAVSEL_UP_RC|TC_CMR_ACPC_CLEAR|TC_CMR_ACPA_SET);
-	tc_write_rc(TC_CLK, TC_CLK_600_CHAN, 24);
-	tc_write_ra(TC_CLK, TC_CLK_600_CHAN, 12);
+	tc_init(TC_CLK, TC_CLK_600_CHAN, TC_CMR_TCCLKS_TIMER_CLOCK1|TC_CMR_WAVE|TC_CMR_WAVSEL_UP_RC|TC_CMR_ACPC_CLEAR|TC_CMR_ACPA_SET);
+	tc_write_rc(TC_CLK, TC_CLK_600_CHAN, TC_CLK_PCK_HZ / 600000);
+	tc_write_ra(TC_CLK, TC_CLK_600_CHAN, TC_CLK_PCK_HZ / 600000 / 2);
 	tc_start(TC_CLK, TC_CLK_600_CHAN);
 
 	/* initialize and enable DMA controller */
 	pmc_enable_periph_clk(ID_XDMAC);
-	xdmac_channel_set_descriptor_control(XDMAC, DMA_CHANNEL_RX, XDMAC_CNDC_NDE_DSCR_FETCH_DIS);
-	xdmac_channel_set_descriptor_control(XDMAC, DMA_CHANNEL_TX, XDMAC_CNDC_NDE_DSCR_FETCH_DIS);
-	xdmac_enable_interrupt(XDMAC, DMA_CHANNEL_RX);
-	xdmac_channel_enable_interrupt(XDMAC, DMA_CHANNEL_RX, XDMAC_CIE_BIE);
 	NVIC_EnableIRQ(XDMAC_IRQn);
 
-	/* XDMAC USART transmission channel config */
-	stTxConfig.mbr_ubc = BUFFER_SIZE;
-	stTxConfig.mbr_sa  = (uint32_t)acTxBuffer;
-	stTxConfig.mbr_da  = (uint32_t)&USART1->US_THR;
-	stTxConfig.mbr_cfg = XDMAC_CC_TYPE_PER_TRAN
-		| XDMAC_CC_DSYNC_MEM2PER
-		| XDMAC_CC_SWREQ_HWR_CONNECTED
-		| XDMAC_CC_CSIZE_CHK_1
-		| XDMAC_CC_DWIDTH_BYTE
-		| XDMAC_CC_SIF_AHB_IF1
-		| XDMAC_CC_DIF_AHB_IF1
-		| XDMAC_CC_SAM_INCREMENTED_AM
-		| XDMAC_CC_DAM_FIXED_AM
-		| XDMAC_CC_PERID(XDMAC_CHANNEL_HWID_USART1_TX);
-	stTxConfig.mbr_bc  = 0;
-	stTxConfig.mbr_ds  = 0;
-	stTxConfig.mbr_sus = 0;
-	stTxConfig.mbr_dus = 0;
-
-	/* XDMAC USART reception channel config */
-	stRxConfig.mbr_ubc = BUFFER_SIZE;
-	stRxConfig.mbr_sa  = (uint32_t)&USART1->US_RHR;
-	stRxConfig.mbr_da  = (uint32_t)acRxBuffer;
-	stRxConfig.mbr_cfg = XDMAC_CC_TYPE_PER_TRAN
-		| XDMAC_CC_DSYNC_PER2MEM
-		| XDMAC_CC_SWREQ_HWR_CONNECTED
-		| XDMAC_CC_CSIZE_CHK_1
-		| XDMAC_CC_DWIDTH_BYTE
-		| XDMAC_CC_SIF_AHB_IF1
-		| XDMAC_CC_DIF_AHB_IF0
-		| XDMAC_CC_SAM_FIXED_AM
-		| XDMAC_CC_DAM_INCREMENTED_AM
-		| XDMAC_CC_PERID(XDMAC_CHANNEL_HWID_USART1_RX);
-	stRxConfig.mbr_bc  = 0;
-	stRxConfig.mbr_ds  = 0;
-	stRxConfig.mbr_sus = 0;
-	stRxConfig.mbr_dus = 0;
-
-	/* start the RX DMA */
-	xdmac_configure_transfer(XDMAC, DMA_CHANNEL_RX, &stRxConfig);
-	xdmac_channel_enable(XDMAC, DMA_CHANNEL_RX);
-
-	/* configure USART */
-	{
-		sam_usart_opt_t usart_console_settings = {
-			14400000UL,
-			US_MR_CHRL_8_BIT,
-			US_MR_PAR_NO,
-			US_MR_NBSTOP_1_BIT,
-			US_MR_CHMODE_NORMAL,
-			0
-		};
-
-		sysclk_enable_peripheral_clock(ID_USART1);
-		usart_init_rs232(USART1, &usart_console_settings, sysclk_get_peripheral_hz());
-		USART1->US_MR |= US_MR_MAN; // Enable Manchester encoder
-		USART1->US_MAN = US_MAN_RXIDLEV|US_MAN_ONE|US_MAN_RX_PL(0)|US_MAN_TX_PL(0); // Disable RX/TX preamble
-		usart_set_rx_timeout(USART1, 0xFFFF);
-		usart_enable_interrupt(USART1, US_IER_TIMEOUT);
-		usart_enable_tx(USART1);
-		usart_enable_rx(USART1);
-		usart_start_rx_timeout(USART1);
-		NVIC_EnableIRQ(USART1_IRQn);
+	/* bring up the data channel links: Manchester USARTs, each with a
+		receive DMA ring that is started once and left running. LINK_BAUD
+		must be one of the rates in the link clock plan */
+	LinksInit(LINK_BAUD);
+
+#if TSYNC_ENABLE
+	TsyncInit(&stTsync, TSYNC_ROLE, TSYNC_ASYMMETRY_NS, TsyncTransmit,
+		LinkGet(TSYNC_LINK));
+#endif
+
+#if RECORD_ENABLE || SD_BENCH_ENABLE
+	/* SD card, and the recorder carrying on from where the last recording
+		on it stopped. Without a card everything else runs as usual */
+	if(SdInit() == 0)
+	{
+#if RECORD_ENABLE
+		RecStart();
+#endif
+	}
+#endif
+
+#if LOG_ENABLE
+	/* serial flash, and the log carrying on from where it stopped. Without
+		the flash everything else runs as usual */
+	if((QspiInit() == 0) && (QlogStart() == 0))
+	{
+		LogBoot();
 	}
+#endif
+
+#if ETH_ENABLE
+	/* Ethernet MAC and PHY, and the network on top of them */
+	NetInit();
+#endif
+
+#if BURST_ENABLE
+	/* external SDRAM for the burst buffers. If it doesn't come up the
+		bridges send straight out of the receive rings instead */
+	ucBurst = (SdramInit() == 0);
+#endif
+
+#if UDP_BRIDGE_ENABLE
+	/* hand the receive rings of all links to the Ethernet port */
+	{
+		uint32_t i;
+
+		for(i = 0; i < LINK_COUNT; i++)
+		{
+			tBurst *pstBurst = NULL;
+
+#if BURST_ENABLE
+			if(ucBurst)
+			{
+				pstBurst = BurstStart(i, LinkGet(i));
+			}
+#endif
+			UdpBridgeStart(i, LinkGet(i), (uint16_t)(NET_UDP_PORT + i),
+				pstBurst);
+		}
+	}
+#endif
+
+#if USB_BRIDGE_ENABLE
+	/* hand the receive rings of the first links to the USB COM ports */
+	{
+		uint32_t i;
+
+		for(i = 0; (i < LINK_COUNT) && (i < UDI_CDC_PORT_NB); i++)
+		{
+			tBurst *pstBurst = NULL;
+
+#if BURST_ENABLE
+			if(ucBurst)
+			{
+				pstBurst = BurstStart(i, LinkGet(i));
+			}
+#endif
+			BridgeStart(i, LinkGet(i), pstBurst);
+		}
+	}
+#endif
+
+#if BER_TEST_ENABLE
+	/* XDMAC USART transmission of the continuous test sequence on each
+		link, and the matching receive checkers */
+	{
+		uint32_t i;
+
+		for(i = 0; i < LINK_COUNT; i++)
+		{
+			tLinkConfig const *pstConfig = LinkGet(i)->pstConfig;
+
+			PrbsCheckInit(&astBerCheck[i], BER_PRBS_ORDER);
+			if(BerTxInit(&astBerTx[i], BER_PRBS_ORDER, pstConfig->ulTxChannel,
+				(uint32_t)&pstConfig->pstUsart->US_THR, pstConfig->ulTxPerId) == 0)
+			{
+				BerTxStart(&astBerTx[i]);
+			}
+		}
+	}
+#endif
 
 	/* setup timer 1, channel 0, to produce a 1 second interrupt */
 	sysclk_enable_peripheral_clock(TC_1HZ_ID);
@@ -0,0 +1,742 @@
+/** ***************************************************************************
+File Name:  net.c
+
+Project:    Platform 4
+
+Purpose:    Minimal IPv4 network layer over the GMAC: ARP, ICMP echo and
+            zero-copy UDP transmission
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "dma_buf.h"
+#include "gmac.h"
+#include "net.h"
+
+
+/* Module Definitions */
+
+/* Ethernet header */
+#define ETH_DST              0
+#define ETH_SRC              6
+#define ETH_TYPE             12
+#define ETH_HEADER_LEN       14
+#define ETH_TYPE_IPV4        0x0800
+#define ETH_TYPE_ARP         0x0806
+#define ETH_FRAME_MAX        1514
+
+/* ARP packet for IPv4 over Ethernet, offsets from the start of the frame */
+#define ARP_HTYPE            14
+#define ARP_PTYPE            16
+#define ARP_HLEN             18
+#define ARP_PLEN             19
+#define ARP_OPER             20
+#define ARP_SHA              22
+#define ARP_SPA              28
+#define ARP_THA              32
+#define ARP_TPA              38
+#define ARP_FRAME_LEN        42
+#define ARP_REQUEST          1
+#define ARP_REPLY            2
+
+/* IPv4 header, offsets from the start of the frame */
+#define IP_VER_IHL           14
+#define IP_TOTAL_LEN         16
+#define IP_ID                18
+#define IP_FRAG              20
+#define IP_TTL               22
+#define IP_PROTO             23
+#define IP_CHECKSUM          24
+#define IP_SRC               26
+#define IP_DST               30
+#define IP_HEADER_LEN        20
+#define IP_FRAG_MSK          0x3FFF
+#define IP_DONT_FRAGMENT     0x4000
+#define IP_PROTO_ICMP        1
+#define IP_PROTO_UDP         17
+#define IP_DEFAULT_TTL       64
+
+/* UDP header, following an IPv4 header without options */
+#define UDP_SRC_PORT         34
+#define UDP_DST_PORT         36
+#define UDP_LEN              38
+#define UDP_CHECKSUM         40
+#define UDP_HEADER_LEN       8
+#define UDP_FRAME_HEADERS    (ETH_HEADER_LEN + IP_HEADER_LEN + UDP_HEADER_LEN)
+
+/* ICMP echo, offsets from the start of the ICMP message */
+#define ICMP_TYPE            0
+#define ICMP_CHECKSUM        2
+#define ICMP_ECHO_REPLY      0
+#define ICMP_ECHO_REQUEST    8
+
+/* a UDP datagram takes two transmit descriptors, its headers and the data */
+#define NET_TX_SLOTS         (NET_TX_DESCS / 2)
+
+/* seconds between ARP requests for the destination once it is known */
+#define NET_ARP_REFRESH      60
+
+#define NET_IP_BROADCAST     NET_IP(255, 255, 255, 255)
+
+
+/* Module Type Definitions */
+
+/* a UDP datagram being transmitted: its headers, built here, and the
+	completion of its data, which is sent from where it is */
+typedef struct
+{
+	uint8_t aucHeader[DMA_BUF_PAD(UDP_FRAME_HEADERS)] DMA_BUF_ALIGNED;
+	tNetSent pfnSent;
+	void *pvArg;
+	uint8_t ucBusy;
+} tNetTxSlot;
+
+
+/* Module Function Declarations */
+
+static void NetReceive(uint8_t const *pucFrame, uint32_t ulLen);
+static void NetReceiveArp(uint8_t const *pucFrame, uint32_t ulLen);
+static void NetReceiveIp(uint8_t const *pucFrame, uint32_t ulLen);
+static void NetSendArp(uint16_t usOper, uint8_t const *pucTha, uint32_t ulTpa);
+static int NetSendReply(uint32_t ulLen);
+static void NetSent(void *pvTag, int iStatus);
+static uint32_t NetPutEth(uint8_t *pucFrame, uint8_t const *pucDst,
+	uint16_t usType);
+static void NetPutIp(uint8_t *pucFrame, uint32_t ulDst, uint8_t ucProto,
+	uint32_t ulPayload);
+static uint16_t NetChecksum(uint8_t const *pucData, uint32_t ulLen);
+static uint16_t NetGet16(uint8_t const *pucSrc);
+static uint32_t NetGet32(uint8_t const *pucSrc);
+static void NetPut16(uint8_t *pucDst, uint16_t usValue);
+static void NetPut32(uint8_t *pucDst, uint32_t ulValue);
+
+
+/* Module Variable Declarations */
+
+static tNet stNet;
+
+static uint8_t const aucNetMac[6] = NET_MAC_ADDR;
+static uint8_t const aucNetBroadcast[6] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/* transmit slots of the UDP datagrams */
+static tNetTxSlot astNetTxSlots[NET_TX_SLOTS];
+
+/* frame for ARP and ICMP replies and ARP requests, one at a time */
+static uint8_t aucNetReply[DMA_BUF_PAD(ETH_FRAME_MAX)] DMA_BUF_ALIGNED;
+static uint8_t ucNetReplyBusy;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               NetInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the GMAC can't be set up
+	Caveats / Effect:   None
+
+	Description:
+	Brings up the GMAC with NET_MAC_ADDR. From then on NetPoll() answers ARP
+	and ping for NET_IP_ADDR and finds the MAC address UDP datagrams to
+	NET_UDP_DEST_ADDR have to go to.
+*/
+int NetInit(void)
+{
+	memset(&stNet, 0, sizeof(stNet));
+	memset(astNetTxSlots, 0, sizeof(astNetTxSlots));
+	ucNetReplyBusy = 0;
+
+	if(((NET_UDP_DEST_ADDR ^ NET_IP_ADDR) & NET_IP_MASK) == 0)
+	{
+		stNet.ulArpTarget = NET_UDP_DEST_ADDR;
+	}
+	else
+	{
+		stNet.ulArpTarget = NET_IP_GATEWAY;
+	}
+	if(NET_UDP_DEST_ADDR == NET_IP_BROADCAST)
+	{
+		memcpy(stNet.aucDestMac, aucNetBroadcast, sizeof(stNet.aucDestMac));
+		stNet.ucResolved = 1;
+	}
+
+	return GmacInit(aucNetMac, NetSent);
+}
+
+/** ***************************************************************************
+	Name:               NetPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the main program loop; may call the
+	                    NetUdpSend() completions
+
+	Description:
+	Answers the received frames, reports finished datagrams, and once a
+	second, as ulSeconds moves on, follows the PHY link and asks ARP for the
+	destination's MAC address: every second until it answers, and every
+	NET_ARP_REFRESH seconds after that.
+*/
+void NetPoll(uint32_t ulSeconds)
+{
+	uint8_t *pucFrame;
+	uint32_t ulLen;
+
+	while((ulLen = GmacReceive(&pucFrame)) != 0)
+	{
+		stNet.ulRxFrames++;
+		NetReceive(pucFrame, ulLen);
+		GmacReceiveDone();
+	}
+
+	GmacPoll();
+
+	if(ulSeconds == stNet.ulLastSecond)
+	{
+		return;
+	}
+	stNet.ulLastSecond = ulSeconds;
+
+	GmacCheckLink();
+	if(!GmacGet()->ucLinkUp || (NET_UDP_DEST_ADDR == NET_IP_BROADCAST))
+	{
+		return;
+	}
+	if(!stNet.ucResolved || (++stNet.ulArpAge >= NET_ARP_REFRESH))
+	{
+		stNet.ulArpAge = 0;
+		NetSendArp(ARP_REQUEST, NULL, stNet.ulArpTarget);
+	}
+}
+
+/** ***************************************************************************
+	Name:               NetReady
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Non-zero if UDP datagrams can be sent
+	Caveats / Effect:   None
+
+	Description:
+	Datagrams can go once the link is up and the destination is resolved.
+*/
+int NetReady(void)
+{
+	return GmacGet()->ucLinkUp && stNet.ucResolved;
+}
+
+/** ***************************************************************************
+	Name:               NetUdpSend
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the datagram can't be sent now
+	Caveats / Effect:   pvData must stay untouched until pfnSent is called
+
+	Description:
+	Sends ulLen bytes at pvData, up to NET_UDP_MAX_PAYLOAD, to port usPort of
+	NET_UDP_DEST_ADDR from the same port. The data is not copied: the GMAC
+	DMA reads it from where it is, behind headers built in a transmit slot,
+	and pfnSent(pvArg) is called from NetPoll() once it is done with it.
+	Fails while NetReady() doesn't hold, or all transmit slots are in use.
+	The GMAC fills in the UDP checksum.
+*/
+int NetUdpSend(uint16_t usPort, void const *pvData, uint32_t ulLen,
+	tNetSent pfnSent, void *pvArg)
+{
+	tNetTxSlot *pstSlot = NULL;
+	tGmacTxBuf astBufs[2];
+	uint8_t *pucHeader;
+	uint32_t i;
+
+	if(!NetReady() || (ulLen == 0) || (ulLen > NET_UDP_MAX_PAYLOAD))
+	{
+		return -1;
+	}
+
+	for(i = 0; i < NET_TX_SLOTS; i++)
+	{
+		if(!astNetTxSlots[i].ucBusy)
+		{
+			pstSlot = &astNetTxSlots[i];
+			break;
+		}
+	}
+	if(!pstSlot)
+	{
+		stNet.ulTxBusy++;
+		return -1;
+	}
+
+	pucHeader = pstSlot->aucHeader;
+	NetPutEth(pucHeader, stNet.aucDestMac, ETH_TYPE_IPV4);
+	NetPutIp(pucHeader, NET_UDP_DEST_ADDR, IP_PROTO_UDP,
+		UDP_HEADER_LEN + ulLen);
+	NetPut16(&pucHeader[UDP_SRC_PORT], usPort);
+	NetPut16(&pucHeader[UDP_DST_PORT], usPort);
+	NetPut16(&pucHeader[UDP_LEN], (uint16_t)(UDP_HEADER_LEN + ulLen));
+	NetPut16(&pucHeader[UDP_CHECKSUM], 0);
+
+	/* the DMA reads memory, not the data cache */
+	DmaBufClean(pucHeader, UDP_FRAME_HEADERS);
+	DmaBufClean(pvData, ulLen);
+
+	astBufs[0].pvData = pucHeader;
+	astBufs[0].ulLen = UDP_FRAME_HEADERS;
+	astBufs[1].pvData = pvData;
+	astBufs[1].ulLen = ulLen;
+	pstSlot->pfnSent = pfnSent;
+	pstSlot->pvArg = pvArg;
+	pstSlot->ucBusy = 1;
+	if(GmacSend(astBufs, 2, pstSlot) != 0)
+	{
+		pstSlot->ucBusy = 0;
+		stNet.ulTxBusy++;
+		return -1;
+	}
+
+	stNet.ulDatagrams++;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               NetGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Network state
+	Caveats / Effect:   None
+
+	Description:
+	Gives read access to the address resolution and the statistics.
+*/
+tNet const *NetGet(void)
+{
+	return &stNet;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               NetReceive
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Hands a received frame to its protocol. Anything but ARP and IPv4 is
+	ignored.
+*/
+static void NetReceive(uint8_t const *pucFrame, uint32_t ulLen)
+{
+	if(ulLen < ETH_HEADER_LEN)
+	{
+		return;
+	}
+
+	switch(NetGet16(&pucFrame[ETH_TYPE]))
+	{
+		case ETH_TYPE_ARP:
+			NetReceiveArp(pucFrame, ulLen);
+			break;
+
+		case ETH_TYPE_IPV4:
+			NetReceiveIp(pucFrame, ulLen);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/** ***************************************************************************
+	Name:               NetReceiveArp
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Learns the destination's MAC address from any ARP packet it sends, and
+	answers requests for our address.
+*/
+static void NetReceiveArp(uint8_t const *pucFrame, uint32_t ulLen)
+{
+	uint32_t const ulSpa = NetGet32(&pucFrame[ARP_SPA]);
+
+	if((ulLen < ARP_FRAME_LEN) || (NetGet16(&pucFrame[ARP_HTYPE]) != 1)
+		|| (NetGet16(&pucFrame[ARP_PTYPE]) != ETH_TYPE_IPV4)
+		|| (pucFrame[ARP_HLEN] != 6) || (pucFrame[ARP_PLEN] != 4))
+	{
+		return;
+	}
+
+	if((ulSpa == stNet.ulArpTarget) && (NET_UDP_DEST_ADDR != NET_IP_BROADCAST))
+	{
+		memcpy(stNet.aucDestMac, &pucFrame[ARP_SHA], sizeof(stNet.aucDestMac));
+		stNet.ucResolved = 1;
+		stNet.ulArpAge = 0;
+	}
+
+	if((NetGet16(&pucFrame[ARP_OPER]) == ARP_REQUEST)
+		&& (NetGet32(&pucFrame[ARP_TPA]) == NET_IP_ADDR))
+	{
+		NetSendArp(ARP_REPLY, &pucFrame[ARP_SHA], ulSpa);
+	}
+}
+
+/** ***************************************************************************
+	Name:               NetReceiveIp
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Answers ICMP echo requests to our address with an echo reply carrying the
+	same data. Fragments and datagrams with a bad header are dropped.
+*/
+static void NetReceiveIp(uint8_t const *pucFrame, uint32_t ulLen)
+{
+	uint32_t ulHeaderLen;
+	uint32_t ulTotalLen;
+	uint8_t *pucIcmp;
+	uint32_t ulIcmpLen;
+
+	if(ulLen < ETH_HEADER_LEN + IP_HEADER_LEN)
+	{
+		return;
+	}
+	ulHeaderLen = (pucFrame[IP_VER_IHL] & 0x0F) * 4UL;
+	ulTotalLen = NetGet16(&pucFrame[IP_TOTAL_LEN]);
+	if(((pucFrame[IP_VER_IHL] >> 4) != 4) || (ulHeaderLen < IP_HEADER_LEN)
+		|| (ulTotalLen < ulHeaderLen) || (ETH_HEADER_LEN + ulTotalLen > ulLen)
+		|| (NetGet32(&pucFrame[IP_DST]) != NET_IP_ADDR)
+		|| (NetGet16(&pucFrame[IP_FRAG]) & IP_FRAG_MSK)
+		|| (NetChecksum(&pucFrame[IP_VER_IHL], ulHeaderLen) != 0))
+	{
+		return;
+	}
+
+	ulIcmpLen = ulTotalLen - ulHeaderLen;
+	if((pucFrame[IP_PROTO] != IP_PROTO_ICMP) || (ulIcmpLen < 8)
+		|| (pucFrame[IP_VER_IHL + ulHeaderLen + ICMP_TYPE]
+			!= ICMP_ECHO_REQUEST)
+		|| ucNetReplyBusy)
+	{
+		return;
+	}
+
+	/* the reply is the request with the addresses swapped, without any IP
+		options */
+	NetPutEth(aucNetReply, &pucFrame[ETH_SRC], ETH_TYPE_IPV4);
+	NetPutIp(aucNetReply, NetGet32(&pucFrame[IP_SRC]), IP_PROTO_ICMP,
+		ulIcmpLen);
+	pucIcmp = &aucNetReply[ETH_HEADER_LEN + IP_HEADER_LEN];
+	memcpy(pucIcmp, &pucFrame[IP_VER_IHL + ulHeaderLen], ulIcmpLen);
+	pucIcmp[ICMP_TYPE] = ICMP_ECHO_REPLY;
+	NetPut16(&pucIcmp[ICMP_CHECKSUM], 0);
+	NetPut16(&pucIcmp[ICMP_CHECKSUM], NetChecksum(pucIcmp, ulIcmpLen));
+
+	if(NetSendReply(ETH_HEADER_LEN + IP_HEADER_LEN + ulIcmpLen) == 0)
+	{
+		stNet.ulEchoReplies++;
+	}
+}
+
+/** ***************************************************************************
+	Name:               NetSendArp
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Dropped if the reply frame is in use
+
+	Description:
+	Sends an ARP request for ulTpa (pucTha NULL, broadcast) or a reply to
+	the host at ulTpa and pucTha.
+*/
+static void NetSendArp(uint16_t usOper, uint8_t const *pucTha, uint32_t ulTpa)
+{
+	static uint8_t const aucUnknown[6] = { 0, 0, 0, 0, 0, 0 };
+
+	if(ucNetReplyBusy)
+	{
+		return;
+	}
+
+	NetPutEth(aucNetReply, pucTha ? pucTha : aucNetBroadcast, ETH_TYPE_ARP);
+	NetPut16(&aucNetReply[ARP_HTYPE], 1);
+	NetPut16(&aucNetReply[ARP_PTYPE], ETH_TYPE_IPV4);
+	aucNetReply[ARP_HLEN] = 6;
+	aucNetReply[ARP_PLEN] = 4;
+	NetPut16(&aucNetReply[ARP_OPER], usOper);
+	memcpy(&aucNetReply[ARP_SHA], aucNetMac, sizeof(aucNetMac));
+	NetPut32(&aucNetReply[ARP_SPA], NET_IP_ADDR);
+	memcpy(&aucNetReply[ARP_THA], pucTha ? pucTha : aucUnknown, 6);
+	NetPut32(&aucNetReply[ARP_TPA], ulTpa);
+
+	if((NetSendReply(ARP_FRAME_LEN) == 0) && (usOper == ARP_REPLY))
+	{
+		stNet.ulArpReplies++;
+	}
+}
+
+/** ***************************************************************************
+	Name:               NetSendReply
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the transmit ring is full
+	Caveats / Effect:   None
+
+	Description:
+	Sends the ulLen bytes built in the reply frame. It stays in use until
+	the GMAC is done with it.
+*/
+static int NetSendReply(uint32_t ulLen)
+{
+	tGmacTxBuf stBuf;
+
+	DmaBufClean(aucNetReply, ulLen);
+	stBuf.pvData = aucNetReply;
+	stBuf.ulLen = ulLen;
+	ucNetReplyBusy = 1;
+	if(GmacSend(&stBuf, 1, aucNetReply) != 0)
+	{
+		ucNetReplyBusy = 0;
+		stNet.ulTxBusy++;
+		return -1;
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               NetSent
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Called from GmacPoll()
+
+	Description:
+	Frees the reply frame or the transmit slot of a finished frame, and
+	passes the completion of a datagram on.
+*/
+static void NetSent(void *pvTag, int iStatus)
+{
+	if(iStatus != 0)
+	{
+		stNet.ulTxErrors++;
+	}
+
+	if(pvTag == aucNetReply)
+	{
+		ucNetReplyBusy = 0;
+	}
+	else
+	{
+		tNetTxSlot *pstSlot = (tNetTxSlot *)pvTag;
+
+		pstSlot->ucBusy = 0;
+		pstSlot->pfnSent(pstSlot->pvArg, iStatus);
+	}
+}
+
+/** ***************************************************************************
+	Name:               NetPutEth
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Length of the Ethernet header
+	Caveats / Effect:   None
+
+	Description:
+	Writes the Ethernet header of a frame from us to pucDst.
+*/
+static uint32_t NetPutEth(uint8_t *pucFrame, uint8_t const *pucDst,
+	uint16_t usType)
+{
+	memmove(&pucFrame[ETH_DST], pucDst, 6);
+	memcpy(&pucFrame[ETH_SRC], aucNetMac, 6);
+	NetPut16(&pucFrame[ETH_TYPE], usType);
+	return ETH_HEADER_LEN;
+}
+
+/** ***************************************************************************
+	Name:               NetPutIp
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Writes the IPv4 header, without options, of a datagram from us to ulDst
+	carrying ulPayload bytes of protocol ucProto.
+*/
+static void NetPutIp(uint8_t *pucFrame, uint32_t ulDst, uint8_t ucProto,
+	uint32_t ulPayload)
+{
+	pucFrame[IP_VER_IHL] = 0x45;
+	pucFrame[IP_VER_IHL + 1] = 0;
+	NetPut16(&pucFrame[IP_TOTAL_LEN], (uint16_t)(IP_HEADER_LEN + ulPayload));
+	NetPut16(&pucFrame[IP_ID], stNet.usIpId++);
+	NetPut16(&pucFrame[IP_FRAG], IP_DONT_FRAGMENT);
+	pucFrame[IP_TTL] = IP_DEFAULT_TTL;
+	pucFrame[IP_PROTO] = ucProto;
+	NetPut16(&pucFrame[IP_CHECKSUM], 0);
+	NetPut32(&pucFrame[IP_SRC], NET_IP_ADDR);
+	NetPut32(&pucFrame[IP_DST], ulDst);
+	NetPut16(&pucFrame[IP_CHECKSUM],
+		NetChecksum(&pucFrame[IP_VER_IHL], IP_HEADER_LEN));
+}
+
+/** ***************************************************************************
+	Name:               NetChecksum
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Internet checksum of the data
+	Caveats / Effect:   None
+
+	Description:
+	Computes the ones' complement of the ones' complement sum of the data as
+	16 bit big endian words. Over data that includes a correct checksum the
+	result is 0.
+*/
+static uint16_t NetChecksum(uint8_t const *pucData, uint32_t ulLen)
+{
+	uint32_t ulSum = 0;
+	uint32_t i;
+
+	for(i = 0; i + 1 < ulLen; i += 2)
+	{
+		ulSum += NetGet16(&pucData[i]);
+	}
+	if(ulLen & 1)
+	{
+		ulSum += (uint32_t)pucData[ulLen - 1] << 8;
+	}
+	while(ulSum >> 16)
+	{
+		ulSum = (ulSum & 0xFFFF) + (ulSum >> 16);
+	}
+	return (uint16_t)~ulSum;
+}
+
+/** ***************************************************************************
+	Name:               NetGet16
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             16 bit value in network byte order
+	Caveats / Effect:   None
+
+	Description:
+	Reads a big endian 16 bit value from any alignment.
+*/
+static uint16_t NetGet16(uint8_t const *pucSrc)
+{
+	return (uint16_t)((pucSrc[0] << 8) | pucSrc[1]);
+}
+
+/** ***************************************************************************
+	Name:               NetGet32
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             32 bit value in network byte order
+	Caveats / Effect:   None
+
+	Description:
+	Reads a big endian 32 bit value from any alignment.
+*/
+static uint32_t NetGet32(uint8_t const *pucSrc)
+{
+	return ((uint32_t)pucSrc[0] << 24) | ((uint32_t)pucSrc[1] << 16)
+		| ((uint32_t)pucSrc[2] << 8) | pucSrc[3];
+}
+
+/** ***************************************************************************
+	Name:               NetPut16
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Writes a 16 bit value in network byte order.
+*/
+static void NetPut16(uint8_t *pucDst, uint16_t usValue)
+{
+	pucDst[0] = (uint8_t)(usValue >> 8);
+	pucDst[1] = (uint8_t)usValue;
+}
+
+/** ***************************************************************************
+	Name:               NetPut32
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Writes a 32 bit value in network byte order.
+*/
+static void NetPut32(uint8_t *pucDst, uint32_t ulValue)
+{
+	pucDst[0] = (uint8_t)(ulValue >> 24);
+	pucDst[1] = (uint8_t)(ulValue >> 16);
+	pucDst[2] = (uint8_t)(ulValue >> 8);
+	pucDst[3] = (uint8_t)ulValue;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
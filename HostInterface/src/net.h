@@ -0,0 +1,86 @@
+/** ***************************************************************************
+File Name:  net.h
+
+Project:    Platform 4
+
+Purpose:    Minimal IPv4 network layer over the GMAC: ARP, ICMP echo and
+            zero-copy UDP transmission
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef NET_H
+#define NET_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "conf_net.h"
+
+
+/* Module Definitions */
+
+/* IPv4 address from its four parts, most significant first */
+#define NET_IP(a, b, c, d) (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) \
+	| ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+/* largest UDP payload that fits an Ethernet frame unfragmented */
+#define NET_UDP_MAX_PAYLOAD  1472
+
+
+/* Module Type Definitions */
+
+/* completion of a NetUdpSend() datagram; iStatus is 0, or -1 if it
+	couldn't be sent */
+typedef void (*tNetSent)(void *pvArg, int iStatus);
+
+/* network state */
+typedef struct
+{
+	/* MAC address the UDP datagrams go to, once ARP has found it, and the
+		address asked for: the destination, or the gateway if the destination
+		isn't on our network */
+	uint8_t aucDestMac[6];
+	uint8_t ucResolved;
+	uint32_t ulArpTarget;
+	/* seconds since the destination was last resolved, and the seconds
+		count of the last NetPoll() */
+	uint32_t ulArpAge;
+	uint32_t ulLastSecond;
+	/* identification of the next IPv4 datagram */
+	uint16_t usIpId;
+	/* statistics */
+	uint32_t ulRxFrames;
+	uint32_t ulArpReplies;
+	uint32_t ulEchoReplies;
+	uint32_t ulDatagrams;
+	uint32_t ulTxBusy;
+	uint32_t ulTxErrors;
+} tNet;
+
+
+/* Global Function Declarations */
+
+int NetInit(void);
+void NetPoll(uint32_t ulSeconds);
+int NetReady(void);
+int NetUdpSend(uint16_t usPort, void const *pvData, uint32_t ulLen,
+	tNetSent pfnSent, void *pvArg);
+tNet const *NetGet(void);
+
+
+#endif /* NET_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,173 @@
+/** ***************************************************************************
+File Name:  pkt_queue.c
+
+Project:    Platform 4
+
+Purpose:    Lock-free single producer, single consumer queue of received
+            packet descriptors, from an ISR to the main program loop
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "pkt_queue.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* the free-running indices rely on the queue dividing 2^32 evenly */
+#if (PKT_QUEUE_SIZE & (PKT_QUEUE_SIZE - 1)) != 0
+#error "PKT_QUEUE_SIZE must be a power of two"
+#endif
+
+/* Each side reads the other side's index with acquire and publishes its own
+	with release ordering, so a descriptor is complete before the consumer
+	sees it and isn't reused before the consumer is done with it. On the M7
+	this is a plain load or store plus a DMB; the same code is safe between
+	two threads on a host */
+#define PKT_QUEUE_LOAD(pulIndex)  __atomic_load_n((pulIndex), __ATOMIC_ACQUIRE)
+#define PKT_QUEUE_STORE(pulIndex, ulValue) \
+	__atomic_store_n((pulIndex), (ulValue), __ATOMIC_RELEASE)
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+/* Module Variable Declarations */
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               PktQueueInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Neither side may be using the queue
+
+	Description:
+	Empties a queue and clears its statistics.
+*/
+void PktQueueInit(tPktQueue *pstQueue)
+{
+	memset(pstQueue, 0, sizeof(*pstQueue));
+}
+
+/** ***************************************************************************
+	Name:               PktQueuePush
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the queue is full
+	Caveats / Effect:   Producer only
+
+	Description:
+	Copies a descriptor onto the back of the queue. A full queue counts an
+	overflow and leaves the descriptor to the caller, which may fold it into
+	the next one.
+*/
+TCM_CODE int PktQueuePush(tPktQueue *pstQueue, tPktDesc const *pstDesc)
+{
+	uint32_t const ulHead = pstQueue->ulHead;
+	uint32_t const ulUsed = ulHead - PKT_QUEUE_LOAD(&pstQueue->ulTail);
+
+	if(ulUsed >= PKT_QUEUE_SIZE)
+	{
+		pstQueue->ulOverflows++;
+		return -1;
+	}
+
+	pstQueue->astDesc[ulHead % PKT_QUEUE_SIZE] = *pstDesc;
+	PKT_QUEUE_STORE(&pstQueue->ulHead, ulHead + 1);
+
+	if(ulUsed + 1 > pstQueue->ulHighWater)
+	{
+		pstQueue->ulHighWater = ulUsed + 1;
+	}
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               PktQueuePeek
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Oldest descriptor, NULL if the queue is empty
+	Caveats / Effect:   Consumer only
+
+	Description:
+	Returns the descriptor at the front of the queue without removing it. It
+	stays valid until PktQueuePop().
+*/
+tPktDesc const *PktQueuePeek(tPktQueue *pstQueue)
+{
+	uint32_t const ulTail = pstQueue->ulTail;
+
+	if(PKT_QUEUE_LOAD(&pstQueue->ulHead) == ulTail)
+	{
+		return NULL;
+	}
+	return &pstQueue->astDesc[ulTail % PKT_QUEUE_SIZE];
+}
+
+/** ***************************************************************************
+	Name:               PktQueuePop
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Consumer only; the queue must not be empty
+
+	Description:
+	Releases the descriptor at the front of the queue back to the producer.
+*/
+void PktQueuePop(tPktQueue *pstQueue)
+{
+	PKT_QUEUE_STORE(&pstQueue->ulTail, pstQueue->ulTail + 1);
+}
+
+/** ***************************************************************************
+	Name:               PktQueueCount
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of queued descriptors
+	Caveats / Effect:   Only a snapshot if called while the other side runs
+
+	Description:
+	Returns how many descriptors are waiting in the queue.
+*/
+uint32_t PktQueueCount(tPktQueue *pstQueue)
+{
+	return PKT_QUEUE_LOAD(&pstQueue->ulHead) - PKT_QUEUE_LOAD(&pstQueue->ulTail);
+}
+
+
+/* Module Function Implementations */
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,78 @@
+/** ***************************************************************************
+File Name:  pkt_queue.h
+
+Project:    Platform 4
+
+Purpose:    Lock-free single producer, single consumer queue of received
+            packet descriptors, from an ISR to the main program loop
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef PKT_QUEUE_H
+#define PKT_QUEUE_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* number of descriptors in a queue, a power of two */
+#ifndef PKT_QUEUE_SIZE
+#define PKT_QUEUE_SIZE 16
+#endif
+
+
+/* Module Type Definitions */
+
+/* one received packet */
+typedef struct
+{
+	/* start of the packet in the receive buffer, and its length. The data
+		may wrap around the end of a circular buffer */
+	uint8_t const *pucData;
+	uint32_t ulLen;
+	/* time base tick count (PpsTicks()) when its first byte arrived */
+	uint64_t ullTicks;
+	/* receiver error flags seen during the packet, 0 if none */
+	uint32_t ulStatus;
+} tPktDesc;
+
+/* queue state. ulHead is only written by the producer and ulTail only by the
+	consumer; both are free-running counts */
+typedef struct
+{
+	tPktDesc astDesc[PKT_QUEUE_SIZE];
+	uint32_t ulHead;
+	uint32_t ulTail;
+	/* producer statistics: descriptors refused because the queue was full,
+		and the most descriptors ever queued at once */
+	uint32_t ulOverflows;
+	uint32_t ulHighWater;
+} tPktQueue;
+
+
+/* Global Function Declarations */
+
+void PktQueueInit(tPktQueue *pstQueue);
+int PktQueuePush(tPktQueue *pstQueue, tPktDesc const *pstDesc);
+tPktDesc const *PktQueuePeek(tPktQueue *pstQueue);
+void PktQueuePop(tPktQueue *pstQueue);
+uint32_t PktQueueCount(tPktQueue *pstQueue);
+
+
+#endif /* PKT_QUEUE_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
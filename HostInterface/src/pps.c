@@ -0,0 +1,654 @@
+/** ***************************************************************************
+File Name:  pps.c
+
+Project:    Platform 4
+
+Purpose:    PPS time base: free-running timer counter extended to 64 bits,
+            PPS edges captured in hardware, a servo disciplining the time
+            to them, and the conversion of timer ticks to PPS time
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "pps.h"
+#include "pps_out.h"
+#include "prof.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* the PPS input channel (TC2 channel 1, TIOA7) is the time base. It counts
+	PCK6 in capture mode, loading RA on the rising edge of the PPS; RB takes
+	the falling edge, as RA is only reloaded after RB */
+#define PPS_CHANNEL          (&TC_PPS->TC_CHANNEL[TC_CHANNEL_PPS_IN])
+
+/* the channel counter is 16 bits wide */
+#define PPS_COUNTER_SPAN     0x10000UL
+
+/* nominal length of a second, 16.16 fixed point ticks */
+#define PPS_PERIOD_NOMINAL   ((int64_t)PPS_TICK_HZ << 16)
+
+/* nanoseconds to 16.16 fixed point ticks */
+#define PPS_NS_Q16(ns)       ((((int64_t)(ns) * (int64_t)PPS_TICK_HZ) << 16) \
+	/ 1000000000)
+
+/* servo gains as shifts of the phase error: phase, frequency and drift, an
+	alpha-beta-gamma filter settling within a few tens of seconds */
+#define PPS_SERVO_PHASE      2
+#define PPS_SERVO_FREQ       5
+#define PPS_SERVO_DRIFT      10
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void PpsService(uint32_t ulStatus);
+static void PpsEdge(uint64_t ullCapture);
+static void PpsServo(uint32_t ulSeconds, int64_t llOffset, int64_t llPredict);
+static void PpsHold(void);
+static int64_t PpsOffset(uint64_t ullTicks);
+static void PpsMove(int64_t llDelta);
+static void PpsSetState(uint8_t ucState);
+
+
+/* Module Variable Declarations */
+
+static tPps stPps TCM_BSS;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               PpsInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   PCK6 must be running; enables the PPS input interrupt
+
+	Description:
+	Selects the PPS source and starts the time base, and the PPS output
+	(PPS_OUT_ENABLE) in step with it. Until the first PPS edge the time
+	counts from here at the nominal PPS_TICK_HZ.
+*/
+void PpsInit(void)
+{
+	memset(&stPps, 0, sizeof(stPps));
+	stPps.llPeriod = PPS_PERIOD_NOMINAL;
+	PpsMove(0);
+
+	/* route the selected PPS to TIOA7, lock indicator off */
+	ioport_set_pin_dir(PIN_PPS_SELECT, IOPORT_DIR_OUTPUT);
+	ioport_set_pin_level(PIN_PPS_SELECT, PPS_SOURCE);
+	ioport_set_pin_dir(PPS_LOCK_IND, IOPORT_DIR_OUTPUT);
+	ioport_set_pin_level(PPS_LOCK_IND, PPS_LOCK_IND_OFF);
+	ioport_set_pin_mode(PIN_TC_PPS_IN, PIN_TC_PPS_IN_MUX);
+	ioport_disable_pin(PIN_TC_PPS_IN);
+
+	/* free-running capture channel; the counter overflow extends it in
+		software and RA holds the time of the last PPS edge */
+	sysclk_enable_peripheral_clock(ID_TC_PPS_IN);
+	tc_init(TC_PPS, TC_CHANNEL_PPS_IN, TC_CMR_TCCLKS_TIMER_CLOCK1
+		| TC_CMR_LDRA_RISING | TC_CMR_LDRB_FALLING);
+	tc_enable_interrupt(TC_PPS, TC_CHANNEL_PPS_IN,
+		TC_IER_COVFS | TC_IER_LDRAS);
+	NVIC_EnableIRQ(TC_PPS_IN_IRQn);
+	tc_start(TC_PPS, TC_CHANNEL_PPS_IN);
+
+#if PPS_OUT_ENABLE
+	/* the output channel counts the same clock; the block sync resets both
+		counters at once so they stay equal */
+	PpsOutInit();
+	tc_sync_trigger(TC_PPS);
+#endif
+}
+
+/** ***************************************************************************
+	Name:               PpsSelect
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Drops the servo out of lock
+
+	Description:
+	Routes PPS_SELECT_GPS or PPS_SELECT_EXT to the PPS input. The new source
+	may have a different phase, so a locked servo goes into holdover and an
+	acquiring one back to free running; either takes the next edge that
+	doesn't fit as a new reference.
+*/
+void PpsSelect(uint8_t ucSource)
+{
+	irqflags_t flags = cpu_irq_save();
+
+	ioport_set_pin_level(PIN_PPS_SELECT, ucSource);
+	if(stPps.ucState == PPS_STATE_LOCKED)
+	{
+		PpsSetState(PPS_STATE_HOLDOVER);
+	}
+	else if(stPps.ucState == PPS_STATE_ACQUIRE)
+	{
+		PpsSetState(PPS_STATE_FREE);
+	}
+
+	cpu_irq_restore(flags);
+}
+
+/** ***************************************************************************
+	Name:               PpsTicks
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Time base tick count
+	Caveats / Effect:   Interrupts must not be masked for more than half a
+	                    counter period (about 680 us) at a time
+
+	Description:
+	Reads the 64 bit time base counter. Cheap enough for any ISR to stamp an
+	event with; PpsTime() converts the count to seconds later. Reading the
+	status clears it, so any overflow or capture pending is dealt with here
+	rather than in the ISR.
+*/
+TCM_CODE uint64_t PpsTicks(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint32_t const ulCount = PPS_CHANNEL->TC_CV & (PPS_COUNTER_SPAN - 1);
+	uint32_t const ulStatus = PPS_CHANNEL->TC_SR;
+	uint64_t ullTicks;
+
+	PpsService(ulStatus);
+
+	/* an overflow in the same status read that the count is still high
+		from happened after the count was read */
+	ullTicks = stPps.ullBase + ulCount;
+	if((ulStatus & TC_SR_COVFS) && (ulCount >= PPS_COUNTER_SPAN / 2))
+	{
+		ullTicks -= PPS_COUNTER_SPAN;
+	}
+
+	cpu_irq_restore(flags);
+	return ullTicks;
+}
+
+/** ***************************************************************************
+	Name:               PpsTime
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Time of tick count ullTicks
+	Caveats / Effect:   None
+
+	Description:
+	Converts a time base tick count to PPS seconds and fraction with the
+	disciplined model: counting from the start of its current second with the
+	servo's length of a second. The count may be from before that, so events
+	stamped in an ISR can be converted whenever convenient.
+*/
+tPpsTime PpsTime(uint64_t ullTicks)
+{
+	irqflags_t flags = cpu_irq_save();
+	int64_t const llSince = PpsOffset(ullTicks);
+	int64_t const llPeriod = stPps.llPeriod;
+	uint32_t const ulSeconds = stPps.ulSeconds;
+	int64_t llWhole;
+	int64_t llRemainder;
+	uint64_t ullFraction;
+
+	cpu_irq_restore(flags);
+
+	/* whole seconds rounded down, so the remainder is never negative */
+	llWhole = llSince / llPeriod;
+	llRemainder = llSince % llPeriod;
+	if(llRemainder < 0)
+	{
+		llWhole--;
+		llRemainder += llPeriod;
+	}
+
+	ullFraction = ((uint64_t)llRemainder << 16) / (uint64_t)(llPeriod >> 16);
+	if(ullFraction > 0xFFFFFFFFULL)
+	{
+		ullFraction = 0xFFFFFFFFULL;
+	}
+
+	return ((uint64_t)(ulSeconds + (uint32_t)llWhole) << 32) | ullFraction;
+}
+
+/** ***************************************************************************
+	Name:               PpsNow
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Current time
+	Caveats / Effect:   None
+
+	Description:
+	Returns the current PPS time.
+*/
+tPpsTime PpsNow(void)
+{
+	return PpsTime(PpsTicks());
+}
+
+/** ***************************************************************************
+	Name:               PpsSecondTicks
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Tick count at which PPS second ulSecond starts
+	Caveats / Effect:   Call with interrupts masked or from an ISR; only
+	                    meaningful for the next few seconds
+
+	Description:
+	Predicts from the disciplined model when a second starts, so it can be
+	marked in hardware.
+*/
+uint64_t PpsSecondTicks(uint32_t ulSecond)
+{
+	int64_t const llSeconds = (int32_t)(ulSecond - stPps.ulSeconds);
+	int64_t const llAhead = llSeconds * stPps.llPeriod
+		+ stPps.llDrift * llSeconds * llSeconds / 2
+		+ (int64_t)stPps.ulRefFrac;
+
+	return stPps.ullRefTicks + (uint64_t)((llAhead + 0x8000) >> 16);
+}
+
+/** ***************************************************************************
+	Name:               PpsLocked
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             1 if the time is disciplined to the PPS, 0 if not
+	Caveats / Effect:   None
+
+	Description:
+	Tells whether the servo is locked, as shown on PPS_LOCK_IND.
+*/
+int PpsLocked(void)
+{
+	return stPps.ucState == PPS_STATE_LOCKED;
+}
+
+/** ***************************************************************************
+	Name:               PpsGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Time base state
+	Caveats / Effect:   Fields may be updated while they are read
+
+	Description:
+	Gives read access to the time base state, servo estimates and
+	statistics.
+*/
+tPps const *PpsGet(void)
+{
+	return &stPps;
+}
+
+/** ***************************************************************************
+	Name:               TC_PPS_IN_Handler
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   ISR
+
+	Description:
+	Counter overflow and PPS capture interrupt of the time base.
+*/
+TCM_CODE void TC_PPS_IN_Handler(void)
+{
+	uint32_t ulProfStart;
+
+	PROF_START(ulProfStart);
+	PpsService(PPS_CHANNEL->TC_SR);
+	PROF_END(PROF_SITE_PPS_ISR, ulProfStart);
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               PpsService
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call with interrupts masked or from the ISR, with a
+	                    status just read from the channel
+
+	Description:
+	Acts on the overflow and capture flags of a channel status read. A
+	capture flagged together with an overflow happened before the overflow
+	if the captured count is still high. Each overflow also checks whether
+	the model is due to move on to the next second without an edge, and
+	lets the PPS output schedule its next edge.
+*/
+static TCM_CODE void PpsService(uint32_t ulStatus)
+{
+	uint64_t const ullBase = stPps.ullBase;
+
+	if(ulStatus & TC_SR_COVFS)
+	{
+		stPps.ullBase += PPS_COUNTER_SPAN;
+	}
+	if(ulStatus & TC_SR_LOVRS)
+	{
+		stPps.ulOverruns++;
+	}
+	if(ulStatus & TC_SR_LDRBS)
+	{
+		(void)PPS_CHANNEL->TC_RB;
+	}
+	if(ulStatus & TC_SR_LDRAS)
+	{
+		uint32_t const ulCapture = PPS_CHANNEL->TC_RA & (PPS_COUNTER_SPAN - 1);
+
+		if((ulStatus & TC_SR_COVFS) && (ulCapture >= PPS_COUNTER_SPAN / 2))
+		{
+			PpsEdge(ullBase + ulCapture);
+		}
+		else
+		{
+			PpsEdge(stPps.ullBase + ulCapture);
+		}
+	}
+
+	if(ulStatus & TC_SR_COVFS)
+	{
+		if(stPps.ullBase >= stPps.ullDeadline)
+		{
+			PpsHold();
+		}
+#if PPS_OUT_ENABLE
+		PpsOutUpdate(stPps.ullBase);
+#endif
+	}
+}
+
+/** ***************************************************************************
+	Name:               PpsEdge
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call with interrupts masked or from the ISR
+
+	Description:
+	Takes a PPS edge captured at tick count ullCapture. An edge a whole
+	number of seconds into the model, within PPS_TOLERANCE_PPM of where the
+	model predicts it, goes to the servo. While the servo follows the PPS
+	anything else is a glitch; otherwise the edge becomes a new reference,
+	taken as the start of the next second so the time doesn't step back.
+*/
+static void PpsEdge(uint64_t ullCapture)
+{
+	int64_t const llOffset = PpsOffset(ullCapture);
+
+	if(stPps.ucState != PPS_STATE_FREE)
+	{
+		int64_t const llPeriod = stPps.llPeriod;
+		int64_t const llSeconds = (llOffset + llPeriod / 2) / llPeriod;
+
+		if((llOffset > 0) && (llSeconds >= 1) && (llSeconds <= PPS_LOST_SECONDS))
+		{
+			int64_t const llPredict = llSeconds * llPeriod
+				+ stPps.llDrift * llSeconds * llSeconds / 2;
+			int64_t const llError = llOffset - llPredict;
+			int64_t const llLimit = llSeconds * llPeriod
+				* PPS_TOLERANCE_PPM / 1000000;
+
+			if((llError <= llLimit) && (llError >= -llLimit))
+			{
+				PpsServo((uint32_t)llSeconds, llOffset, llPredict);
+				return;
+			}
+		}
+
+		if(stPps.ucState != PPS_STATE_HOLDOVER)
+		{
+			stPps.ulGlitches++;
+			return;
+		}
+	}
+
+	/* new reference */
+	stPps.ulSeconds = PPS_TIME_SECONDS(PpsTime(ullCapture)) + 1;
+	stPps.ullRefTicks = ullCapture;
+	stPps.ulRefFrac = 0;
+	stPps.llDrift = 0;
+	PpsMove(0);
+	stPps.ucNewRef = 1;
+	stPps.ulGood = 0;
+	stPps.ulMissed = 0;
+	stPps.ulSteps++;
+	stPps.ulEdges++;
+	PpsSetState(PPS_STATE_ACQUIRE);
+}
+
+/** ***************************************************************************
+	Name:               PpsServo
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call with interrupts masked or from the ISR
+
+	Description:
+	Disciplines the model to an edge ulSeconds after the start of its
+	current second, llOffset ticks (16.16) in where it predicted llPredict.
+	The edge after a new reference measures the length of the second
+	outright. After that the error is filtered into the phase, frequency and
+	drift (alpha-beta-gamma), so the time slews rather than steps and a
+	noisy edge moves it by a fraction of its error; only while acquiring is a
+	large phase error stepped out. The edge then starts the model's new
+	current second.
+*/
+static void PpsServo(uint32_t ulSeconds, int64_t llOffset, int64_t llPredict)
+{
+	int64_t const llSeconds = ulSeconds;
+	int64_t llError = llOffset - llPredict;
+	int64_t llDelta;
+
+	if(stPps.ucNewRef && (ulSeconds == 1))
+	{
+		stPps.llPeriod = llOffset;
+		llDelta = llOffset;
+		llError = 0;
+	}
+	else if((stPps.ucState != PPS_STATE_LOCKED)
+		&& ((llError > PPS_NS_Q16(PPS_STEP_NS))
+			|| (llError < -PPS_NS_Q16(PPS_STEP_NS))))
+	{
+		stPps.llPeriod += stPps.llDrift * llSeconds;
+		llDelta = llOffset;
+		stPps.ulSteps++;
+	}
+	else
+	{
+		llDelta = llPredict + (llError >> PPS_SERVO_PHASE);
+		stPps.llPeriod += stPps.llDrift * llSeconds
+			+ (llError >> PPS_SERVO_FREQ) / llSeconds;
+		stPps.llDrift += (llError >> PPS_SERVO_DRIFT) / (llSeconds * llSeconds);
+	}
+
+	stPps.ucNewRef = 0;
+	stPps.ulSeconds += ulSeconds;
+	PpsMove(llDelta);
+	stPps.ulMissed = 0;
+	stPps.ulEdges++;
+
+	/* estimates in engineering units */
+	stPps.lPhaseNs = (int32_t)(llError * 1000000000 / PPS_PERIOD_NOMINAL);
+	stPps.lFreqPpb = (int32_t)((stPps.llPeriod - PPS_PERIOD_NOMINAL)
+		* 1000000000 / PPS_PERIOD_NOMINAL);
+	stPps.lDriftPpt = (int32_t)(stPps.llDrift * 1000000000000
+		/ PPS_PERIOD_NOMINAL);
+
+	/* lock */
+	if((llError <= PPS_NS_Q16(PPS_LOCK_NS))
+		&& (llError >= -PPS_NS_Q16(PPS_LOCK_NS)))
+	{
+		stPps.ulGood++;
+	}
+	else
+	{
+		stPps.ulGood = 0;
+	}
+
+	if(stPps.ucState == PPS_STATE_LOCKED)
+	{
+		if((llError > PPS_NS_Q16(4 * PPS_LOCK_NS))
+			|| (llError < -PPS_NS_Q16(4 * PPS_LOCK_NS)))
+		{
+			PpsSetState(PPS_STATE_ACQUIRE);
+		}
+	}
+	else if(stPps.ulGood >= PPS_LOCK_EDGES)
+	{
+		PpsSetState(PPS_STATE_LOCKED);
+	}
+	else
+	{
+		PpsSetState(PPS_STATE_ACQUIRE);
+	}
+}
+
+/** ***************************************************************************
+	Name:               PpsHold
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call with interrupts masked or from the ISR
+
+	Description:
+	Moves the model on to its next second when no edge came, on the current
+	frequency and drift estimate. After PPS_LOST_SECONDS the PPS is lost: a
+	locked time base goes into holdover, an unlocked one back to free
+	running.
+*/
+static void PpsHold(void)
+{
+	int64_t const llDelta = stPps.llPeriod + stPps.llDrift / 2;
+
+	stPps.llPeriod += stPps.llDrift;
+	stPps.ulSeconds++;
+	PpsMove(llDelta);
+
+	if(++stPps.ulMissed >= PPS_LOST_SECONDS)
+	{
+		if(stPps.ucState == PPS_STATE_LOCKED)
+		{
+			PpsSetState(PPS_STATE_HOLDOVER);
+		}
+		else if(stPps.ucState == PPS_STATE_ACQUIRE)
+		{
+			PpsSetState(PPS_STATE_FREE);
+		}
+	}
+	if(stPps.ucState == PPS_STATE_HOLDOVER)
+	{
+		stPps.ulHoldover++;
+	}
+}
+
+/** ***************************************************************************
+	Name:               PpsOffset
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Ticks (16.16) from the start of the model's current
+	                    second to tick count ullTicks, negative if before
+	Caveats / Effect:   Call with interrupts masked or from the ISR
+
+	Description:
+	Measures a tick count against the model.
+*/
+static int64_t PpsOffset(uint64_t ullTicks)
+{
+	return (int64_t)((ullTicks - stPps.ullRefTicks) << 16)
+		- (int64_t)stPps.ulRefFrac;
+}
+
+/** ***************************************************************************
+	Name:               PpsMove
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call with interrupts masked or from the ISR
+
+	Description:
+	Moves the start of the model's current second by llDelta ticks (16.16)
+	and sets the deadline for the next edge half a second after it is due.
+*/
+static void PpsMove(int64_t llDelta)
+{
+	int64_t const llFrac = (int64_t)stPps.ulRefFrac + llDelta;
+
+	stPps.ullRefTicks += (uint64_t)(llFrac >> 16);
+	stPps.ulRefFrac = (uint32_t)(llFrac & 0xFFFF);
+	stPps.ullDeadline = stPps.ullRefTicks
+		+ (uint64_t)((stPps.llPeriod + stPps.llPeriod / 2) >> 16);
+}
+
+/** ***************************************************************************
+	Name:               PpsSetState
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Drives PPS_LOCK_IND
+
+	Description:
+	Changes the servo state, showing lock on the indicator.
+*/
+static void PpsSetState(uint8_t ucState)
+{
+	if(ucState != stPps.ucState)
+	{
+		stPps.ucState = ucState;
+		ioport_set_pin_level(PPS_LOCK_IND, (ucState == PPS_STATE_LOCKED)
+			? PPS_LOCK_IND_ON : PPS_LOCK_IND_OFF);
+	}
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
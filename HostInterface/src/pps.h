@@ -0,0 +1,114 @@
+/** ***************************************************************************
+File Name:  pps.h
+
+Project:    Platform 4
+
+Purpose:    PPS time base: free-running timer counter extended to 64 bits,
+            PPS edges captured in hardware, a servo disciplining the time
+            to them, and the conversion of timer ticks to PPS time
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef PPS_H
+#define PPS_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "conf_pps.h"
+
+
+/* Module Definitions */
+
+/* the time base counts PCK6 (TIMER_CLOCK1) */
+#define PPS_TICK_HZ          TC_CLK_PCK_HZ
+
+/* whole seconds and nanoseconds of a tPpsTime */
+#define PPS_TIME_SECONDS(t)  ((uint32_t)((t) >> 32))
+#define PPS_TIME_NS(t)       ((uint32_t)((((t) & 0xFFFFFFFFULL) \
+	* 1000000000ULL) >> 32))
+
+/* servo states, tPps.ucState */
+#define PPS_STATE_FREE       0   /* no PPS, running on the nominal rate */
+#define PPS_STATE_ACQUIRE    1   /* following the PPS, not yet within lock */
+#define PPS_STATE_LOCKED     2   /* disciplined to the PPS */
+#define PPS_STATE_HOLDOVER   3   /* PPS lost after lock, running on the last
+                                    frequency and drift estimate */
+
+
+/* Module Type Definitions */
+
+/* a point in time: PPS seconds in the upper 32 bits and the binary fraction
+	of the second in the lower 32 bits */
+typedef uint64_t tPpsTime;
+
+/* time base state */
+typedef struct
+{
+	/* tick count at the last counter overflow */
+	uint64_t ullBase;
+	/* disciplined model: PPS second ulSeconds started at tick count
+		ullRefTicks + ulRefFrac / 65536. A second lasts llPeriod ticks and
+		that changes by llDrift every second, both 16.16 fixed point. The
+		model moves on to the next second by itself at tick count ullDeadline
+		if no PPS edge has come by then */
+	uint64_t ullRefTicks;
+	uint32_t ulRefFrac;
+	uint32_t ulSeconds;
+	int64_t llPeriod;
+	int64_t llDrift;
+	uint64_t ullDeadline;
+	/* servo state, PPS_STATE_x, edges in a row within PPS_LOCK_NS and
+		seconds since the last accepted edge */
+	uint8_t ucState;
+	uint32_t ulGood;
+	uint32_t ulMissed;
+	/* the reference was just taken from an edge, the next one measures the
+		length of the second */
+	uint8_t ucNewRef;
+	/* servo estimates as of the last accepted edge: phase error against the
+		model in ns, frequency error of the crystal in ppb and its drift in
+		ppt (0.001 ppb) per second */
+	int32_t lPhaseNs;
+	int32_t lFreqPpb;
+	int32_t lDriftPpt;
+	/* statistics: accepted edges, edges ignored as glitches, captures
+		overwritten before they were read, phase steps and seconds spent in
+		holdover */
+	uint32_t ulEdges;
+	uint32_t ulGlitches;
+	uint32_t ulOverruns;
+	uint32_t ulSteps;
+	uint32_t ulHoldover;
+} tPps;
+
+
+/* Global Function Declarations */
+
+void PpsInit(void);
+void PpsSelect(uint8_t ucSource);
+uint64_t PpsTicks(void);
+tPpsTime PpsTime(uint64_t ullTicks);
+tPpsTime PpsNow(void);
+uint64_t PpsSecondTicks(uint32_t ulSecond);
+int PpsLocked(void);
+tPps const *PpsGet(void);
+
+
+#endif /* PPS_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,267 @@
+/** ***************************************************************************
+File Name:  pps_out.c
+
+Project:    Platform 4
+
+Purpose:    PPS output: a pulse on TIOA8 at the start of every second of
+            the disciplined time, generated by the timer hardware
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "pps.h"
+#include "pps_out.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* the PPS output channel (TC2 channel 2, TIOA8) counts PCK6 in waveform
+	mode, in step with the time base channel. RA compare sets TIOA8 for the
+	rising edge and RC compare clears it for the falling edge */
+#define PPS_OUT_CHANNEL      (&TC_PPS->TC_CHANNEL[TC_CHANNEL_PPS_OUT])
+#define PPS_OUT_CMR          (TC_CMR_TCCLKS_TIMER_CLOCK1 | TC_CMR_WAVE \
+	| TC_CMR_WAVSEL_UP | TC_CMR_ASWTRG_CLEAR)
+
+/* the channel counter is 16 bits wide, so a compare matches once every
+	counter period. An edge is armed when it is due between PPS_OUT_MARGIN
+	ticks and one period ahead, which makes the match the right one and
+	leaves room for interrupt latency. While an edge is near, RB compare
+	interrupts half way through each period so the window is never missed */
+#define PPS_OUT_SPAN         0x10000UL
+#define PPS_OUT_MARGIN       0x4000UL
+
+/* pulse width in ticks */
+#define PPS_OUT_WIDTH        ((uint64_t)PPS_TICK_HZ * PPS_OUT_WIDTH_MS / 1000)
+
+
+/* Module Type Definitions */
+
+/* output state */
+typedef struct
+{
+	/* PPS second the next pulse marks, the tick count of its next edge,
+		and whether that is the falling edge and is armed in the channel */
+	uint32_t ulSecond;
+	uint64_t ullEdge;
+	uint8_t ucFall;
+	uint8_t ucArmed;
+	tPpsOutStats stStats;
+} tPpsOut;
+
+
+/* Module Function Declarations */
+
+static void PpsOutArm(uint64_t ullNow);
+
+
+/* Module Variable Declarations */
+
+static tPpsOut stPpsOut TCM_BSS;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               PpsOutInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Called by PpsInit(), which starts the counter in step
+	                    with the time base
+
+	Description:
+	Sets up the PPS output channel with TIOA8 low.
+*/
+void PpsOutInit(void)
+{
+	memset(&stPpsOut, 0, sizeof(stPpsOut));
+
+	ioport_set_pin_mode(PIN_TC_PPS_OUT, PIN_TC_PPS_OUT_MUX);
+	ioport_disable_pin(PIN_TC_PPS_OUT);
+
+	sysclk_enable_peripheral_clock(ID_TC_PPS_OUT);
+	tc_init(TC_PPS, TC_CHANNEL_PPS_OUT, PPS_OUT_CMR);
+	tc_write_rb(TC_PPS, TC_CHANNEL_PPS_OUT, PPS_OUT_SPAN / 2);
+	NVIC_EnableIRQ(TC_PPS_OUT_IRQn);
+	tc_start(TC_PPS, TC_CHANNEL_PPS_OUT);
+}
+
+/** ***************************************************************************
+	Name:               PpsOutUpdate
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call with interrupts masked or from an ISR, at least
+	                    once every counter period
+
+	Description:
+	Moves the output on at tick count ullNow: retires an edge that has gone
+	out, follows the disciplined model for the next rising edge, and arms
+	the next edge in the channel once it is close enough. Pulses only start
+	while the servo is locked or holding over; a pulse under way is always
+	finished.
+*/
+TCM_CODE void PpsOutUpdate(uint64_t ullNow)
+{
+	if(stPpsOut.ucArmed)
+	{
+		if((int64_t)(ullNow - stPpsOut.ullEdge) < 0)
+		{
+			PpsOutArm(ullNow);
+			return;
+		}
+
+		/* the edge has gone out */
+		PPS_OUT_CHANNEL->TC_CMR = PPS_OUT_CMR;
+		stPpsOut.ucArmed = 0;
+		if(!stPpsOut.ucFall)
+		{
+			stPpsOut.ucFall = 1;
+			stPpsOut.ullEdge += PPS_OUT_WIDTH;
+		}
+		else
+		{
+			stPpsOut.ucFall = 0;
+			stPpsOut.ulSecond++;
+			stPpsOut.stStats.ulPulses++;
+		}
+	}
+
+	if(!stPpsOut.ucFall)
+	{
+		uint8_t const ucState = PpsGet()->ucState;
+
+		if((ucState != PPS_STATE_LOCKED) && (ucState != PPS_STATE_HOLDOVER))
+		{
+			stPpsOut.ulSecond = PPS_TIME_SECONDS(PpsTime(ullNow)) + 1;
+			PPS_OUT_CHANNEL->TC_IDR = TC_IDR_CPBS;
+			return;
+		}
+
+		/* the model moves with every PPS edge, so the rising edge is only
+			fixed once it is armed */
+		stPpsOut.ullEdge = PpsSecondTicks(stPpsOut.ulSecond);
+		if((int64_t)(stPpsOut.ullEdge - ullNow) < (int64_t)PPS_OUT_MARGIN)
+		{
+			stPpsOut.ulSecond = PPS_TIME_SECONDS(PpsTime(ullNow)) + 1;
+			stPpsOut.ullEdge = PpsSecondTicks(stPpsOut.ulSecond);
+			stPpsOut.stStats.ulSkipped++;
+		}
+	}
+
+	PpsOutArm(ullNow);
+}
+
+/** ***************************************************************************
+	Name:               PpsOutGetStats
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Output statistics
+	Caveats / Effect:   Fields may be updated while they are read
+
+	Description:
+	Gives read access to the output statistics.
+*/
+tPpsOutStats const *PpsOutGetStats(void)
+{
+	return &stPpsOut.stStats;
+}
+
+/** ***************************************************************************
+	Name:               TC_PPS_OUT_Handler
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   ISR
+
+	Description:
+	Half period interrupt of the output channel, enabled while an edge is
+	near.
+*/
+TCM_CODE void TC_PPS_OUT_Handler(void)
+{
+	irqflags_t flags = cpu_irq_save();
+
+	(void)PPS_OUT_CHANNEL->TC_SR;
+	PpsOutUpdate(PpsTicks());
+
+	cpu_irq_restore(flags);
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               PpsOutArm
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call with interrupts masked or from an ISR
+
+	Description:
+	Arms the next edge in the channel if it is due within the arming window,
+	and keeps the half period interrupt on while it is less than two counter
+	periods away.
+*/
+static TCM_CODE void PpsOutArm(uint64_t ullNow)
+{
+	uint64_t const ullAhead = stPpsOut.ullEdge - ullNow;
+
+	if(!stPpsOut.ucArmed && (ullAhead >= PPS_OUT_MARGIN)
+		&& (ullAhead < PPS_OUT_SPAN))
+	{
+		uint32_t const ulMatch = (uint32_t)stPpsOut.ullEdge & (PPS_OUT_SPAN - 1);
+
+		if(stPpsOut.ucFall)
+		{
+			PPS_OUT_CHANNEL->TC_RC = ulMatch;
+			PPS_OUT_CHANNEL->TC_CMR = PPS_OUT_CMR | TC_CMR_ACPC_CLEAR;
+		}
+		else
+		{
+			PPS_OUT_CHANNEL->TC_RA = ulMatch;
+			PPS_OUT_CHANNEL->TC_CMR = PPS_OUT_CMR | TC_CMR_ACPA_SET;
+		}
+		stPpsOut.ucArmed = 1;
+	}
+
+	if(ullAhead < 2 * PPS_OUT_SPAN)
+	{
+		PPS_OUT_CHANNEL->TC_IER = TC_IER_CPBS;
+	}
+	else
+	{
+		PPS_OUT_CHANNEL->TC_IDR = TC_IDR_CPBS;
+	}
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,53 @@
+/** ***************************************************************************
+File Name:  pps_out.h
+
+Project:    Platform 4
+
+Purpose:    PPS output: a pulse on TIOA8 at the start of every second of
+            the disciplined time, generated by the timer hardware
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef PPS_OUT_H
+#define PPS_OUT_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* output statistics */
+typedef struct
+{
+	/* pulses sent, and seconds skipped because the servo wasn't locked or
+		an edge came due too soon to be set up */
+	uint32_t ulPulses;
+	uint32_t ulSkipped;
+} tPpsOutStats;
+
+
+/* Global Function Declarations */
+
+void PpsOutInit(void);
+void PpsOutUpdate(uint64_t ullNow);
+tPpsOutStats const *PpsOutGetStats(void);
+
+
+#endif /* PPS_OUT_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,278 @@
+/** ***************************************************************************
+File Name:  prbs.c
+
+Project:    Platform 4
+
+Purpose:    Pseudo-random bit sequence generation and self-synchronizing
+            bit error checking for data channel qualification
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "prbs.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static inline uint8_t PrbsNextByte(tPrbs const *pstPrbs);
+static inline void PrbsPush(tPrbs *pstPrbs, uint8_t ucByte);
+
+
+/* Module Variable Declarations */
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               PrbsInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 for an unsupported order
+	Caveats / Effect:   None
+
+	Description:
+	Sets up a generator for PRBS-7, 15 or 23, starting from the all ones
+	state. Bits are produced in transmission order, i.e. LSB first in each
+	byte as the USART shifts them out.
+
+	A byte at a time needs the short tap M to be at least 8 bits back. PRBS-7
+	and PRBS-15 don't satisfy that directly, but a sequence that satisfies
+	p(x) also satisfies p(x)^2 and p(x)^4, so x^28+x^24+1 and x^30+x^28+1 are
+	used for them instead. Both still fit the 32 bit history.
+*/
+int PrbsInit(tPrbs *pstPrbs, uint32_t ulOrder)
+{
+	uint8_t aucBits[32];
+	uint32_t ulTapN;
+	uint32_t ulTapM;
+	uint32_t i;
+
+	switch(ulOrder)
+	{
+		case PRBS_7:
+			pstPrbs->ucTapN = 28;
+			pstPrbs->ucTapM = 24;
+			ulTapM = 6;
+			break;
+		case PRBS_15:
+			pstPrbs->ucTapN = 30;
+			pstPrbs->ucTapM = 28;
+			ulTapM = 14;
+			break;
+		case PRBS_23:
+			pstPrbs->ucTapN = 23;
+			pstPrbs->ucTapM = 18;
+			ulTapM = 18;
+			break;
+		default:
+			return -1;
+	}
+	ulTapN = ulOrder;
+
+	/* seed the history by running the plain polynomial bit by bit */
+	pstPrbs->ulHistory = 0;
+	for(i = 0; i < 32; i++)
+	{
+		aucBits[i] = (i < ulTapN) ? 1 : aucBits[i - ulTapN] ^ aucBits[i - ulTapM];
+		pstPrbs->ulHistory |= (uint32_t)aucBits[i] << i;
+	}
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               PrbsFill
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Writes the next ulLen bytes of the sequence to pucDst. Consecutive calls
+	continue the sequence without a break.
+*/
+TCM_CODE void PrbsFill(tPrbs *pstPrbs, uint8_t *pucDst, uint32_t ulLen)
+{
+	while(ulLen--)
+	{
+		uint8_t const ucByte = PrbsNextByte(pstPrbs);
+
+		PrbsPush(pstPrbs, ucByte);
+		*pucDst++ = ucByte;
+	}
+}
+
+/** ***************************************************************************
+	Name:               PrbsCheckInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 for an unsupported order
+	Caveats / Effect:   None
+
+	Description:
+	Sets up a receive checker for the given sequence and clears its
+	statistics.
+*/
+int PrbsCheckInit(tPrbsCheck *pstCheck, uint32_t ulOrder)
+{
+	memset(pstCheck, 0, sizeof(*pstCheck));
+	return PrbsInit(&pstCheck->stGen, ulOrder);
+}
+
+/** ***************************************************************************
+	Name:               PrbsCheck
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Checks a chunk of the received byte stream against the sequence.
+
+	While acquiring, the history is loaded straight from the received bytes
+	and each new byte is compared with the one predicted from them. After
+	PRBS_SYNC_BYTES good predictions in a row the checker locks and switches
+	to running its own generator, so a bit error is only counted once instead
+	of also corrupting the following predictions. A monitoring window with
+	more than PRBS_LOSS_ERRORS bit errors is taken as a slip (a lost or extra
+	byte) and the checker re-acquires. A slip near the end of a window may not
+	push it over the limit, so each window is only added to the totals once
+	the window after it is also in sync; on a slip both are discarded.
+*/
+TCM_CODE void PrbsCheck(tPrbsCheck *pstCheck, uint8_t const *pucData, uint32_t ulLen)
+{
+	tPrbs *pstGen = &pstCheck->stGen;
+
+	while(ulLen--)
+	{
+		uint8_t const ucRx = *pucData++;
+
+		if(!pstCheck->ucLocked)
+		{
+			pstCheck->ulUnlockedBytes++;
+			if(pstCheck->ucFill < sizeof(pstGen->ulHistory))
+			{
+				pstCheck->ucFill++;
+			}
+			else if(PrbsNextByte(pstGen) == ucRx)
+			{
+				if(++pstCheck->ulSyncCount >= PRBS_SYNC_BYTES)
+				{
+					pstCheck->ucLocked = 1;
+					pstCheck->ucPending = 0;
+					pstCheck->ulWindowBytes = 0;
+					pstCheck->ulWindowErrors = 0;
+				}
+			}
+			else
+			{
+				pstCheck->ulSyncCount = 0;
+			}
+			PrbsPush(pstGen, ucRx);
+		}
+		else
+		{
+			uint8_t const ucExpected = PrbsNextByte(pstGen);
+
+			PrbsPush(pstGen, ucExpected);
+			pstCheck->ulWindowErrors +=
+				(uint32_t)__builtin_popcount((uint32_t)(ucExpected ^ ucRx));
+
+			if(++pstCheck->ulWindowBytes == PRBS_WINDOW_BYTES)
+			{
+				if(pstCheck->ulWindowErrors > PRBS_LOSS_ERRORS)
+				{
+					/* lost sync, the errors in this window were caused by the
+						misalignment rather than by the link */
+					pstCheck->ulSlips++;
+					pstCheck->ucLocked = 0;
+					pstCheck->ucFill = 0;
+					pstCheck->ulSyncCount = 0;
+				}
+				else
+				{
+					if(pstCheck->ucPending)
+					{
+						pstCheck->ullBits += PRBS_WINDOW_BYTES * 8;
+						pstCheck->ullErrors += pstCheck->ulPendingErrors;
+					}
+					pstCheck->ulPendingErrors = pstCheck->ulWindowErrors;
+					pstCheck->ucPending = 1;
+				}
+				pstCheck->ulWindowBytes = 0;
+				pstCheck->ulWindowErrors = 0;
+			}
+		}
+	}
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               PrbsNextByte
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Next 8 bits of the sequence, first bit in bit 0
+	Caveats / Effect:   Doesn't advance the generator, see PrbsPush()
+
+	Description:
+	Evaluates b[k+j] = b[k+j-N] ^ b[k+j-M] for j = 0..7 in one step. With the
+	newest history bit in bit 31, b[k+j-N] sits in bit 32-N+j.
+*/
+static inline uint8_t PrbsNextByte(tPrbs const *pstPrbs)
+{
+	return (uint8_t)((pstPrbs->ulHistory >> (32 - pstPrbs->ucTapN))
+		^ (pstPrbs->ulHistory >> (32 - pstPrbs->ucTapM)));
+}
+
+/** ***************************************************************************
+	Name:               PrbsPush
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Appends 8 bits to the generator history.
+*/
+static inline void PrbsPush(tPrbs *pstPrbs, uint8_t ucByte)
+{
+	pstPrbs->ulHistory = (pstPrbs->ulHistory >> 8) | ((uint32_t)ucByte << 24);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
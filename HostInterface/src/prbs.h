@@ -0,0 +1,102 @@
+/** ***************************************************************************
+File Name:  prbs.h
+
+Project:    Platform 4
+
+Purpose:    Pseudo-random bit sequence generation and self-synchronizing
+            bit error checking for data channel qualification
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef PRBS_H
+#define PRBS_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* supported sequences (ITU-T O.150 polynomials), identified by their order:
+	PRBS-7 x^7+x^6+1, PRBS-15 x^15+x^14+1, PRBS-23 x^23+x^18+1 */
+#define PRBS_7  7
+#define PRBS_15 15
+#define PRBS_23 23
+
+/* consecutive correctly predicted bytes needed to declare lock */
+#ifndef PRBS_SYNC_BYTES
+#define PRBS_SYNC_BYTES 8
+#endif
+
+/* bytes per error monitoring window once locked, and the number of bit
+	errors in a window that is taken as loss of sync (random data gives
+	about half the bits in error) */
+#ifndef PRBS_WINDOW_BYTES
+#define PRBS_WINDOW_BYTES 128
+#endif
+#ifndef PRBS_LOSS_ERRORS
+#define PRBS_LOSS_ERRORS (PRBS_WINDOW_BYTES * 8 / 4)
+#endif
+
+
+/* Module Type Definitions */
+
+/* sequence generator. ulHistory holds the last 32 bits of the sequence, the
+	oldest in bit 0; ucTapN/ucTapM are the recurrence taps, b[k] = b[k-N] ^
+	b[k-M], with M >= 8 so a whole byte can be produced per step */
+typedef struct
+{
+	uint32_t ulHistory;
+	uint8_t ucTapN;
+	uint8_t ucTapM;
+} tPrbs;
+
+/* receive checker */
+typedef struct
+{
+	tPrbs stGen;
+	/* bytes loaded into the history while acquiring */
+	uint8_t ucFill;
+	/* locked to the incoming sequence */
+	uint8_t ucLocked;
+	/* consecutive good predictions while acquiring */
+	uint32_t ulSyncCount;
+	/* current monitoring window, and the errors of the previous one which
+		aren't committed until this one is also found to be in sync */
+	uint32_t ulWindowBytes;
+	uint32_t ulWindowErrors;
+	uint32_t ulPendingErrors;
+	uint8_t ucPending;
+	/* statistics: bits compared and in error while locked, loss of sync
+		events, and bytes received while not locked */
+	uint64_t ullBits;
+	uint64_t ullErrors;
+	uint32_t ulSlips;
+	uint32_t ulUnlockedBytes;
+} tPrbsCheck;
+
+
+/* Global Function Declarations */
+
+int PrbsInit(tPrbs *pstPrbs, uint32_t ulOrder);
+void PrbsFill(tPrbs *pstPrbs, uint8_t *pucDst, uint32_t ulLen);
+
+int PrbsCheckInit(tPrbsCheck *pstCheck, uint32_t ulOrder);
+void PrbsCheck(tPrbsCheck *pstCheck, uint8_t const *pucData, uint32_t ulLen);
+
+
+#endif /* PRBS_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
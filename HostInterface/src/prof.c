@@ -0,0 +1,289 @@
+/** ***************************************************************************
+File Name:  prof.c
+
+Project:    Platform 4
+
+Purpose:    Cycle counter instrumentation of the ISRs and main loop: run
+            time, entry interval and run time histogram of each site
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdio.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "prof.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static uint32_t ProfAppend(uint32_t ulSize, uint32_t ulLen, int iAdded);
+
+
+/* Module Variable Declarations */
+
+/* statistics of every site, written from the ISRs */
+static tProfSite astProfSites[PROF_SITES] TCM_BSS;
+
+/* site names, indexed by PROF_SITE_x */
+static char const * const apcProfNames[PROF_SITES] = {
+	"xdmac isr",
+	"link0 isr",
+	"link1 isr",
+	"link2 isr",
+	"tc3 isr",
+	"main loop",
+	"link poll",
+	"wake",
+	"pps isr"
+};
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               ProfInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Starts the DWT cycle counter
+
+	Description:
+	Clears the statistics of every site and starts the cycle counter. Call
+	before any of the instrumented interrupts are enabled.
+*/
+void ProfInit(void)
+{
+	memset(astProfSites, 0, sizeof(astProfSites));
+	PROF_CYCLES_INIT();
+}
+
+/** ***************************************************************************
+	Name:               ProfRecord
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Only call for a site from the one context that owns it
+
+	Description:
+	Records one run of a site that started at cycle ulStart and ended at
+	ulEnd. Normally called through PROF_END(). The cycle counter wraps every
+	2^32 cycles, so intervals longer than that are meaningless.
+*/
+TCM_CODE void ProfRecord(uint32_t ulSite, uint32_t ulStart, uint32_t ulEnd)
+{
+	tProfSite *pstSite = &astProfSites[ulSite];
+	uint32_t const ulCycles = ulEnd - ulStart;
+
+	if(pstSite->ucResetReq)
+	{
+		memset(pstSite, 0, sizeof(*pstSite));
+	}
+
+	if(pstSite->ulCount == 0)
+	{
+		pstSite->ulMin = ulCycles;
+		pstSite->ulMax = ulCycles;
+	}
+	else
+	{
+		uint32_t const ulInterval = ulStart - pstSite->ulLastStart;
+
+		if(ulCycles < pstSite->ulMin)
+		{
+			pstSite->ulMin = ulCycles;
+		}
+		if(ulCycles > pstSite->ulMax)
+		{
+			pstSite->ulMax = ulCycles;
+		}
+		if((pstSite->ulCount == 1) || (ulInterval < pstSite->ulMinInterval))
+		{
+			pstSite->ulMinInterval = ulInterval;
+		}
+		if(ulInterval > pstSite->ulMaxInterval)
+		{
+			pstSite->ulMaxInterval = ulInterval;
+		}
+	}
+
+	pstSite->ulLastStart = ulStart;
+	pstSite->ullTotal += ulCycles;
+	pstSite->aulHist[ProfBucket(ulCycles)]++;
+	pstSite->ulCount++;
+}
+
+/** ***************************************************************************
+	Name:               ProfReset
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Asks every site to clear its statistics. The clear is done by the
+	recording context on its next run, so it never races with an update; until
+	then the site reports no runs.
+*/
+void ProfReset(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < PROF_SITES; i++)
+	{
+		astProfSites[i].ucResetReq = 1;
+	}
+}
+
+/** ***************************************************************************
+	Name:               ProfGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Statistics of ulSite
+	Caveats / Effect:   Fields may be updated while they are read
+
+	Description:
+	Gives read access to the statistics of a site.
+*/
+tProfSite const *ProfGet(uint32_t ulSite)
+{
+	return &astProfSites[ulSite];
+}
+
+/** ***************************************************************************
+	Name:               ProfBucket
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Histogram bucket of a run time
+	Caveats / Effect:   None
+
+	Description:
+	Maps a run time to its power of two histogram bucket, see PROF_BUCKETS.
+*/
+TCM_CODE uint32_t ProfBucket(uint32_t ulCycles)
+{
+	uint32_t ulBucket;
+
+	if(ulCycles < 2)
+	{
+		return 0;
+	}
+
+	ulBucket = 31 - (uint32_t)__builtin_clz(ulCycles);
+	return (ulBucket < PROF_BUCKETS) ? ulBucket : PROF_BUCKETS - 1;
+}
+
+/** ***************************************************************************
+	Name:               ProfFormat
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Length of the formatted line
+	Caveats / Effect:   None
+
+	Description:
+	Formats the statistics of a site as a text line: run count, minimum,
+	average and maximum run time, minimum and maximum interval between
+	starts, then every non-empty histogram bucket as <log2 cycles>:<count>.
+	The line is cut short if pcDst is too small.
+*/
+uint32_t ProfFormat(uint32_t ulSite, char *pcDst, uint32_t ulSize)
+{
+	tProfSite const *pstSite = &astProfSites[ulSite];
+	uint32_t const ulCount = pstSite->ucResetReq ? 0 : pstSite->ulCount;
+	uint32_t ulLen = 0;
+	uint32_t i;
+
+	if(ulSize == 0)
+	{
+		return 0;
+	}
+
+	if(ulCount == 0)
+	{
+		return ProfAppend(ulSize, 0,
+			snprintf(pcDst, ulSize, "%-10s no runs\r\n", apcProfNames[ulSite]));
+	}
+
+	ulLen = ProfAppend(ulSize, ulLen,
+		snprintf(pcDst, ulSize, "%-10s %8lu runs %6lu/%6lu/%6lu cycles %9lu/%9lu apart",
+			apcProfNames[ulSite], (unsigned long)ulCount,
+			(unsigned long)pstSite->ulMin,
+			(unsigned long)(pstSite->ullTotal / ulCount),
+			(unsigned long)pstSite->ulMax,
+			(unsigned long)pstSite->ulMinInterval,
+			(unsigned long)pstSite->ulMaxInterval));
+
+	for(i = 0; i < PROF_BUCKETS; i++)
+	{
+		if(pstSite->aulHist[i])
+		{
+			ulLen = ProfAppend(ulSize, ulLen,
+				snprintf(&pcDst[ulLen], ulSize - ulLen, " %lu:%lu",
+					(unsigned long)i, (unsigned long)pstSite->aulHist[i]));
+		}
+	}
+
+	return ProfAppend(ulSize, ulLen,
+		snprintf(&pcDst[ulLen], ulSize - ulLen, "\r\n"));
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               ProfAppend
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             New length of the text
+	Caveats / Effect:   None
+
+	Description:
+	Accounts for iAdded characters appended by snprintf() to a ulLen long
+	string, clamping the length to what actually fitted in ulSize bytes.
+*/
+static uint32_t ProfAppend(uint32_t ulSize, uint32_t ulLen, int iAdded)
+{
+	if(iAdded < 0)
+	{
+		return ulLen;
+	}
+	ulLen += (uint32_t)iAdded;
+	return (ulLen < ulSize) ? ulLen : ulSize - 1;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
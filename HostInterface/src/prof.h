@@ -0,0 +1,112 @@
+/** ***************************************************************************
+File Name:  prof.h
+
+Project:    Platform 4
+
+Purpose:    Cycle counter instrumentation of the ISRs and main loop: run
+            time, entry interval and run time histogram of each site
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef PROF_H
+#define PROF_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* instrumentation on/off; when off PROF_START()/PROF_END() compile to
+	nothing */
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 1
+#endif
+
+/* cycle counter read at every instrumentation point, and its start up. A
+	host build of prof.c supplies its own on the command line */
+#ifndef PROF_CYCLES
+#include "asf.h"
+#define PROF_CYCLES()        (DWT->CYCCNT)
+#define PROF_CYCLES_INIT()   do { \
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+		DWT->LAR = 0xC5ACCE55; \
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; \
+	} while(0)
+#endif
+
+/* instrumented sites. Each is only ever recorded from one context (one ISR,
+	or the main loop), which is what keeps the statistics lock-free */
+#define PROF_SITE_XDMAC_ISR  0
+#define PROF_SITE_LINK0_ISR  1
+#define PROF_SITE_LINK1_ISR  2
+#define PROF_SITE_LINK2_ISR  3
+#define PROF_SITE_TC3_ISR    4
+#define PROF_SITE_MAIN_LOOP  5
+#define PROF_SITE_LINK_POLL  6
+#define PROF_SITE_WAKE       7
+#define PROF_SITE_PPS_ISR    8
+#define PROF_SITES           9
+
+/* run time histogram: bucket 0 counts 0 and 1 cycle, bucket n counts
+	2^n to 2^(n+1) - 1 cycles, the last bucket everything above */
+#define PROF_BUCKETS         20
+
+/* stamp the start and end of an instrumented section */
+#if PROF_ENABLE
+#define PROF_START(ulStart)        ((ulStart) = PROF_CYCLES())
+#define PROF_END(ulSite, ulStart)  ProfRecord((ulSite), (ulStart), PROF_CYCLES())
+#else
+#define PROF_START(ulStart)        ((ulStart) = 0)
+#define PROF_END(ulSite, ulStart)  ((void)(ulStart))
+#endif
+
+
+/* Module Type Definitions */
+
+/* statistics of one site, all times in core cycles */
+typedef struct
+{
+	/* number of runs, and the shortest, longest and total run time */
+	uint32_t ulCount;
+	uint32_t ulMin;
+	uint32_t ulMax;
+	uint64_t ullTotal;
+	/* shortest and longest time between successive starts; for a periodic
+		ISR the spread is the jitter of its entry latency */
+	uint32_t ulMinInterval;
+	uint32_t ulMaxInterval;
+	uint32_t ulLastStart;
+	/* run time histogram, see PROF_BUCKETS */
+	uint32_t aulHist[PROF_BUCKETS];
+	/* set by ProfReset(), cleared by the recording context as it clears
+		the statistics */
+	volatile uint8_t ucResetReq;
+} tProfSite;
+
+
+/* Global Function Declarations */
+
+void ProfInit(void);
+void ProfRecord(uint32_t ulSite, uint32_t ulStart, uint32_t ulEnd);
+void ProfReset(void);
+tProfSite const *ProfGet(uint32_t ulSite);
+uint32_t ProfBucket(uint32_t ulCycles);
+uint32_t ProfFormat(uint32_t ulSite, char *pcDst, uint32_t ulSize);
+
+
+#endif /* PROF_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
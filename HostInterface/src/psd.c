@@ -0,0 +1,346 @@
+/** ***************************************************************************
+File Name:  psd.c
+
+Project:    Platform 4
+
+Purpose:    Welch power spectral density of the samples in the link frames,
+            sent out the USB vendor bulk interface
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "conf_link.h"
+#include "psd.h"
+
+
+/* Module Definitions */
+
+/* samples between the starts of successive segments */
+#define PSD_HOP              (PSD_FFT_SIZE - PSD_OVERLAP)
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void PsdSegment(uint32_t ulLink);
+static void PsdFinish(uint32_t ulLink);
+static void PsdSent(uint8_t *pucBuf, uint32_t ulLen, int iStatus);
+static tPpsTime PsdSampleTime(uint32_t ulSamples);
+
+
+/* Module Variable Declarations */
+
+static tPsd astPsd[LINK_COUNT];
+
+static arm_rfft_fast_instance_f32 stPsdFft;
+
+/* Hann window, and the scale that turns a sum of PSD_AVERAGES squared
+	magnitudes of windowed segments into a one sided density */
+static float32_t afPsdWindow[PSD_FFT_SIZE];
+static float32_t fPsdScale;
+
+/* windowed segment, which the FFT uses as scratch space and which then
+	holds the squared magnitudes, and the FFT output */
+static float32_t afPsdWork[PSD_FFT_SIZE];
+static float32_t afPsdSpectrum[PSD_FFT_SIZE];
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               PsdInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if CMSIS-DSP has no FFT of
+	                    PSD_FFT_SIZE
+	Caveats / Effect:   Call before PsdWrite()
+
+	Description:
+	Sets up the real FFT and the window. The periodic Hann window is used,
+	which with half the segment overlapping weights every sample the same.
+	The density is |X(k)|^2 / (fs * sum(w^2)), averaged over the segments
+	and doubled for the bins that stand for a negative frequency as well.
+*/
+int PsdInit(void)
+{
+	float32_t fPower = 0.0f;
+	uint32_t i;
+
+	memset(astPsd, 0, sizeof(astPsd));
+	if(arm_rfft_fast_init_f32(&stPsdFft, PSD_FFT_SIZE) != ARM_MATH_SUCCESS)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < PSD_FFT_SIZE; i++)
+	{
+		afPsdWindow[i] = 0.5f - 0.5f * arm_cos_f32(2.0f * PI * (float32_t)i
+			/ (float32_t)PSD_FFT_SIZE);
+		fPower += afPsdWindow[i] * afPsdWindow[i];
+	}
+	fPsdScale = 2.0f / ((float32_t)PSD_SAMPLE_RATE_HZ * fPower
+		* (float32_t)PSD_AVERAGES);
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               PsdWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Main program loop only. Runs an FFT for every
+	                    PSD_FFT_SIZE - PSD_OVERLAP samples
+
+	Description:
+	Takes the samples of a frame payload; an odd byte at the end is ignored.
+	A frame missing before this one (usSeq not the one after the last) would
+	splice two stretches of signal into one segment, so the segment being
+	filled is thrown away and a new one starts with this frame; the segments
+	already in the average stay.
+*/
+void PsdWrite(uint32_t ulLink, uint16_t usSeq, tPpsTime tTime,
+	void const *pvData, uint32_t ulLen)
+{
+	tPsd *pstPsd = &astPsd[ulLink];
+	uint8_t const *pucData = pvData;
+	uint32_t ulSamples = ulLen / 2;
+
+	if((pstPsd->ulFill != 0) && (usSeq != pstPsd->usNextSeq))
+	{
+		pstPsd->ulFill = 0;
+		pstPsd->ulGaps++;
+	}
+	pstPsd->usNextSeq = (uint16_t)(usSeq + 1);
+	if(pstPsd->ulFill == 0)
+	{
+		pstPsd->tInput = tTime;
+	}
+	pstPsd->ulSamples += ulSamples;
+
+	while(ulSamples)
+	{
+		uint32_t ulCount = PSD_FFT_SIZE - pstPsd->ulFill;
+
+		if(ulCount > ulSamples)
+		{
+			ulCount = ulSamples;
+		}
+		/* little endian 16 bit samples are q15, scaled to +-1.0 */
+		arm_q15_to_float((q15_t *)(void *)pucData,
+			&pstPsd->afInput[pstPsd->ulFill], ulCount);
+		pstPsd->ulFill += ulCount;
+		pucData += ulCount * 2;
+		ulSamples -= ulCount;
+
+		if(pstPsd->ulFill == PSD_FFT_SIZE)
+		{
+			PsdSegment(ulLink);
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               PsdGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Spectrum state of a link
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to the statistics.
+*/
+tPsd const *PsdGet(uint32_t ulLink)
+{
+	return &astPsd[ulLink];
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               PsdSegment
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The link's segment must be full
+
+	Description:
+	Windows the segment, adds its squared magnitudes into the average and
+	keeps the last PSD_OVERLAP samples as the start of the next segment.
+	arm_rfft_fast_f32() packs the real DC and half sample rate terms into
+	the first two outputs, followed by the complex bins in between.
+*/
+static void PsdSegment(uint32_t ulLink)
+{
+	tPsd *pstPsd = &astPsd[ulLink];
+
+	arm_mult_f32(pstPsd->afInput, afPsdWindow, afPsdWork, PSD_FFT_SIZE);
+	arm_rfft_fast_f32(&stPsdFft, afPsdWork, afPsdSpectrum, 0);
+
+	afPsdWork[0] = afPsdSpectrum[0] * afPsdSpectrum[0];
+	afPsdWork[PSD_BINS - 1] = afPsdSpectrum[1] * afPsdSpectrum[1];
+	arm_cmplx_mag_squared_f32(&afPsdSpectrum[2], &afPsdWork[1],
+		PSD_BINS - 2);
+	arm_add_f32(pstPsd->afSum, afPsdWork, pstPsd->afSum, PSD_BINS);
+
+	if(pstPsd->ulSegments++ == 0)
+	{
+		pstPsd->tFirst = pstPsd->tInput;
+	}
+
+	memmove(pstPsd->afInput, &pstPsd->afInput[PSD_HOP],
+		PSD_OVERLAP * sizeof(pstPsd->afInput[0]));
+	pstPsd->ulFill = PSD_OVERLAP;
+	pstPsd->tInput += PsdSampleTime(PSD_HOP);
+
+	if(pstPsd->ulSegments == PSD_AVERAGES)
+	{
+		PsdFinish(ulLink);
+	}
+}
+
+/** ***************************************************************************
+	Name:               PsdFinish
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The link's average must be complete
+
+	Description:
+	Scales the average into a spectrum in a free output buffer, queues it on
+	the USB vendor bulk IN endpoint as one transfer and starts the next
+	average. The spectrum is dropped if the host has no room for it.
+*/
+static void PsdFinish(uint32_t ulLink)
+{
+	tPsd *pstPsd = &astPsd[ulLink];
+	tPsdOut *pstOut = NULL;
+	uint32_t i;
+
+	for(i = 0; i < PSD_OUT_BUFS; i++)
+	{
+		if(!pstPsd->astOut[i].ucBusy)
+		{
+			pstOut = &pstPsd->astOut[i];
+			break;
+		}
+	}
+
+	if(!pstOut || !UsbStreamIsEnabled())
+	{
+		pstPsd->ulDropped++;
+	}
+	else
+	{
+		tPsdFrame *pstFrame = &pstOut->stFrame;
+
+		pstFrame->stHeader.ulMagic = PSD_MAGIC;
+		pstFrame->stHeader.ucVersion = PSD_VERSION;
+		pstFrame->stHeader.ucLink = (uint8_t)ulLink;
+		pstFrame->stHeader.usBins = PSD_BINS;
+		pstFrame->stHeader.ulSampleRateHz = PSD_SAMPLE_RATE_HZ;
+		pstFrame->stHeader.usFftSize = PSD_FFT_SIZE;
+		pstFrame->stHeader.usOverlap = PSD_OVERLAP;
+		pstFrame->stHeader.usAverages = PSD_AVERAGES;
+		pstFrame->stHeader.usReserved = 0;
+		pstFrame->stHeader.ulSeq = pstPsd->ulSpectra;
+		pstFrame->stHeader.tTime = pstPsd->tFirst;
+
+		/* DC and half the sample rate have no negative frequency twin */
+		arm_scale_f32(pstPsd->afSum, fPsdScale, pstFrame->afPsd, PSD_BINS);
+		pstFrame->afPsd[0] *= 0.5f;
+		pstFrame->afPsd[PSD_BINS - 1] *= 0.5f;
+
+		pstOut->ucBusy = 1;
+		if(UsbStreamWrite((uint8_t *)pstFrame, sizeof(*pstFrame), 1, PsdSent)
+			!= 0)
+		{
+			pstOut->ucBusy = 0;
+			pstPsd->ulDropped++;
+		}
+	}
+
+	pstPsd->ulSpectra++;
+	memset(pstPsd->afSum, 0, sizeof(pstPsd->afSum));
+	pstPsd->ulSegments = 0;
+}
+
+/** ***************************************************************************
+	Name:               PsdSent
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   USB ISR
+
+	Description:
+	A spectrum has gone to the host, or the transfer was aborted; either
+	way its buffer is free again.
+*/
+static void PsdSent(uint8_t *pucBuf, uint32_t ulLen, int iStatus)
+{
+	uint32_t i;
+	uint32_t j;
+
+	UNUSED(ulLen);
+	UNUSED(iStatus);
+	for(i = 0; i < LINK_COUNT; i++)
+	{
+		for(j = 0; j < PSD_OUT_BUFS; j++)
+		{
+			if(pucBuf == (uint8_t *)&astPsd[i].astOut[j].stFrame)
+			{
+				astPsd[i].astOut[j].ucBusy = 0;
+				return;
+			}
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               PsdSampleTime
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             The time taken by a number of samples
+	Caveats / Effect:   None
+
+	Description:
+	Converts a sample count into a PPS time interval at PSD_SAMPLE_RATE_HZ.
+*/
+static tPpsTime PsdSampleTime(uint32_t ulSamples)
+{
+	return ((tPpsTime)ulSamples << 32) / PSD_SAMPLE_RATE_HZ;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,127 @@
+/** ***************************************************************************
+File Name:  psd.h
+
+Project:    Platform 4
+
+Purpose:    Welch power spectral density of the samples in the link frames,
+            sent out the USB vendor bulk interface
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef PSD_H
+#define PSD_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "arm_math.h"
+#include "conf_psd.h"
+#include "dma_buf.h"
+#include "pps.h"
+
+
+/* Module Definitions */
+
+#if (PSD_FFT_SIZE < 32) || (PSD_FFT_SIZE > 4096) \
+	|| (PSD_FFT_SIZE & (PSD_FFT_SIZE - 1))
+#error "PSD_FFT_SIZE must be a power of two from 32 to 4096"
+#endif
+#if (PSD_OVERLAP < 0) || (PSD_OVERLAP >= PSD_FFT_SIZE)
+#error "PSD_OVERLAP must be less than PSD_FFT_SIZE"
+#endif
+
+/* bins of a spectrum, DC to half the sample rate */
+#define PSD_BINS             (PSD_FFT_SIZE / 2 + 1)
+
+/* spectrum identification: "OSPS" */
+#define PSD_MAGIC            0x5350534FUL
+#define PSD_VERSION          1
+
+
+/* Module Type Definitions */
+
+/* spectrum header, little endian, followed by PSD_BINS floats: the one
+	sided power spectral density of each bin in full scale squared per Hz
+	(16 bit samples are taken as fractions of 32768). ulSeq counts the
+	spectra of the link, so a gap in it is spectra dropped; tTime is the
+	PPS time of the first sample of the first segment, from the frame
+	times */
+typedef struct
+{
+	uint32_t ulMagic;
+	uint8_t ucVersion;
+	uint8_t ucLink;
+	uint16_t usBins;
+	uint32_t ulSampleRateHz;
+	uint16_t usFftSize;
+	uint16_t usOverlap;
+	uint16_t usAverages;
+	uint16_t usReserved;
+	uint32_t ulSeq;
+	tPpsTime tTime;
+} tPsdHeader;
+
+/* a spectrum as it goes to the host */
+typedef struct
+{
+	tPsdHeader stHeader;
+	float32_t afPsd[PSD_BINS];
+} tPsdFrame;
+
+/* a finished spectrum, and whether it is still with the USB driver */
+typedef struct
+{
+	tPsdFrame stFrame DMA_BUF_ALIGNED;
+	volatile uint8_t ucBusy;
+} tPsdOut;
+
+/* state of one link */
+typedef struct
+{
+	/* the segment being filled, the PPS time of its first sample, and the
+		frame sequence number expected next */
+	float32_t afInput[PSD_FFT_SIZE];
+	uint32_t ulFill;
+	tPpsTime tInput;
+	uint16_t usNextSeq;
+	/* the spectrum being averaged: sum of the segments' squared magnitudes,
+		the number in it, and the time of its first sample */
+	float32_t afSum[PSD_BINS];
+	uint32_t ulSegments;
+	tPpsTime tFirst;
+	tPsdOut astOut[PSD_OUT_BUFS];
+	/* statistics: samples taken, restarts for lost frames, spectra
+		finished, and those dropped because the host wasn't keeping up or
+		hadn't opened the interface */
+	uint32_t ulSamples;
+	uint32_t ulGaps;
+	uint32_t ulSpectra;
+	uint32_t ulDropped;
+} tPsd;
+
+
+/* Global Function Declarations */
+
+int PsdInit(void);
+void PsdWrite(uint32_t ulLink, uint16_t usSeq, tPpsTime tTime,
+	void const *pvData, uint32_t ulLen);
+tPsd const *PsdGet(uint32_t ulLink);
+
+
+#endif /* PSD_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
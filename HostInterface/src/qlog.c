@@ -0,0 +1,711 @@
+/** ***************************************************************************
+File Name:  qlog.c
+
+Project:    Platform 4
+
+Purpose:    Post-mortem log: an append-only ring of short records in the
+            QSPI flash, written in the background
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stddef.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "crc.h"
+#include "qlog.h"
+
+
+/* Module Definitions */
+
+/* flash operation in progress, tQlog.ucOp */
+#define QLOG_OP_NONE         0
+#define QLOG_OP_ERASE        1
+#define QLOG_OP_PROGRAM      2
+#define QLOG_OP_HEADER       3
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void QlogClosePage(void);
+static void QlogStartOp(void);
+static void QlogErase(void);
+static int QlogReadSector(uint32_t ulSector, tQlogSector *pstHeader);
+static int QlogPageEmpty(uint32_t ulSeq, uint32_t ulPage);
+static uint32_t QlogAddr(uint32_t ulSeq, uint32_t ulPage);
+static uint32_t QlogSectorCrc(tQlogSector const *pstHeader);
+static uint32_t QlogRecordCrc(uint8_t const *pucHeader, void const *pvData,
+	uint32_t ulLen);
+
+
+/* Module Variable Declarations */
+
+static tQlog stQlog;
+
+/* staging ring, a page each */
+static tQlogPage astQlogPages[QLOG_PAGE_BUFS];
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               QlogStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if there is no flash or it is too
+	                    small
+	Caveats / Effect:   QspiInit() must have succeeded; reads every sector
+	                    header of the log. Nothing is written until the first
+	                    QlogPoll(), so the log can be read back before that
+
+	Description:
+	Finds where the log stopped and carries on after it. The newest sector
+	is the one with the highest sequence number; writing resumes at its
+	first empty page, or in the next sector if it is full; if the newest
+	sector is empty, having been erased ahead, it resumes in the sector
+	before. A sector only gets its header once its erase has finished, so
+	one whose erase the reset cut short is erased again.
+*/
+int QlogStart(void)
+{
+	tQspi const *pstQspi = QspiGet();
+	uint32_t const ulFlashSectors = pstQspi->ulSize / QSPI_SECTOR_SIZE;
+	tQlogSector stHeader;
+	uint8_t ucFound = 0;
+	uint32_t ulHead = 0;
+	uint32_t i;
+
+	memset(&stQlog, 0, sizeof(stQlog));
+	if(!pstQspi->ucReady || (ulFlashSectors < QLOG_FIRST_SECTOR + 3))
+	{
+		return -1;
+	}
+	stQlog.ulFirstSector = QLOG_FIRST_SECTOR;
+	stQlog.ulSectors = ulFlashSectors - QLOG_FIRST_SECTOR;
+	if((QLOG_SECTORS != 0) && (QLOG_SECTORS < stQlog.ulSectors))
+	{
+		stQlog.ulSectors = QLOG_SECTORS;
+	}
+	if(stQlog.ulSectors < 3)
+	{
+		return -1;
+	}
+
+	stQlog.ulMinErases = UINT32_MAX;
+	for(i = 0; i < stQlog.ulSectors; i++)
+	{
+		if(QlogReadSector(i, &stHeader) != 0)
+		{
+			continue;
+		}
+		if(!ucFound || ((int32_t)(stHeader.ulSeq - ulHead) > 0))
+		{
+			ulHead = stHeader.ulSeq;
+			ucFound = 1;
+		}
+		if(stHeader.ulErases < stQlog.ulMinErases)
+		{
+			stQlog.ulMinErases = stHeader.ulErases;
+		}
+		if(stHeader.ulErases > stQlog.ulMaxErases)
+		{
+			stQlog.ulMaxErases = stHeader.ulErases;
+		}
+	}
+	if(stQlog.ulMinErases == UINT32_MAX)
+	{
+		stQlog.ulMinErases = 0;
+	}
+
+	if(ucFound)
+	{
+		stQlog.ulEraseSeq = ulHead + 1;
+
+		/* the newest sector may only have been erased ahead, writing then
+			resumes in the one before it */
+		if(QlogPageEmpty(ulHead, 0)
+			&& (QlogReadSector((ulHead - 1) % stQlog.ulSectors, &stHeader) == 0)
+			&& (stHeader.ulSeq == ulHead - 1))
+		{
+			ulHead--;
+		}
+
+		/* pages are programmed in order, so the first empty one is where
+			the log stopped */
+		stQlog.ulSeq = ulHead + 1;
+		stQlog.ulPage = 0;
+		for(i = 0; i < QLOG_SECTOR_PAGES; i++)
+		{
+			if(QlogPageEmpty(ulHead, i))
+			{
+				stQlog.ulSeq = ulHead;
+				stQlog.ulPage = i;
+				break;
+			}
+		}
+	}
+
+	for(i = 0; i < QLOG_PAGE_BUFS; i++)
+	{
+		astQlogPages[i].ulLen = 0;
+	}
+	stQlog.ucStarted = 1;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QlogWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the record was dropped
+	Caveats / Effect:   Main program loop only
+
+	Description:
+	Stages a record of type ucType with ulLen bytes from pvData, stamped
+	with tTime. The record is copied, so the caller's buffer is free again
+	at once; it never waits for the flash. A record longer than
+	QLOG_MAX_PAYLOAD, or one arriving while every page is waiting for the
+	flash, is dropped and counted.
+*/
+int QlogWrite(uint8_t ucType, tPpsTime tTime, void const *pvData,
+	uint32_t ulLen)
+{
+	uint32_t const ulSize = QLOG_RECORD_HEADER + ((ulLen + 3) & ~3UL);
+	tQlogPage *pstPage = &astQlogPages[stQlog.ulHead];
+	uint8_t *pucRecord;
+	uint32_t ulCrc;
+
+	if(!stQlog.ucStarted)
+	{
+		return -1;
+	}
+	if(ulLen > QLOG_MAX_PAYLOAD)
+	{
+		stQlog.ulDropped++;
+		return -1;
+	}
+
+	/* records don't straddle pages */
+	if((stQlog.ulFull < QLOG_PAGE_BUFS) && (pstPage->ulLen != 0)
+		&& (pstPage->ulLen + ulSize > QSPI_PAGE_SIZE))
+	{
+		QlogClosePage();
+		pstPage = &astQlogPages[stQlog.ulHead];
+	}
+	if(stQlog.ulFull >= QLOG_PAGE_BUFS)
+	{
+		stQlog.ulDropped++;
+		return -1;
+	}
+
+	if(pstPage->ulLen == 0)
+	{
+		/* the page takes the next place in the log. The first page of a
+			sector starts with the sector header, filled in when it goes out */
+		pstPage->ulSeq = stQlog.ulSeq;
+		pstPage->ulPage = stQlog.ulPage;
+		pstPage->ulLen = (stQlog.ulPage == 0) ? QLOG_SECTOR_HEADER : 0;
+		pstPage->tStarted = tTime;
+		if(++stQlog.ulPage == QLOG_SECTOR_PAGES)
+		{
+			stQlog.ulPage = 0;
+			stQlog.ulSeq++;
+		}
+	}
+
+	pucRecord = &pstPage->aucData[pstPage->ulLen];
+	pucRecord[0] = (uint8_t)ulLen;
+	pucRecord[1] = (uint8_t)(ulLen >> 8);
+	pucRecord[2] = ucType;
+	pucRecord[3] = QLOG_RECORD_SYNC;
+	memcpy(&pucRecord[8], &tTime, sizeof(tTime));
+	memcpy(&pucRecord[QLOG_RECORD_HEADER], pvData, ulLen);
+	memset(&pucRecord[QLOG_RECORD_HEADER + ulLen], 0xFF,
+		ulSize - QLOG_RECORD_HEADER - ulLen);
+	ulCrc = QlogRecordCrc(pucRecord, &pucRecord[QLOG_RECORD_HEADER], ulLen);
+	memcpy(&pucRecord[4], &ulCrc, sizeof(ulCrc));
+	pstPage->ulLen += ulSize;
+
+	stQlog.ulRecords++;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QlogPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the main program loop
+
+	Description:
+	Runs the flash in the background, one erase or page program at a time,
+	each checked on by a quick status read per call. Waiting pages go out in
+	order, each after its sector has been erased and given its header; with
+	nothing waiting the next sector is erased ahead, so a page rarely waits
+	for an erase. A partly filled page is sent once it is QLOG_FLUSH_SECONDS
+	old.
+*/
+void QlogPoll(tPpsTime tNow)
+{
+	if(!stQlog.ucStarted)
+	{
+		return;
+	}
+
+	if(stQlog.ucOp != QLOG_OP_NONE)
+	{
+		uint8_t const ucOp = stQlog.ucOp;
+		int const iResult = QspiPoll();
+
+		if(iResult == QSPI_BUSY)
+		{
+			return;
+		}
+		if(iResult != 0)
+		{
+			stQlog.ulErrors++;
+		}
+		stQlog.ucOp = QLOG_OP_NONE;
+		if(ucOp == QLOG_OP_PROGRAM)
+		{
+			if(iResult == 0)
+			{
+				stQlog.ulPages++;
+			}
+			astQlogPages[stQlog.ulTail].ulLen = 0;
+			stQlog.ulTail = (stQlog.ulTail + 1) % QLOG_PAGE_BUFS;
+			stQlog.ulFull--;
+		}
+		else if((ucOp == QLOG_OP_ERASE) && (iResult == 0))
+		{
+			/* the header marks the sector as erased and part of the log */
+			if(QspiProgram(QlogAddr(stQlog.stHeader.ulSeq, 0),
+				&stQlog.stHeader, sizeof(stQlog.stHeader)) == 0)
+			{
+				stQlog.ucOp = QLOG_OP_HEADER;
+				return;
+			}
+			stQlog.ulErrors++;
+		}
+	}
+
+	if((stQlog.ulFull < QLOG_PAGE_BUFS)
+		&& (astQlogPages[stQlog.ulHead].ulLen != 0)
+		&& (tNow - astQlogPages[stQlog.ulHead].tStarted
+			>= ((uint64_t)QLOG_FLUSH_SECONDS << 32)))
+	{
+		QlogClosePage();
+	}
+
+	QlogStartOp();
+}
+
+/** ***************************************************************************
+	Name:               QlogReadStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Points pstCursor at the oldest sector the log still holds, the one the
+	next erase will take, for QlogRead() to read on to the newest.
+*/
+void QlogReadStart(tQlogCursor *pstCursor)
+{
+	pstCursor->ulSeq = (stQlog.ulEraseSeq > stQlog.ulSectors)
+		? stQlog.ulEraseSeq - stQlog.ulSectors : 0;
+	pstCursor->ulEndSeq = stQlog.ulSeq;
+	pstCursor->ulPage = 0;
+	pstCursor->ulOffset = 0;
+}
+
+/** ***************************************************************************
+	Name:               QlogRead
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             1 if a record was read, 0 at the end of the log, -1
+	                    if the flash is busy
+	Caveats / Effect:   Blocks for the flash reads. Records still staged in
+	                    memory aren't seen, and once the log is being written
+	                    the oldest sector may go while it is read
+
+	Description:
+	Reads the next record in the flash, oldest first, into *pstRecord.
+	Sectors that don't carry the sequence number expected of them haven't
+	been written in this pass and are skipped, and so is the rest of a page
+	from the first record that fails its checks: the erased end of a page
+	sent part full, or a record torn by a reset.
+*/
+int QlogRead(tQlogCursor *pstCursor, tQlogRecord *pstRecord)
+{
+	uint8_t aucHeader[QLOG_RECORD_HEADER];
+	tQlogSector stSector;
+	uint32_t ulAddr;
+	uint32_t ulLen;
+	uint32_t ulCrc;
+
+	if(!stQlog.ucStarted)
+	{
+		return 0;
+	}
+	if(stQlog.ucOp != QLOG_OP_NONE)
+	{
+		return -1;
+	}
+
+	while((int32_t)(pstCursor->ulEndSeq - pstCursor->ulSeq) >= 0)
+	{
+		if(pstCursor->ulPage == QLOG_SECTOR_PAGES)
+		{
+			pstCursor->ulSeq++;
+			pstCursor->ulPage = 0;
+			pstCursor->ulOffset = 0;
+			continue;
+		}
+		if((pstCursor->ulPage == 0) && (pstCursor->ulOffset == 0))
+		{
+			if((QlogReadSector(pstCursor->ulSeq % stQlog.ulSectors, &stSector)
+				!= 0) || (stSector.ulSeq != pstCursor->ulSeq))
+			{
+				pstCursor->ulPage = QLOG_SECTOR_PAGES;
+				continue;
+			}
+			pstCursor->ulOffset = QLOG_SECTOR_HEADER;
+		}
+
+		ulAddr = QlogAddr(pstCursor->ulSeq, pstCursor->ulPage)
+			+ pstCursor->ulOffset;
+		if(pstCursor->ulOffset + QLOG_RECORD_HEADER <= QSPI_PAGE_SIZE)
+		{
+			if(QspiRead(ulAddr, aucHeader, sizeof(aucHeader)) != 0)
+			{
+				return -1;
+			}
+			ulLen = (uint32_t)aucHeader[0] | ((uint32_t)aucHeader[1] << 8);
+			if((aucHeader[3] == QLOG_RECORD_SYNC)
+				&& (ulLen <= QLOG_MAX_PAYLOAD)
+				&& (pstCursor->ulOffset + QLOG_RECORD_HEADER + ulLen
+					<= QSPI_PAGE_SIZE))
+			{
+				if(QspiRead(ulAddr + QLOG_RECORD_HEADER, pstRecord->aucData,
+					ulLen) != 0)
+				{
+					return -1;
+				}
+				memcpy(&ulCrc, &aucHeader[4], sizeof(ulCrc));
+				if(ulCrc == QlogRecordCrc(aucHeader, pstRecord->aucData, ulLen))
+				{
+					pstRecord->ucType = aucHeader[2];
+					pstRecord->usLen = (uint16_t)ulLen;
+					memcpy(&pstRecord->tTime, &aucHeader[8],
+						sizeof(pstRecord->tTime));
+					pstCursor->ulOffset += QLOG_RECORD_HEADER
+						+ ((ulLen + 3) & ~3UL);
+					return 1;
+				}
+			}
+		}
+
+		/* nothing more in this page */
+		pstCursor->ulPage++;
+		pstCursor->ulOffset = 0;
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QlogGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Log state
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to the log position and the statistics.
+*/
+tQlog const *QlogGet(void)
+{
+	return &stQlog;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               QlogClosePage
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   There must be a page being filled (ulFull below
+	                    QLOG_PAGE_BUFS)
+
+	Description:
+	Queues the page being filled for the flash and moves on to the next.
+*/
+static void QlogClosePage(void)
+{
+	stQlog.ulFull++;
+	if(stQlog.ulFull > stQlog.ulMaxFull)
+	{
+		stQlog.ulMaxFull = stQlog.ulFull;
+	}
+	stQlog.ulHead = (stQlog.ulHead + 1) % QLOG_PAGE_BUFS;
+}
+
+/** ***************************************************************************
+	Name:               QlogStartOp
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The flash must be idle
+
+	Description:
+	Starts the next flash operation: the oldest waiting page, or the erase
+	of its sector if that hasn't been done yet, or with nothing waiting the
+	erase of the sector after the one being filled. A page the flash won't
+	take is dropped, so one bad page can't stop the log.
+*/
+static void QlogStartOp(void)
+{
+	tQlogPage *pstPage = &astQlogPages[stQlog.ulTail];
+	uint32_t ulSkip;
+
+	if(stQlog.ulFull == 0)
+	{
+		if((int32_t)(stQlog.ulSeq + 1 - stQlog.ulEraseSeq) >= 0)
+		{
+			QlogErase();
+		}
+		return;
+	}
+
+	if((int32_t)(pstPage->ulSeq - stQlog.ulEraseSeq) >= 0)
+	{
+		QlogErase();
+		return;
+	}
+
+	/* the sector header is already in the flash */
+	ulSkip = (pstPage->ulPage == 0) ? QLOG_SECTOR_HEADER : 0;
+	if(QspiProgram(QlogAddr(pstPage->ulSeq, pstPage->ulPage) + ulSkip,
+		&pstPage->aucData[ulSkip], pstPage->ulLen - ulSkip) != 0)
+	{
+		stQlog.ulErrors++;
+		pstPage->ulLen = 0;
+		stQlog.ulTail = (stQlog.ulTail + 1) % QLOG_PAGE_BUFS;
+		stQlog.ulFull--;
+		return;
+	}
+	stQlog.ucOp = QLOG_OP_PROGRAM;
+}
+
+/** ***************************************************************************
+	Name:               QlogErase
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The flash must be idle
+
+	Description:
+	Starts erasing the sector with sequence number ulEraseSeq, and makes up
+	the header QlogPoll() programs once it is done, taking the erase count
+	on from the header the sector had. A sector without one (never used, or
+	its erase cut short by a reset) is taken to be as worn as the sector
+	before it, which the rotation erases as often.
+*/
+static void QlogErase(void)
+{
+	uint32_t const ulSeq = stQlog.ulEraseSeq;
+	tQlogSector *pstHeader = &stQlog.stHeader;
+	uint32_t ulErases = 1;
+
+	if(QlogReadSector(ulSeq % stQlog.ulSectors, pstHeader) == 0)
+	{
+		ulErases = pstHeader->ulErases + 1;
+	}
+	else if((QlogReadSector((ulSeq - 1) % stQlog.ulSectors, pstHeader) == 0)
+		&& (pstHeader->ulSeq == ulSeq - 1))
+	{
+		ulErases = pstHeader->ulErases;
+	}
+	if(ulErases > stQlog.ulMaxErases)
+	{
+		stQlog.ulMaxErases = ulErases;
+	}
+	pstHeader->ulMagic = QLOG_SECTOR_MAGIC;
+	pstHeader->ulSeq = ulSeq;
+	pstHeader->ulErases = ulErases;
+	pstHeader->ulCrc = QlogSectorCrc(pstHeader);
+	stQlog.ulEraseSeq++;
+
+	if(QspiErase(QlogAddr(ulSeq, 0)) != 0)
+	{
+		stQlog.ulErrors++;
+		return;
+	}
+	stQlog.ucOp = QLOG_OP_ERASE;
+	stQlog.ulErases++;
+}
+
+/** ***************************************************************************
+	Name:               QlogReadSector
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if the header is valid, -1 if not
+	Caveats / Effect:   The flash must be idle
+
+	Description:
+	Reads the header of sector ulSector of the log, and checks it belongs
+	there.
+*/
+static int QlogReadSector(uint32_t ulSector, tQlogSector *pstHeader)
+{
+	if((QspiRead((stQlog.ulFirstSector + ulSector) * QSPI_SECTOR_SIZE,
+			pstHeader, sizeof(*pstHeader)) != 0)
+		|| (pstHeader->ulMagic != QLOG_SECTOR_MAGIC)
+		|| (pstHeader->ulCrc != QlogSectorCrc(pstHeader))
+		|| (pstHeader->ulSeq % stQlog.ulSectors != ulSector))
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QlogPageEmpty
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             1 if the page holds no records, 0 if it does
+	Caveats / Effect:   The flash must be idle
+
+	Description:
+	Checks page ulPage of the sector with sequence number ulSeq, after the
+	sector header in the first page. A page that has been programmed, even
+	partly, is not all ones.
+*/
+static int QlogPageEmpty(uint32_t ulSeq, uint32_t ulPage)
+{
+	uint32_t const ulSkip = (ulPage == 0) ? QLOG_SECTOR_HEADER : 0;
+	uint32_t aulPage[QSPI_PAGE_SIZE / 4];
+	uint32_t i;
+
+	if(QspiRead(QlogAddr(ulSeq, ulPage) + ulSkip, aulPage,
+		QSPI_PAGE_SIZE - ulSkip) != 0)
+	{
+		return 0;
+	}
+	for(i = 0; i < (QSPI_PAGE_SIZE - ulSkip) / 4; i++)
+	{
+		if(aulPage[i] != 0xFFFFFFFFUL)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/** ***************************************************************************
+	Name:               QlogAddr
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Flash address
+	Caveats / Effect:   None
+
+	Description:
+	Finds page ulPage of the sector with sequence number ulSeq.
+*/
+static uint32_t QlogAddr(uint32_t ulSeq, uint32_t ulPage)
+{
+	return (stQlog.ulFirstSector + ulSeq % stQlog.ulSectors)
+		* QSPI_SECTOR_SIZE + ulPage * QSPI_PAGE_SIZE;
+}
+
+/** ***************************************************************************
+	Name:               QlogSectorCrc
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             CRC-32 of the sector header
+	Caveats / Effect:   None
+
+	Description:
+	Computes the CRC of the header as if its ulCrc field were 0.
+*/
+static uint32_t QlogSectorCrc(tQlogSector const *pstHeader)
+{
+	static uint32_t const ulZero = 0;
+
+	return Crc32(Crc32(CRC32_INIT, pstHeader, offsetof(tQlogSector, ulCrc)),
+		&ulZero, sizeof(ulZero));
+}
+
+/** ***************************************************************************
+	Name:               QlogRecordCrc
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             CRC-32 of the record
+	Caveats / Effect:   None
+
+	Description:
+	Computes the CRC of a record header and its ulLen bytes of payload, as
+	if the header's CRC field were 0.
+*/
+static uint32_t QlogRecordCrc(uint8_t const *pucHeader, void const *pvData,
+	uint32_t ulLen)
+{
+	static uint32_t const ulZero = 0;
+	uint32_t ulCrc;
+
+	ulCrc = Crc32(CRC32_INIT, pucHeader, 4);
+	ulCrc = Crc32(ulCrc, &ulZero, sizeof(ulZero));
+	ulCrc = Crc32(ulCrc, &pucHeader[8], QLOG_RECORD_HEADER - 8);
+	return Crc32(ulCrc, pvData, ulLen);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
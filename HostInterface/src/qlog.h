@@ -0,0 +1,156 @@
+/** ***************************************************************************
+File Name:  qlog.h
+
+Project:    Platform 4
+
+Purpose:    Post-mortem log: an append-only ring of short records in the
+            QSPI flash, written in the background
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef QLOG_H
+#define QLOG_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "conf_qlog.h"
+#include "dma_buf.h"
+#include "pps.h"
+#include "qspi.h"
+
+
+/* Module Definitions */
+
+/* Log layout. The log is a ring of flash sectors, each starting with a
+	QLOG_SECTOR_HEADER byte header (tQlogSector), programmed as soon as the
+	sector has been erased. Sectors are used in turn, so they all wear at
+	the same rate. Pages hold whole
+	records, each a QLOG_RECORD_HEADER byte header (length, type,
+	QLOG_RECORD_SYNC, CRC-32 and PPS time, little endian) and up to
+	QLOG_MAX_PAYLOAD bytes of payload, padded to a multiple of 4 bytes.
+	Each page's records are programmed at once; the erased rest of a page
+	that was sent part full, or a record torn by a reset, ends it */
+#define QLOG_SECTOR_HEADER   16
+#define QLOG_RECORD_HEADER   16
+#define QLOG_RECORD_SYNC     0x5A
+#define QLOG_MAX_PAYLOAD     (QSPI_PAGE_SIZE - QLOG_SECTOR_HEADER \
+	- QLOG_RECORD_HEADER)
+#define QLOG_SECTOR_PAGES    (QSPI_SECTOR_SIZE / QSPI_PAGE_SIZE)
+
+/* sector header identification: "OSQL" */
+#define QLOG_SECTOR_MAGIC    0x4C51534FUL
+
+/* record types */
+#define QLOG_TYPE_BOOT       1   /* startup, with the reset cause */
+#define QLOG_TYPE_STATS      2   /* periodic statistics */
+#define QLOG_TYPE_EVENT      3   /* something went wrong, with a snippet */
+
+/* Module Type Definitions */
+
+/* sector header. ulSeq goes up by one from sector to sector, and is the
+	sector's position in the log modulo the number of sectors; ulErases
+	counts the erases of the sector. ulCrc is the CRC-32 (crc.h) of the
+	header with ulCrc 0 */
+typedef struct
+{
+	uint32_t ulMagic;
+	uint32_t ulSeq;
+	uint32_t ulErases;
+	uint32_t ulCrc;
+} tQlogSector;
+
+/* a page being filled or waiting for the flash, and where it goes: page
+	ulPage of the sector with sequence number ulSeq */
+typedef struct
+{
+	uint8_t aucData[QSPI_PAGE_SIZE] DMA_BUF_ALIGNED;
+	uint32_t ulLen;
+	uint32_t ulSeq;
+	uint32_t ulPage;
+	/* when the first record went in, for QLOG_FLUSH_SECONDS */
+	tPpsTime tStarted;
+} tQlogPage;
+
+/* log state */
+typedef struct
+{
+	/* the log has started, and its sectors in the flash */
+	uint8_t ucStarted;
+	uint32_t ulFirstSector;
+	uint32_t ulSectors;
+	/* where the next page goes, and the sequence number of the next sector
+		to erase. Sectors are erased one ahead of the page being written */
+	uint32_t ulSeq;
+	uint32_t ulPage;
+	uint32_t ulEraseSeq;
+	/* header of the sector last erased, programmed after the erase */
+	tQlogSector stHeader;
+	/* staging ring: the page being filled, the oldest one waiting for the
+		flash, the number waiting, and the flash operation in progress
+		(QLOG_OP_x in qlog.c) */
+	uint32_t ulHead;
+	uint32_t ulTail;
+	uint32_t ulFull;
+	uint8_t ucOp;
+	/* statistics: records staged, records dropped for lack of staging space
+		or being too long, pages programmed, sectors erased, failed flash
+		operations, and the most pages ever waiting */
+	uint32_t ulRecords;
+	uint32_t ulDropped;
+	uint32_t ulPages;
+	uint32_t ulErases;
+	uint32_t ulErrors;
+	uint32_t ulMaxFull;
+	/* wear: erase counts of the least erased sector found at start, and of
+		the most erased one so far */
+	uint32_t ulMinErases;
+	uint32_t ulMaxErases;
+} tQlog;
+
+/* position of QlogRead() in the log */
+typedef struct
+{
+	uint32_t ulSeq;
+	uint32_t ulEndSeq;
+	uint32_t ulPage;
+	uint32_t ulOffset;
+} tQlogCursor;
+
+/* a record read back by QlogRead() */
+typedef struct
+{
+	uint8_t ucType;
+	uint16_t usLen;
+	tPpsTime tTime;
+	uint8_t aucData[QLOG_MAX_PAYLOAD];
+} tQlogRecord;
+
+
+/* Global Function Declarations */
+
+int QlogStart(void);
+int QlogWrite(uint8_t ucType, tPpsTime tTime, void const *pvData,
+	uint32_t ulLen);
+void QlogPoll(tPpsTime tNow);
+void QlogReadStart(tQlogCursor *pstCursor);
+int QlogRead(tQlogCursor *pstCursor, tQlogRecord *pstRecord);
+tQlog const *QlogGet(void);
+
+
+#endif /* QLOG_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
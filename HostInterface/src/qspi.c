@@ -0,0 +1,533 @@
+/** ***************************************************************************
+File Name:  qspi.c
+
+Project:    Platform 4
+
+Purpose:    Serial NOR flash on the QSPI: memory-mapped reads, and sector
+            erases and XDMAC page programs that run in the background
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "dma_buf.h"
+#include "qspi.h"
+
+
+/* Module Definitions */
+
+/* operation progress, tQspi.ucState */
+#define QSPI_IDLE            0
+#define QSPI_PROGRAMMING     1
+#define QSPI_WAITING         2
+
+/* commands common to serial NOR flashes, with 24 bit addresses */
+#define QSPI_CMD_WRITE_ENABLE    0x06
+#define QSPI_CMD_READ_STATUS     0x05
+#define QSPI_CMD_PAGE_PROGRAM    0x02
+#define QSPI_CMD_SECTOR_ERASE    0x20
+#define QSPI_CMD_READ_DUAL       0x3B
+#define QSPI_CMD_READ_ID         0x9F
+#define QSPI_CMD_RESET_ENABLE    0x66
+#define QSPI_CMD_RESET           0x99
+
+/* status register: write in progress */
+#define QSPI_STATUS_WIP          0x01
+
+/* dummy clocks of the dual output fast read */
+#define QSPI_READ_DUMMY          8
+
+/* time limits: a command on the bus, the flash's recovery from a reset,
+	and the flash finishing a page program or a sector erase */
+#define QSPI_CMD_TIMEOUT_US      1000UL
+#define QSPI_RESET_US            100UL
+#define QSPI_PROGRAM_TIMEOUT_US  10000UL
+#define QSPI_ERASE_TIMEOUT_US    2000000UL
+
+/* largest flash that 24 bit addresses reach */
+#define QSPI_MAX_SIZE            (16UL * 1024 * 1024)
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static int QspiCommand(uint8_t ucInst, uint32_t ulIfr, uint32_t ulAddr,
+	void *pvData, uint32_t ulLen);
+static int QspiEndTransfer(void);
+static int QspiWriteEnable(void);
+static uint32_t QspiElapsedUs(tPpsTime tStart);
+
+
+/* Module Variable Declarations */
+
+static tQspi stQspi;
+
+/* XDMAC copy of a page into the QSPI memory space */
+static xdmac_channel_config_t stQspiDma;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               QspiInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if no flash answered
+	Caveats / Effect:   Needs the PPS time base (PpsInit()) for its timeouts
+
+	Description:
+	Sets the QSPI up in serial memory mode at QSPI_CLOCK_HZ, resets the flash
+	so an operation cut short by our own reset doesn't linger, and reads its
+	JEDEC ID to find its size.
+*/
+int QspiInit(void)
+{
+	Qspi *pstQspi = QSPI;
+	uint32_t const ulMck = sysclk_get_peripheral_hz();
+	uint32_t ulDiv = (ulMck + QSPI_CLOCK_HZ - 1) / QSPI_CLOCK_HZ;
+	uint8_t aucId[3];
+	tPpsTime tStart;
+
+	memset(&stQspi, 0, sizeof(stQspi));
+
+	if(ulDiv < 1)
+	{
+		ulDiv = 1;
+	}
+	sysclk_enable_peripheral_clock(ID_QSPI);
+	pstQspi->QSPI_CR = QSPI_CR_SWRST;
+	pstQspi->QSPI_IDR = 0xFFFFFFFF;
+	pstQspi->QSPI_MR = QSPI_MR_SMM | QSPI_MR_CSMODE_LASTXFER;
+	pstQspi->QSPI_SCR = QSPI_SCR_SCBR(ulDiv - 1);
+	pstQspi->QSPI_CR = QSPI_CR_QSPIEN;
+	stQspi.ulClockHz = ulMck / ulDiv;
+
+	if(QspiCommand(QSPI_CMD_RESET_ENABLE, 0, 0, NULL, 0)
+		|| QspiCommand(QSPI_CMD_RESET, 0, 0, NULL, 0))
+	{
+		return -1;
+	}
+	tStart = PpsNow();
+	while(QspiElapsedUs(tStart) < QSPI_RESET_US)
+	{
+	}
+
+	/* manufacturer, memory type, and the capacity as a power of two */
+	if(QspiCommand(QSPI_CMD_READ_ID, QSPI_IFR_DATAEN
+		| QSPI_IFR_TFRTYP_TRSFR_READ, 0, aucId, sizeof(aucId)))
+	{
+		return -1;
+	}
+	stQspi.ulJedecId = ((uint32_t)aucId[0] << 16) | ((uint32_t)aucId[1] << 8)
+		| aucId[2];
+	if((stQspi.ulJedecId == 0) || (stQspi.ulJedecId == 0xFFFFFF)
+		|| (aucId[2] < 16) || (aucId[2] > 31))
+	{
+		return -1;
+	}
+	stQspi.ulSize = 1UL << aucId[2];
+	if(stQspi.ulSize > QSPI_MAX_SIZE)
+	{
+		stQspi.ulSize = QSPI_MAX_SIZE;
+	}
+
+	/* pages are copied into the memory space by the XDMAC, a byte at a time
+		so the QSPI sees them in order */
+	xdmac_channel_set_descriptor_control(XDMAC, QSPI_DMA_CHANNEL,
+		XDMAC_CNDC_NDE_DSCR_FETCH_DIS);
+	stQspiDma.mbr_cfg = XDMAC_CC_TYPE_MEM_TRAN
+		| XDMAC_CC_MBSIZE_SINGLE
+		| XDMAC_CC_MEMSET_NORMAL_MODE
+		| XDMAC_CC_CSIZE_CHK_1
+		| XDMAC_CC_DWIDTH_BYTE
+		| XDMAC_CC_SIF_AHB_IF0
+		| XDMAC_CC_DIF_AHB_IF1
+		| XDMAC_CC_SAM_INCREMENTED_AM
+		| XDMAC_CC_DAM_INCREMENTED_AM;
+
+	stQspi.ucReady = 1;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QspiRead
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the flash is busy or missing
+	Caveats / Effect:   Blocks for the transfer, about 0.2 us per byte
+
+	Description:
+	Reads ulLen bytes at ulAddr through the QSPI memory space with the dual
+	output fast read. The space is mapped strongly ordered, so it is read a
+	byte at a time rather than with memcpy(), which might not align its
+	accesses.
+*/
+int QspiRead(uint32_t ulAddr, void *pvData, uint32_t ulLen)
+{
+	Qspi *pstQspi = QSPI;
+	uint8_t const volatile *pucSrc = (uint8_t const volatile *)QSPIMEM_ADDR
+		+ ulAddr;
+	uint8_t *pucDst = pvData;
+	uint32_t i;
+
+	if(!stQspi.ucReady || (stQspi.ucState != QSPI_IDLE)
+		|| (ulAddr + ulLen > stQspi.ulSize))
+	{
+		return -1;
+	}
+	if(ulLen == 0)
+	{
+		return 0;
+	}
+
+	pstQspi->QSPI_ICR = QSPI_ICR_INST(QSPI_CMD_READ_DUAL);
+	pstQspi->QSPI_IFR = QSPI_IFR_WIDTH_DUAL_OUTPUT | QSPI_IFR_INSTEN
+		| QSPI_IFR_ADDREN | QSPI_IFR_DATAEN | QSPI_IFR_ADDRL_24_BIT
+		| QSPI_IFR_TFRTYP_TRSFR_READ_MEMORY
+		| QSPI_IFR_NBDUM(QSPI_READ_DUMMY);
+	/* the write to IFR has to land before the memory space is accessed */
+	(void)pstQspi->QSPI_IFR;
+	for(i = 0; i < ulLen; i++)
+	{
+		pucDst[i] = pucSrc[i];
+	}
+	return QspiEndTransfer();
+}
+
+/** ***************************************************************************
+	Name:               QspiErase
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if the erase started, -1 if it couldn't
+	Caveats / Effect:   None
+
+	Description:
+	Starts erasing the QSPI_SECTOR_SIZE sector holding ulAddr, and returns
+	straight away; QspiPoll() reports when the flash is done.
+*/
+int QspiErase(uint32_t ulAddr)
+{
+	if(!stQspi.ucReady || (stQspi.ucState != QSPI_IDLE)
+		|| (ulAddr >= stQspi.ulSize))
+	{
+		return -1;
+	}
+
+	if(QspiWriteEnable()
+		|| QspiCommand(QSPI_CMD_SECTOR_ERASE, QSPI_IFR_ADDREN,
+			ulAddr & ~(QSPI_SECTOR_SIZE - 1UL), NULL, 0))
+	{
+		stQspi.ulErrors++;
+		return -1;
+	}
+
+	stQspi.ucState = QSPI_WAITING;
+	stQspi.ucErasing = 1;
+	stQspi.tStart = PpsNow();
+	stQspi.ulErases++;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QspiProgram
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if the program started, -1 if it couldn't
+	Caveats / Effect:   The ulLen bytes must be within one QSPI_PAGE_SIZE
+	                    page and erased; pvData must stay untouched until
+	                    QspiPoll() reports the program done
+
+	Description:
+	Starts programming ulLen bytes from pvData at ulAddr, and returns
+	straight away. The XDMAC feeds the data to the QSPI; QspiPoll() ends the
+	transfer and waits for the flash to finish.
+*/
+int QspiProgram(uint32_t ulAddr, void const *pvData, uint32_t ulLen)
+{
+	Qspi *pstQspi = QSPI;
+
+	if(!stQspi.ucReady || (stQspi.ucState != QSPI_IDLE) || (ulLen == 0)
+		|| (ulAddr + ulLen > stQspi.ulSize)
+		|| ((ulAddr % QSPI_PAGE_SIZE) + ulLen > QSPI_PAGE_SIZE))
+	{
+		return -1;
+	}
+	if(QspiWriteEnable())
+	{
+		stQspi.ulErrors++;
+		return -1;
+	}
+
+	pstQspi->QSPI_ICR = QSPI_ICR_INST(QSPI_CMD_PAGE_PROGRAM);
+	pstQspi->QSPI_IFR = QSPI_IFR_WIDTH_SINGLE_BIT_SPI | QSPI_IFR_INSTEN
+		| QSPI_IFR_ADDREN | QSPI_IFR_DATAEN | QSPI_IFR_ADDRL_24_BIT
+		| QSPI_IFR_TFRTYP_TRSFR_WRITE_MEMORY;
+	(void)pstQspi->QSPI_IFR;
+
+	/* the DMA reads memory, not the data cache */
+	DmaBufClean(pvData, ulLen);
+	xdmac_channel_disable(XDMAC, QSPI_DMA_CHANNEL);
+	stQspiDma.mbr_ubc = ulLen;
+	stQspiDma.mbr_sa  = (uint32_t)pvData;
+	stQspiDma.mbr_da  = QSPIMEM_ADDR + ulAddr;
+	xdmac_configure_transfer(XDMAC, QSPI_DMA_CHANNEL, &stQspiDma);
+	xdmac_channel_enable(XDMAC, QSPI_DMA_CHANNEL);
+
+	stQspi.ucState = QSPI_PROGRAMMING;
+	stQspi.ucErasing = 0;
+	stQspi.tStart = PpsNow();
+	stQspi.ulPrograms++;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QspiPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             QSPI_BUSY while an erase or program is in progress,
+	                    then once 0 if it succeeded or -1 if it failed; 0
+	                    when idle
+	Caveats / Effect:   Call from the main program loop
+
+	Description:
+	Sees an erase or program through: once the XDMAC has sent a page the
+	transfer is ended, which starts the flash programming it, and then the
+	flash's status is checked on each call until it is done. Each check is
+	a two byte command, so the main loop is never held up. An operation
+	that outlasts the flash's worst case is abandoned and fails.
+*/
+int QspiPoll(void)
+{
+	uint8_t ucStatus;
+	uint32_t ulUs;
+
+	if(stQspi.ucState == QSPI_IDLE)
+	{
+		return 0;
+	}
+
+	ulUs = QspiElapsedUs(stQspi.tStart);
+
+	if(stQspi.ucState == QSPI_PROGRAMMING)
+	{
+		if(xdmac_channel_get_status(XDMAC) & (1UL << QSPI_DMA_CHANNEL))
+		{
+			if(ulUs < QSPI_PROGRAM_TIMEOUT_US)
+			{
+				return QSPI_BUSY;
+			}
+			xdmac_channel_disable(XDMAC, QSPI_DMA_CHANNEL);
+		}
+		if(QspiEndTransfer() != 0)
+		{
+			stQspi.ucState = QSPI_IDLE;
+			stQspi.ulErrors++;
+			return -1;
+		}
+		stQspi.ucState = QSPI_WAITING;
+	}
+
+	if(QspiCommand(QSPI_CMD_READ_STATUS, QSPI_IFR_DATAEN
+		| QSPI_IFR_TFRTYP_TRSFR_READ, 0, &ucStatus, 1) != 0)
+	{
+		ucStatus = QSPI_STATUS_WIP;
+	}
+	if(ucStatus & QSPI_STATUS_WIP)
+	{
+		if(ulUs < (stQspi.ucErasing ? QSPI_ERASE_TIMEOUT_US
+			: QSPI_PROGRAM_TIMEOUT_US))
+		{
+			return QSPI_BUSY;
+		}
+		stQspi.ucState = QSPI_IDLE;
+		stQspi.ulErrors++;
+		return -1;
+	}
+
+	stQspi.ucState = QSPI_IDLE;
+	if(stQspi.ucErasing)
+	{
+		if(ulUs > stQspi.ulMaxEraseUs)
+		{
+			stQspi.ulMaxEraseUs = ulUs;
+		}
+	}
+	else if(ulUs > stQspi.ulMaxProgramUs)
+	{
+		stQspi.ulMaxProgramUs = ulUs;
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QspiGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Flash and driver state
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to the flash details and statistics.
+*/
+tQspi const *QspiGet(void)
+{
+	return &stQspi;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               QspiCommand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 on timeout
+	Caveats / Effect:   Busy waits; the state must be idle
+
+	Description:
+	Sends instruction ucInst in single bit SPI, with the address and data
+	phases ulIfr enables. Data is read into pvData (ulLen bytes) through the
+	memory space; commands here never write data.
+*/
+static int QspiCommand(uint8_t ucInst, uint32_t ulIfr, uint32_t ulAddr,
+	void *pvData, uint32_t ulLen)
+{
+	Qspi *pstQspi = QSPI;
+	uint8_t const volatile *pucSrc = (uint8_t const volatile *)QSPIMEM_ADDR;
+	uint8_t *pucDst = pvData;
+	uint32_t i;
+
+	/* clear a stale end of instruction */
+	(void)pstQspi->QSPI_SR;
+	pstQspi->QSPI_IAR = QSPI_IAR_ADDR(ulAddr);
+	pstQspi->QSPI_ICR = QSPI_ICR_INST(ucInst);
+	pstQspi->QSPI_IFR = ulIfr | QSPI_IFR_WIDTH_SINGLE_BIT_SPI
+		| QSPI_IFR_INSTEN | QSPI_IFR_ADDRL_24_BIT;
+	(void)pstQspi->QSPI_IFR;
+
+	if(!(ulIfr & QSPI_IFR_DATAEN))
+	{
+		/* the instruction went out with the write to IFR */
+		tPpsTime const tStart = PpsNow();
+
+		while(!(pstQspi->QSPI_SR & QSPI_SR_INSTRE))
+		{
+			if(QspiElapsedUs(tStart) >= QSPI_CMD_TIMEOUT_US)
+			{
+				return -1;
+			}
+		}
+		return 0;
+	}
+
+	for(i = 0; i < ulLen; i++)
+	{
+		pucDst[i] = pucSrc[i];
+	}
+	return QspiEndTransfer();
+}
+
+/** ***************************************************************************
+	Name:               QspiEndTransfer
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 on timeout
+	Caveats / Effect:   Busy waits
+
+	Description:
+	Ends a transfer through the memory space: the chip select is released
+	and the QSPI reports the end of the instruction.
+*/
+static int QspiEndTransfer(void)
+{
+	Qspi *pstQspi = QSPI;
+	tPpsTime const tStart = PpsNow();
+
+	pstQspi->QSPI_CR = QSPI_CR_LASTXFER;
+	while(!(pstQspi->QSPI_SR & QSPI_SR_INSTRE))
+	{
+		if(QspiElapsedUs(tStart) >= QSPI_CMD_TIMEOUT_US)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QspiWriteEnable
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 on timeout
+	Caveats / Effect:   None
+
+	Description:
+	Sets the flash's write enable latch, which every erase and program needs
+	and clears.
+*/
+static int QspiWriteEnable(void)
+{
+	return QspiCommand(QSPI_CMD_WRITE_ENABLE, 0, 0, NULL, 0);
+}
+
+/** ***************************************************************************
+	Name:               QspiElapsedUs
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Microseconds since tStart
+	Caveats / Effect:   None
+
+	Description:
+	Measures time on the PPS time base, which is always running.
+*/
+static uint32_t QspiElapsedUs(tPpsTime tStart)
+{
+	uint64_t const ullElapsed = PpsNow() - tStart;
+
+	/* keep the product in range, ~70 minutes is plenty */
+	if(ullElapsed >> 44)
+	{
+		return UINT32_MAX;
+	}
+	return (uint32_t)((ullElapsed * 1000000) >> 32);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,83 @@
+/** ***************************************************************************
+File Name:  qspi.h
+
+Project:    Platform 4
+
+Purpose:    Serial NOR flash on the QSPI: memory-mapped reads, and sector
+            erases and XDMAC page programs that run in the background
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef QSPI_H
+#define QSPI_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "conf_qlog.h"
+#include "pps.h"
+
+
+/* Module Definitions */
+
+/* erase and program units common to serial NOR flash */
+#define QSPI_SECTOR_SIZE     4096
+#define QSPI_PAGE_SIZE       256
+
+/* QspiPoll(): an erase or program is still in progress */
+#define QSPI_BUSY            1
+
+
+/* Module Type Definitions */
+
+/* flash and driver state */
+typedef struct
+{
+	/* the flash answered, its JEDEC manufacturer and device ID, and its size
+		in bytes */
+	uint8_t ucReady;
+	uint32_t ulJedecId;
+	uint32_t ulSize;
+	uint32_t ulClockHz;
+	/* operation in progress: QSPI_IDLE, QSPI_PROGRAMMING or QSPI_WAITING
+		(qspi.c), whether it is an erase, and when it started */
+	uint8_t ucState;
+	uint8_t ucErasing;
+	tPpsTime tStart;
+	/* statistics: erases and programs, failed ones, and the longest wait for
+		the flash to finish each kind */
+	uint32_t ulErases;
+	uint32_t ulPrograms;
+	uint32_t ulErrors;
+	uint32_t ulMaxEraseUs;
+	uint32_t ulMaxProgramUs;
+} tQspi;
+
+
+/* Global Function Declarations */
+
+int QspiInit(void);
+int QspiRead(uint32_t ulAddr, void *pvData, uint32_t ulLen);
+int QspiErase(uint32_t ulAddr);
+int QspiProgram(uint32_t ulAddr, void const *pvData, uint32_t ulLen);
+int QspiPoll(void);
+tQspi const *QspiGet(void);
+
+
+#endif /* QSPI_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,524 @@
+/** ***************************************************************************
+File Name:  rec.c
+
+Project:    Platform 4
+
+Purpose:    Recorder: stages received frames in memory and logs them to the
+            SD card, with an index block after every group of chunks
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stddef.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "crc.h"
+#include "rec.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void RecCopy(uint8_t const *pucData, uint32_t ulLen, tPpsTime tTime);
+static void RecCloseStage(void);
+static void RecWriteStage(void);
+static int RecReadIndex(uint32_t ulGroup, uint32_t *pulSeq);
+static uint32_t RecIndexCrc(tRecIndex const *pstIndex);
+
+
+/* Module Variable Declarations */
+
+static tRec stRec;
+
+/* staging ring, a chunk each */
+static tRecStage astRecStages[REC_STAGES];
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               RecStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if there is no card or it is too
+	                    small
+	Caveats / Effect:   SdInit() must have succeeded; reads up to a few dozen
+	                    index blocks
+
+	Description:
+	Finds where the last recording stopped and carries on after it. The
+	groups the last recording wrote in its latest pass around the ring are
+	the ones whose sequence numbers run on from that of group 0, so the last
+	of them is found by a binary search over the index blocks. The group
+	after it is left alone, as it holds whatever was recorded after that
+	index was written, and recording resumes in the one after that.
+*/
+int RecStart(void)
+{
+	tSd const *pstSd = SdGet();
+	uint32_t ulSeq0;
+	uint32_t ulSeq;
+	uint32_t ulLo;
+	uint32_t ulHi;
+
+	memset(&stRec, 0, sizeof(stRec));
+	if(!pstSd->ucReady
+		|| (pstSd->ulBlocks < REC_FIRST_BLOCK + REC_BENCH_BLOCKS
+			+ 2 * REC_GROUP_BLOCKS))
+	{
+		return -1;
+	}
+	stRec.ulFirstBlock = REC_FIRST_BLOCK;
+	stRec.ulGroups = (pstSd->ulBlocks - REC_FIRST_BLOCK - REC_BENCH_BLOCKS)
+		/ REC_GROUP_BLOCKS;
+
+	if(RecReadIndex(0, &ulSeq0) != 0)
+	{
+		/* nothing recorded yet, or group 0 was being rewritten; number on
+			from the end of the ring in case it was */
+		stRec.ulGroup = 0;
+		stRec.ulSeq = (RecReadIndex(stRec.ulGroups - 1, &ulSeq) == 0)
+			? ulSeq + 1 : 1;
+	}
+	else
+	{
+		/* group ulLo is in the latest pass, group ulHi isn't */
+		ulLo = 0;
+		ulHi = stRec.ulGroups;
+		while(ulHi - ulLo > 1)
+		{
+			uint32_t const ulMid = ulLo + (ulHi - ulLo) / 2;
+
+			if((RecReadIndex(ulMid, &ulSeq) == 0) && (ulSeq - ulSeq0 == ulMid))
+			{
+				ulLo = ulMid;
+			}
+			else
+			{
+				ulHi = ulMid;
+			}
+		}
+
+		/* skip a group, keeping the sequence numbers in step with the
+			position so the search works next time. Skipping past the end
+			starts the next pass */
+		stRec.ulGroup = ulLo + 2;
+		stRec.ulSeq = ulSeq0 + ulLo + 2;
+		if(stRec.ulGroup >= stRec.ulGroups)
+		{
+			stRec.ulGroup = 0;
+		}
+	}
+
+	astRecStages[0].ulLen = 0;
+	astRecStages[0].stEntry.usFirst = REC_NO_RECORD;
+	stRec.ucStarted = 1;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               RecWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the record was dropped
+	Caveats / Effect:   None
+
+	Description:
+	Stages a record of ulLen bytes at pvData, received on link ulLink at
+	tTime. The record is copied, so the caller's buffer is free again at
+	once. If the card has fallen so far behind that there isn't room for the
+	whole record in the staging chunks, it is dropped and counted.
+*/
+int RecWrite(uint32_t ulLink, tPpsTime tTime, void const *pvData,
+	uint32_t ulLen)
+{
+	tRecStage *pstStage = &astRecStages[stRec.ulHead];
+	uint8_t aucHeader[REC_RECORD_HEADER];
+	uint32_t ulSpace = 0;
+
+	if(!stRec.ucStarted)
+	{
+		return -1;
+	}
+
+	if(stRec.ulFull < REC_STAGES)
+	{
+		ulSpace = REC_CHUNK_SIZE - pstStage->ulLen
+			+ (REC_STAGES - 1 - stRec.ulFull) * REC_CHUNK_SIZE;
+	}
+	if((ulLen > 0xFFFF) || (REC_RECORD_HEADER + ulLen > ulSpace))
+	{
+		stRec.ulLostBytes += REC_RECORD_HEADER + ulLen;
+		return -1;
+	}
+
+	if(pstStage->stEntry.usFirst == REC_NO_RECORD)
+	{
+		pstStage->stEntry.usFirst = (uint16_t)pstStage->ulLen;
+		pstStage->stEntry.tTime = tTime;
+	}
+
+	aucHeader[0] = (uint8_t)ulLen;
+	aucHeader[1] = (uint8_t)(ulLen >> 8);
+	aucHeader[2] = (uint8_t)ulLink;
+	aucHeader[3] = REC_RECORD_SYNC;
+	memcpy(&aucHeader[4], &tTime, sizeof(tTime));
+	RecCopy(aucHeader, sizeof(aucHeader), tTime);
+	RecCopy((uint8_t const *)pvData, ulLen, tTime);
+
+	stRec.ulRecords++;
+	stRec.ullBytes += REC_RECORD_HEADER + ulLen;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               RecPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the main program loop
+
+	Description:
+	Keeps the card busy: when a chunk write finishes its stage is freed and
+	the next waiting chunk goes out, so writes run back to back while there
+	is a backlog and the staging ring absorbs the card's write stalls. A
+	partly filled chunk is sent once it is REC_FLUSH_SECONDS old.
+*/
+void RecPoll(tPpsTime tNow)
+{
+	if(!stRec.ucStarted)
+	{
+		return;
+	}
+
+	if(stRec.ucWriting)
+	{
+		int const iResult = SdPoll();
+
+		if(iResult == SD_BUSY)
+		{
+			return;
+		}
+		if(iResult == 0)
+		{
+			stRec.ulChunks++;
+		}
+		else
+		{
+			stRec.ulWriteErrors++;
+		}
+		stRec.ucWriting = 0;
+		stRec.ulTail = (stRec.ulTail + 1) % REC_STAGES;
+		stRec.ulFull--;
+	}
+
+	if((stRec.ulFull < REC_STAGES) && (astRecStages[stRec.ulHead].ulLen != 0)
+		&& (tNow - astRecStages[stRec.ulHead].tStarted
+			>= ((uint64_t)REC_FLUSH_SECONDS << 32)))
+	{
+		RecCloseStage();
+	}
+
+	if(stRec.ulFull != 0)
+	{
+		RecWriteStage();
+	}
+}
+
+/** ***************************************************************************
+	Name:               RecBench
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the card isn't ready or the
+	                    recorder is busy
+	Caveats / Effect:   Busy waits for ulBytes to be written; overwrites the
+	                    REC_BENCH_BLOCKS scratch blocks at the end of the card
+
+	Description:
+	Measures the card the way the recorder uses it: ulBytes of back to back
+	chunk writes, reporting the throughput and the slowest single write,
+	which is the stall the staging ring has to ride out.
+*/
+int RecBench(uint32_t ulBytes, tRecBench *pstResult)
+{
+	tSd const *pstSd = SdGet();
+	uint8_t *pucChunk = astRecStages[0].aucData;
+	uint32_t ulBlock = 0;
+	tPpsTime tStart;
+	uint32_t i;
+
+	memset(pstResult, 0, sizeof(*pstResult));
+	if(!pstSd->ucReady || stRec.ucWriting || stRec.ulFull
+		|| astRecStages[stRec.ulHead].ulLen
+		|| (pstSd->ulBlocks < REC_BENCH_BLOCKS))
+	{
+		return -1;
+	}
+
+	for(i = 0; i < REC_CHUNK_SIZE; i++)
+	{
+		pucChunk[i] = (uint8_t)i;
+	}
+
+	tStart = PpsNow();
+	while(pstResult->ulBytes < ulBytes)
+	{
+		int iResult;
+
+		if(SdWrite(pstSd->ulBlocks - REC_BENCH_BLOCKS + ulBlock, pucChunk,
+			REC_CHUNK_BLOCKS) != 0)
+		{
+			pstResult->ulErrors++;
+			break;
+		}
+		while((iResult = SdPoll()) == SD_BUSY) {};
+		if(iResult != 0)
+		{
+			pstResult->ulErrors++;
+		}
+		if(pstSd->ulLastWriteUs > pstResult->ulMaxWriteUs)
+		{
+			pstResult->ulMaxWriteUs = pstSd->ulLastWriteUs;
+		}
+
+		pstResult->ulBytes += REC_CHUNK_SIZE;
+		ulBlock += REC_CHUNK_BLOCKS;
+		if(ulBlock + REC_CHUNK_BLOCKS > REC_BENCH_BLOCKS)
+		{
+			ulBlock = 0;
+		}
+	}
+	pstResult->ulElapsedUs = (uint32_t)(((PpsNow() - tStart) * 1000000) >> 32);
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               RecGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Recorder state
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to the recording position and the statistics.
+*/
+tRec const *RecGet(void)
+{
+	return &stRec;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               RecCopy
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The caller has checked there is room
+
+	Description:
+	Appends data received at tTime to the staging ring, closing chunks as
+	they fill.
+*/
+static void RecCopy(uint8_t const *pucData, uint32_t ulLen, tPpsTime tTime)
+{
+	while(ulLen)
+	{
+		tRecStage *pstStage = &astRecStages[stRec.ulHead];
+		uint32_t ulCopy = REC_CHUNK_SIZE - pstStage->ulLen;
+
+		if(ulCopy > ulLen)
+		{
+			ulCopy = ulLen;
+		}
+		if(pstStage->ulLen == 0)
+		{
+			pstStage->tStarted = tTime;
+		}
+		memcpy(&pstStage->aucData[pstStage->ulLen], pucData, ulCopy);
+		pstStage->ulLen += ulCopy;
+		pucData += ulCopy;
+		ulLen -= ulCopy;
+
+		if(pstStage->ulLen == REC_CHUNK_SIZE)
+		{
+			RecCloseStage();
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               RecCloseStage
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   There must be a chunk being filled (ulFull below
+	                    REC_STAGES)
+
+	Description:
+	Queues the chunk being filled for the card and starts filling the next.
+*/
+static void RecCloseStage(void)
+{
+	tRecStage *pstStage = &astRecStages[stRec.ulHead];
+
+	pstStage->stEntry.usLen = (uint16_t)pstStage->ulLen;
+	stRec.ulFull++;
+	if(stRec.ulFull > stRec.ulMaxFull)
+	{
+		stRec.ulMaxFull = stRec.ulFull;
+	}
+
+	stRec.ulHead = (stRec.ulHead + 1) % REC_STAGES;
+	pstStage = &astRecStages[stRec.ulHead];
+	pstStage->ulLen = 0;
+	pstStage->stEntry.usFirst = REC_NO_RECORD;
+	pstStage->stEntry.tTime = 0;
+	pstStage->stEntry.ulLost = stRec.ulLostBytes;
+}
+
+/** ***************************************************************************
+	Name:               RecWriteStage
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The card must be idle
+
+	Description:
+	Starts writing the oldest waiting chunk to its place in the current
+	group. The last chunk of a group carries the group's index block with
+	it, in the same multi-block write. A chunk the card won't take is
+	counted and dropped rather than holding up the ones behind it.
+*/
+static void RecWriteStage(void)
+{
+	tRecStage *pstStage = &astRecStages[stRec.ulTail];
+	tRecIndex *pstIndex = &stRec.stIndex;
+	uint32_t ulBlocks = REC_CHUNK_BLOCKS;
+
+	pstIndex->astEntry[stRec.ulChunk] = pstStage->stEntry;
+	if(stRec.ulChunk == REC_INDEX_CHUNKS - 1)
+	{
+		pstIndex->ulMagic = REC_INDEX_MAGIC;
+		pstIndex->ulSeq = stRec.ulSeq;
+		pstIndex->usVersion = REC_INDEX_VERSION;
+		pstIndex->usChunkBlocks = REC_CHUNK_BLOCKS;
+		pstIndex->ulCrc = RecIndexCrc(pstIndex);
+		memcpy(&pstStage->aucData[REC_CHUNK_SIZE], pstIndex, sizeof(*pstIndex));
+		ulBlocks++;
+	}
+
+	if(SdWrite(stRec.ulFirstBlock + stRec.ulGroup * REC_GROUP_BLOCKS
+		+ stRec.ulChunk * REC_CHUNK_BLOCKS, pstStage->aucData, ulBlocks) == 0)
+	{
+		stRec.ucWriting = 1;
+	}
+	else
+	{
+		stRec.ulWriteErrors++;
+		stRec.ulTail = (stRec.ulTail + 1) % REC_STAGES;
+		stRec.ulFull--;
+	}
+
+	if(++stRec.ulChunk == REC_INDEX_CHUNKS)
+	{
+		stRec.ulChunk = 0;
+		stRec.ulSeq++;
+		if(++stRec.ulGroup == stRec.ulGroups)
+		{
+			stRec.ulGroup = 0;
+		}
+		memset(pstIndex, 0, sizeof(*pstIndex));
+	}
+}
+
+/** ***************************************************************************
+	Name:               RecReadIndex
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 and the group's sequence number if its index block
+	                    is valid, -1 if not
+	Caveats / Effect:   Uses the first staging chunk as its buffer
+
+	Description:
+	Reads and checks the index block at the end of a group.
+*/
+static int RecReadIndex(uint32_t ulGroup, uint32_t *pulSeq)
+{
+	tRecIndex *pstIndex = (tRecIndex *)astRecStages[0].aucData;
+
+	if((SdRead(stRec.ulFirstBlock + (ulGroup + 1) * REC_GROUP_BLOCKS - 1,
+		pstIndex) != 0)
+		|| (pstIndex->ulMagic != REC_INDEX_MAGIC)
+		|| (pstIndex->usVersion != REC_INDEX_VERSION)
+		|| (pstIndex->usChunkBlocks != REC_CHUNK_BLOCKS)
+		|| (pstIndex->ulCrc != RecIndexCrc(pstIndex)))
+	{
+		return -1;
+	}
+	*pulSeq = pstIndex->ulSeq;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               RecIndexCrc
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             CRC-32 of the index block
+	Caveats / Effect:   None
+
+	Description:
+	Computes the CRC of the block as if its ulCrc field were 0.
+*/
+static uint32_t RecIndexCrc(tRecIndex const *pstIndex)
+{
+	static uint32_t const ulZero = 0;
+	uint32_t ulCrc;
+
+	ulCrc = Crc32(CRC32_INIT, pstIndex, offsetof(tRecIndex, ulCrc));
+	ulCrc = Crc32(ulCrc, &ulZero, sizeof(ulZero));
+	return Crc32(ulCrc, &pstIndex->astEntry, sizeof(pstIndex->astEntry));
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
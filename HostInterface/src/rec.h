@@ -0,0 +1,150 @@
+/** ***************************************************************************
+File Name:  rec.h
+
+Project:    Platform 4
+
+Purpose:    Recorder: stages received frames in memory and logs them to the
+            SD card, with an index block after every group of chunks
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef REC_H
+#define REC_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "conf_rec.h"
+#include "dma_buf.h"
+#include "pps.h"
+#include "sd.h"
+
+
+/* Module Definitions */
+
+/* Log layout. The recorded part of the card is a ring of groups, each
+	REC_INDEX_CHUNKS chunks of REC_CHUNK_BLOCKS blocks followed by an index
+	block (tRecIndex) describing them. The chunks hold a stream of records,
+	each a REC_RECORD_HEADER byte header (length, link, REC_RECORD_SYNC and
+	PPS time, little endian) and the frame payload; records run on from one
+	chunk into the next */
+#define REC_CHUNK_SIZE       (REC_CHUNK_BLOCKS * SD_BLOCK_SIZE)
+#define REC_INDEX_CHUNKS     ((SD_BLOCK_SIZE - 16) / sizeof(tRecIndexEntry))
+#define REC_GROUP_BLOCKS     (REC_INDEX_CHUNKS * REC_CHUNK_BLOCKS + 1)
+#define REC_RECORD_HEADER    12
+#define REC_RECORD_SYNC      0xA5
+
+/* index block identification: "OSRI" */
+#define REC_INDEX_MAGIC      0x4952534FUL
+#define REC_INDEX_VERSION    1
+
+/* tRecIndexEntry.usFirst of a chunk in which no record starts */
+#define REC_NO_RECORD        0xFFFF
+
+#if REC_CHUNK_SIZE > 0xFFFF
+#error "REC_CHUNK_BLOCKS is too large for the index entries"
+#endif
+
+
+/* Module Type Definitions */
+
+/* index entry of one chunk: PPS time of the first record that starts in
+	it, bytes of the chunk used, offset of that first record, and the count
+	of bytes dropped for lack of staging space before the chunk was started */
+typedef struct
+{
+	tPpsTime tTime;
+	uint16_t usLen;
+	uint16_t usFirst;
+	uint32_t ulLost;
+} tRecIndexEntry;
+
+/* index block. ulSeq goes up by one from group to group; ulCrc is the
+	CRC-32 (crc.h) of the block with ulCrc 0 */
+typedef struct
+{
+	uint32_t ulMagic;
+	uint32_t ulSeq;
+	uint16_t usVersion;
+	uint16_t usChunkBlocks;
+	uint32_t ulCrc;
+	tRecIndexEntry astEntry[REC_INDEX_CHUNKS];
+} tRecIndex;
+
+/* a chunk being filled or waiting for the card, with room after it for
+	the index block that ends its group */
+typedef struct
+{
+	uint8_t aucData[REC_CHUNK_SIZE + SD_BLOCK_SIZE] DMA_BUF_ALIGNED;
+	uint32_t ulLen;
+	tRecIndexEntry stEntry;
+	/* when the first byte went in, for REC_FLUSH_SECONDS */
+	tPpsTime tStarted;
+} tRecStage;
+
+/* recorder state */
+typedef struct
+{
+	/* recording has started, and the ring of groups on the card */
+	uint8_t ucStarted;
+	uint32_t ulFirstBlock;
+	uint32_t ulGroups;
+	/* where the next chunk goes, and the sequence number of its group */
+	uint32_t ulGroup;
+	uint32_t ulChunk;
+	uint32_t ulSeq;
+	/* staging ring: the chunk being filled, the oldest one waiting for the
+		card, the number waiting, and whether the oldest is being written */
+	uint32_t ulHead;
+	uint32_t ulTail;
+	uint32_t ulFull;
+	uint8_t ucWriting;
+	/* index of the group being written */
+	tRecIndex stIndex;
+	/* statistics: records and bytes staged, chunks written, bytes dropped
+		for lack of staging space, failed writes, and the most chunks ever
+		waiting for the card */
+	uint32_t ulRecords;
+	uint64_t ullBytes;
+	uint32_t ulChunks;
+	uint32_t ulLostBytes;
+	uint32_t ulWriteErrors;
+	uint32_t ulMaxFull;
+} tRec;
+
+/* RecBench() results */
+typedef struct
+{
+	uint32_t ulBytes;
+	uint32_t ulElapsedUs;
+	uint32_t ulMaxWriteUs;
+	uint32_t ulErrors;
+} tRecBench;
+
+
+/* Global Function Declarations */
+
+int RecStart(void);
+int RecWrite(uint32_t ulLink, tPpsTime tTime, void const *pvData,
+	uint32_t ulLen);
+void RecPoll(tPpsTime tNow);
+int RecBench(uint32_t ulBytes, tRecBench *pstResult);
+tRec const *RecGet(void);
+
+
+#endif /* REC_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
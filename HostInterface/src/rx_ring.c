@@ -0,0 +1,350 @@
+/** ***************************************************************************
+File Name:  rx_ring.c
+
+Project:    Platform 4
+
+Purpose:    Continuous data channel reception through a circular XDMAC
+            linked list
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "rx_ring.h"
+#include "tcm.h"
+
+
+/* Module Definitions */
+
+/* the free-running byte counters rely on the ring dividing 2^32 evenly */
+#if (RX_RING_SIZE & (RX_RING_SIZE - 1)) != 0
+#error "RX_RING_SEGMENTS * RX_RING_SEGMENT_SIZE must be a power of two"
+#endif
+
+/* an overrun skips to two segments past the one being written over, see
+	RxRingPeek(), which must leave intact data to read */
+#if RX_RING_SEGMENTS < 3
+#error "RX_RING_SEGMENTS must be at least 3"
+#endif
+
+/* maximum amount of unread data before the DMA starts overwriting it. The
+	segment currently being written is not safe to hold unread data */
+#define RX_RING_MAX_PENDING (RX_RING_SIZE - RX_RING_SEGMENT_SIZE)
+
+/* microblock control for every descriptor in the chain: fetch the next view 1
+	descriptor, keep the source (USART RHR), take the new destination */
+#define RX_RING_DESC_UBC (XDMAC_UBC_NVIEW_NDV1 \
+	| XDMAC_UBC_NDE_FETCH_EN \
+	| XDMAC_UBC_NSEN_UNCHANGED \
+	| XDMAC_UBC_NDEN_UPDATED \
+	| XDMAC_UBC_UBLEN(RX_RING_SEGMENT_SIZE))
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+/* Module Variable Declarations */
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               RxRingInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the descriptors can't be allocated
+	Caveats / Effect:   The XDMAC channel must be disabled
+
+	Description:
+	Builds the circular descriptor chain for a peripheral to memory receive
+	ring and programs the channel configuration. ulSrcAddr is the peripheral
+	receive holding register and ulPerId its XDMAC hardware interface ID.
+	The descriptors are allocated on the first call and reused after that.
+*/
+int RxRingInit(tRxRing *pstRing, uint32_t ulChannel, uint32_t ulSrcAddr,
+	uint32_t ulPerId)
+{
+	lld_view1 *pastDesc = pstRing->pastDesc;
+	uint32_t i;
+
+	if(!pastDesc)
+	{
+		pastDesc = DmaBufAllocNoCache(RX_RING_SEGMENTS * sizeof(lld_view1));
+		if(!pastDesc)
+		{
+			return -1;
+		}
+	}
+
+	memset(pstRing, 0, sizeof(*pstRing));
+	pstRing->pastDesc = pastDesc;
+	pstRing->ulChannel = ulChannel;
+	pstRing->ulSrcAddr = ulSrcAddr;
+
+	/* link every segment to the next, and the last back to the first */
+	for(i = 0; i < RX_RING_SEGMENTS; i++)
+	{
+		pastDesc[i].mbr_nda = (uint32_t)&pastDesc[(i + 1) % RX_RING_SEGMENTS];
+		pastDesc[i].mbr_ubc = RX_RING_DESC_UBC;
+		pastDesc[i].mbr_sa  = ulSrcAddr;
+		pastDesc[i].mbr_da  =
+			(uint32_t)&pstRing->aucData[i * RX_RING_SEGMENT_SIZE];
+	}
+	DmaBufClean(pastDesc, RX_RING_SEGMENTS * sizeof(lld_view1));
+
+	/* nothing in the cache may be written back over the DMA's data */
+	DmaBufInvalidate(pstRing->aucData, RX_RING_SIZE);
+
+	/* view 1 descriptors don't carry a channel configuration, so it is set
+		once here and stays in effect for the whole chain */
+	xdmac_channel_set_config(XDMAC, ulChannel, XDMAC_CC_TYPE_PER_TRAN
+		| XDMAC_CC_DSYNC_PER2MEM
+		| XDMAC_CC_SWREQ_HWR_CONNECTED
+		| XDMAC_CC_CSIZE_CHK_1
+		| XDMAC_CC_DWIDTH_BYTE
+		| XDMAC_CC_SIF_AHB_IF1
+		| XDMAC_CC_DIF_AHB_IF0
+		| XDMAC_CC_SAM_FIXED_AM
+		| XDMAC_CC_DAM_INCREMENTED_AM
+		| XDMAC_CC_PERID(ulPerId));
+	xdmac_channel_set_block_control(XDMAC, ulChannel, 0);
+	xdmac_channel_set_datastride_mempattern(XDMAC, ulChannel, 0);
+	xdmac_channel_set_source_microblock_stride(XDMAC, ulChannel, 0);
+	xdmac_channel_set_destination_microblock_stride(XDMAC, ulChannel, 0);
+
+	/* every completed segment raises an end of block interrupt */
+	xdmac_enable_interrupt(XDMAC, ulChannel);
+	xdmac_channel_enable_interrupt(XDMAC, ulChannel, XDMAC_CIE_BIE);
+
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               RxRingStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Points the channel at the first descriptor and starts it. Once started the
+	channel runs until RxRingStop() is called, and holds a sleep lock so the
+	core never goes deeper than WFI sleep, where the DMA keeps running.
+*/
+void RxRingStart(tRxRing *pstRing)
+{
+	sleepmgr_lock_mode(SLEEPMGR_SLEEP_WFI);
+
+	pstRing->ulSegCount = 0;
+	pstRing->ulReadCount = 0;
+
+	/* clear any stale interrupt status */
+	xdmac_channel_get_interrupt_status(XDMAC, pstRing->ulChannel);
+
+	xdmac_channel_set_microblock_control(XDMAC, pstRing->ulChannel, 0);
+	xdmac_channel_set_descriptor_addr(XDMAC, pstRing->ulChannel,
+		(uint32_t)&pstRing->pastDesc[0], 0);
+	xdmac_channel_set_descriptor_control(XDMAC, pstRing->ulChannel,
+		XDMAC_CNDC_NDE_DSCR_FETCH_EN
+		| XDMAC_CNDC_NDVIEW_NDV1
+		| XDMAC_CNDC_NDSUP_SRC_PARAMS_UPDATED
+		| XDMAC_CNDC_NDDUP_DST_PARAMS_UPDATED);
+	xdmac_channel_enable(XDMAC, pstRing->ulChannel);
+}
+
+/** ***************************************************************************
+	Name:               RxRingStop
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Blocks until the channel has flushed
+
+	Description:
+	Disables the channel and waits for it to finish writing buffered data,
+	then releases the sleep lock taken by RxRingStart().
+*/
+void RxRingStop(tRxRing *pstRing)
+{
+	xdmac_channel_disable(XDMAC, pstRing->ulChannel);
+	while(xdmac_channel_get_status(XDMAC) & (1UL << pstRing->ulChannel)) {};
+	sleepmgr_unlock_mode(SLEEPMGR_SLEEP_WFI);
+}
+
+/** ***************************************************************************
+	Name:               RxRingSegmentDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the XDMAC ISR only
+
+	Description:
+	Records the completion of one segment. Called on every end of block
+	interrupt of the ring channel; the count is only used to detect overruns,
+	the write position itself is read back from the channel registers.
+*/
+TCM_CODE void RxRingSegmentDone(tRxRing *pstRing)
+{
+	pstRing->ulSegCount++;
+}
+
+/** ***************************************************************************
+	Name:               RxRingGetWriteOffset
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Offset in aucData[] the DMA will write next
+	Caveats / Effect:   None
+
+	Description:
+	Derives the DMA write pointer from the next descriptor address and the
+	remaining microblock length. The two registers can't be read atomically,
+	so they are re-read until the descriptor address is stable across the
+	CUBC read and the channel isn't in the middle of a descriptor fetch.
+*/
+TCM_CODE uint32_t RxRingGetWriteOffset(tRxRing const *pstRing)
+{
+	XdmacChid const volatile *pstChan = &XDMAC->XDMAC_CHID[pstRing->ulChannel];
+	uint32_t ulNda;
+	uint32_t ulUbc;
+	uint32_t ulNext;
+	uint32_t ulOffset;
+
+	do
+	{
+		ulNda = pstChan->XDMAC_CNDA & XDMAC_CNDA_NDA_Msk;
+		ulUbc = pstChan->XDMAC_CUBC & XDMAC_CUBC_UBLEN_Msk;
+	} while(!(pstChan->XDMAC_CC & XDMAC_CC_INITD)
+		|| (ulNda != (pstChan->XDMAC_CNDA & XDMAC_CNDA_NDA_Msk)));
+
+	/* CNDA already holds the descriptor after the one being executed */
+	ulNext = (ulNda - (uint32_t)&pstRing->pastDesc[0]) / sizeof(lld_view1);
+	ulOffset = ((ulNext + RX_RING_SEGMENTS - 1) % RX_RING_SEGMENTS)
+		* RX_RING_SEGMENT_SIZE + (RX_RING_SEGMENT_SIZE - ulUbc);
+
+	return ulOffset % RX_RING_SIZE;
+}
+
+/** ***************************************************************************
+	Name:               RxRingGetWriteCount
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Free-running count of bytes written by the DMA
+	Caveats / Effect:   None
+
+	Description:
+	Extends the DMA write offset to a free-running byte count, comparable with
+	ulReadCount, using the ISR segment count to tell which lap of the ring
+	the DMA is on. The segment count may lag the hardware by a segment whose
+	interrupt is still pending, which only ever puts the write offset ahead of
+	it.
+*/
+TCM_CODE uint32_t RxRingGetWriteCount(tRxRing const *pstRing)
+{
+	uint32_t const ulOffset = RxRingGetWriteOffset(pstRing);
+	uint32_t const ulDone = pstRing->ulSegCount * RX_RING_SEGMENT_SIZE;
+	uint32_t ulCount = ulDone - (ulDone % RX_RING_SIZE) + ulOffset;
+
+	if((int32_t)(ulCount - ulDone) < 0)
+	{
+		ulCount += RX_RING_SIZE;
+	}
+	return ulCount;
+}
+
+/** ***************************************************************************
+	Name:               RxRingPeek
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of contiguous bytes available at *ppucData
+	Caveats / Effect:   May discard data if the DMA has lapped the reader
+
+	Description:
+	Returns the largest contiguous run of received, unconsumed data. Data
+	wrapping past the end of the ring is returned by the next call once the
+	first part has been consumed with RxRingConsume(). The run is invalidated
+	in the data cache, including the partly read and partly written lines at
+	either end, which may have been cached by an earlier call.
+*/
+TCM_CODE uint32_t RxRingPeek(tRxRing *pstRing, uint8_t const **ppucData)
+{
+	uint32_t const ulWrite = RxRingGetWriteOffset(pstRing);
+	uint32_t const ulDone = pstRing->ulSegCount * RX_RING_SEGMENT_SIZE;
+	uint32_t ulRead;
+	uint32_t ulLen;
+
+	/* has the DMA come around and started writing over unread data? The
+		difference is signed as the ISR count may lag the hardware */
+	if((int32_t)(ulDone - pstRing->ulReadCount) > (int32_t)RX_RING_MAX_PENDING)
+	{
+		/* skip ahead to the oldest segment that is still intact, the one
+			after the segment being written. That is at ulDone, or a segment
+			later if its end of block interrupt is still pending, so the
+			skip allows for one more */
+		uint32_t const ulOldest = ulDone + 2 * RX_RING_SEGMENT_SIZE
+			- RX_RING_SIZE;
+
+		pstRing->ulOverruns++;
+		pstRing->ulLostBytes += ulOldest - pstRing->ulReadCount;
+		pstRing->ulReadCount = ulOldest;
+	}
+
+	ulRead = pstRing->ulReadCount % RX_RING_SIZE;
+	*ppucData = &pstRing->aucData[ulRead];
+
+	ulLen = (ulWrite >= ulRead) ? (ulWrite - ulRead) : (RX_RING_SIZE - ulRead);
+	DmaBufInvalidate(*ppucData, ulLen);
+
+	return ulLen;
+}
+
+/** ***************************************************************************
+	Name:               RxRingConsume
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Releases ulLen bytes previously returned by RxRingPeek() back to the DMA.
+*/
+TCM_CODE void RxRingConsume(tRxRing *pstRing, uint32_t ulLen)
+{
+	pstRing->ulReadCount += ulLen;
+}
+
+
+/* Module Function Implementations */
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,93 @@
+/** ***************************************************************************
+File Name:  rx_ring.h
+
+Project:    Platform 4
+
+Purpose:    Continuous data channel reception through a circular XDMAC
+            linked list
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef RX_RING_H
+#define RX_RING_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "dma_buf.h"
+
+
+/* Module Definitions */
+
+/* number of linked list descriptors (segments) in the receive ring */
+#ifndef RX_RING_SEGMENTS
+#define RX_RING_SEGMENTS 8
+#endif
+
+/* size, in bytes, of one receive segment */
+#ifndef RX_RING_SEGMENT_SIZE
+#define RX_RING_SEGMENT_SIZE 512
+#endif
+
+/* total size of the receive ring */
+#define RX_RING_SIZE (RX_RING_SEGMENTS * RX_RING_SEGMENT_SIZE)
+
+
+/* Module Type Definitions */
+
+/* receive ring state. The XDMAC walks pastDesc[] forever, so the channel is
+	never stopped; the application drains data behind the DMA write pointer */
+typedef struct
+{
+	/* receive storage, RX_RING_SEGMENTS back-to-back segments. Line aligned
+		so the data cache can be invalidated over it without touching the
+		rest of the structure */
+	uint8_t aucData[RX_RING_SIZE] DMA_BUF_ALIGNED;
+	/* circular view 1 descriptor chain, one per segment, in non-cacheable
+		memory (DmaBufAllocNoCache) */
+	lld_view1 *pastDesc;
+	/* XDMAC channel and peripheral source register */
+	uint32_t ulChannel;
+	uint32_t ulSrcAddr;
+	/* free-running count of segments completed by the DMA (ISR updated) */
+	volatile uint32_t ulSegCount;
+	/* free-running count of bytes consumed by the application */
+	uint32_t ulReadCount;
+	/* number of times the DMA lapped the application */
+	uint32_t ulOverruns;
+	/* number of unread bytes skipped over by overruns, up to the oldest
+		segment still intact */
+	uint32_t ulLostBytes;
+} tRxRing;
+
+
+/* Global Function Declarations */
+
+int RxRingInit(tRxRing *pstRing, uint32_t ulChannel, uint32_t ulSrcAddr,
+	uint32_t ulPerId);
+void RxRingStart(tRxRing *pstRing);
+void RxRingStop(tRxRing *pstRing);
+void RxRingSegmentDone(tRxRing *pstRing);
+uint32_t RxRingGetWriteOffset(tRxRing const *pstRing);
+uint32_t RxRingGetWriteCount(tRxRing const *pstRing);
+uint32_t RxRingPeek(tRxRing *pstRing, uint8_t const **ppucData);
+void RxRingConsume(tRxRing *pstRing, uint32_t ulLen);
+
+
+#endif /* RX_RING_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,700 @@
+/** ***************************************************************************
+File Name:  sd.c
+
+Project:    Platform 4
+
+Purpose:    SD card driver on the HSMCI: card identification, and XDMAC
+            multi-block writes that run in the background
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "dma_buf.h"
+#include "sd.h"
+
+
+/* Module Definitions */
+
+/* write progress, tSd.ucState */
+#define SD_IDLE              0
+#define SD_WRITING           1
+#define SD_STOPPING          2
+
+/* identification clock */
+#define SD_INIT_CLOCK_HZ     400000UL
+
+/* time limits: a command and its response, the card's busy signal after an
+	R1b command, card power up (ACMD41), and a whole write */
+#define SD_CMD_TIMEOUT_US    10000UL
+#define SD_BUSY_TIMEOUT_US   500000UL
+#define SD_POWER_UP_US       1000000UL
+#define SD_WRITE_TIMEOUT_US  1000000UL
+
+/* HSMCI_SR errors of a command's response, and of a data transfer */
+#define SD_SR_CMD_ERRORS     (HSMCI_SR_RINDE | HSMCI_SR_RDIRE | HSMCI_SR_RCRCE \
+	| HSMCI_SR_RENDE | HSMCI_SR_RTOE | HSMCI_SR_CSTOE)
+#define SD_SR_DATA_ERRORS    (HSMCI_SR_DCRCE | HSMCI_SR_DTOE | HSMCI_SR_BLKOVRE \
+	| HSMCI_SR_OVRE | HSMCI_SR_UNRE)
+/* tSd.ulStatus: the write timed out, a bit HSMCI_SR doesn't use */
+#define SD_STATUS_TIMEOUT    (1UL << 11)
+
+/* commands, as HSMCI_CMDR values */
+#define SD_CMD_R1            (HSMCI_CMDR_RSPTYP_48_BIT | HSMCI_CMDR_MAXLAT_64)
+#define SD_CMD0_GO_IDLE      (HSMCI_CMDR_CMDNB(0) | HSMCI_CMDR_RSPTYP_NORESP)
+#define SD_CMD2_ALL_SEND_CID (HSMCI_CMDR_CMDNB(2) | HSMCI_CMDR_RSPTYP_136_BIT \
+	| HSMCI_CMDR_MAXLAT_64)
+#define SD_CMD3_SEND_RCA     (HSMCI_CMDR_CMDNB(3) | SD_CMD_R1)
+#define SD_CMD6_SWITCH       (HSMCI_CMDR_CMDNB(6) | SD_CMD_R1 \
+	| HSMCI_CMDR_TRCMD_START_DATA | HSMCI_CMDR_TRDIR_READ \
+	| HSMCI_CMDR_TRTYP_SINGLE)
+#define SD_CMD7_SELECT       (HSMCI_CMDR_CMDNB(7) | HSMCI_CMDR_RSPTYP_R1B \
+	| HSMCI_CMDR_MAXLAT_64)
+#define SD_CMD8_SEND_IF_COND (HSMCI_CMDR_CMDNB(8) | SD_CMD_R1)
+#define SD_CMD9_SEND_CSD     (HSMCI_CMDR_CMDNB(9) | HSMCI_CMDR_RSPTYP_136_BIT \
+	| HSMCI_CMDR_MAXLAT_64)
+#define SD_CMD12_STOP        (HSMCI_CMDR_CMDNB(12) | HSMCI_CMDR_RSPTYP_R1B \
+	| HSMCI_CMDR_MAXLAT_64 | HSMCI_CMDR_TRCMD_STOP_DATA)
+#define SD_CMD16_BLOCKLEN    (HSMCI_CMDR_CMDNB(16) | SD_CMD_R1)
+#define SD_CMD17_READ        (HSMCI_CMDR_CMDNB(17) | SD_CMD_R1 \
+	| HSMCI_CMDR_TRCMD_START_DATA | HSMCI_CMDR_TRDIR_READ \
+	| HSMCI_CMDR_TRTYP_SINGLE)
+#define SD_CMD25_WRITE_MULTI (HSMCI_CMDR_CMDNB(25) | SD_CMD_R1 \
+	| HSMCI_CMDR_TRCMD_START_DATA | HSMCI_CMDR_TRDIR_WRITE \
+	| HSMCI_CMDR_TRTYP_MULTIPLE)
+#define SD_CMD55_APP         (HSMCI_CMDR_CMDNB(55) | SD_CMD_R1)
+#define SD_ACMD23_PRE_ERASE  (HSMCI_CMDR_CMDNB(23) | SD_CMD_R1)
+#define SD_ACMD41_SEND_OP    (HSMCI_CMDR_CMDNB(41) | SD_CMD_R1)
+
+/* CMD8 argument and echo: 2.7-3.6 V, check pattern */
+#define SD_IF_COND           0x000001AAUL
+/* ACMD41 argument and OCR: 3.2-3.4 V, host supports high capacity, power
+	up finished, card is high capacity */
+#define SD_OCR_VOLTAGE       0x00300000UL
+#define SD_OCR_HCS           (1UL << 30)
+#define SD_OCR_READY         (1UL << 31)
+/* CMD6: switch function group 1 to high speed */
+#define SD_SWITCH_HS         0x80FFFFF1UL
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static int SdCommand(uint32_t ulCmdr, uint32_t ulArg, uint32_t ulIgnore);
+static int SdWait(uint32_t ulMask, uint32_t ulTimeoutUs, uint32_t *pulStatus);
+static int SdReadData(uint32_t *pulDst, uint32_t ulWords);
+static int SdSwitchHighSpeed(void);
+static void SdSetClock(uint32_t ulHz);
+static uint32_t SdCsdBits(uint32_t const *paulCsd, uint32_t ulPos,
+	uint32_t ulSize);
+static uint32_t SdElapsedUs(tPpsTime tStart);
+
+
+/* Module Variable Declarations */
+
+static tSd stSd;
+
+/* XDMAC transfer to the HSMCI transmit data register */
+static xdmac_channel_config_t stSdDma;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               SdInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if no usable card answered
+	Caveats / Effect:   Blocks for up to a second while the card powers up;
+	                    needs the PPS time base (PpsInit()) for its timeouts
+
+	Description:
+	Identifies the card in slot A on a one bit bus, selects it and raises the
+	clock to SD_CLOCK_HZ, or to SD_HS_CLOCK_HZ if it supports high speed
+	mode. SD version 1 cards and SDHC/SDXC cards are both handled.
+*/
+int SdInit(void)
+{
+	Hsmci *pstHsmci = HSMCI;
+	uint32_t aulCsd[4];
+	uint32_t ulOcr = 0;
+	uint8_t ucVersion2;
+	tPpsTime tStart;
+	uint32_t i;
+
+	memset(&stSd, 0, sizeof(stSd));
+
+	sysclk_enable_peripheral_clock(ID_HSMCI);
+	pstHsmci->HSMCI_CR = HSMCI_CR_SWRST;
+	pstHsmci->HSMCI_CR = HSMCI_CR_MCIDIS | HSMCI_CR_PWSDIS;
+	pstHsmci->HSMCI_IDR = 0xFFFFFFFF;
+	pstHsmci->HSMCI_DTOR = HSMCI_DTOR_DTOMUL_1048576 | HSMCI_DTOR_DTOCYC(15);
+	pstHsmci->HSMCI_CSTOR = HSMCI_CSTOR_CSTOMUL_1048576
+		| HSMCI_CSTOR_CSTOCYC(15);
+	pstHsmci->HSMCI_CFG = HSMCI_CFG_FIFOMODE | HSMCI_CFG_FERRCTRL;
+	pstHsmci->HSMCI_MR = HSMCI_MR_PWSDIV_Msk | HSMCI_MR_RDPROOF
+		| HSMCI_MR_WRPROOF;
+	SdSetClock(SD_INIT_CLOCK_HZ);
+	pstHsmci->HSMCI_SDCR = HSMCI_SDCR_SDCSEL_SLOTA | HSMCI_SDCR_SDCBUS_1;
+	pstHsmci->HSMCI_DMA = 0;
+	pstHsmci->HSMCI_CR = HSMCI_CR_MCIEN | HSMCI_CR_PWSDIS;
+
+	/* the 74 clocks the card needs after power up, then reset it */
+	if(SdCommand(HSMCI_CMDR_SPCMD_INIT | HSMCI_CMDR_OPDCMD_OPENDRAIN, 0, 0)
+		|| SdCommand(SD_CMD0_GO_IDLE, 0, 0))
+	{
+		return -1;
+	}
+
+	/* version 2 cards echo CMD8, older ones don't answer it */
+	ucVersion2 = (SdCommand(SD_CMD8_SEND_IF_COND, SD_IF_COND, 0) == 0);
+	if(ucVersion2 && ((pstHsmci->HSMCI_RSPR[0] & 0xFFF) != SD_IF_COND))
+	{
+		return -1;
+	}
+
+	/* wait for power up; the OCR (R3) has no CRC */
+	tStart = PpsNow();
+	do
+	{
+		if(SdCommand(SD_CMD55_APP, 0, 0)
+			|| SdCommand(SD_ACMD41_SEND_OP, SD_OCR_VOLTAGE
+				| (ucVersion2 ? SD_OCR_HCS : 0), HSMCI_SR_RCRCE))
+		{
+			return -1;
+		}
+		ulOcr = pstHsmci->HSMCI_RSPR[0];
+	} while(!(ulOcr & SD_OCR_READY) && (SdElapsedUs(tStart) < SD_POWER_UP_US));
+	if(!(ulOcr & SD_OCR_READY))
+	{
+		return -1;
+	}
+	stSd.ucHighCapacity = (ulOcr & SD_OCR_HCS) != 0;
+
+	/* relative address, and the size from the CSD */
+	if(SdCommand(SD_CMD2_ALL_SEND_CID, 0, 0)
+		|| SdCommand(SD_CMD3_SEND_RCA, 0, 0))
+	{
+		return -1;
+	}
+	stSd.usRca = (uint16_t)(pstHsmci->HSMCI_RSPR[0] >> 16);
+	if(SdCommand(SD_CMD9_SEND_CSD, (uint32_t)stSd.usRca << 16, 0))
+	{
+		return -1;
+	}
+	for(i = 0; i < 4; i++)
+	{
+		aulCsd[i] = pstHsmci->HSMCI_RSPR[0];
+	}
+	if(SdCsdBits(aulCsd, 126, 2) == 1)
+	{
+		/* CSD version 2: C_SIZE in 512 KB units */
+		stSd.ulBlocks = (SdCsdBits(aulCsd, 48, 22) + 1) * 1024;
+	}
+	else
+	{
+		/* CSD version 1: (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) blocks of
+			2^READ_BL_LEN bytes */
+		stSd.ulBlocks = (SdCsdBits(aulCsd, 62, 12) + 1)
+			<< (SdCsdBits(aulCsd, 47, 3) + 2 + SdCsdBits(aulCsd, 80, 4) - 9);
+	}
+
+	/* into the transfer state at full speed, with 512 byte blocks */
+	if(SdCommand(SD_CMD7_SELECT, (uint32_t)stSd.usRca << 16, 0))
+	{
+		return -1;
+	}
+	SdSetClock(SD_CLOCK_HZ);
+	if(!stSd.ucHighCapacity && SdCommand(SD_CMD16_BLOCKLEN, SD_BLOCK_SIZE, 0))
+	{
+		return -1;
+	}
+	/* command class 10 is the switch function */
+	if(SdCsdBits(aulCsd, 84, 12) & (1UL << 10))
+	{
+		(void)SdSwitchHighSpeed();
+	}
+
+	/* card writes are sent from memory by the XDMAC, one word at a time as
+		the HSMCI asks for them */
+	xdmac_channel_set_descriptor_control(XDMAC, SD_DMA_CHANNEL,
+		XDMAC_CNDC_NDE_DSCR_FETCH_DIS);
+	stSdDma.mbr_da  = (uint32_t)&pstHsmci->HSMCI_TDR;
+	stSdDma.mbr_cfg = XDMAC_CC_TYPE_PER_TRAN
+		| XDMAC_CC_MBSIZE_SINGLE
+		| XDMAC_CC_DSYNC_MEM2PER
+		| XDMAC_CC_SWREQ_HWR_CONNECTED
+		| XDMAC_CC_CSIZE_CHK_1
+		| XDMAC_CC_DWIDTH_WORD
+		| XDMAC_CC_SIF_AHB_IF0
+		| XDMAC_CC_DIF_AHB_IF1
+		| XDMAC_CC_SAM_INCREMENTED_AM
+		| XDMAC_CC_DAM_FIXED_AM
+		| XDMAC_CC_PERID(XDMAC_CHANNEL_HWID_HSMCI);
+
+	NVIC_ClearPendingIRQ(HSMCI_IRQn);
+	NVIC_EnableIRQ(HSMCI_IRQn);
+
+	stSd.ucReady = 1;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               SdWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if the write started, -1 if it couldn't
+	Caveats / Effect:   pvData must be word aligned and stay untouched until
+	                    SdPoll() reports the write done
+
+	Description:
+	Starts writing ulBlocks blocks from pvData to the card at block ulBlock
+	as one multi-block write, and returns straight away. The XDMAC feeds the
+	data to the HSMCI; SdPoll() sees the write through to the end. The card
+	is told the length up front (ACMD23) so it can erase ahead of the data.
+*/
+int SdWrite(uint32_t ulBlock, void const *pvData, uint32_t ulBlocks)
+{
+	Hsmci *pstHsmci = HSMCI;
+	uint32_t const ulAddr = stSd.ucHighCapacity ? ulBlock
+		: ulBlock * SD_BLOCK_SIZE;
+
+	if(!stSd.ucReady || (stSd.ucState != SD_IDLE) || (ulBlocks == 0)
+		|| (ulBlocks > (HSMCI_BLKR_BCNT_Msk >> HSMCI_BLKR_BCNT_Pos)))
+	{
+		return -1;
+	}
+
+	/* only a hint, the write goes ahead without it */
+	if(SdCommand(SD_CMD55_APP, (uint32_t)stSd.usRca << 16, 0) == 0)
+	{
+		(void)SdCommand(SD_ACMD23_PRE_ERASE, ulBlocks, 0);
+	}
+
+	/* the DMA reads memory, not the data cache */
+	DmaBufClean(pvData, ulBlocks * SD_BLOCK_SIZE);
+	xdmac_channel_disable(XDMAC, SD_DMA_CHANNEL);
+	stSdDma.mbr_ubc = ulBlocks * SD_BLOCK_SIZE / 4;
+	stSdDma.mbr_sa  = (uint32_t)pvData;
+	xdmac_configure_transfer(XDMAC, SD_DMA_CHANNEL, &stSdDma);
+	xdmac_channel_enable(XDMAC, SD_DMA_CHANNEL);
+
+	pstHsmci->HSMCI_DMA = HSMCI_DMA_DMAEN;
+	pstHsmci->HSMCI_BLKR = HSMCI_BLKR_BCNT(ulBlocks)
+		| HSMCI_BLKR_BLKLEN(SD_BLOCK_SIZE);
+	stSd.tWriteStart = PpsNow();
+	stSd.ulStatus = 0;
+	if(SdCommand(SD_CMD25_WRITE_MULTI, ulAddr, 0))
+	{
+		xdmac_channel_disable(XDMAC, SD_DMA_CHANNEL);
+		pstHsmci->HSMCI_DMA = 0;
+		stSd.ulErrors++;
+		return -1;
+	}
+
+	stSd.ucState = SD_WRITING;
+	stSd.ulWrites++;
+	stSd.ulBlocksWritten += ulBlocks;
+	pstHsmci->HSMCI_IER = HSMCI_IER_XFRDONE;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               SdPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             SD_BUSY while a write is in progress, then once 0 if
+	                    it succeeded or -1 if it failed; 0 when idle
+	Caveats / Effect:   Call from the main program loop
+
+	Description:
+	Sees a write started by SdWrite() through: once all blocks have been
+	sent it stops the transmission (CMD12) and waits for the card to finish
+	programming, which is when the write time is taken. A write that takes
+	longer than SD_WRITE_TIMEOUT_US is abandoned and fails.
+*/
+int SdPoll(void)
+{
+	Hsmci *pstHsmci = HSMCI;
+	uint32_t ulSr;
+	uint32_t ulUs;
+
+	if(stSd.ucState == SD_IDLE)
+	{
+		return 0;
+	}
+
+	ulUs = SdElapsedUs(stSd.tWriteStart);
+
+	if(stSd.ucState == SD_WRITING)
+	{
+		ulSr = pstHsmci->HSMCI_SR;
+		stSd.ulStatus |= ulSr;
+		if(!(ulSr & HSMCI_SR_XFRDONE))
+		{
+			if(ulUs < SD_WRITE_TIMEOUT_US)
+			{
+				pstHsmci->HSMCI_IER = HSMCI_IER_XFRDONE;
+				return SD_BUSY;
+			}
+			stSd.ulStatus |= SD_STATUS_TIMEOUT;
+		}
+
+		xdmac_channel_disable(XDMAC, SD_DMA_CHANNEL);
+		pstHsmci->HSMCI_DMA = 0;
+		if(SdCommand(SD_CMD12_STOP, 0, 0) != 0)
+		{
+			stSd.ulStatus |= SD_STATUS_TIMEOUT;
+		}
+		stSd.ucState = SD_STOPPING;
+	}
+
+	/* the card holds the data line low while it programs the data */
+	ulSr = pstHsmci->HSMCI_SR;
+	stSd.ulStatus |= ulSr & SD_SR_DATA_ERRORS;
+	if(!(ulSr & HSMCI_SR_NOTBUSY))
+	{
+		if(ulUs < SD_WRITE_TIMEOUT_US)
+		{
+			pstHsmci->HSMCI_IER = HSMCI_IER_NOTBUSY;
+			return SD_BUSY;
+		}
+		stSd.ulStatus |= SD_STATUS_TIMEOUT;
+	}
+
+	stSd.ucState = SD_IDLE;
+	stSd.ulLastWriteUs = ulUs;
+	if(ulUs > stSd.ulMaxWriteUs)
+	{
+		stSd.ulMaxWriteUs = ulUs;
+	}
+	if(stSd.ulStatus & (SD_SR_DATA_ERRORS | SD_STATUS_TIMEOUT))
+	{
+		stSd.ulErrors++;
+		return -1;
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               SdRead
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 on failure
+	Caveats / Effect:   Blocks until the block has been read; pvData must be
+	                    word aligned and not be written while a write is in
+	                    progress
+
+	Description:
+	Reads the block at ulBlock into the SD_BLOCK_SIZE bytes at pvData,
+	through the receive data register.
+*/
+int SdRead(uint32_t ulBlock, void *pvData)
+{
+	Hsmci *pstHsmci = HSMCI;
+
+	if(!stSd.ucReady || (stSd.ucState != SD_IDLE))
+	{
+		return -1;
+	}
+
+	pstHsmci->HSMCI_DMA = 0;
+	pstHsmci->HSMCI_BLKR = HSMCI_BLKR_BCNT(1) | HSMCI_BLKR_BLKLEN(SD_BLOCK_SIZE);
+	if(SdCommand(SD_CMD17_READ, stSd.ucHighCapacity ? ulBlock
+		: ulBlock * SD_BLOCK_SIZE, 0))
+	{
+		return -1;
+	}
+	return SdReadData((uint32_t *)pvData, SD_BLOCK_SIZE / 4);
+}
+
+/** ***************************************************************************
+	Name:               SdGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Card and driver state
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to the card size and the write statistics.
+*/
+tSd const *SdGet(void)
+{
+	return &stSd;
+}
+
+/** ***************************************************************************
+	Name:               HSMCI_Handler
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   ISR
+
+	Description:
+	Only there to wake the main program loop when a write has been sent or
+	the card has finished programming; SdPoll() does the rest and enables the
+	interrupt again while it waits.
+*/
+void HSMCI_Handler(void)
+{
+	HSMCI->HSMCI_IDR = 0xFFFFFFFF;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               SdCommand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the card didn't answer properly
+	Caveats / Effect:   Busy waits for the response, and for the end of the
+	                    busy signal of an R1b command
+
+	Description:
+	Sends a command (an HSMCI_CMDR value) with its argument. Response errors
+	in ulIgnore don't count.
+*/
+static int SdCommand(uint32_t ulCmdr, uint32_t ulArg, uint32_t ulIgnore)
+{
+	Hsmci *pstHsmci = HSMCI;
+	uint32_t ulStatus = 0;
+
+	pstHsmci->HSMCI_ARGR = ulArg;
+	pstHsmci->HSMCI_CMDR = ulCmdr;
+	if((SdWait(HSMCI_SR_CMDRDY, SD_CMD_TIMEOUT_US, &ulStatus) != 0)
+		|| (ulStatus & SD_SR_CMD_ERRORS & ~ulIgnore))
+	{
+		return -1;
+	}
+
+	if((ulCmdr & HSMCI_CMDR_RSPTYP_Msk) == HSMCI_CMDR_RSPTYP_R1B)
+	{
+		return SdWait(HSMCI_SR_NOTBUSY, SD_BUSY_TIMEOUT_US, &ulStatus);
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               SdWait
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 once all of ulMask is set in HSMCI_SR, -1 on timeout
+	Caveats / Effect:   Busy waits
+
+	Description:
+	Polls the status register, collecting every bit seen in *pulStatus, as
+	the error bits clear when it is read.
+*/
+static int SdWait(uint32_t ulMask, uint32_t ulTimeoutUs, uint32_t *pulStatus)
+{
+	tPpsTime const tStart = PpsNow();
+
+	while(1)
+	{
+		uint32_t const ulSr = HSMCI->HSMCI_SR;
+
+		*pulStatus |= ulSr;
+		if((ulSr & ulMask) == ulMask)
+		{
+			return 0;
+		}
+		if(SdElapsedUs(tStart) >= ulTimeoutUs)
+		{
+			return -1;
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               SdReadData
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 on a timeout or data error
+	Caveats / Effect:   Busy waits
+
+	Description:
+	Reads the data of a read command that has been sent, word by word, and
+	waits for the end of the transfer.
+*/
+static int SdReadData(uint32_t *pulDst, uint32_t ulWords)
+{
+	uint32_t ulStatus = 0;
+	uint32_t i;
+
+	for(i = 0; i < ulWords; i++)
+	{
+		if(SdWait(HSMCI_SR_RXRDY, SD_CMD_TIMEOUT_US, &ulStatus) != 0)
+		{
+			return -1;
+		}
+		pulDst[i] = HSMCI->HSMCI_RDR;
+	}
+	if((SdWait(HSMCI_SR_XFRDONE, SD_CMD_TIMEOUT_US, &ulStatus) != 0)
+		|| (ulStatus & SD_SR_DATA_ERRORS))
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               SdSwitchHighSpeed
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if the card is now in high speed mode, -1 if not
+	Caveats / Effect:   None
+
+	Description:
+	Asks the card to switch to high speed mode (CMD6), and if the 64 byte
+	status it returns says it did, moves the HSMCI to high speed timing at
+	SD_HS_CLOCK_HZ.
+*/
+static int SdSwitchHighSpeed(void)
+{
+	uint32_t aulStatus[16];
+
+	HSMCI->HSMCI_BLKR = HSMCI_BLKR_BCNT(1) | HSMCI_BLKR_BLKLEN(sizeof(aulStatus));
+	if(SdCommand(SD_CMD6_SWITCH, SD_SWITCH_HS, 0)
+		|| SdReadData(aulStatus, sizeof(aulStatus) / 4))
+	{
+		return -1;
+	}
+
+	/* status bits 379:376, the function group 1 result, in byte 16 */
+	if((aulStatus[4] & 0x0F) != 1)
+	{
+		return -1;
+	}
+
+	HSMCI->HSMCI_CFG |= HSMCI_CFG_HSMODE;
+	SdSetClock(SD_HS_CLOCK_HZ);
+	stSd.ucHighSpeed = 1;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               SdSetClock
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Sets the card clock to the fastest rate that doesn't exceed ulHz, within
+	the range of the divider: MCK / (2 * CLKDIV + CLKODD + 2).
+*/
+static void SdSetClock(uint32_t ulHz)
+{
+	uint32_t const ulMck = sysclk_get_peripheral_hz();
+	uint32_t ulDiv = (ulMck + ulHz - 1) / ulHz;
+
+	if(ulDiv < 2)
+	{
+		ulDiv = 2;
+	}
+	if(ulDiv > 2 * 255 + 1 + 2)
+	{
+		ulDiv = 2 * 255 + 1 + 2;
+	}
+
+	HSMCI->HSMCI_MR = (HSMCI->HSMCI_MR
+		& ~(HSMCI_MR_CLKDIV_Msk | HSMCI_MR_CLKODD))
+		| HSMCI_MR_CLKDIV((ulDiv - 2) / 2)
+		| (((ulDiv - 2) & 1) ? HSMCI_MR_CLKODD : 0);
+	stSd.ulClockHz = ulMck / ulDiv;
+}
+
+/** ***************************************************************************
+	Name:               SdCsdBits
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             The field's value
+	Caveats / Effect:   None
+
+	Description:
+	Extracts the ulSize bit field starting at bit ulPos of the 128 bit CSD,
+	held most significant word first as it comes out of HSMCI_RSPR.
+*/
+static uint32_t SdCsdBits(uint32_t const *paulCsd, uint32_t ulPos,
+	uint32_t ulSize)
+{
+	uint32_t ulValue = 0;
+	uint32_t i;
+
+	for(i = 0; i < ulSize; i++)
+	{
+		uint32_t const ulBit = ulPos + i;
+
+		ulValue |= ((paulCsd[3 - ulBit / 32] >> (ulBit % 32)) & 1) << i;
+	}
+	return ulValue;
+}
+
+/** ***************************************************************************
+	Name:               SdElapsedUs
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Microseconds since tStart
+	Caveats / Effect:   None
+
+	Description:
+	Measures time on the PPS time base, which is always running.
+*/
+static uint32_t SdElapsedUs(tPpsTime tStart)
+{
+	uint64_t const ullElapsed = PpsNow() - tStart;
+
+	/* keep the product in range, ~70 minutes is plenty */
+	if(ullElapsed >> 44)
+	{
+		return UINT32_MAX;
+	}
+	return (uint32_t)((ullElapsed * 1000000) >> 32);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,83 @@
+/** ***************************************************************************
+File Name:  sd.h
+
+Project:    Platform 4
+
+Purpose:    SD card driver on the HSMCI: card identification, and XDMAC
+            multi-block writes that run in the background
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef SD_H
+#define SD_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "conf_rec.h"
+#include "pps.h"
+
+
+/* Module Definitions */
+
+#define SD_BLOCK_SIZE        512
+
+/* SdPoll(): a write is still in progress */
+#define SD_BUSY              1
+
+
+/* Module Type Definitions */
+
+/* card and driver state */
+typedef struct
+{
+	/* the card answered identification, its size in blocks, and whether it
+		is addressed in blocks (SDHC/SDXC) rather than bytes */
+	uint8_t ucReady;
+	uint8_t ucHighCapacity;
+	uint8_t ucHighSpeed;
+	uint16_t usRca;
+	uint32_t ulBlocks;
+	uint32_t ulClockHz;
+	/* write in progress: SD_IDLE, SD_WRITING or SD_STOPPING (sd.c), the
+		status bits seen so far and when it started */
+	uint8_t ucState;
+	uint32_t ulStatus;
+	tPpsTime tWriteStart;
+	/* statistics: writes, blocks written, failed writes, and the time taken
+		by the last and the slowest write, from SdWrite() until the card is
+		done programming */
+	uint32_t ulWrites;
+	uint32_t ulBlocksWritten;
+	uint32_t ulErrors;
+	uint32_t ulLastWriteUs;
+	uint32_t ulMaxWriteUs;
+} tSd;
+
+
+/* Global Function Declarations */
+
+int SdInit(void);
+int SdWrite(uint32_t ulBlock, void const *pvData, uint32_t ulBlocks);
+int SdPoll(void);
+int SdRead(uint32_t ulBlock, void *pvData);
+tSd const *SdGet(void);
+
+
+#endif /* SD_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,207 @@
+/** ***************************************************************************
+File Name:  sdram.c
+
+Project:    Platform 4
+
+Purpose:    External SDRAM: SDRAMC bring-up of the AS4C32M16SB at
+            BOARD_SDRAM_ADDR
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+
+/* Local Include Files */
+#include "dma_buf.h"
+#include "pps.h"
+#include "sdram.h"
+
+
+/* Module Definitions */
+
+/* AS4C32M16SB-7: 4 banks of 8192 rows of 1024 columns of 16 bits, CAS
+	latency 3. Timings in nanoseconds, converted to MCK cycles below */
+#define SDRAM_T_RC_NS        63   /* also the auto refresh period, tRFC */
+#define SDRAM_T_RAS_NS       42
+#define SDRAM_T_RP_NS        21
+#define SDRAM_T_RCD_NS       21
+#define SDRAM_T_WR_NS        14
+#define SDRAM_T_XSR_NS       70
+#define SDRAM_T_MRD_CYCLES   2
+
+/* every row refreshed once in 64 ms */
+#define SDRAM_REFRESH_NS     (64000000UL / 8192)
+
+/* power up pause before the first command, and the number of auto refresh
+	cycles the device wants before the mode register is loaded */
+#define SDRAM_POWER_UP_US    200
+#define SDRAM_INIT_REFRESHES 8
+
+/* MCK cycles covering ulNs nanoseconds */
+#define SDRAM_CYCLES(ulMhz, ulNs) (((ulNs) * (ulMhz) + 999) / 1000)
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void SdramCommand(uint32_t ulMode);
+static int SdramTest(void);
+
+
+/* Module Variable Declarations */
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               SdramInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 if the SDRAM doesn't hold data
+	Caveats / Effect:   Waits about 250 us. The SDRAM pins must be set up
+	                    (board_init() without CONF_BOARD_USART2) and the PPS
+	                    time base running
+
+	Description:
+	Brings up the SDRAM controller for the device on the board and runs it
+	through its power up sequence, then checks every address line by
+	writing and reading back a word at each power of two offset. The SDRAM
+	is cacheable (MPU region set up by board_init()), so DMA buffers in it
+	need the same cache maintenance as those in the internal SRAM.
+*/
+int SdramInit(void)
+{
+	uint32_t const ulMhz = sysclk_get_peripheral_hz() / 1000000;
+	uint64_t const ullStart = PpsTicks();
+	uint32_t i;
+
+	pmc_enable_periph_clk(ID_SDRAMC);
+
+	SDRAMC->SDRAMC_CR = SDRAMC_CR_NC_COL10
+		| SDRAMC_CR_NR_ROW13
+		| SDRAMC_CR_NB_BANK4
+		| SDRAMC_CR_CAS_LATENCY3
+		| SDRAMC_CR_DBW
+		| SDRAMC_CR_TWR(SDRAM_CYCLES(ulMhz, SDRAM_T_WR_NS))
+		| SDRAMC_CR_TRC_TRFC(SDRAM_CYCLES(ulMhz, SDRAM_T_RC_NS))
+		| SDRAMC_CR_TRP(SDRAM_CYCLES(ulMhz, SDRAM_T_RP_NS))
+		| SDRAMC_CR_TRCD(SDRAM_CYCLES(ulMhz, SDRAM_T_RCD_NS))
+		| SDRAMC_CR_TRAS(SDRAM_CYCLES(ulMhz, SDRAM_T_RAS_NS))
+		| SDRAMC_CR_TXSR(SDRAM_CYCLES(ulMhz, SDRAM_T_XSR_NS));
+	SDRAMC->SDRAMC_CFR1 = SDRAMC_CFR1_TMRD(SDRAM_T_MRD_CYCLES)
+		| SDRAMC_CFR1_UNAL_SUPPORTED;
+	SDRAMC->SDRAMC_MDR = SDRAMC_MDR_MD_SDRAM;
+	SDRAMC->SDRAMC_LPR = 0;
+
+	/* let the device's supplies and clock settle */
+	while(PpsTicks() - ullStart < (uint64_t)PPS_TICK_HZ * SDRAM_POWER_UP_US / 1000000) {};
+
+	SdramCommand(SDRAMC_MR_MODE_NOP);
+	SdramCommand(SDRAMC_MR_MODE_ALLBANKS_PRECHARGE);
+	for(i = 0; i < SDRAM_INIT_REFRESHES; i++)
+	{
+		SdramCommand(SDRAMC_MR_MODE_AUTO_REFRESH);
+	}
+	/* the controller builds the mode register value (CAS latency, burst
+		length 1) from SDRAMC_CR */
+	SdramCommand(SDRAMC_MR_MODE_LOAD_MODEREG);
+	SdramCommand(SDRAMC_MR_MODE_NORMAL);
+
+	SDRAMC->SDRAMC_TR = SDRAMC_TR_COUNT(SDRAM_CYCLES(ulMhz, SDRAM_REFRESH_NS));
+
+	return SdramTest();
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               SdramCommand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Writes to the first word of the SDRAM
+
+	Description:
+	Issues one command to the device: the controller sends it on the next
+	access to the SDRAM once SDRAMC_MR has been set.
+*/
+static void SdramCommand(uint32_t ulMode)
+{
+	SDRAMC->SDRAMC_MR = SDRAMC_MR_MODE(ulMode);
+	/* make sure the mode is set before the access */
+	(void)SDRAMC->SDRAMC_MR;
+	__DMB();
+	*(uint16_t volatile *)BOARD_SDRAM_ADDR = 0;
+	__DSB();
+}
+
+/** ***************************************************************************
+	Name:               SdramTest
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every word read back, -1 otherwise
+	Caveats / Effect:   Overwrites a word at each power of two offset
+
+	Description:
+	Writes a different value at the start of the SDRAM and at every power of
+	two offset up to BOARD_SDRAM_SIZE, then reads them all back from the
+	device rather than the data cache. A missing device, a stuck or open
+	address line or the wrong geometry shows up as a word that doesn't
+	match.
+*/
+static int SdramTest(void)
+{
+	uint32_t volatile *const pulBase = (uint32_t volatile *)BOARD_SDRAM_ADDR;
+	uint32_t ulOffset;
+
+	pulBase[0] = 0xA5A5A5A5UL;
+	for(ulOffset = sizeof(uint32_t); ulOffset < BOARD_SDRAM_SIZE; ulOffset <<= 1)
+	{
+		pulBase[ulOffset / sizeof(uint32_t)] = ~ulOffset;
+	}
+
+	/* push the words out to the device and drop them from the cache. Each
+		is a partial line, which DmaBufInvalidate() writes back first */
+	DmaBufInvalidate((void const *)pulBase, sizeof(uint32_t));
+	for(ulOffset = sizeof(uint32_t); ulOffset < BOARD_SDRAM_SIZE; ulOffset <<= 1)
+	{
+		DmaBufInvalidate((void const *)&pulBase[ulOffset / sizeof(uint32_t)],
+			sizeof(uint32_t));
+	}
+
+	if(pulBase[0] != 0xA5A5A5A5UL)
+	{
+		return -1;
+	}
+	for(ulOffset = sizeof(uint32_t); ulOffset < BOARD_SDRAM_SIZE; ulOffset <<= 1)
+	{
+		if(pulBase[ulOffset / sizeof(uint32_t)] != ~ulOffset)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
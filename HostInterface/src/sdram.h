@@ -0,0 +1,44 @@
+/** ***************************************************************************
+File Name:  sdram.h
+
+Project:    Platform 4
+
+Purpose:    External SDRAM: SDRAMC bring-up of the AS4C32M16SB at
+            BOARD_SDRAM_ADDR
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef SDRAM_H
+#define SDRAM_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "asf.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* Global Function Declarations */
+
+int SdramInit(void);
+
+
+#endif /* SDRAM_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
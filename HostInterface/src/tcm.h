@@ -0,0 +1,54 @@
+/** ***************************************************************************
+File Name:  tcm.h
+
+Project:    Platform 4
+
+Purpose:    Placement of hot path code and data in the tightly coupled
+            memories
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef TCM_H
+#define TCM_H
+
+/* Local Include Files */
+#include "conf_board.h"
+
+
+/* Module Definitions */
+
+/* The ITCM and DTCM run at the core clock with no wait states and, unlike
+	flash, no cache misses, so code placed there has a fixed execution time.
+	board_init() copies .itcm_text and .dtcm_data out of flash and zeroes
+	.dtcm_bss (see flash.ld). Without CONF_BOARD_ENABLE_TCM_AT_INIT the
+	TCMs are off and everything stays in the normal sections.
+
+	TCM_CODE    functions: ISRs and the receive path they feed
+	TCM_DATA    initialized variables
+	TCM_BSS     zero initialized variables; not for DMA buffers */
+#ifdef CONF_BOARD_ENABLE_TCM_AT_INIT
+#define TCM_CODE __attribute__((section(".itcm_text")))
+#define TCM_DATA __attribute__((section(".dtcm_data")))
+#define TCM_BSS  __attribute__((section(".dtcm_bss")))
+#else
+#define TCM_CODE
+#define TCM_DATA
+#define TCM_BSS
+#endif
+
+
+#endif /* TCM_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
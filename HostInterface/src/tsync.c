@@ -0,0 +1,482 @@
+/** ***************************************************************************
+File Name:  tsync.c
+
+Project:    Platform 4
+
+Purpose:    Two-way time transfer over a data channel link: message
+            exchange, path delay and clock offset, in the manner of PTP
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stddef.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "tsync.h"
+
+
+/* Module Definitions */
+
+/* exchange states. The master goes IDLE, SYNC, FOLLOW_UP, WAIT_REQ,
+	WAIT_FOLLOW, RESP and back to IDLE; the slave goes IDLE, WAIT_FOLLOW_UP,
+	REQ, FOLLOW, WAIT_RESP and back to IDLE. The states named after a message
+	are waiting for the link to take it */
+#define TSYNC_STATE_IDLE            0
+#define TSYNC_STATE_SYNC            1
+#define TSYNC_STATE_FOLLOW_UP       2
+#define TSYNC_STATE_WAIT_REQ        3
+#define TSYNC_STATE_WAIT_FOLLOW     4
+#define TSYNC_STATE_RESP            5
+#define TSYNC_STATE_WAIT_FOLLOW_UP  6
+#define TSYNC_STATE_REQ             7
+#define TSYNC_STATE_FOLLOW          8
+#define TSYNC_STATE_WAIT_RESP       9
+
+/* message layout */
+#define TSYNC_OFS_TYPE              2
+#define TSYNC_OFS_SEQ               4
+#define TSYNC_OFS_STAMP0            6
+#define TSYNC_OFS_STAMP1            14
+#define TSYNC_HEADER_LEN            TSYNC_OFS_STAMP0
+
+/* a duration in ms as a tPpsTime */
+#define TSYNC_MS(ms)                ((((uint64_t)(ms)) << 32) / 1000)
+
+/* weight of a new path delay in the filtered delay, as a shift */
+#define TSYNC_DELAY_SHIFT           3
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static int TsyncSend(tTsync *pstSync, uint8_t ucType, uint32_t ulStamps,
+	uint64_t ullStamp0, uint64_t ullStamp1, uint64_t *pullTxTime);
+static void TsyncUpdate(tTsync *pstSync);
+static void TsyncPutStamp(uint8_t *pucDst, uint64_t ullStamp);
+static uint64_t TsyncGetStamp(uint8_t const *pucSrc);
+
+
+/* Module Variable Declarations */
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               TsyncInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Sets up one end of the exchange as TSYNC_MASTER or TSYNC_SLAVE. Messages
+	go out through pfnSend, which is handed pvContext. lAsymmetryNs is the
+	path delay master to slave minus slave to master, known from the link
+	hardware; the exchange itself can only measure the mean of the two.
+*/
+void TsyncInit(tTsync *pstSync, uint8_t ucRole, int32_t lAsymmetryNs,
+	tTsyncSend pfnSend, void *pvContext)
+{
+	memset(pstSync, 0, sizeof(*pstSync));
+	pstSync->ucRole = ucRole;
+	pstSync->ucState = TSYNC_STATE_IDLE;
+	pstSync->lAsymmetryNs = lAsymmetryNs;
+	pstSync->pfnSend = pfnSend;
+	pstSync->pvContext = pvContext;
+}
+
+/** ***************************************************************************
+	Name:               TsyncPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   May send a message
+
+	Description:
+	Runs the exchange at time ullNow: the master starts a new one every
+	TSYNC_INTERVAL_MS, a message the link was too busy to take is tried
+	again, and an exchange that got no answer within TSYNC_TIMEOUT_MS is
+	abandoned. Call regularly from the main loop.
+*/
+void TsyncPoll(tTsync *pstSync, uint64_t ullNow)
+{
+	uint64_t const ullElapsed = ullNow - pstSync->ullStart;
+
+	switch(pstSync->ucState)
+	{
+		case TSYNC_STATE_IDLE:
+			if((pstSync->ucRole == TSYNC_MASTER)
+				&& (ullElapsed >= TSYNC_MS(TSYNC_INTERVAL_MS)))
+			{
+				pstSync->usSeq++;
+				pstSync->ullStart = ullNow;
+				pstSync->ucState = TSYNC_STATE_SYNC;
+			}
+			else
+			{
+				return;
+			}
+			break;
+
+		case TSYNC_STATE_WAIT_REQ:
+		case TSYNC_STATE_WAIT_FOLLOW:
+		case TSYNC_STATE_WAIT_FOLLOW_UP:
+		case TSYNC_STATE_WAIT_RESP:
+			if(ullElapsed >= TSYNC_MS(TSYNC_TIMEOUT_MS))
+			{
+				pstSync->ulTimeouts++;
+				pstSync->ucState = TSYNC_STATE_IDLE;
+			}
+			return;
+
+		default:
+			/* a message to send; if the link stays busy give up like for a
+				lost answer */
+			if(ullElapsed >= TSYNC_MS(TSYNC_TIMEOUT_MS))
+			{
+				pstSync->ulTimeouts++;
+				pstSync->ucState = TSYNC_STATE_IDLE;
+				return;
+			}
+			break;
+	}
+
+	switch(pstSync->ucState)
+	{
+		case TSYNC_STATE_SYNC:
+			if(TsyncSend(pstSync, TSYNC_SYNC, 0, 0, 0, &pstSync->ullT1) == 0)
+			{
+				pstSync->ucState = TSYNC_STATE_FOLLOW_UP;
+			}
+			break;
+
+		case TSYNC_STATE_FOLLOW_UP:
+			if(TsyncSend(pstSync, TSYNC_FOLLOW_UP, 1, pstSync->ullT1, 0, NULL)
+				== 0)
+			{
+				pstSync->ucState = TSYNC_STATE_WAIT_REQ;
+			}
+			break;
+
+		case TSYNC_STATE_RESP:
+			if(TsyncSend(pstSync, TSYNC_DELAY_RESP, 1, pstSync->ullT4, 0, NULL)
+				== 0)
+			{
+				pstSync->ucState = TSYNC_STATE_IDLE;
+			}
+			break;
+
+		case TSYNC_STATE_REQ:
+			if(TsyncSend(pstSync, TSYNC_DELAY_REQ, 0, 0, 0, &pstSync->ullT3)
+				== 0)
+			{
+				pstSync->ucState = TSYNC_STATE_FOLLOW;
+			}
+			break;
+
+		case TSYNC_STATE_FOLLOW:
+			if(TsyncSend(pstSync, TSYNC_DELAY_FOLLOW, 2, pstSync->ullT2,
+				pstSync->ullT3, NULL) == 0)
+			{
+				pstSync->ucState = TSYNC_STATE_WAIT_RESP;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/** ***************************************************************************
+	Name:               TsyncIsMessage
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Non-zero if the frame payload is a time sync message
+	Caveats / Effect:   None
+
+	Description:
+	Tells time sync messages apart from other frame payloads by their magic
+	bytes.
+*/
+int TsyncIsMessage(uint8_t const *pucMsg, uint32_t ulLen)
+{
+	return (ulLen >= TSYNC_HEADER_LEN) && (pucMsg[0] == TSYNC_MAGIC0)
+		&& (pucMsg[1] == TSYNC_MAGIC1);
+}
+
+/** ***************************************************************************
+	Name:               TsyncReceive
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Takes a time sync message that arrived at ullRxTime. The receive time
+	must be taken at the same point of the message as the transmit time the
+	other end stamps (see tTsyncSend); a constant difference between the two
+	shows up as path delay and cancels out of the offset. Messages that
+	don't belong to the exchange in progress are ignored, except that a SYNC
+	always starts a new exchange on the slave.
+*/
+void TsyncReceive(tTsync *pstSync, uint8_t const *pucMsg, uint32_t ulLen,
+	uint64_t ullRxTime)
+{
+	uint8_t ucType;
+	uint16_t usSeq;
+
+	if(!TsyncIsMessage(pucMsg, ulLen))
+	{
+		return;
+	}
+	ucType = pucMsg[TSYNC_OFS_TYPE];
+	usSeq = (uint16_t)(pucMsg[TSYNC_OFS_SEQ]
+		| (pucMsg[TSYNC_OFS_SEQ + 1] << 8));
+
+	if((pstSync->ucRole == TSYNC_SLAVE) && (ucType == TSYNC_SYNC))
+	{
+		pstSync->usSeq = usSeq;
+		pstSync->ullStart = ullRxTime;
+		pstSync->ullT2 = ullRxTime;
+		pstSync->ucState = TSYNC_STATE_WAIT_FOLLOW_UP;
+		return;
+	}
+	if(usSeq != pstSync->usSeq)
+	{
+		return;
+	}
+
+	switch(pstSync->ucState)
+	{
+		case TSYNC_STATE_WAIT_FOLLOW_UP:
+			if((ucType == TSYNC_FOLLOW_UP) && (ulLen >= TSYNC_OFS_STAMP1))
+			{
+				pstSync->ullT1 = TsyncGetStamp(&pucMsg[TSYNC_OFS_STAMP0]);
+				pstSync->ucState = TSYNC_STATE_REQ;
+				/* send the request straight away rather than on the next
+					poll */
+				TsyncPoll(pstSync, ullRxTime);
+			}
+			break;
+
+		case TSYNC_STATE_WAIT_RESP:
+			if((ucType == TSYNC_DELAY_RESP) && (ulLen >= TSYNC_OFS_STAMP1))
+			{
+				pstSync->ullT4 = TsyncGetStamp(&pucMsg[TSYNC_OFS_STAMP0]);
+				pstSync->ucState = TSYNC_STATE_IDLE;
+				TsyncUpdate(pstSync);
+			}
+			break;
+
+		case TSYNC_STATE_WAIT_REQ:
+			if(ucType == TSYNC_DELAY_REQ)
+			{
+				pstSync->ullT4 = ullRxTime;
+				pstSync->ucState = TSYNC_STATE_WAIT_FOLLOW;
+			}
+			break;
+
+		case TSYNC_STATE_WAIT_FOLLOW:
+			if((ucType == TSYNC_DELAY_FOLLOW) && (ulLen >= TSYNC_MSG_MAX))
+			{
+				pstSync->ullT2 = TsyncGetStamp(&pucMsg[TSYNC_OFS_STAMP0]);
+				pstSync->ullT3 = TsyncGetStamp(&pucMsg[TSYNC_OFS_STAMP1]);
+				pstSync->ucState = TSYNC_STATE_RESP;
+				TsyncUpdate(pstSync);
+				TsyncPoll(pstSync, ullRxTime);
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/** ***************************************************************************
+	Name:               TsyncDiffNs
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             ullA - ullB in ns
+	Caveats / Effect:   Only for differences under 2^31 seconds
+
+	Description:
+	Subtracts two tPpsTime values and converts the difference to ns, taking
+	the whole seconds and the fraction separately so that nothing overflows.
+*/
+int64_t TsyncDiffNs(uint64_t ullA, uint64_t ullB)
+{
+	int64_t const llDiff = (int64_t)(ullA - ullB);
+
+	/* the arithmetic shift floors the seconds, leaving a positive fraction */
+	return (llDiff >> 32) * 1000000000LL
+		+ (int64_t)(((uint64_t)llDiff & 0xFFFFFFFFULL) * 1000000000ULL >> 32);
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TsyncSend
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if the message went out, -1 if the link was busy
+	Caveats / Effect:   None
+
+	Description:
+	Builds a message of type ucType carrying the first ulStamps of ullStamp0
+	and ullStamp1, with the sequence number of the exchange, and hands it to
+	the link. The time it went out is stored in *pullTxTime if that isn't
+	NULL.
+*/
+static int TsyncSend(tTsync *pstSync, uint8_t ucType, uint32_t ulStamps,
+	uint64_t ullStamp0, uint64_t ullStamp1, uint64_t *pullTxTime)
+{
+	uint8_t aucMsg[TSYNC_MSG_MAX];
+	uint64_t ullTxTime;
+
+	aucMsg[0] = TSYNC_MAGIC0;
+	aucMsg[1] = TSYNC_MAGIC1;
+	aucMsg[TSYNC_OFS_TYPE] = ucType;
+	aucMsg[TSYNC_OFS_TYPE + 1] = 0;
+	aucMsg[TSYNC_OFS_SEQ] = (uint8_t)pstSync->usSeq;
+	aucMsg[TSYNC_OFS_SEQ + 1] = (uint8_t)(pstSync->usSeq >> 8);
+	TsyncPutStamp(&aucMsg[TSYNC_OFS_STAMP0], ullStamp0);
+	TsyncPutStamp(&aucMsg[TSYNC_OFS_STAMP1], ullStamp1);
+
+	if(pstSync->pfnSend(pstSync->pvContext, aucMsg,
+		(uint32_t)(TSYNC_HEADER_LEN + ulStamps * sizeof(uint64_t)), &ullTxTime)
+		!= 0)
+	{
+		return -1;
+	}
+	if(pullTxTime != NULL)
+	{
+		*pullTxTime = ullTxTime;
+	}
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               TsyncUpdate
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Works out the path delay and the offset of the slave's clock from the
+	four times of a completed exchange:
+
+		t2 - t1 = delay master to slave + offset
+		t4 - t3 = delay slave to master - offset
+
+	The sum gives twice the mean path delay, which is filtered. An exchange
+	whose delay is well above the filtered one was held up on the way and
+	is dropped. The offset is then t2 - t1 less the delay master to slave,
+	which is the mean path delay plus half the asymmetry.
+*/
+static void TsyncUpdate(tTsync *pstSync)
+{
+	int64_t const llMs = TsyncDiffNs(pstSync->ullT2, pstSync->ullT1);
+	int64_t const llSm = TsyncDiffNs(pstSync->ullT4, pstSync->ullT3);
+	int64_t const llDelay = (llMs + llSm) / 2;
+
+	if(!pstSync->ucValid)
+	{
+		pstSync->llDelayNs = llDelay;
+	}
+	else if(llDelay > pstSync->llDelayNs + TSYNC_DELAY_GATE_NS)
+	{
+		pstSync->ulRejected++;
+		return;
+	}
+	else
+	{
+		/* divide rather than shift so negative steps round like positive */
+		pstSync->llDelayNs += (llDelay - pstSync->llDelayNs)
+			/ (1 << TSYNC_DELAY_SHIFT);
+	}
+
+	pstSync->llOffsetNs = llMs - pstSync->llDelayNs
+		- pstSync->lAsymmetryNs / 2;
+	pstSync->ucValid = 1;
+	pstSync->ulExchanges++;
+}
+
+/** ***************************************************************************
+	Name:               TsyncPutStamp
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Writes a timestamp into a message, least significant byte first.
+*/
+static void TsyncPutStamp(uint8_t *pucDst, uint64_t ullStamp)
+{
+	uint32_t i;
+
+	for(i = 0; i < sizeof(uint64_t); i++)
+	{
+		pucDst[i] = (uint8_t)(ullStamp >> (8 * i));
+	}
+}
+
+/** ***************************************************************************
+	Name:               TsyncGetStamp
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Timestamp read from a message
+	Caveats / Effect:   None
+
+	Description:
+	Reads a timestamp written by TsyncPutStamp().
+*/
+static uint64_t TsyncGetStamp(uint8_t const *pucSrc)
+{
+	uint64_t ullStamp = 0;
+	uint32_t i;
+
+	for(i = sizeof(uint64_t); i > 0; i--)
+	{
+		ullStamp = (ullStamp << 8) | pucSrc[i - 1];
+	}
+	return ullStamp;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,122 @@
+/** ***************************************************************************
+File Name:  tsync.h
+
+Project:    Platform 4
+
+Purpose:    Two-way time transfer over a data channel link: message
+            exchange, path delay and clock offset, in the manner of PTP
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef TSYNC_H
+#define TSYNC_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* time between exchanges started by the master, and how long either end
+	waits for the next message of an exchange before giving up on it */
+#ifndef TSYNC_INTERVAL_MS
+#define TSYNC_INTERVAL_MS    1000
+#endif
+#ifndef TSYNC_TIMEOUT_MS
+#define TSYNC_TIMEOUT_MS     100
+#endif
+
+/* an exchange whose path delay exceeds the filtered delay by more than this
+	was held up somewhere (a late stamp) and is discarded */
+#ifndef TSYNC_DELAY_GATE_NS
+#define TSYNC_DELAY_GATE_NS  2000
+#endif
+
+/* message payload: TSYNC_MAGIC0/1, type, 0, sequence number and up to two
+	timestamps, multi-byte fields little endian */
+#define TSYNC_MAGIC0         0x54
+#define TSYNC_MAGIC1         0x53
+#define TSYNC_MSG_MAX        22
+
+/* message types. The master sends SYNC and then FOLLOW_UP with the time
+	SYNC went out (t1). The slave stamps SYNC in (t2), sends DELAY_REQ and
+	then DELAY_FOLLOW with t2 and the time DELAY_REQ went out (t3). The
+	master stamps DELAY_REQ in (t4) and returns it in DELAY_RESP, so both
+	ends end up with all four times */
+#define TSYNC_SYNC           1
+#define TSYNC_FOLLOW_UP      2
+#define TSYNC_DELAY_REQ      3
+#define TSYNC_DELAY_FOLLOW   4
+#define TSYNC_DELAY_RESP     5
+
+/* roles */
+#define TSYNC_MASTER         0
+#define TSYNC_SLAVE          1
+
+
+/* Module Type Definitions */
+
+/* sends a message payload out the link, returning 0 and the time the
+	transmission started in *pullTxTime, or -1 if the link is busy */
+typedef int (*tTsyncSend)(void *pvContext, uint8_t const *pucMsg,
+	uint32_t ulLen, uint64_t *pullTxTime);
+
+/* one end of the exchange. Times are PPS times (tPpsTime) of this end */
+typedef struct
+{
+	uint8_t ucRole;
+	/* exchange state, TSYNC_STATE_x in tsync.c, its sequence number and
+		when it started */
+	uint8_t ucState;
+	uint16_t usSeq;
+	uint64_t ullStart;
+	/* the four times of the exchange in progress */
+	uint64_t ullT1;
+	uint64_t ullT2;
+	uint64_t ullT3;
+	uint64_t ullT4;
+	/* path delay master to slave minus slave to master, in ns, which the
+		exchange can't see by itself */
+	int32_t lAsymmetryNs;
+	/* results: offset of the slave's clock from the master's, from the last
+		exchange, and the filtered mean path delay, both in ns; ucValid is set
+		once there is a result */
+	int64_t llOffsetNs;
+	int64_t llDelayNs;
+	uint8_t ucValid;
+	/* statistics */
+	uint32_t ulExchanges;
+	uint32_t ulTimeouts;
+	uint32_t ulRejected;
+	/* transmit hook */
+	tTsyncSend pfnSend;
+	void *pvContext;
+} tTsync;
+
+
+/* Global Function Declarations */
+
+void TsyncInit(tTsync *pstSync, uint8_t ucRole, int32_t lAsymmetryNs,
+	tTsyncSend pfnSend, void *pvContext);
+void TsyncPoll(tTsync *pstSync, uint64_t ullNow);
+int TsyncIsMessage(uint8_t const *pucMsg, uint32_t ulLen);
+void TsyncReceive(tTsync *pstSync, uint8_t const *pucMsg, uint32_t ulLen,
+	uint64_t ullRxTime);
+int64_t TsyncDiffNs(uint64_t ullA, uint64_t ullB);
+
+
+#endif /* TSYNC_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,309 @@
+/** ***************************************************************************
+File Name:  udp_bridge.c
+
+Project:    Platform 4
+
+Purpose:    Zero-copy bridge from a link's receive DMA ring to UDP datagrams
+            sent out the Ethernet port
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "net.h"
+#include "udp_bridge.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static void UdpBridgePollBurst(tUdpBridge *pstBridge);
+static void UdpBridgeSent(void *pvArg, int iStatus);
+
+
+/* Module Variable Declarations */
+
+static tUdpBridge astUdpBridge[LINK_COUNT];
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               UdpBridgeStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The link's ring must only be read by the bridge from
+	                    now on
+
+	Description:
+	Bridges a link to UDP port usPort of NET_UDP_DEST_ADDR: the received byte
+	stream is sent directly out of the receive DMA ring by UdpBridgePoll(),
+	without copying. With a burst buffer (pstBurst not NULL) the data goes
+	through it instead, so it survives the network going away for a while.
+*/
+void UdpBridgeStart(uint32_t ulIndex, tLink *pstLink, uint16_t usPort,
+	tBurst *pstBurst)
+{
+	tUdpBridge *pstBridge = &astUdpBridge[ulIndex];
+
+	memset(pstBridge, 0, sizeof(*pstBridge));
+	pstBridge->usPort = usPort;
+	pstBridge->pstBurst = pstBurst;
+	pstBridge->pstLink = pstLink;
+}
+
+/** ***************************************************************************
+	Name:               UdpBridgePoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Call from the main program loop, after NetPoll()
+
+	Description:
+	Sends the next datagram when the previous one has gone. The GMAC DMA
+	reads the datagram straight out of the ring; it is released back to the
+	receive DMA by UdpBridgeSent() once the frame is out. While data is
+	flowing only full datagrams are sent, or whatever is left before the end
+	of the ring; once the line has gone idle at the end of a queued packet,
+	everything up to that point goes out, so a packet never shares a
+	datagram with the next one.
+	Until the network is ready received data is thrown away, so the
+	destination doesn't get a burst of stale data when it is.
+	With a burst buffer, see UdpBridgePollBurst().
+*/
+void UdpBridgePoll(uint32_t ulIndex)
+{
+	tUdpBridge *pstBridge = &astUdpBridge[ulIndex];
+	tLink *pstLink = pstBridge->pstLink;
+	tRxRing *pstRing;
+	uint8_t const *pucData;
+	uint32_t ulLen;
+	uint32_t ulEnd;
+
+	if(pstBridge->pstBurst)
+	{
+		UdpBridgePollBurst(pstBridge);
+		return;
+	}
+	if(!pstLink || pstBridge->ulInFlight)
+	{
+		return;
+	}
+	pstRing = &pstLink->stRxRing;
+
+	/* packets that have been sent right up to their end are finished */
+	while(LinkRxPacket(pstLink, &ulEnd)
+		&& ((int32_t)(ulEnd - pstRing->ulReadCount) <= 0))
+	{
+		LinkRxPacketDone(pstLink);
+	}
+
+	ulLen = RxRingPeek(pstRing, &pucData);
+
+	if(!NetReady())
+	{
+		RxRingConsume(pstRing, ulLen);
+		pstBridge->ulDiscarded += ulLen;
+		return;
+	}
+
+	if(LinkRxPacket(pstLink, &ulEnd))
+	{
+		/* the line went idle at ulEnd, send everything up to there. If the
+			packet wraps around the ring the next poll sends the rest */
+		if(ulLen > ulEnd - pstRing->ulReadCount)
+		{
+			ulLen = ulEnd - pstRing->ulReadCount;
+		}
+	}
+	else if((ulLen < NET_UDP_MAX_PAYLOAD)
+		&& (pucData + ulLen != &pstRing->aucData[RX_RING_SIZE]))
+	{
+		/* wait for a full datagram */
+		return;
+	}
+	if(ulLen > NET_UDP_MAX_PAYLOAD)
+	{
+		ulLen = NET_UDP_MAX_PAYLOAD;
+	}
+	if(ulLen == 0)
+	{
+		return;
+	}
+
+	pstBridge->ulInFlight = ulLen;
+	if(NetUdpSend(pstBridge->usPort, pucData, ulLen, UdpBridgeSent,
+		pstBridge) != 0)
+	{
+		/* the transmit ring is full, try again later */
+		pstBridge->ulInFlight = 0;
+	}
+}
+
+/** ***************************************************************************
+	Name:               UdpBridgeGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Bridge state of a link
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to the bridge statistics.
+*/
+tUdpBridge const *UdpBridgeGet(uint32_t ulIndex)
+{
+	return &astUdpBridge[ulIndex];
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               UdpBridgePollBurst
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Main program loop only, after NetPoll()
+
+	Description:
+	UdpBridgePoll() for a link fed through a burst buffer. The receive ring
+	is emptied into the buffer on every call, whatever the network is doing,
+	and datagrams are cut from the buffer the way they would be from the
+	ring, at the packet ends it kept. Data is only thrown away before the
+	network is first ready; after that it is held while the PHY link is
+	down or the destination's address is being looked up again, and a
+	backlog drains as fast as the transmit ring takes it.
+*/
+static void UdpBridgePollBurst(tUdpBridge *pstBridge)
+{
+	tBurst *pstBurst = pstBridge->pstBurst;
+	uint8_t const *pucData;
+	uint32_t ulLen;
+	uint32_t ulEnd;
+
+	BurstFill(pstBurst);
+
+	if(pstBridge->ulInFlight)
+	{
+		return;
+	}
+
+	/* packets that have been sent right up to their end are finished */
+	while(BurstPacket(pstBurst, &ulEnd)
+		&& ((int32_t)(ulEnd - pstBurst->ulReadCount) <= 0))
+	{
+		BurstPacketDone(pstBurst);
+	}
+
+	ulLen = BurstPeek(pstBurst, &pucData);
+
+	if(!NetReady())
+	{
+		if(!pstBridge->ucWasReady)
+		{
+			BurstConsume(pstBurst, ulLen);
+			pstBridge->ulDiscarded += ulLen;
+		}
+		return;
+	}
+	pstBridge->ucWasReady = 1;
+
+	if(BurstPacket(pstBurst, &ulEnd))
+	{
+		/* the line went idle at ulEnd, send everything up to there */
+		if(ulLen > ulEnd - pstBurst->ulReadCount)
+		{
+			ulLen = ulEnd - pstBurst->ulReadCount;
+		}
+	}
+	else if((ulLen < NET_UDP_MAX_PAYLOAD)
+		&& (pucData + ulLen != &pstBurst->pucData[BURST_SIZE]))
+	{
+		/* wait for a full datagram */
+		return;
+	}
+	if(ulLen > NET_UDP_MAX_PAYLOAD)
+	{
+		ulLen = NET_UDP_MAX_PAYLOAD;
+	}
+	if(ulLen == 0)
+	{
+		return;
+	}
+
+	pstBridge->ulInFlight = ulLen;
+	if(NetUdpSend(pstBridge->usPort, pucData, ulLen, UdpBridgeSent,
+		pstBridge) != 0)
+	{
+		/* the transmit ring is full, try again later */
+		pstBridge->ulInFlight = 0;
+	}
+}
+
+/** ***************************************************************************
+	Name:               UdpBridgeSent
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Called from NetPoll()
+
+	Description:
+	Datagram completion. The ring or burst buffer space the GMAC was reading
+	from is released, whether or not the frame went out.
+*/
+static void UdpBridgeSent(void *pvArg, int iStatus)
+{
+	tUdpBridge *pstBridge = (tUdpBridge *)pvArg;
+
+	if(iStatus == 0)
+	{
+		pstBridge->ulDatagrams++;
+		pstBridge->ulBytes += pstBridge->ulInFlight;
+	}
+	else
+	{
+		pstBridge->ulErrors++;
+	}
+	if(pstBridge->pstBurst)
+	{
+		BurstConsume(pstBridge->pstBurst, pstBridge->ulInFlight);
+	}
+	else
+	{
+		RxRingConsume(&pstBridge->pstLink->stRxRing, pstBridge->ulInFlight);
+	}
+	pstBridge->ulInFlight = 0;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,71 @@
+/** ***************************************************************************
+File Name:  udp_bridge.h
+
+Project:    Platform 4
+
+Purpose:    Zero-copy bridge from a link's receive DMA ring to UDP datagrams
+            sent out the Ethernet port
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef UDP_BRIDGE_H
+#define UDP_BRIDGE_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "burst.h"
+#include "link.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* bridge state of one link */
+typedef struct
+{
+	/* link whose receive ring feeds the datagrams, NULL if not bridged, and
+		the burst buffer the data goes through, NULL if it is sent straight
+		out of the ring */
+	tLink *pstLink;
+	tBurst *pstBurst;
+	/* UDP port the datagrams go to and come from */
+	uint16_t usPort;
+	/* bytes of the ring or burst buffer handed to the GMAC, 0 if no
+		datagram is going out */
+	uint32_t ulInFlight;
+	/* the network has been ready at least once */
+	uint8_t ucWasReady;
+	/* statistics */
+	uint32_t ulDatagrams;
+	uint32_t ulBytes;
+	uint32_t ulErrors;
+	uint32_t ulDiscarded;
+} tUdpBridge;
+
+
+/* Global Function Declarations */
+
+void UdpBridgeStart(uint32_t ulIndex, tLink *pstLink, uint16_t usPort,
+	tBurst *pstBurst);
+void UdpBridgePoll(uint32_t ulIndex);
+tUdpBridge const *UdpBridgeGet(uint32_t ulIndex);
+
+
+#endif /* UDP_BRIDGE_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
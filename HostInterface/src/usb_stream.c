@@ -0,0 +1,399 @@
+/** ***************************************************************************
+File Name:  usb_stream.c
+
+Project:    Platform 4
+
+Purpose:    Vendor specific USB interface for bulk data streaming: one bulk IN
+            and one bulk OUT endpoint, each with a queue of transfers
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <string.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "usb_stream.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* one queued transfer */
+typedef struct
+{
+	uint8_t *pucBuf;
+	uint32_t ulLen;
+	/* end an IN transfer with a short (or zero length) packet */
+	uint8_t ucEnd;
+	tUsbStreamDone pfnDone;
+} tUsbStreamJob;
+
+/* transfer queue of one endpoint. The driver (udd) runs one job per
+	endpoint at a time, so the job at the head is the one running and the
+	others are started from the completion interrupt, back to back */
+typedef struct
+{
+	tUsbStreamJob astJob[USB_STREAM_JOBS];
+	udd_ep_id_t ucEp;
+	udd_callback_trans_t pfnCallback;
+	uint8_t ucHead;
+	uint8_t ucCount;
+} tUsbStreamQueue;
+
+
+/* Module Function Declarations */
+
+static bool UsbStreamEnable(void);
+static void UsbStreamDisable(void);
+static bool UsbStreamSetup(void);
+static uint8_t UsbStreamGetSetting(void);
+static int UsbStreamSubmit(tUsbStreamQueue *pstQueue, uint8_t *pucBuf,
+	uint32_t ulLen, uint8_t ucEnd, tUsbStreamDone pfnDone);
+static bool UsbStreamRun(tUsbStreamQueue *pstQueue);
+static void UsbStreamComplete(tUsbStreamQueue *pstQueue,
+	udd_ep_status_t status, iram_size_t nb_transfered);
+static void UsbStreamInDone(udd_ep_status_t status, iram_size_t nb_transfered,
+	udd_ep_id_t ep);
+static void UsbStreamOutDone(udd_ep_status_t status, iram_size_t nb_transfered,
+	udd_ep_id_t ep);
+
+
+/* Module Variable Declarations */
+
+static tUsbStreamQueue stInQueue = {
+	.ucEp = USB_STREAM_EP_IN,
+	.pfnCallback = UsbStreamInDone,
+};
+static tUsbStreamQueue stOutQueue = {
+	.ucEp = USB_STREAM_EP_OUT,
+	.pfnCallback = UsbStreamOutDone,
+};
+
+/* the host has selected the configuration */
+static volatile uint8_t ucStreamEnabled = 0;
+
+
+/* Global Variables (Must be justified!) */
+
+/* referenced by the composite device descriptors (udi_composite_desc.c) */
+UDC_DESC_STORAGE udi_api_t udi_api_stream = {
+	.enable = UsbStreamEnable,
+	.disable = UsbStreamDisable,
+	.setup = UsbStreamSetup,
+	.getsetting = UsbStreamGetSetting,
+	.sof_notify = NULL,
+};
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               UsbStreamWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if queued, -1 if the interface isn't enabled or the
+	                    queue is full
+	Caveats / Effect:   pucBuf must stay untouched until pfnDone is called
+
+	Description:
+	Queues a device to host transfer of any length; it is split into packets
+	by the driver. ucEnd ends the transfer with a short packet (a zero length
+	packet if ulLen is a multiple of the packet size), completing the host's
+	read; otherwise the host read carries on into the next transfer.
+	pfnDone may be NULL.
+*/
+int UsbStreamWrite(uint8_t *pucBuf, uint32_t ulLen, uint8_t ucEnd,
+	tUsbStreamDone pfnDone)
+{
+	return UsbStreamSubmit(&stInQueue, pucBuf, ulLen, ucEnd, pfnDone);
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamRead
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if queued, -1 if the interface isn't enabled or the
+	                    queue is full
+	Caveats / Effect:   ulLen should be a multiple of the packet size (512)
+
+	Description:
+	Queues a host to device transfer. It completes when ulLen bytes have been
+	received or the host ends its transfer with a short packet. The driver
+	invalidates the buffer in the data cache once the DMA is done, so it
+	should come from DmaBufAlloc() or be line aligned and padded.
+*/
+int UsbStreamRead(uint8_t *pucBuf, uint32_t ulLen, tUsbStreamDone pfnDone)
+{
+	return UsbStreamSubmit(&stOutQueue, pucBuf, ulLen, 0, pfnDone);
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamIsEnabled
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             1 if the host has configured the interface
+	Caveats / Effect:   None
+
+	Description:
+	Reports whether transfers can be queued.
+*/
+uint8_t UsbStreamIsEnabled(void)
+{
+	return ucStreamEnabled;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               UsbStreamEnable
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             true
+	Caveats / Effect:   Called by the USB device core
+
+	Description:
+	The host has selected the configuration, the endpoints are allocated.
+*/
+static bool UsbStreamEnable(void)
+{
+	stInQueue.ucHead = 0;
+	stInQueue.ucCount = 0;
+	stOutQueue.ucHead = 0;
+	stOutQueue.ucCount = 0;
+	ucStreamEnabled = 1;
+	return true;
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamDisable
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Called by the USB device core
+
+	Description:
+	The configuration is going away. Freeing the endpoints aborts the running
+	jobs, which fails the rest of the queues through UsbStreamComplete().
+*/
+static void UsbStreamDisable(void)
+{
+	ucStreamEnabled = 0;
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamSetup
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             false, the request is stalled
+	Caveats / Effect:   Called by the USB device core
+
+	Description:
+	The interface has no class or vendor requests.
+*/
+static bool UsbStreamSetup(void)
+{
+	return false;
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamGetSetting
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0, there are no alternate settings
+	Caveats / Effect:   Called by the USB device core
+
+	Description:
+	Returns the alternate setting in use.
+*/
+static uint8_t UsbStreamGetSetting(void)
+{
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamSubmit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if queued, -1 otherwise
+	Caveats / Effect:   None
+
+	Description:
+	Adds a job to an endpoint queue, starting it if the endpoint is idle.
+*/
+static int UsbStreamSubmit(tUsbStreamQueue *pstQueue, uint8_t *pucBuf,
+	uint32_t ulLen, uint8_t ucEnd, tUsbStreamDone pfnDone)
+{
+	irqflags_t flags = cpu_irq_save();
+	tUsbStreamJob *pstJob;
+
+	if(!ucStreamEnabled || (pstQueue->ucCount == USB_STREAM_JOBS))
+	{
+		cpu_irq_restore(flags);
+		return -1;
+	}
+
+	pstJob = &pstQueue->astJob[(pstQueue->ucHead + pstQueue->ucCount)
+		% USB_STREAM_JOBS];
+	pstJob->pucBuf = pucBuf;
+	pstJob->ulLen = ulLen;
+	pstJob->ucEnd = ucEnd;
+	pstJob->pfnDone = pfnDone;
+	pstQueue->ucCount++;
+
+	/* the endpoint is idle, start the job now; otherwise it follows on from
+		the completion of the one ahead of it */
+	if((pstQueue->ucCount == 1) && !UsbStreamRun(pstQueue))
+	{
+		pstQueue->ucCount = 0;
+		cpu_irq_restore(flags);
+		return -1;
+	}
+
+	cpu_irq_restore(flags);
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamRun
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             false if the endpoint is halted or not configured
+	Caveats / Effect:   Interrupts must be disabled
+
+	Description:
+	Hands the job at the head of a queue to the driver.
+*/
+static bool UsbStreamRun(tUsbStreamQueue *pstQueue)
+{
+	tUsbStreamJob const *pstJob = &pstQueue->astJob[pstQueue->ucHead];
+
+	return udd_ep_run(pstQueue->ucEp, pstJob->ucEnd, pstJob->pucBuf,
+		pstJob->ulLen, pstQueue->pfnCallback);
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamComplete
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   USB ISR
+
+	Description:
+	Retires the job at the head of a queue. The next job is started before
+	the completion is reported, so the endpoint isn't left idle while the
+	application deals with it. If the job was aborted, the endpoint is going
+	away (or was halted) and the jobs behind it are failed too.
+*/
+static void UsbStreamComplete(tUsbStreamQueue *pstQueue,
+	udd_ep_status_t status, iram_size_t nb_transfered)
+{
+	tUsbStreamJob stJob;
+	int iStatus = (status == UDD_EP_TRANSFER_OK) ? 0 : -1;
+
+	if(pstQueue->ucCount == 0)
+	{
+		return;
+	}
+
+	stJob = pstQueue->astJob[pstQueue->ucHead];
+	pstQueue->ucHead = (pstQueue->ucHead + 1) % USB_STREAM_JOBS;
+	pstQueue->ucCount--;
+
+	if((iStatus == 0) && pstQueue->ucCount && !UsbStreamRun(pstQueue))
+	{
+		iStatus = -1;
+	}
+
+	if(stJob.pfnDone)
+	{
+		stJob.pfnDone(stJob.pucBuf, nb_transfered, iStatus);
+	}
+
+	/* fail everything queued behind an aborted job */
+	while((iStatus != 0) && pstQueue->ucCount)
+	{
+		stJob = pstQueue->astJob[pstQueue->ucHead];
+		pstQueue->ucHead = (pstQueue->ucHead + 1) % USB_STREAM_JOBS;
+		pstQueue->ucCount--;
+		if(stJob.pfnDone)
+		{
+			stJob.pfnDone(stJob.pucBuf, 0, -1);
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamInDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   USB ISR
+
+	Description:
+	Bulk IN transfer completion.
+*/
+static void UsbStreamInDone(udd_ep_status_t status, iram_size_t nb_transfered,
+	udd_ep_id_t ep)
+{
+	UNUSED(ep);
+	UsbStreamComplete(&stInQueue, status, nb_transfered);
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamOutDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   USB ISR
+
+	Description:
+	Bulk OUT transfer completion.
+*/
+static void UsbStreamOutDone(udd_ep_status_t status, iram_size_t nb_transfered,
+	udd_ep_id_t ep)
+{
+	UNUSED(ep);
+	UsbStreamComplete(&stOutQueue, status, nb_transfered);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,119 @@
+/** ***************************************************************************
+File Name:  usb_stream.h
+
+Project:    Platform 4
+
+Purpose:    Vendor specific USB interface for bulk data streaming: one bulk IN
+            and one bulk OUT endpoint, each with a queue of transfers
+
+Program:    Host Interface
+
+Compiler:   This program was developed using AtmelStudio 7
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef USB_STREAM_H
+#define USB_STREAM_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+/* included from conf_usb.h, so only the USB stack headers can be used */
+#include "conf_usb.h"
+#include "usb_protocol.h"
+#include "udd.h"
+#include "udc_desc.h"
+#include "udi.h"
+
+
+/* Module Definitions */
+
+/* number of transfers that can be queued in each direction */
+#ifndef USB_STREAM_JOBS
+#define USB_STREAM_JOBS 4
+#endif
+
+/* bulk endpoint sizes */
+#define USB_STREAM_EPS_FS_SIZE 64
+#define USB_STREAM_EPS_HS_SIZE 512
+
+/* interface descriptor contents, for UDI_COMPOSITE_DESC_FS/HS in conf_usb.h.
+	USB_STREAM_EP_IN, USB_STREAM_EP_OUT and USB_STREAM_IFACE_NUMBER are
+	defined in conf_usb.h */
+#define USB_STREAM_DESC_COMMON \
+	.iface.bLength            = sizeof(usb_iface_desc_t), \
+	.iface.bDescriptorType    = USB_DT_INTERFACE, \
+	.iface.bInterfaceNumber   = USB_STREAM_IFACE_NUMBER, \
+	.iface.bAlternateSetting  = 0, \
+	.iface.bNumEndpoints      = 2, \
+	.iface.bInterfaceClass    = CLASS_VENDOR_SPECIFIC, \
+	.iface.bInterfaceSubClass = 0, \
+	.iface.bInterfaceProtocol = 0, \
+	.iface.iInterface         = 0, \
+	.ep_in.bLength            = sizeof(usb_ep_desc_t), \
+	.ep_in.bDescriptorType    = USB_DT_ENDPOINT, \
+	.ep_in.bEndpointAddress   = USB_STREAM_EP_IN, \
+	.ep_in.bmAttributes       = USB_EP_TYPE_BULK, \
+	.ep_in.bInterval          = 0, \
+	.ep_out.bLength           = sizeof(usb_ep_desc_t), \
+	.ep_out.bDescriptorType   = USB_DT_ENDPOINT, \
+	.ep_out.bEndpointAddress  = USB_STREAM_EP_OUT, \
+	.ep_out.bmAttributes      = USB_EP_TYPE_BULK, \
+	.ep_out.bInterval         = 0,
+
+#define USB_STREAM_DESC_FS { \
+	USB_STREAM_DESC_COMMON \
+	.ep_in.wMaxPacketSize     = LE16(USB_STREAM_EPS_FS_SIZE), \
+	.ep_out.wMaxPacketSize    = LE16(USB_STREAM_EPS_FS_SIZE), \
+	}
+
+#define USB_STREAM_DESC_HS { \
+	USB_STREAM_DESC_COMMON \
+	.ep_in.wMaxPacketSize     = LE16(USB_STREAM_EPS_HS_SIZE), \
+	.ep_out.wMaxPacketSize    = LE16(USB_STREAM_EPS_HS_SIZE), \
+	}
+
+
+/* Module Type Definitions */
+
+/* interface descriptor */
+COMPILER_PACK_SET(1)
+typedef struct
+{
+	usb_iface_desc_t iface;
+	usb_ep_desc_t ep_in;
+	usb_ep_desc_t ep_out;
+} tUsbStreamDesc;
+COMPILER_PACK_RESET()
+
+/* transfer completion, called from the USB ISR with the number of bytes
+	transferred; iStatus is 0, or -1 if the transfer was aborted */
+typedef void (*tUsbStreamDone)(uint8_t *pucBuf, uint32_t ulLen, int iStatus);
+
+
+/* Global Variables */
+
+/* interface API for the USB device core, UDI_COMPOSITE_API in conf_usb.h */
+extern UDC_DESC_STORAGE udi_api_t udi_api_stream;
+
+
+/* Global Function Declarations */
+
+int UsbStreamWrite(uint8_t *pucBuf, uint32_t ulLen, uint8_t ucEnd,
+	tUsbStreamDone pfnDone);
+int UsbStreamRead(uint8_t *pucBuf, uint32_t ulLen, tUsbStreamDone pfnDone);
+uint8_t UsbStreamIsEnabled(void);
+
+
+#endif /* USB_STREAM_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
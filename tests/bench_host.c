@@ -0,0 +1,112 @@
+/** ***************************************************************************
+File Name:  bench_host.c
+
+Project:    Platform 4
+
+Purpose:    Runs the data channel benchmarks of bench.c on the host, timed
+            with the host's cycle counter, see "make -C tests bench"
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Local Include Files */
+#include "bench.h"
+#include "crc.h"
+
+
+/* Module Definitions */
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static uint32_t BenchHostCycles(void);
+
+
+/* Module Variable Declarations */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0
+	Caveats / Effect:   None
+
+	Description:
+	Runs the benchmarks once and prints a line per result, as RunBenchmark()
+	in main.c does to the USB console. The counts are of the host's cycle
+	counter, so they compare the routines with each other on the host, not
+	with the target.
+*/
+int main(void)
+{
+	tBenchResult astResults[BENCH_RESULTS];
+	uint32_t ulCount;
+	uint32_t i;
+
+	CrcInit();
+	ulCount = BenchRun(BenchHostCycles, astResults);
+
+	for(i = 0; i < ulCount; i++)
+	{
+		char acLine[96];
+
+		BenchFormat(&astResults[i], acLine, sizeof(acLine));
+		fputs(acLine, stdout);
+	}
+	return 0;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               BenchHostCycles
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Current cycle count, low 32 bits
+	Caveats / Effect:   None
+
+	Description:
+	The time stamp counter on x86, read with the compiler builtin as the
+	intrinsics headers clash with the register qualifiers of stubs/compiler.h,
+	otherwise the monotonic clock in ns. The benchmarks take differences, so
+	the wrap of the low 32 bits is harmless.
+*/
+static uint32_t BenchHostCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return (uint32_t)__builtin_ia32_rdtsc();
+#else
+	struct timespec stNow;
+
+	clock_gettime(CLOCK_MONOTONIC, &stNow);
+	return (uint32_t)((uint64_t)stNow.tv_sec * 1000000000ULL
+		+ (uint64_t)stNow.tv_nsec);
+#endif
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,178 @@
+/** ***************************************************************************
+File Name:  arm_math.h
+
+Project:    Platform 4
+
+Purpose:    Host build stand-in for the CMSIS-DSP functions the tested
+            modules use, written for clarity rather than speed; the real FFT
+            is a plain DFT with the same output packing
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef TEST_ARM_MATH_H
+#define TEST_ARM_MATH_H
+
+/* System Include Files */
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/* Module Definitions */
+
+#define PI                   3.14159265358979f
+
+/* largest real FFT CMSIS-DSP has */
+#define TEST_RFFT_MAX        4096
+
+
+/* Module Type Definitions */
+
+typedef float float32_t;
+typedef int16_t q15_t;
+
+typedef enum
+{
+	ARM_MATH_SUCCESS = 0,
+	ARM_MATH_ARGUMENT_ERROR = -1
+} arm_status;
+
+typedef struct
+{
+	uint16_t fftLenRFFT;
+} arm_rfft_fast_instance_f32;
+
+
+/* Global Function Implementations */
+
+static inline arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S,
+	uint16_t fftLen)
+{
+	if((fftLen < 32) || (fftLen > TEST_RFFT_MAX) || (fftLen & (fftLen - 1)))
+	{
+		return ARM_MATH_ARGUMENT_ERROR;
+	}
+	S->fftLenRFFT = fftLen;
+	return ARM_MATH_SUCCESS;
+}
+
+/* forward transform only. Output: the real DC and half sample rate terms,
+	then the real and imaginary parts of bins 1 to fftLen / 2 - 1. The input
+	is scratch space, as in CMSIS-DSP, and is left scrambled */
+static inline void arm_rfft_fast_f32(arm_rfft_fast_instance_f32 *S,
+	float32_t *p, float32_t *pOut, uint8_t ifftFlag)
+{
+	static double adCos[TEST_RFFT_MAX];
+	static double adSin[TEST_RFFT_MAX];
+	static uint32_t ulTableLen;
+	uint32_t const ulLen = S->fftLenRFFT;
+	uint32_t k;
+	uint32_t i;
+
+	(void)ifftFlag;
+	if(ulTableLen != ulLen)
+	{
+		for(i = 0; i < ulLen; i++)
+		{
+			adCos[i] = cos(2.0 * M_PI * (double)i / (double)ulLen);
+			adSin[i] = sin(2.0 * M_PI * (double)i / (double)ulLen);
+		}
+		ulTableLen = ulLen;
+	}
+
+	for(k = 0; k <= ulLen / 2; k++)
+	{
+		double dRe = 0.0;
+		double dIm = 0.0;
+
+		for(i = 0; i < ulLen; i++)
+		{
+			uint32_t const ulPhase = (k * i) % ulLen;
+
+			dRe += (double)p[i] * adCos[ulPhase];
+			dIm -= (double)p[i] * adSin[ulPhase];
+		}
+		if(k == 0)
+		{
+			pOut[0] = (float32_t)dRe;
+		}
+		else if(k == ulLen / 2)
+		{
+			pOut[1] = (float32_t)dRe;
+		}
+		else
+		{
+			pOut[2 * k] = (float32_t)dRe;
+			pOut[2 * k + 1] = (float32_t)dIm;
+		}
+	}
+	memset(p, 0x55, ulLen * sizeof(p[0]));
+}
+
+static inline float32_t arm_cos_f32(float32_t x)
+{
+	return cosf(x);
+}
+
+static inline void arm_q15_to_float(q15_t *pSrc, float32_t *pDst,
+	uint32_t blockSize)
+{
+	while(blockSize--)
+	{
+		*pDst++ = (float32_t)*pSrc++ / 32768.0f;
+	}
+}
+
+static inline void arm_mult_f32(float32_t *pSrcA, float32_t *pSrcB,
+	float32_t *pDst, uint32_t blockSize)
+{
+	while(blockSize--)
+	{
+		*pDst++ = *pSrcA++ * *pSrcB++;
+	}
+}
+
+static inline void arm_add_f32(float32_t *pSrcA, float32_t *pSrcB,
+	float32_t *pDst, uint32_t blockSize)
+{
+	while(blockSize--)
+	{
+		*pDst++ = *pSrcA++ + *pSrcB++;
+	}
+}
+
+static inline void arm_scale_f32(float32_t *pSrc, float32_t scale,
+	float32_t *pDst, uint32_t blockSize)
+{
+	while(blockSize--)
+	{
+		*pDst++ = *pSrc++ * scale;
+	}
+}
+
+static inline void arm_cmplx_mag_squared_f32(float32_t *pSrc,
+	float32_t *pDst, uint32_t numSamples)
+{
+	while(numSamples--)
+	{
+		*pDst++ = pSrc[0] * pSrc[0] + pSrc[1] * pSrc[1];
+		pSrc += 2;
+	}
+}
+
+
+#endif /* TEST_ARM_MATH_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,65 @@
+/** ***************************************************************************
+File Name:  asf.h
+
+Project:    Platform 4
+
+Purpose:    Host build stand-in for the ASF umbrella header: the parts of the
+            SAME70 the tested modules use, backed by register models the
+            tests drive
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef TEST_ASF_H
+#define TEST_ASF_H
+
+/* this file is forced in ahead of every source (see the Makefile), and the
+	firmware's own asf.h, which a module's "asf.h" finds first, is then
+	skipped by its include guard */
+#define ASF_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "compiler.h"
+#include "status_codes.h"
+#include "component/xdmac.h"
+#include "xdmac.h"
+
+
+/* Module Definitions */
+
+/* the XDMAC is a plain structure; a test plays the hardware by writing the
+	channel registers and calling the ISR entry points */
+extern Xdmac stTestXdmac;
+#define XDMAC                (&stTestXdmac)
+
+/* sleep modes don't exist on the host */
+#define SLEEPMGR_SLEEP_WFI   1
+
+static inline void sleepmgr_lock_mode(int iMode)
+{
+	UNUSED(iMode);
+}
+
+static inline void sleepmgr_unlock_mode(int iMode)
+{
+	UNUSED(iMode);
+}
+
+
+#endif /* TEST_ASF_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
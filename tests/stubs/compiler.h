@@ -0,0 +1,95 @@
+/** ***************************************************************************
+File Name:  compiler.h
+
+Project:    Platform 4
+
+Purpose:    Host build stand-in for the ASF compiler abstraction, with the
+            few helpers the tested modules use
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef TEST_COMPILER_H
+#define TEST_COMPILER_H
+
+/* System Include Files */
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+#define COMPILER_PRAGMA(arg)           _Pragma(#arg)
+#define COMPILER_PACK_SET(alignment)   COMPILER_PRAGMA(pack(alignment))
+#define COMPILER_PACK_RESET()          COMPILER_PRAGMA(pack())
+#define COMPILER_ALIGNED(a)            __attribute__((__aligned__(a)))
+#define COMPILER_WORD_ALIGNED          __attribute__((__aligned__(4)))
+
+#define UNUSED(v)                      (void)(v)
+#define Assert(expr)                   assert(expr)
+
+/* CMSIS register qualifiers */
+#define __I                            volatile const
+#define __O                            volatile
+#define __IO                           volatile
+
+/* the host is little endian, like the target */
+#define LE16(x)                        (x)
+#define LE32(x)                        (x)
+#define le16_to_cpu(x)                 (x)
+#define cpu_to_le16(x)                 (x)
+#define le32_to_cpu(x)                 (x)
+#define cpu_to_le32(x)                 (x)
+#define MSB(u16)                       (((uint8_t *)&(u16))[1])
+#define LSB(u16)                       (((uint8_t *)&(u16))[0])
+
+/* barriers; the tests' register models are plain memory */
+#define __DSB()                        __sync_synchronize()
+#define __DMB()                        __sync_synchronize()
+#define __ISB()                        __sync_synchronize()
+
+
+/* Module Type Definitions */
+
+typedef uint16_t le16_t;
+typedef uint32_t le32_t;
+typedef uint32_t iram_size_t;
+
+/* no interrupts on the host; a test plays the ISR from the same thread. If
+	it sets pfnTestIrqSave, that is called just before the interrupts would
+	be masked, where an interrupt can still come in */
+typedef uint32_t irqflags_t;
+
+extern void (*pfnTestIrqSave)(void);
+
+static inline irqflags_t cpu_irq_save(void)
+{
+	if(pfnTestIrqSave)
+	{
+		pfnTestIrqSave();
+	}
+	return 0;
+}
+
+static inline void cpu_irq_restore(irqflags_t flags)
+{
+	UNUSED(flags);
+}
+
+
+#endif /* TEST_COMPILER_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
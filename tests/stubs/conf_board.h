@@ -0,0 +1,28 @@
+/** ***************************************************************************
+File Name:  conf_board.h
+
+Project:    Platform 4
+
+Purpose:    Host build board configuration: no TCM and no QSPI, so the
+            modules build into ordinary sections
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef CONF_BOARD_H
+#define CONF_BOARD_H
+
+#endif /* CONF_BOARD_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,202 @@
+/** ***************************************************************************
+File Name:  test.c
+
+Project:    Platform 4
+
+Purpose:    Checks and reporting shared by the host unit tests, and the
+            host versions of the hardware services the modules call
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdio.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "asf.h"
+#include "dma_buf.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* non-cacheable pool; static so its addresses fit the modules' 32 bit
+	descriptor fields (the tests link with -no-pie) */
+#define TEST_NOCACHE_SIZE    8192
+
+
+/* Module Variable Declarations */
+
+static uint32_t ulTestChecks;
+static uint32_t ulTestFailures;
+
+static uint8_t aucTestNoCache[TEST_NOCACHE_SIZE] DMA_BUF_ALIGNED;
+static uint32_t ulTestNoCacheUsed;
+
+
+/* Global Variables (Must be justified!) */
+
+/* register model of the XDMAC, see asf.h */
+Xdmac stTestXdmac;
+
+/* interrupt played as the interrupts are masked, see compiler.h */
+void (*pfnTestIrqSave)(void);
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestCheck
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             iPass
+	Caveats / Effect:   None
+
+	Description:
+	Counts a check, reporting it if it failed.
+*/
+int TestCheck(int iPass, char const *pcFile, int iLine, char const *pcExpr)
+{
+	ulTestChecks++;
+	if(!iPass)
+	{
+		ulTestFailures++;
+		printf("%s:%d: check failed: %s\n", pcFile, iLine, pcExpr);
+	}
+	return iPass;
+}
+
+/** ***************************************************************************
+	Name:               TestEqual
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Non-zero if the values are equal
+	Caveats / Effect:   None
+
+	Description:
+	Counts a comparison, reporting both values if it failed.
+*/
+int TestEqual(int64_t lActual, int64_t lExpected, char const *pcFile,
+	int iLine, char const *pcExpr)
+{
+	ulTestChecks++;
+	if(lActual != lExpected)
+	{
+		ulTestFailures++;
+		printf("%s:%d: %s is %lld, expected %lld\n", pcFile, iLine, pcExpr,
+			(long long)lActual, (long long)lExpected);
+		return 0;
+	}
+	return 1;
+}
+
+/** ***************************************************************************
+	Name:               TestResult
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Exit status for main(): 0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Prints the summary line of a test program.
+*/
+int TestResult(char const *pcName)
+{
+	printf("%s: %lu checks, %lu failed\n", pcName,
+		(unsigned long)ulTestChecks, (unsigned long)ulTestFailures);
+	return ulTestFailures ? 1 : 0;
+}
+
+/** ***************************************************************************
+	Name:               DmaBufAllocNoCache
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Line aligned block, NULL when the pool is used up
+	Caveats / Effect:   Never freed
+
+	Description:
+	Host version: a static pool, as on the target.
+*/
+void *DmaBufAllocNoCache(uint32_t ulSize)
+{
+	uint32_t const ulPad = DMA_BUF_PAD(ulSize);
+	void *pvBlock;
+
+	if(ulPad > TEST_NOCACHE_SIZE - ulTestNoCacheUsed)
+	{
+		return NULL;
+	}
+	pvBlock = &aucTestNoCache[ulTestNoCacheUsed];
+	ulTestNoCacheUsed += ulPad;
+	return pvBlock;
+}
+
+/** ***************************************************************************
+	Name:               DmaBufAlloc
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Line aligned block, NULL when the pool is used up
+	Caveats / Effect:   Never freed
+
+	Description:
+	Host version: there is no cache, so both pools are the same.
+*/
+void *DmaBufAlloc(uint32_t ulSize)
+{
+	return DmaBufAllocNoCache(ulSize);
+}
+
+/** ***************************************************************************
+	Name:               DmaBufClean, DmaBufPrepareRead, DmaBufInvalidate
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Host versions: there is no data cache to maintain.
+*/
+void DmaBufClean(void const *pvAddr, uint32_t ulSize)
+{
+	UNUSED(pvAddr);
+	UNUSED(ulSize);
+}
+
+void DmaBufPrepareRead(void const *pvAddr, uint32_t ulSize)
+{
+	UNUSED(pvAddr);
+	UNUSED(ulSize);
+}
+
+void DmaBufInvalidate(void const *pvAddr, uint32_t ulSize)
+{
+	UNUSED(pvAddr);
+	UNUSED(ulSize);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,52 @@
+/** ***************************************************************************
+File Name:  test.h
+
+Project:    Platform 4
+
+Purpose:    Checks and reporting shared by the host unit tests
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef TEST_H
+#define TEST_H
+
+/* System Include Files */
+#include <stdint.h>
+#include <stdio.h>
+
+
+/* Module Definitions */
+
+/* records a failure and carries on, so one run shows every broken check */
+#define TEST_CHECK(expr) \
+	TestCheck((expr) != 0, __FILE__, __LINE__, #expr)
+
+/* as TEST_CHECK, giving both sides of a comparison of integers on failure */
+#define TEST_EQUAL(lActual, lExpected) \
+	TestEqual((int64_t)(lActual), (int64_t)(lExpected), __FILE__, __LINE__, \
+		#lActual)
+
+
+/* Global Function Declarations */
+
+int TestCheck(int iPass, char const *pcFile, int iLine, char const *pcExpr);
+int TestEqual(int64_t lActual, int64_t lExpected, char const *pcFile,
+	int iLine, char const *pcExpr);
+int TestResult(char const *pcName);
+
+
+#endif /* TEST_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,45 @@
+/** ***************************************************************************
+File Name:  test_cycles.h
+
+Project:    Platform 4
+
+Purpose:    Cycle counter for a host build of prof.c, forced into it by
+            tests/Makefile; the test that links it supplies the counter
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef TEST_CYCLES_H
+#define TEST_CYCLES_H
+
+/* System Include Files */
+#include <stdint.h>
+
+
+/* Module Definitions */
+
+/* replace the DWT cycle counter of prof.h */
+#define PROF_CYCLES()        TestCycles()
+#define PROF_CYCLES_INIT()   TestCyclesInit()
+
+
+/* Global Function Declarations */
+
+uint32_t TestCycles(void);
+void TestCyclesInit(void);
+
+
+#endif /* TEST_CYCLES_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,184 @@
+/** ***************************************************************************
+File Name:  test_link.h
+
+Project:    Platform 4
+
+Purpose:    Host build stand-ins for the USART, PMC and NVIC drivers and the
+            board definitions link.c uses, forced into it by tests/Makefile;
+            the USART is a register model the test drives
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+#ifndef TEST_LINK_H
+#define TEST_LINK_H
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "compiler.h"
+#include "component/pmc.h"
+#include "component/usart.h"
+#include "conf_clock.h"
+
+
+/* Module Definitions */
+
+/* link 0's USART is a plain structure; the test plays the receiver by
+	setting US_CSR and calling USART1_Handler() */
+extern Usart stTestUsart;
+#define USART1               (&stTestUsart)
+#define ID_USART1            14
+#define USART1_IRQn          14
+
+/* a status register of the model, which the firmware may only read */
+#define TEST_REG(reg)        (*(uint32_t *)&(reg))
+
+/* board definitions, as in user_board.h */
+#define BOARD_FREQ_MAINCK_XTAL   16000000U
+#define DMA_CHANNEL_RX       1
+#define DMA_CHANNEL_TX       2
+#define TC_CLK_PCK_HZ        48000000UL
+
+/* PMC driver */
+#define PMC_PCK_4            4
+
+/* MCK, as set up by conf_clock.h */
+#define TEST_MCK_HZ          ((uint32_t)BOARD_FREQ_MAINCK_XTAL \
+	* CONFIG_PLL0_MUL / CONFIG_PLL0_DIV / CONFIG_SYSCLK_DIV)
+
+
+/* Module Type Definitions */
+
+typedef int IRQn_Type;
+
+/* USART driver options, as in usart.h */
+typedef struct
+{
+	uint32_t baudrate;
+	uint32_t char_length;
+	uint32_t parity_type;
+	uint32_t stop_bits;
+	uint32_t channel_mode;
+	uint32_t irda_filter;
+} sam_usart_opt_t;
+
+
+/* Global Function Declarations */
+
+void USART1_Handler(void);
+
+/* USART driver: the mode, timeout and interrupt mask registers hold what is
+	written to them, and STTTO clears the timeout status */
+static inline uint32_t usart_init_rs232(Usart *p_usart,
+	const sam_usart_opt_t *p_usart_opt, uint32_t ul_mck)
+{
+	p_usart->US_MR = p_usart_opt->char_length | p_usart_opt->parity_type
+		| p_usart_opt->stop_bits | p_usart_opt->channel_mode;
+	p_usart->US_BRGR = ul_mck / (8 * p_usart_opt->baudrate);
+	return 0;
+}
+
+static inline void usart_set_rx_timeout(Usart *p_usart, uint32_t timeout)
+{
+	p_usart->US_RTOR = timeout;
+}
+
+static inline void usart_enable_interrupt(Usart *p_usart, uint32_t ul_sources)
+{
+	TEST_REG(p_usart->US_IMR) |= ul_sources;
+}
+
+static inline void usart_disable_interrupt(Usart *p_usart, uint32_t ul_sources)
+{
+	TEST_REG(p_usart->US_IMR) &= ~ul_sources;
+}
+
+static inline uint32_t usart_get_interrupt_mask(Usart *p_usart)
+{
+	return p_usart->US_IMR;
+}
+
+static inline uint32_t usart_get_status(Usart *p_usart)
+{
+	return p_usart->US_CSR;
+}
+
+static inline void usart_reset_status(Usart *p_usart)
+{
+	TEST_REG(p_usart->US_CSR) &= ~(US_CSR_OVRE | US_CSR_FRAME | US_CSR_PARE
+		| US_CSR_MANERR);
+}
+
+static inline void usart_start_rx_timeout(Usart *p_usart)
+{
+	TEST_REG(p_usart->US_CSR) &= ~US_CSR_TIMEOUT;
+}
+
+static inline void usart_enable_tx(Usart *p_usart)
+{
+	UNUSED(p_usart);
+}
+
+static inline void usart_enable_rx(Usart *p_usart)
+{
+	UNUSED(p_usart);
+}
+
+/* clocks and interrupt controller: nothing to do on the host */
+static inline void pmc_enable_upll_clock(void)
+{
+}
+
+static inline uint32_t pmc_switch_pck_to_upllck(uint32_t ul_id,
+	uint32_t ul_pres)
+{
+	UNUSED(ul_id);
+	UNUSED(ul_pres);
+	return 0;
+}
+
+static inline uint32_t pmc_switch_pck_to_pllack(uint32_t ul_id,
+	uint32_t ul_pres)
+{
+	UNUSED(ul_id);
+	UNUSED(ul_pres);
+	return 0;
+}
+
+static inline void pmc_enable_pck(uint32_t ul_id)
+{
+	UNUSED(ul_id);
+}
+
+static inline void sysclk_enable_peripheral_clock(uint32_t ul_id)
+{
+	UNUSED(ul_id);
+}
+
+static inline uint32_t sysclk_get_peripheral_hz(void)
+{
+	return TEST_MCK_HZ;
+}
+
+static inline void NVIC_EnableIRQ(IRQn_Type eIrq)
+{
+	UNUSED(eIrq);
+}
+
+
+#endif /* TEST_LINK_H */
+
+/***********************  E N D   O F   F I L E  *****************************/
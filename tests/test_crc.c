@@ -0,0 +1,305 @@
+/** ***************************************************************************
+File Name:  test_crc.c
+
+Project:    Platform 4
+
+Purpose:    CRC test: check values, and the slicing routines against the
+            bytewise ones and a bit at a time reference for every length,
+            alignment and split of the data
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+
+/* Local Include Files */
+#include "crc.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* test data, with room past the longest run for every alignment */
+#define TEST_DATA_SIZE       4096
+#define TEST_ALIGNS          8
+
+/* every length up to this is checked at every alignment */
+#define TEST_SHORT_MAX       300
+
+/* splits of the data into chunks, and the most chunks in one split */
+#define TEST_SPLITS          2000
+#define TEST_CHUNKS_MAX      12
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static uint32_t TestCrc32Bits(uint32_t ulCrc, uint8_t const *pucData,
+	uint32_t ulLen);
+static uint16_t TestCrc16Bits(uint16_t usCrc, uint8_t const *pucData,
+	uint32_t ulLen);
+static void TestCheckValues(void);
+static void TestLengths(void);
+static void TestChunks(void);
+
+
+/* Module Variable Declarations */
+
+static uint8_t aucData[TEST_DATA_SIZE + TEST_ALIGNS];
+
+static uint32_t ulRandState = 13579;
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the CRC tests.
+*/
+int main(void)
+{
+	uint32_t i;
+
+	CrcInit();
+	for(i = 0; i < sizeof(aucData); i++)
+	{
+		aucData[i] = (uint8_t)(TestRand() >> 7);
+	}
+
+	TestCheckValues();
+	TestLengths();
+	TestChunks();
+	return TestResult("crc");
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestCrc32Bits
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Updated CRC-32
+	Caveats / Effect:   None
+
+	Description:
+	CRC-32 straight from its definition, one bit at a time and without
+	tables, taking and returning the same running value as Crc32().
+*/
+static uint32_t TestCrc32Bits(uint32_t ulCrc, uint8_t const *pucData,
+	uint32_t ulLen)
+{
+	uint32_t k;
+
+	ulCrc = ~ulCrc;
+	while(ulLen--)
+	{
+		ulCrc ^= *pucData++;
+		for(k = 0; k < 8; k++)
+		{
+			ulCrc = (ulCrc >> 1) ^ ((ulCrc & 1) ? 0xEDB88320UL : 0);
+		}
+	}
+	return ~ulCrc;
+}
+
+/** ***************************************************************************
+	Name:               TestCrc16Bits
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Updated CRC-16
+	Caveats / Effect:   None
+
+	Description:
+	CRC-16/CCITT-FALSE straight from its definition, one bit at a time.
+*/
+static uint16_t TestCrc16Bits(uint16_t usCrc, uint8_t const *pucData,
+	uint32_t ulLen)
+{
+	uint32_t k;
+
+	while(ulLen--)
+	{
+		usCrc ^= (uint16_t)(*pucData++ << 8);
+		for(k = 0; k < 8; k++)
+		{
+			usCrc = (uint16_t)((usCrc << 1) ^ ((usCrc & 0x8000) ? 0x1021 : 0));
+		}
+	}
+	return usCrc;
+}
+
+/** ***************************************************************************
+	Name:               TestCheckValues
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The published check values, the CRC of "123456789", from every routine,
+	and no data leaves the starting value as it is.
+*/
+static void TestCheckValues(void)
+{
+	static char const acCheck[] = "123456789";
+	uint32_t const ulLen = sizeof(acCheck) - 1;
+
+	TEST_EQUAL(Crc32(CRC32_INIT, acCheck, ulLen), 0xCBF43926UL);
+	TEST_EQUAL(Crc32Bytewise(CRC32_INIT, acCheck, ulLen), 0xCBF43926UL);
+	TEST_EQUAL(TestCrc32Bits(CRC32_INIT, (uint8_t const *)acCheck, ulLen),
+		0xCBF43926UL);
+	TEST_EQUAL(Crc16(CRC16_INIT, acCheck, ulLen), 0x29B1);
+	TEST_EQUAL(Crc16Bytewise(CRC16_INIT, acCheck, ulLen), 0x29B1);
+	TEST_EQUAL(TestCrc16Bits(CRC16_INIT, (uint8_t const *)acCheck, ulLen),
+		0x29B1);
+
+	TEST_EQUAL(Crc32(CRC32_INIT, acCheck, 0), CRC32_INIT);
+	TEST_EQUAL(Crc32Bytewise(CRC32_INIT, acCheck, 0), CRC32_INIT);
+	TEST_EQUAL(Crc16(CRC16_INIT, acCheck, 0), CRC16_INIT);
+	TEST_EQUAL(Crc16Bytewise(CRC16_INIT, acCheck, 0), CRC16_INIT);
+}
+
+/** ***************************************************************************
+	Name:               TestLengths
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The slicing routines give the bytewise result for every length up to
+	TEST_SHORT_MAX, covering every tail after the 8 byte steps, and for
+	every alignment of the start, and for long runs; the bytewise routines
+	give the bit at a time result.
+*/
+static void TestLengths(void)
+{
+	uint32_t ulAlign;
+	uint32_t ulLen;
+
+	for(ulAlign = 0; ulAlign < TEST_ALIGNS; ulAlign++)
+	{
+		uint8_t const *pucData = &aucData[ulAlign];
+
+		for(ulLen = 0; ulLen <= TEST_DATA_SIZE;
+			ulLen += (ulLen < TEST_SHORT_MAX) ? 1 : 509)
+		{
+			uint32_t const ulCrc32 = Crc32Bytewise(CRC32_INIT, pucData, ulLen);
+			uint16_t const usCrc16 = Crc16Bytewise(CRC16_INIT, pucData, ulLen);
+
+			TEST_EQUAL(ulCrc32, TestCrc32Bits(CRC32_INIT, pucData, ulLen));
+			TEST_EQUAL(usCrc16, TestCrc16Bits(CRC16_INIT, pucData, ulLen));
+			TEST_EQUAL(Crc32(CRC32_INIT, pucData, ulLen), ulCrc32);
+			TEST_EQUAL(Crc16(CRC16_INIT, pucData, ulLen), usCrc16);
+		}
+		TEST_EQUAL(Crc32(CRC32_INIT, pucData, TEST_DATA_SIZE),
+			TestCrc32Bits(CRC32_INIT, pucData, TEST_DATA_SIZE));
+		TEST_EQUAL(Crc16(CRC16_INIT, pucData, TEST_DATA_SIZE),
+			TestCrc16Bits(CRC16_INIT, pucData, TEST_DATA_SIZE));
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestChunks
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A run split into chunks of random length, each passed the running value
+	of the one before, gives the CRC of the whole run, with the slicing and
+	bytewise routines mixed from chunk to chunk.
+*/
+static void TestChunks(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < TEST_SPLITS; i++)
+	{
+		uint32_t const ulStart = TestRand() % TEST_ALIGNS;
+		uint32_t const ulLen = TestRand() % (TEST_DATA_SIZE / 2) + 1;
+		uint32_t const ulChunks = TestRand() % TEST_CHUNKS_MAX + 1;
+		uint32_t ulCrc32 = CRC32_INIT;
+		uint16_t usCrc16 = CRC16_INIT;
+		uint32_t ulDone = 0;
+		uint32_t j;
+
+		for(j = 0; j < ulChunks; j++)
+		{
+			uint32_t ulChunk = (j + 1 == ulChunks) ? ulLen - ulDone
+				: TestRand() % (ulLen - ulDone + 1);
+			uint8_t const *pucData = &aucData[ulStart + ulDone];
+
+			if(TestRand() & 1)
+			{
+				ulCrc32 = Crc32(ulCrc32, pucData, ulChunk);
+				usCrc16 = Crc16(usCrc16, pucData, ulChunk);
+			}
+			else
+			{
+				ulCrc32 = Crc32Bytewise(ulCrc32, pucData, ulChunk);
+				usCrc16 = Crc16Bytewise(usCrc16, pucData, ulChunk);
+			}
+			ulDone += ulChunk;
+		}
+
+		TEST_EQUAL(ulDone, ulLen);
+		TEST_EQUAL(ulCrc32, Crc32Bytewise(CRC32_INIT, &aucData[ulStart], ulLen));
+		TEST_EQUAL(usCrc16, Crc16Bytewise(CRC16_INIT, &aucData[ulStart], ulLen));
+	}
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,519 @@
+/** ***************************************************************************
+File Name:  test_frame.c
+
+Project:    Platform 4
+
+Purpose:    Frame parser test: chunking, resynchronisation after false sync
+            words, and a fuzzed stream of damaged frames
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "crc.h"
+#include "frame.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* frames in the fuzzed stream, the largest payload in it, and the chance
+	in 256 of a frame being damaged */
+#define TEST_FUZZ_FRAMES     5000
+#define TEST_FUZZ_PAYLOAD    300
+#define TEST_FUZZ_DAMAGE     64
+
+#define TEST_STREAM_SIZE \
+	(TEST_FUZZ_FRAMES * (TEST_FUZZ_PAYLOAD + FRAME_OVERHEAD + 64))
+
+
+/* Module Type Definitions */
+
+/* what the fuzzed stream holds for each sequence number */
+typedef struct
+{
+	uint32_t ulPayload;
+	uint32_t ulLen;
+	uint8_t ucIntact;
+	uint8_t ucSeen;
+} tTestFrame;
+
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static uint32_t TestParse(uint8_t const *pucStream, uint32_t ulLen,
+	uint32_t ulChunk, uint8_t ucRandom, uint8_t ucFuzz);
+static uint32_t TestFalseSync(uint8_t *pucDst, uint32_t ulPayloadLen);
+static void TestChunks(void);
+static void TestResync(void);
+static void TestIdle(void);
+static void TestFuzz(void);
+
+
+/* Module Variable Declarations */
+
+static tFrameParser stParser;
+
+static uint8_t aucStream[TEST_STREAM_SIZE];
+static uint8_t aucPayload[FRAME_MAX_PAYLOAD];
+static tTestFrame astFrames[TEST_FUZZ_FRAMES];
+
+/* sequence numbers of the frames TestParse() received, in order */
+static uint16_t ausSeen[TEST_FUZZ_FRAMES];
+static uint32_t ulSeen;
+
+static uint32_t ulRandState = 4242;
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the frame parser tests.
+*/
+int main(void)
+{
+	CrcInit();
+	TestChunks();
+	TestResync();
+	TestIdle();
+	TestFuzz();
+	return TestResult("frame");
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestParse
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of frames received
+	Caveats / Effect:   Resets the parser first
+
+	Description:
+	Feeds a stream through the parser in chunks of ulChunk bytes, or of
+	random sizes up to ulChunk, the way LinkFeed() does: each call's return
+	is consumed, and once the stream is used up the parser is fed empty
+	chunks and told the line is idle until it has nothing left, as
+	LinkPoll() does at the end of a packet. The sequence numbers received
+	are kept in ausSeen[], and with ucFuzz each frame is compared with the
+	one TestFuzz() sent with its sequence number.
+*/
+static uint32_t TestParse(uint8_t const *pucStream, uint32_t ulLen,
+	uint32_t ulChunk, uint8_t ucRandom, uint8_t ucFuzz)
+{
+	uint32_t ulPos = 0;
+
+	FrameParserInit(&stParser);
+	ulSeen = 0;
+
+	for(;;)
+	{
+		uint32_t ulFeed = ucRandom ? TestRand() % ulChunk + 1 : ulChunk;
+		uint32_t ulUsed;
+
+		if(ulFeed > ulLen - ulPos)
+		{
+			ulFeed = ulLen - ulPos;
+		}
+		ulUsed = FrameParserFeed(&stParser, &pucStream[ulPos], ulFeed);
+		TEST_CHECK(ulUsed <= ulFeed);
+		ulPos += ulUsed;
+
+		if(FrameParserReady(&stParser))
+		{
+			uint16_t const usSeq = FrameGetSeq(&stParser);
+
+			if(ucFuzz && (usSeq < TEST_FUZZ_FRAMES))
+			{
+				TEST_EQUAL(FrameGetLength(&stParser), astFrames[usSeq].ulLen);
+				TEST_CHECK(memcmp(FrameGetPayload(&stParser),
+					&pucStream[astFrames[usSeq].ulPayload],
+					astFrames[usSeq].ulLen) == 0);
+			}
+			if(ulSeen < TEST_FUZZ_FRAMES)
+			{
+				ausSeen[ulSeen] = usSeq;
+			}
+			ulSeen++;
+		}
+		else if(ulFeed == 0)
+		{
+			/* the end of the stream is an idle line */
+			if(!FrameParserIdle(&stParser))
+			{
+				break;
+			}
+		}
+		else
+		{
+			/* without a frame the whole chunk is taken */
+			TEST_EQUAL(ulUsed, ulFeed);
+		}
+	}
+	TEST_EQUAL(FrameParserPending(&stParser), 0);
+	return ulSeen;
+}
+
+/** ***************************************************************************
+	Name:               TestFalseSync
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Length of the false start
+	Caveats / Effect:   None
+
+	Description:
+	Writes a sync word and header that claim a payload of ulPayloadLen
+	bytes, as noise or a damaged frame might. Above FRAME_MAX_PAYLOAD it
+	fails the length check, otherwise the CRC once the claimed length has
+	been read.
+*/
+static uint32_t TestFalseSync(uint8_t *pucDst, uint32_t ulPayloadLen)
+{
+	pucDst[0] = FRAME_SYNC0;
+	pucDst[1] = FRAME_SYNC1;
+	pucDst[2] = (uint8_t)ulPayloadLen;
+	pucDst[3] = (uint8_t)(ulPayloadLen >> 8);
+	pucDst[4] = 0x55;
+	pucDst[5] = 0xAA;
+	return FRAME_HEADER_SIZE;
+}
+
+/** ***************************************************************************
+	Name:               TestChunks
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Back to back frames of every payload size from empty to the largest,
+	with a payload full of sync words, arrive whole whatever the chunking.
+*/
+static void TestChunks(void)
+{
+	uint32_t ulLen = 0;
+	uint32_t ulFrames = 0;
+	uint32_t ulChunk;
+	uint32_t i;
+
+	for(i = 0; i < sizeof(aucPayload); i++)
+	{
+		aucPayload[i] = (i & 1) ? FRAME_SYNC1 : FRAME_SYNC0;
+	}
+	for(i = 0; i <= FRAME_MAX_PAYLOAD; i += 61)
+	{
+		ulLen += FrameBuild(&aucStream[ulLen], (uint16_t)ulFrames++,
+			aucPayload, i);
+	}
+	ulLen += FrameBuild(&aucStream[ulLen], (uint16_t)ulFrames++, aucPayload,
+		FRAME_MAX_PAYLOAD);
+
+	for(ulChunk = 1; ulChunk < 300; ulChunk += (ulChunk < 20) ? 1 : 37)
+	{
+		TEST_EQUAL(TestParse(aucStream, ulLen, ulChunk, 0, 0), ulFrames);
+		TEST_EQUAL(stParser.ulSeqLost, 0);
+		TEST_EQUAL(stParser.ulSkipped, 0);
+		TEST_EQUAL(stParser.ulCrcErrors + stParser.ulLenErrors, 0);
+	}
+	TEST_EQUAL(TestParse(aucStream, ulLen, ulLen, 0, 0), ulFrames);
+	TEST_EQUAL(ausSeen[ulFrames - 1], ulFrames - 1);
+	TEST_EQUAL(FrameGetLength(&stParser), FRAME_MAX_PAYLOAD);
+	TEST_CHECK(memcmp(FrameGetPayload(&stParser), aucPayload,
+		FRAME_MAX_PAYLOAD) == 0);
+}
+
+/** ***************************************************************************
+	Name:               TestResync
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A false start just before real frames, failing on its length or on its
+	CRC, must not take the frames behind it, whether they are still to come
+	or already buffered when the check fails; in the worst case the false
+	start swallows two whole frames. A damaged frame with a sync word in
+	its payload is the same.
+*/
+static void TestResync(void)
+{
+	static uint32_t const aulClaim[] = { 0, 5, 40, 100, FRAME_MAX_PAYLOAD,
+		FRAME_MAX_PAYLOAD + 1, 0xFFFF };
+	uint32_t ulChunk;
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < sizeof(aucPayload); i++)
+	{
+		aucPayload[i] = (uint8_t)(i * 13);
+	}
+
+	for(i = 0; i < sizeof(aulClaim) / sizeof(aulClaim[0]); i++)
+	{
+		uint32_t ulLen = 0;
+
+		aucStream[ulLen++] = 0x00;
+		ulLen += TestFalseSync(&aucStream[ulLen], aulClaim[i]);
+		ulLen += FrameBuild(&aucStream[ulLen], 1, aucPayload, 10);
+		ulLen += FrameBuild(&aucStream[ulLen], 2, aucPayload, 20);
+		ulLen += FrameBuild(&aucStream[ulLen], 3, aucPayload, 300);
+
+		for(ulChunk = 1; ulChunk <= ulLen; ulChunk += (ulChunk < 16) ? 1 : 29)
+		{
+			TEST_EQUAL(TestParse(aucStream, ulLen, ulChunk, 0, 0), 3);
+			for(j = 0; j < 3; j++)
+			{
+				TEST_EQUAL(ausSeen[j], j + 1);
+			}
+			/* a claim longer than the stream is cut short by the idle */
+			TEST_EQUAL(stParser.ulCrcErrors + stParser.ulLenErrors
+				+ stParser.ulTruncated, 1);
+			TEST_EQUAL(stParser.ulLenErrors,
+				aulClaim[i] > FRAME_MAX_PAYLOAD ? 1 : 0);
+		}
+	}
+
+	/* a frame whose CRC is damaged carries what looks like a frame in its
+		payload, and the real frame follows */
+	{
+		uint32_t ulLen = 0;
+		uint32_t ulInner = FrameBuild(aucPayload, 7, "inner", 5);
+
+		ulLen += FrameBuild(&aucStream[ulLen], 1, aucPayload, ulInner + 30);
+		aucStream[ulLen - 1] ^= 0x01;
+		ulLen += FrameBuild(&aucStream[ulLen], 2, "outer", 5);
+
+		for(ulChunk = 1; ulChunk <= ulLen; ulChunk++)
+		{
+			TEST_EQUAL(TestParse(aucStream, ulLen, ulChunk, 0, 0), 2);
+			TEST_EQUAL(ausSeen[0], 7);
+			TEST_EQUAL(ausSeen[1], 2);
+			TEST_EQUAL(stParser.ulCrcErrors, 1);
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestIdle
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A frame cut short by the line going idle is dropped at the idle, and
+	doesn't swallow the start of the next one; until then
+	FrameParserRemaining() counts down the rest of it.
+*/
+static void TestIdle(void)
+{
+	uint32_t ulLen;
+
+	memset(aucPayload, 0x11, sizeof(aucPayload));
+	ulLen = FrameBuild(aucStream, 1, aucPayload, 100);
+	FrameBuild(&aucStream[ulLen], 2, aucPayload, 50);
+	FrameParserInit(&stParser);
+
+	TEST_EQUAL(FrameParserRemaining(&stParser), 0);
+	TEST_EQUAL(FrameParserFeed(&stParser, aucStream, 3), 3);
+	TEST_EQUAL(FrameParserRemaining(&stParser), FRAME_HEADER_SIZE - 3);
+	TEST_EQUAL(FrameParserFeed(&stParser, &aucStream[3], 60), 60);
+	TEST_EQUAL(FrameParserRemaining(&stParser), ulLen - 63);
+	TEST_EQUAL(FrameParserIdle(&stParser), 0);
+	TEST_EQUAL(stParser.ulTruncated, 1);
+	TEST_EQUAL(FrameParserRemaining(&stParser), 0);
+
+	TEST_EQUAL(FrameParserFeed(&stParser, &aucStream[ulLen], 60),
+		50 + FRAME_OVERHEAD);
+	TEST_CHECK(FrameParserReady(&stParser));
+	TEST_EQUAL(FrameGetSeq(&stParser), 2);
+
+	/* idle with a frame held, or between frames, drops nothing */
+	TEST_EQUAL(FrameParserIdle(&stParser), 0);
+	TEST_EQUAL(stParser.ulTruncated, 1);
+	TEST_CHECK(FrameParserReady(&stParser));
+}
+
+/** ***************************************************************************
+	Name:               TestFuzz
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A long stream of frames with random payloads, some damaged by a flipped
+	bit, a lost tail, or noise and false starts in front of them, parsed in
+	random chunks, a byte at a time to 4 KB at a time. Every intact frame
+	must be received, with the payload it was sent with, and no damaged
+	one.
+*/
+static void TestFuzz(void)
+{
+	uint32_t ulLen = 0;
+	uint32_t ulIntact = 0;
+	uint32_t ulPass;
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < TEST_FUZZ_FRAMES; i++)
+	{
+		tTestFrame *pstFrame = &astFrames[i];
+		uint32_t const ulPayload = TestRand() % (TEST_FUZZ_PAYLOAD + 1);
+		uint32_t ulDamage = (TestRand() & 0xFF) < TEST_FUZZ_DAMAGE
+			? TestRand() % 4 : 4;
+
+		for(j = 0; j < ulPayload; j++)
+		{
+			aucPayload[j] = (uint8_t)TestRand();
+		}
+		/* the first and last frames are left alone, so the sequence count
+			spans the whole stream */
+		if((i == 0) || (i == TEST_FUZZ_FRAMES - 1))
+		{
+			ulDamage = 4;
+		}
+
+		/* sync words in payloads are common enough in real data */
+		if(ulPayload >= 8)
+		{
+			TestFalseSync(&aucPayload[TestRand() % (ulPayload - 7)],
+				TestRand() % 2000);
+		}
+
+		if(ulDamage == 0)
+		{
+			/* noise, maybe with a false start, in front of the frame */
+			uint32_t ulNoise = TestRand() % 40;
+
+			for(j = 0; j < ulNoise; j++)
+			{
+				aucStream[ulLen++] = (uint8_t)TestRand();
+			}
+			if(TestRand() & 1)
+			{
+				ulLen += TestFalseSync(&aucStream[ulLen], TestRand() % 2000);
+			}
+		}
+
+		pstFrame->ulPayload = ulLen + FRAME_HEADER_SIZE;
+		pstFrame->ulLen = ulPayload;
+		pstFrame->ucIntact = 1;
+		ulLen += FrameBuild(&aucStream[ulLen], (uint16_t)i, aucPayload,
+			ulPayload);
+
+		if(ulDamage == 1)
+		{
+			/* a flipped bit anywhere in the frame */
+			uint32_t const ulAt = TestRand() % (ulPayload + FRAME_OVERHEAD);
+
+			aucStream[ulLen - ulPayload - FRAME_OVERHEAD + ulAt] ^=
+				(uint8_t)(1 << (TestRand() % 8));
+			pstFrame->ucIntact = 0;
+		}
+		else if(ulDamage == 2)
+		{
+			/* the end of the frame lost */
+			ulLen -= TestRand() % (ulPayload + FRAME_CRC_SIZE) + 1;
+			pstFrame->ucIntact = 0;
+		}
+		ulIntact += pstFrame->ucIntact;
+	}
+
+	for(ulPass = 0; ulPass < 4; ulPass++)
+	{
+		uint32_t const ulChunk = (ulPass == 0) ? 1 : 1 << (ulPass * 4);
+		uint32_t ulBad = 0;
+		uint32_t ulMissed = 0;
+
+		for(i = 0; i < TEST_FUZZ_FRAMES; i++)
+		{
+			astFrames[i].ucSeen = 0;
+		}
+		TestParse(aucStream, ulLen, ulChunk, ulPass != 0, 1);
+
+		/* each intact frame exactly once, and no damaged one */
+		for(i = 0; i < ulSeen; i++)
+		{
+			tTestFrame *pstFrame = &astFrames[ausSeen[i]];
+
+			if(!pstFrame->ucIntact || pstFrame->ucSeen)
+			{
+				ulBad++;
+			}
+			pstFrame->ucSeen = 1;
+		}
+		for(i = 0; i < TEST_FUZZ_FRAMES; i++)
+		{
+			if(astFrames[i].ucIntact && !astFrames[i].ucSeen)
+			{
+				ulMissed++;
+			}
+		}
+		TEST_EQUAL(ulBad, 0);
+		TEST_EQUAL(ulMissed, 0);
+		TEST_EQUAL(ulSeen, ulIntact);
+		TEST_EQUAL(stParser.ulFrames, ulIntact);
+		TEST_EQUAL(stParser.ulSeqLost, TEST_FUZZ_FRAMES - ulIntact);
+	}
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
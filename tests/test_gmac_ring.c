@@ -0,0 +1,854 @@
+/** ***************************************************************************
+File Name:  test_gmac_ring.c
+
+Project:    Platform 4
+
+Purpose:    GMAC descriptor ring test: a model of the GMAC receive and
+            transmit DMA runs against the rings, checking the ownership bits
+            it sees, frames spread over several buffers and the ring wrap
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "gmac_ring.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* receive ring: few buffers, so it wraps and fills often */
+#define TEST_RX_DESCS        8
+#define TEST_RX_BUF_SIZE     128
+
+/* transmit ring, and the buffers of the frames queued to it */
+#define TEST_TX_DESCS        8
+#define TEST_TX_BUFS         4
+#define TEST_TX_BUF_SIZE     64
+#define TEST_TX_SLOTS        16
+
+/* frames the tests keep track of at once */
+#define TEST_FIFO            64
+
+
+/* Module Type Definitions */
+
+/* a frame expected out of a ring, in order */
+typedef struct
+{
+	uint32_t ulSeq;
+	uint32_t ulLen;
+	/* transmit only: the status the DMA gave it */
+	int iStatus;
+} tTestFrame;
+
+/* frames in order, with a free-running head and tail */
+typedef struct
+{
+	tTestFrame astFrame[TEST_FIFO];
+	uint32_t ulHead;
+	uint32_t ulTail;
+} tTestFifo;
+
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static uint8_t TestByte(uint32_t ulSeq, uint32_t ulOffset);
+static void TestPush(tTestFifo *pstFifo, uint32_t ulSeq, uint32_t ulLen,
+	int iStatus);
+static tTestFrame *TestPeek(tTestFifo *pstFifo, uint32_t ulIndex);
+static uint32_t TestCount(tTestFifo const *pstFifo);
+static uint32_t TestRxNext(uint32_t ulIndex);
+static void TestRxBuffer(uint32_t ulSeq, uint32_t ulOffset, uint32_t ulLen,
+	uint32_t ulFlags, uint32_t ulFrameLen);
+static uint32_t TestRxFrame(uint32_t ulSeq, uint32_t ulLen);
+static uint32_t TestRxDrain(uint32_t ulMax);
+static void TestRxCheckRing(void);
+static void TestTxDma(uint32_t ulMax, uint32_t ulErrorPct);
+static int TestTxQueue(uint32_t ulSeq, uint32_t ulBufs);
+static void TestTxDone(void *pvTag, int iStatus);
+static void TestTxCheckRing(void);
+static void TestRxStream(void);
+static void TestRxPartial(void);
+static void TestTxStream(void);
+static void TestTxFlush(void);
+
+
+/* Module Variable Declarations */
+
+/* statics, as the descriptors hold 32 bit buffer addresses */
+static tGmacDesc astRxDesc[TEST_RX_DESCS] COMPILER_WORD_ALIGNED;
+static uint8_t aucRxBufs[TEST_RX_DESCS * TEST_RX_BUF_SIZE] COMPILER_WORD_ALIGNED;
+static tGmacRxRing stRx;
+
+static tGmacDesc astTxDesc[TEST_TX_DESCS] COMPILER_WORD_ALIGNED;
+static uint8_t aucTxBufs[TEST_TX_SLOTS][TEST_TX_BUFS][TEST_TX_BUF_SIZE];
+static tGmacTxRing stTx;
+
+/* the descriptor each DMA works on next */
+static uint32_t ulDmaRx;
+static uint32_t ulDmaTx;
+
+/* receive: frames the ring should give; transmit: frames queued, and those
+	sent and waiting to be reclaimed */
+static tTestFifo stRxFifo;
+static tTestFifo stTxFifo;
+static uint32_t ulTxSent;
+static uint32_t ulTxDescsBusy;
+
+static uint32_t ulRandState = 2121;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the GMAC ring tests.
+*/
+int main(void)
+{
+	TestRxStream();
+	TestRxPartial();
+	TestTxStream();
+	TestTxFlush();
+	return TestResult("gmac_ring");
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestByte
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             A byte of a frame
+	Caveats / Effect:   None
+
+	Description:
+	Frame contents follow from the sequence number, so a frame from the
+	wrong buffer or cut short shows.
+*/
+static uint8_t TestByte(uint32_t ulSeq, uint32_t ulOffset)
+{
+	return (uint8_t)(ulSeq * 31 + ulOffset * 7 + (ulOffset >> 8));
+}
+
+/** ***************************************************************************
+	Name:               TestPush
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Adds a frame to the back of a list.
+*/
+static void TestPush(tTestFifo *pstFifo, uint32_t ulSeq, uint32_t ulLen,
+	int iStatus)
+{
+	tTestFrame *pstFrame = &pstFifo->astFrame[pstFifo->ulHead++ % TEST_FIFO];
+
+	TEST_CHECK(TestCount(pstFifo) <= TEST_FIFO);
+	pstFrame->ulSeq = ulSeq;
+	pstFrame->ulLen = ulLen;
+	pstFrame->iStatus = iStatus;
+}
+
+/** ***************************************************************************
+	Name:               TestPeek
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             The frame ulIndex from the front of a list
+	Caveats / Effect:   None
+
+	Description:
+	Gives access to a frame of a list.
+*/
+static tTestFrame *TestPeek(tTestFifo *pstFifo, uint32_t ulIndex)
+{
+	return &pstFifo->astFrame[(pstFifo->ulTail + ulIndex) % TEST_FIFO];
+}
+
+/** ***************************************************************************
+	Name:               TestCount
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of frames on a list
+	Caveats / Effect:   None
+
+	Description:
+	Counts the frames on a list.
+*/
+static uint32_t TestCount(tTestFifo const *pstFifo)
+{
+	return pstFifo->ulHead - pstFifo->ulTail;
+}
+
+/** ***************************************************************************
+	Name:               TestRxNext
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             The receive descriptor after ulIndex
+	Caveats / Effect:   None
+
+	Description:
+	The DMA goes back to the start of the ring at the descriptor with the
+	wrap bit, which must be the last.
+*/
+static uint32_t TestRxNext(uint32_t ulIndex)
+{
+	uint32_t const ulWrap = astRxDesc[ulIndex].ulAddr & GMAC_RX_WRAP;
+
+	TEST_EQUAL(ulWrap != 0, ulIndex == TEST_RX_DESCS - 1);
+	return ulWrap ? 0 : ulIndex + 1;
+}
+
+/** ***************************************************************************
+	Name:               TestRxBuffer
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The descriptor must belong to the DMA
+
+	Description:
+	The receive DMA fills the buffer of its next descriptor with ulLen bytes
+	of a frame from ulOffset on, writes the status and then hands the buffer
+	to software. The frame length is in the status of the buffer ending it.
+*/
+static void TestRxBuffer(uint32_t ulSeq, uint32_t ulOffset, uint32_t ulLen,
+	uint32_t ulFlags, uint32_t ulFrameLen)
+{
+	tGmacDesc *pstDesc = &astRxDesc[ulDmaRx];
+	uint8_t *pucBuf =
+		(uint8_t *)(uintptr_t)(pstDesc->ulAddr & GMAC_RX_ADDR_MSK);
+	uint32_t i;
+
+	TEST_CHECK(!(pstDesc->ulAddr & GMAC_RX_OWN));
+	TEST_CHECK(pucBuf == &aucRxBufs[ulDmaRx * TEST_RX_BUF_SIZE]);
+	for(i = 0; i < ulLen; i++)
+	{
+		pucBuf[i] = TestByte(ulSeq, ulOffset + i);
+	}
+	pstDesc->ulStatus = ulFlags
+		| ((ulFlags & GMAC_RX_EOF) ? (ulFrameLen & GMAC_RX_LEN_MSK) : 0);
+	pstDesc->ulAddr |= GMAC_RX_OWN;
+	ulDmaRx = TestRxNext(ulDmaRx);
+}
+
+/** ***************************************************************************
+	Name:               TestRxFrame
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             1 if the frame was received, 0 if there weren't
+	                    enough buffers for it
+	Caveats / Effect:   None
+
+	Description:
+	The receive DMA takes a whole frame, over as many buffers as it needs.
+	If the buffers it needs still belong to software the frame is lost,
+	which the GMAC counts but the ring can't see.
+*/
+static uint32_t TestRxFrame(uint32_t ulSeq, uint32_t ulLen)
+{
+	uint32_t const ulBufs = (ulLen + TEST_RX_BUF_SIZE - 1) / TEST_RX_BUF_SIZE;
+	uint32_t ulIndex = ulDmaRx;
+	uint32_t ulOffset;
+	uint32_t i;
+
+	for(i = 0; i < ulBufs; i++)
+	{
+		if(astRxDesc[ulIndex].ulAddr & GMAC_RX_OWN)
+		{
+			return 0;
+		}
+		ulIndex = TestRxNext(ulIndex);
+	}
+
+	for(ulOffset = 0, i = 0; i < ulBufs; i++)
+	{
+		uint32_t const ulChunk = (ulLen - ulOffset < TEST_RX_BUF_SIZE)
+			? ulLen - ulOffset : TEST_RX_BUF_SIZE;
+
+		TestRxBuffer(ulSeq, ulOffset, ulChunk,
+			((i == 0) ? GMAC_RX_SOF : 0) | ((i == ulBufs - 1) ? GMAC_RX_EOF : 0),
+			ulLen);
+		ulOffset += ulChunk;
+	}
+	return 1;
+}
+
+/** ***************************************************************************
+	Name:               TestRxDrain
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of frames taken
+	Caveats / Effect:   None
+
+	Description:
+	Takes up to ulMax frames from the ring, each of which must be the next
+	one expected, whole and in its own buffer.
+*/
+static uint32_t TestRxDrain(uint32_t ulMax)
+{
+	uint32_t ulTaken = 0;
+
+	while(ulTaken < ulMax)
+	{
+		uint8_t *pucFrame = NULL;
+		uint32_t const ulLen = GmacRxRingPeek(&stRx, &pucFrame);
+		tTestFrame const *pstExpected = TestPeek(&stRxFifo, 0);
+		uint32_t i;
+
+		if(ulLen == 0)
+		{
+			break;
+		}
+		TEST_CHECK(TestCount(&stRxFifo) > 0);
+		TEST_EQUAL(ulLen, pstExpected->ulLen);
+		TEST_CHECK(pucFrame == &aucRxBufs[stRx.ulHead * TEST_RX_BUF_SIZE]);
+		TEST_CHECK(GmacRxRingPeek(&stRx, &pucFrame) == ulLen);
+		for(i = 0; i < ulLen; i++)
+		{
+			if(pucFrame[i] != TestByte(pstExpected->ulSeq, i))
+			{
+				TEST_CHECK(pucFrame[i] == TestByte(pstExpected->ulSeq, i));
+				break;
+			}
+		}
+		GmacRxRingRelease(&stRx);
+		stRxFifo.ulTail++;
+		ulTaken++;
+	}
+	return ulTaken;
+}
+
+/** ***************************************************************************
+	Name:               TestRxCheckRing
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Software only ever clears the ownership bit: every descriptor keeps its
+	buffer, and the wrap bit stays on the last.
+*/
+static void TestRxCheckRing(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < TEST_RX_DESCS; i++)
+	{
+		TEST_EQUAL(astRxDesc[i].ulAddr & ~GMAC_RX_OWN,
+			(uint32_t)(uintptr_t)&aucRxBufs[i * TEST_RX_BUF_SIZE]
+			| ((i == TEST_RX_DESCS - 1) ? GMAC_RX_WRAP : 0));
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestTxDma
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The transmit DMA sends up to ulMax frames. It stops at a descriptor
+	that belongs to software; otherwise it gathers the buffers up to the one
+	marked last, none of which may belong to software, then marks only the
+	first descriptor used, with an error now and then.
+*/
+static void TestTxDma(uint32_t ulMax, uint32_t ulErrorPct)
+{
+	while(ulMax--)
+	{
+		uint32_t const ulFirst = ulDmaTx;
+		tTestFrame *pstFrame = TestPeek(&stTxFifo, ulTxSent);
+		uint32_t ulLen = 0;
+		uint32_t ulStatus;
+
+		if(astTxDesc[ulFirst].ulStatus & GMAC_TX_USED)
+		{
+			TEST_EQUAL(ulTxSent, TestCount(&stTxFifo));
+			return;
+		}
+		TEST_CHECK(ulTxSent < TestCount(&stTxFifo));
+
+		do
+		{
+			tGmacDesc const *pstDesc = &astTxDesc[ulDmaTx];
+			uint8_t const *pucBuf = (uint8_t const *)(uintptr_t)pstDesc->ulAddr;
+			uint32_t const ulBufLen = pstDesc->ulStatus & GMAC_TX_LEN_MSK;
+			uint32_t i;
+
+			ulStatus = pstDesc->ulStatus;
+			TEST_CHECK(!(ulStatus & GMAC_TX_USED));
+			TEST_EQUAL((ulStatus & GMAC_TX_WRAP) != 0,
+				ulDmaTx == TEST_TX_DESCS - 1);
+			for(i = 0; i < ulBufLen; i++)
+			{
+				if(pucBuf[i] != TestByte(pstFrame->ulSeq, ulLen + i))
+				{
+					TEST_CHECK(pucBuf[i] == TestByte(pstFrame->ulSeq, ulLen + i));
+					break;
+				}
+			}
+			ulLen += ulBufLen;
+			ulDmaTx = (ulStatus & GMAC_TX_WRAP) ? 0 : ulDmaTx + 1;
+		} while(!(ulStatus & GMAC_TX_LAST) && (ulDmaTx != ulFirst));
+
+		TEST_CHECK(ulStatus & GMAC_TX_LAST);
+		TEST_EQUAL(ulLen, pstFrame->ulLen);
+		pstFrame->iStatus = ((TestRand() % 100) < ulErrorPct) ? -1 : 0;
+		astTxDesc[ulFirst].ulStatus |= GMAC_TX_USED
+			| ((pstFrame->iStatus != 0) ? (1UL << 29) : 0);
+		ulTxSent++;
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestTxQueue
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Result of GmacTxRingQueue()
+	Caveats / Effect:   None
+
+	Description:
+	Queues a frame of ulBufs buffers of random length, tagged with its
+	sequence number.
+*/
+static int TestTxQueue(uint32_t ulSeq, uint32_t ulBufs)
+{
+	tGmacTxBuf astBufs[TEST_TX_BUFS];
+	uint32_t ulLen = 0;
+	uint32_t i;
+	uint32_t j;
+	int iResult;
+
+	for(i = 0; i < ulBufs; i++)
+	{
+		uint8_t *pucBuf = aucTxBufs[ulSeq % TEST_TX_SLOTS][i];
+
+		astBufs[i].pvData = pucBuf;
+		astBufs[i].ulLen = 1 + TestRand() % TEST_TX_BUF_SIZE;
+		for(j = 0; j < astBufs[i].ulLen; j++)
+		{
+			pucBuf[j] = TestByte(ulSeq, ulLen + j);
+		}
+		ulLen += astBufs[i].ulLen;
+	}
+
+	iResult = GmacTxRingQueue(&stTx, astBufs, ulBufs,
+		(void *)(uintptr_t)ulSeq);
+	TEST_EQUAL(iResult, (ulBufs <= TEST_TX_DESCS - 1 - ulTxDescsBusy) ? 0 : -1);
+	if(iResult == 0)
+	{
+		TestPush(&stTxFifo, ulSeq, ulLen, 0);
+		ulTxDescsBusy += ulBufs;
+	}
+	return iResult;
+}
+
+/** ***************************************************************************
+	Name:               TestTxDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Completion of a frame: the oldest queued, with the status it went out
+	with, or failed by a flush if it never went out.
+*/
+static void TestTxDone(void *pvTag, int iStatus)
+{
+	tTestFrame const *pstFrame = TestPeek(&stTxFifo, 0);
+
+	TEST_CHECK(TestCount(&stTxFifo) > 0);
+	TEST_EQUAL((uintptr_t)pvTag, pstFrame->ulSeq);
+	TEST_EQUAL(iStatus, (ulTxSent > 0) ? pstFrame->iStatus : -1);
+	stTxFifo.ulTail++;
+	if(ulTxSent > 0)
+	{
+		ulTxSent--;
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestTxCheckRing
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The wrap bit is on the last descriptor only, every descriptor not
+	holding a frame belongs to software, and the free count keeps one
+	descriptor back.
+*/
+static void TestTxCheckRing(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < TEST_TX_DESCS; i++)
+	{
+		uint32_t const ulSince = (i + TEST_TX_DESCS - stTx.ulTail)
+			% TEST_TX_DESCS;
+
+		TEST_EQUAL((astTxDesc[i].ulStatus & GMAC_TX_WRAP) != 0,
+			i == TEST_TX_DESCS - 1);
+		if(ulSince >= stTx.ulBusy)
+		{
+			TEST_CHECK(astTxDesc[i].ulStatus & GMAC_TX_USED);
+		}
+	}
+	TEST_EQUAL(stTx.ulBusy, ulTxDescsBusy);
+	TEST_EQUAL(GmacTxRingFree(&stTx), TEST_TX_DESCS - 1 - ulTxDescsBusy);
+}
+
+/** ***************************************************************************
+	Name:               TestRxStream
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Frames arrive and are taken in random bursts, round the ring many
+	times. Every frame that fits one buffer comes out once, in order and
+	whole; every frame over several buffers is dropped and counted once;
+	frames the DMA had no room for are the only ones missing.
+*/
+static void TestRxStream(void)
+{
+	uint32_t ulSeq = 0;
+	uint32_t ulOversize = 0;
+	uint32_t ulDelivered = 0;
+	uint32_t i;
+
+	memset(&stRxFifo, 0, sizeof(stRxFifo));
+	GmacRxRingInit(&stRx, astRxDesc, TEST_RX_DESCS, aucRxBufs,
+		TEST_RX_BUF_SIZE);
+	ulDmaRx = 0;
+	TestRxCheckRing();
+	for(i = 0; i < TEST_RX_DESCS; i++)
+	{
+		TEST_EQUAL(astRxDesc[i].ulAddr & GMAC_RX_OWN, 0);
+	}
+
+	for(i = 0; i < 50000; i++)
+	{
+		if(TestRand() % 100 < 55)
+		{
+			uint32_t ulLen = 1 + TestRand() % TEST_RX_BUF_SIZE;
+
+			if(TestRand() % 10 == 0)
+			{
+				ulLen = TEST_RX_BUF_SIZE + 1
+					+ TestRand() % (3 * TEST_RX_BUF_SIZE);
+			}
+			if(TestRxFrame(ulSeq, ulLen))
+			{
+				if(ulLen <= TEST_RX_BUF_SIZE)
+				{
+					TestPush(&stRxFifo, ulSeq, ulLen, 0);
+				}
+				else
+				{
+					ulOversize++;
+				}
+			}
+			ulSeq++;
+		}
+		else
+		{
+			ulDelivered += TestRxDrain(1 + TestRand() % 4);
+		}
+	}
+	ulDelivered += TestRxDrain(TEST_RX_DESCS);
+
+	TestRxCheckRing();
+	TEST_EQUAL(TestCount(&stRxFifo), 0);
+	TEST_EQUAL(stRx.ulFrames, ulDelivered);
+	TEST_EQUAL(stRx.ulDropped, ulOversize);
+	TEST_CHECK(ulOversize > 100);
+	TEST_CHECK(ulDelivered > 10000);
+	TEST_EQUAL(stRx.ulHead, ulDmaRx);
+	for(i = 0; i < TEST_RX_DESCS; i++)
+	{
+		TEST_EQUAL(astRxDesc[i].ulAddr & GMAC_RX_OWN, 0);
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestRxPartial
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The DMA hands each buffer over as it fills it, so software can see the
+	start of a long frame before its end has arrived. The start is dropped
+	and counted, its buffers go straight back to the DMA; the rest of the
+	frame, arriving later with no start of frame, is dropped without being
+	counted again, and the frame after it comes out.
+*/
+static void TestRxPartial(void)
+{
+	uint8_t *pucFrame;
+	uint32_t ulStart;
+	uint32_t i;
+
+	memset(&stRxFifo, 0, sizeof(stRxFifo));
+	GmacRxRingInit(&stRx, astRxDesc, TEST_RX_DESCS, aucRxBufs,
+		TEST_RX_BUF_SIZE);
+
+	/* start near the end so the frame wraps round the ring */
+	for(ulDmaRx = 0, i = 0; i < TEST_RX_DESCS - 2; i++)
+	{
+		TEST_EQUAL(TestRxFrame(i, 60), 1);
+		TestPush(&stRxFifo, i, 60, 0);
+	}
+	TEST_EQUAL(TestRxDrain(TEST_RX_DESCS), TEST_RX_DESCS - 2);
+	ulStart = ulDmaRx;
+
+	TestRxBuffer(100, 0, TEST_RX_BUF_SIZE, GMAC_RX_SOF, 0);
+	TestRxBuffer(100, TEST_RX_BUF_SIZE, TEST_RX_BUF_SIZE, 0, 0);
+	TestRxBuffer(100, 2 * TEST_RX_BUF_SIZE, TEST_RX_BUF_SIZE, 0, 0);
+	TEST_EQUAL(GmacRxRingPeek(&stRx, &pucFrame), 0);
+	TEST_EQUAL(stRx.ulDropped, 1);
+	TEST_EQUAL(stRx.ulHead, ulDmaRx);
+	for(i = 0; i < 3; i++)
+	{
+		TEST_EQUAL(astRxDesc[(ulStart + i) % TEST_RX_DESCS].ulAddr
+			& GMAC_RX_OWN, 0);
+	}
+
+	TestRxBuffer(100, 3 * TEST_RX_BUF_SIZE, 10, GMAC_RX_EOF,
+		3 * TEST_RX_BUF_SIZE + 10);
+	TEST_EQUAL(TestRxFrame(101, 42), 1);
+	TestPush(&stRxFifo, 101, 42, 0);
+	TEST_EQUAL(TestRxDrain(TEST_RX_DESCS), 1);
+	TEST_EQUAL(stRx.ulDropped, 1);
+	TEST_EQUAL(stRx.ulFrames, TEST_RX_DESCS - 1);
+
+	/* a frame filling its buffer exactly still fits */
+	TEST_EQUAL(TestRxFrame(102, TEST_RX_BUF_SIZE), 1);
+	TestPush(&stRxFifo, 102, TEST_RX_BUF_SIZE, 0);
+	TEST_EQUAL(TestRxFrame(103, TEST_RX_BUF_SIZE + 1), 1);
+	TEST_EQUAL(TestRxDrain(TEST_RX_DESCS), 1);
+	TEST_EQUAL(stRx.ulDropped, 2);
+	TestRxCheckRing();
+}
+
+/** ***************************************************************************
+	Name:               TestTxStream
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Frames of one to four buffers are queued, sent and reclaimed in random
+	bursts, round the ring many times. The DMA only ever sees whole frames
+	and stops at the end of what is queued; a frame is refused exactly when
+	it doesn't fit; the completions come back in order with the status the
+	frame went out with.
+*/
+static void TestTxStream(void)
+{
+	uint32_t ulSeq = 0;
+	uint32_t ulFrames = 0;
+	uint32_t ulErrors = 0;
+	uint32_t i;
+
+	memset(&stTxFifo, 0, sizeof(stTxFifo));
+	GmacTxRingInit(&stTx, astTxDesc, TEST_TX_DESCS);
+	ulDmaTx = 0;
+	ulTxSent = 0;
+	ulTxDescsBusy = 0;
+	TestTxCheckRing();
+	TEST_EQUAL(GmacTxRingQueue(&stTx, NULL, 0, NULL), -1);
+
+	for(i = 0; i < 50000; i++)
+	{
+		uint32_t const ulAction = TestRand() % 3;
+
+		if(ulAction == 0)
+		{
+			if(TestTxQueue(ulSeq, 1 + TestRand() % TEST_TX_BUFS) == 0)
+			{
+				ulSeq++;
+			}
+		}
+		else if(ulAction == 1)
+		{
+			TestTxDma(TestRand() % 4, 5);
+		}
+		else
+		{
+			uint32_t const ulSent = ulTxSent;
+			uint32_t ulDescs = 0;
+			uint32_t j;
+
+			for(j = 0; j < ulSent; j++)
+			{
+				tTestFrame const *pstFrame = TestPeek(&stTxFifo, j);
+
+				ulDescs += (uint32_t)stTx.aucDescs[(stTx.ulTail + ulDescs)
+					% TEST_TX_DESCS];
+				ulErrors += (pstFrame->iStatus != 0);
+			}
+			TEST_EQUAL(GmacTxRingReclaim(&stTx, TestTxDone), ulSent);
+			TEST_EQUAL(ulTxSent, 0);
+			ulTxDescsBusy -= ulDescs;
+			ulFrames += ulSent;
+		}
+		TestTxCheckRing();
+	}
+
+	TEST_CHECK(ulSeq > 5000);
+	TEST_EQUAL(stTx.ulFrames + stTx.ulErrors, ulFrames);
+	TEST_EQUAL(stTx.ulErrors, ulErrors);
+	TEST_CHECK(ulErrors > 0);
+}
+
+/** ***************************************************************************
+	Name:               TestTxFlush
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	After a transmit error the GMAC stops and goes back to the first
+	descriptor. A flush completes the frames sent, fails the rest, and
+	leaves the ring empty for the GMAC to start over from the beginning.
+*/
+static void TestTxFlush(void)
+{
+	uint32_t i;
+
+	memset(&stTxFifo, 0, sizeof(stTxFifo));
+	GmacTxRingInit(&stTx, astTxDesc, TEST_TX_DESCS);
+	ulDmaTx = 0;
+	ulTxSent = 0;
+	ulTxDescsBusy = 0;
+
+	/* move the ring away from its first descriptor */
+	TEST_EQUAL(TestTxQueue(0, 3), 0);
+	TestTxDma(1, 0);
+	TEST_EQUAL(GmacTxRingReclaim(&stTx, TestTxDone), 1);
+	ulTxDescsBusy = 0;
+
+	TEST_EQUAL(TestTxQueue(1, 3), 0);
+	TEST_EQUAL(TestTxQueue(2, 3), 0);
+	TEST_EQUAL(TestTxQueue(3, 2), -1);
+	TEST_EQUAL(TestTxQueue(3, 1), 0);
+	TestTxDma(1, 0);
+	TEST_EQUAL(ulTxSent, 1);
+
+	GmacTxRingFlush(&stTx, TestTxDone);
+	TEST_EQUAL(TestCount(&stTxFifo), 0);
+	TEST_EQUAL(stTx.ulFrames, 2);
+	TEST_EQUAL(stTx.ulErrors, 2);
+	TEST_EQUAL(stTx.ulBusy, 0);
+	TEST_EQUAL(stTx.ulHead, 0);
+	TEST_EQUAL(stTx.ulTail, 0);
+	ulTxDescsBusy = 0;
+	TestTxCheckRing();
+	for(i = 0; i < TEST_TX_DESCS; i++)
+	{
+		TEST_CHECK(astTxDesc[i].ulStatus & GMAC_TX_USED);
+	}
+
+	ulDmaTx = 0;
+	TEST_EQUAL(TestTxQueue(4, 4), 0);
+	TestTxDma(2, 0);
+	TEST_EQUAL(ulTxSent, 1);
+	TEST_EQUAL(ulDmaTx, 4);
+	TEST_EQUAL(GmacTxRingReclaim(&stTx, TestTxDone), 1);
+	TEST_EQUAL(stTx.ulFrames, 3);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,587 @@
+/** ***************************************************************************
+File Name:  test_link.c
+
+Project:    Platform 4
+
+Purpose:    Link receive path test: register models of the USART and of the
+            XDMAC ring deliver packets of frames to LinkPoll(), with the
+            USART interrupt played wherever it can come in
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "crc.h"
+#include "frame.h"
+#include "link.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* packets of 1 to TEST_PKT_FRAMES frames, each with up to TEST_PAYLOAD_MAX
+	bytes of payload */
+#define TEST_PKT_FRAMES      4
+#define TEST_PAYLOAD_MAX     64
+#define TEST_PKT_MAX         (TEST_PKT_FRAMES \
+	* (TEST_PAYLOAD_MAX + FRAME_OVERHEAD))
+
+/* packets sent by each test */
+#define TEST_PACKETS         3000
+
+/* time base ticks from the start of one packet to the start of the next */
+#define TEST_PKT_TICKS       20000
+
+/* expected arrival times kept, by sequence number; far more than can be in
+	flight */
+#define TEST_EXPECT          256
+
+
+/* Module Type Definitions */
+
+/* a packet on the line */
+typedef struct
+{
+	uint8_t aucData[TEST_PKT_MAX];
+	uint32_t ulLen;
+	/* bytes the receiver has taken so far */
+	uint32_t ulSent;
+	/* time base tick count at which the receiver has its first byte */
+	uint64_t ullTicks;
+} tTestPacket;
+
+/* the DMA side of the model, see test_rx_ring.c */
+typedef struct
+{
+	uint8_t ucFetchDue;
+	uint32_t ulIrqPending;
+} tTestDma;
+
+
+/* Module Function Declarations */
+
+static void TestDmaFetch(void);
+static void TestDmaWrite(uint8_t const *pucData, uint32_t ulLen);
+static void TestDmaIrq(void);
+static uint32_t TestRand(void);
+static void TestBuild(tTestPacket *pstPacket);
+static void TestSend(tTestPacket *pstPacket, uint32_t ulLen);
+static void TestIdle(void);
+static void TestFrame(tLink *pstLink);
+static void TestWindowIrq(void);
+static void TestStart(void);
+static void TestCheckAll(void);
+static void TestPackets(void);
+static void TestPollWindow(void);
+
+
+/* Module Variable Declarations */
+
+static tLink *pstTestLink;
+static tTestDma stDma;
+
+/* time base */
+static uint64_t ullTestTicks;
+
+/* frames built and seen, the sequence number of the next of each, and
+	the time each is expected at */
+static uint32_t ulBuilt;
+static uint32_t ulSeen;
+static uint16_t usBuildSeq;
+static uint16_t usSeenSeq;
+static uint64_t aullExpect[TEST_EXPECT];
+
+/* what TestWindowIrq() delivers, and whether it did */
+static tTestPacket *pstWindowPacket;
+static uint32_t ulWindowLen;
+static uint32_t ulWindowIrqs;
+
+static uint32_t ulRandState = 24680;
+
+
+/* Global Variables (Must be justified!) */
+
+/* register model of the link USART, see test_link.h */
+Usart stTestUsart;
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the link receive tests.
+*/
+int main(void)
+{
+	CrcInit();
+	TestPackets();
+	TestPollWindow();
+	return TestResult("link");
+}
+
+/** ***************************************************************************
+	Name:               PpsTicks, PpsTime
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             The test's time base
+	Caveats / Effect:   None
+
+	Description:
+	Host versions: the time base is a plain count the test moves on, and
+	times are kept in its ticks.
+*/
+uint64_t PpsTicks(void)
+{
+	return ullTestTicks;
+}
+
+tPpsTime PpsTime(uint64_t ullTicks)
+{
+	return ullTicks;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestDmaFetch
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Loads the view 1 descriptor CNDA points at, which must read the USART's
+	receive holding register.
+*/
+static void TestDmaFetch(void)
+{
+	XdmacChid volatile *pstChan =
+		&XDMAC->XDMAC_CHID[pstTestLink->pstConfig->ulRxChannel];
+	lld_view1 const *pstDesc =
+		(lld_view1 const *)(uintptr_t)(pstChan->XDMAC_CNDA & XDMAC_CNDA_NDA_Msk);
+
+	TEST_EQUAL(pstDesc->mbr_sa, (uint32_t)(uintptr_t)&stTestUsart.US_RHR);
+	pstChan->XDMAC_CDA = pstDesc->mbr_da;
+	pstChan->XDMAC_CUBC = pstDesc->mbr_ubc & XDMAC_UBC_UBLEN_Msk;
+	pstChan->XDMAC_CNDA = pstDesc->mbr_nda;
+	pstChan->XDMAC_CC |= XDMAC_CC_INITD;
+	stDma.ucFetchDue = 0;
+}
+
+/** ***************************************************************************
+	Name:               TestDmaWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Moves received bytes into the ring through the current descriptor,
+	leaving the end of block interrupts pending for TestDmaIrq().
+*/
+static void TestDmaWrite(uint8_t const *pucData, uint32_t ulLen)
+{
+	XdmacChid volatile *pstChan =
+		&XDMAC->XDMAC_CHID[pstTestLink->pstConfig->ulRxChannel];
+
+	while(ulLen--)
+	{
+		if(stDma.ucFetchDue)
+		{
+			TestDmaFetch();
+		}
+		*(uint8_t *)(uintptr_t)pstChan->XDMAC_CDA = *pucData++;
+		pstChan->XDMAC_CDA++;
+		if(--pstChan->XDMAC_CUBC == 0)
+		{
+			stDma.ulIrqPending++;
+			stDma.ucFetchDue = 1;
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestDmaIrq
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Takes the pending end of block interrupts through LinkDmaIsr(), as
+	XDMAC_Handler would.
+*/
+static void TestDmaIrq(void)
+{
+	XdmacChid volatile *pstChan =
+		&XDMAC->XDMAC_CHID[pstTestLink->pstConfig->ulRxChannel];
+
+	while(stDma.ulIrqPending)
+	{
+		stDma.ulIrqPending--;
+		TEST_REG(pstChan->XDMAC_CIS) = XDMAC_CIS_BIS;
+		LinkDmaIsr(pstTestLink);
+		TEST_REG(pstChan->XDMAC_CIS) = 0;
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestBuild
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Moves the time base on to the start of the packet
+
+	Description:
+	Builds the next packet of frames with consecutive sequence numbers, each
+	payload filled from its sequence number, and notes when each frame is
+	due to be stamped: the packet's first byte arrives at the current time
+	and the frames after it one character time per byte later.
+*/
+static void TestBuild(tTestPacket *pstPacket)
+{
+	uint32_t const ulFrames = TestRand() % TEST_PKT_FRAMES + 1;
+	uint8_t aucPayload[TEST_PAYLOAD_MAX];
+	uint32_t i;
+	uint32_t j;
+
+	ullTestTicks += TEST_PKT_TICKS;
+	pstPacket->ullTicks = ullTestTicks;
+	pstPacket->ulLen = 0;
+	pstPacket->ulSent = 0;
+	for(i = 0; i < ulFrames; i++)
+	{
+		uint32_t const ulPayload = TestRand() % (TEST_PAYLOAD_MAX + 1);
+
+		for(j = 0; j < ulPayload; j++)
+		{
+			aucPayload[j] = (uint8_t)(usBuildSeq * 7 + j);
+		}
+		aullExpect[usBuildSeq % TEST_EXPECT] = pstPacket->ullTicks
+			+ (((uint64_t)pstPacket->ulLen * pstTestLink->ulCharTicks) >> 16);
+		pstPacket->ulLen += FrameBuild(&pstPacket->aucData[pstPacket->ulLen],
+			usBuildSeq, aucPayload, ulPayload);
+		usBuildSeq++;
+		ulBuilt++;
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestSend
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The receiver takes the next ulLen bytes of a packet. The first byte of
+	the packet raises RXRDY once it is all in, a character time after the
+	packet started, which interrupts if the link has it enabled; the DMA
+	takes every byte, and its end of block interrupts are taken once the
+	bytes are in.
+*/
+static void TestSend(tTestPacket *pstPacket, uint32_t ulLen)
+{
+	if((ulLen != 0) && (pstPacket->ulSent == 0))
+	{
+		TestDmaWrite(pstPacket->aucData, 1);
+		pstPacket->ulSent = 1;
+		ulLen--;
+		ullTestTicks = pstPacket->ullTicks + (pstTestLink->ulCharTicks >> 16);
+		if(stTestUsart.US_IMR & US_IMR_RXRDY)
+		{
+			TEST_REG(stTestUsart.US_CSR) |= US_CSR_RXRDY;
+			USART1_Handler();
+			TEST_REG(stTestUsart.US_CSR) &= ~US_CSR_RXRDY;
+		}
+	}
+	TestDmaWrite(&pstPacket->aucData[pstPacket->ulSent], ulLen);
+	pstPacket->ulSent += ulLen;
+	TestDmaIrq();
+}
+
+/** ***************************************************************************
+	Name:               TestIdle
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The line has gone idle for the receiver timeout.
+*/
+static void TestIdle(void)
+{
+	TEST_REG(stTestUsart.US_CSR) |= US_CSR_TIMEOUT;
+	USART1_Handler();
+	TEST_EQUAL(stTestUsart.US_CSR & US_CSR_TIMEOUT, 0);
+}
+
+/** ***************************************************************************
+	Name:               TestFrame
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The LinkPoll() frame handler: every frame must come in order, intact,
+	and stamped with the time its first byte arrived.
+*/
+static void TestFrame(tLink *pstLink)
+{
+	uint16_t const usSeq = FrameGetSeq(&pstLink->stParser);
+	uint8_t const *pucPayload = FrameGetPayload(&pstLink->stParser);
+	uint32_t const ulPayload = FrameGetLength(&pstLink->stParser);
+	uint32_t j;
+
+	TEST_EQUAL(usSeq, usSeenSeq);
+	TEST_EQUAL(LinkFrameTime(pstLink), aullExpect[usSeq % TEST_EXPECT]);
+	for(j = 0; j < ulPayload; j++)
+	{
+		if(!TEST_EQUAL(pucPayload[j], (uint8_t)(usSeq * 7 + j)))
+		{
+			break;
+		}
+	}
+	usSeenSeq = (uint16_t)(usSeq + 1);
+	ulSeen++;
+}
+
+/** ***************************************************************************
+	Name:               TestWindowIrq
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   pfnTestIrqSave, once
+
+	Description:
+	Plays the USART interrupts that come in as LinkPoll() is about to mask
+	them, once it has found the packet queue empty: the packet on the line
+	ends, and ulWindowLen bytes of the next one, pstWindowPacket, arrive.
+*/
+static void TestWindowIrq(void)
+{
+	pfnTestIrqSave = NULL;
+	ulWindowIrqs++;
+	TestIdle();
+	TestSend(pstWindowPacket, ulWindowLen);
+}
+
+/** ***************************************************************************
+	Name:               TestStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Brings up the link at its default rate on fresh register models, and
+	starts the DMA on the first descriptor.
+*/
+static void TestStart(void)
+{
+	memset(&stTestXdmac, 0, sizeof(stTestXdmac));
+	memset(&stTestUsart, 0, sizeof(stTestUsart));
+	memset(&stDma, 0, sizeof(stDma));
+	TEST_EQUAL(LinksInit(LINK_BAUD), 0);
+	pstTestLink = LinkGet(0);
+	TEST_CHECK(XDMAC->XDMAC_GE & (1UL << pstTestLink->pstConfig->ulRxChannel));
+	TEST_EQUAL(stTestUsart.US_IMR & (US_IMR_TIMEOUT | US_IMR_RXRDY),
+		US_IMR_TIMEOUT | US_IMR_RXRDY);
+	TestDmaFetch();
+
+	/* one character: preamble, start frame delimiter, 8 data bits, stop */
+	TEST_EQUAL(pstTestLink->ulCharTicks, (uint32_t)((((uint64_t)PPS_TICK_HZ
+		* (LINK_MAN_PREAMBLE_LEN + 3 + 8 + 1)) << 16) / LINK_BAUD));
+
+	ulBuilt = 0;
+	ulSeen = 0;
+	usBuildSeq = 0;
+	usSeenSeq = 0;
+	ulWindowIrqs = 0;
+	pfnTestIrqSave = NULL;
+}
+
+/** ***************************************************************************
+	Name:               TestCheckAll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Once the line is idle and polled, every frame built has been seen and
+	nothing was counted as lost or broken.
+*/
+static void TestCheckAll(void)
+{
+	TEST_EQUAL(ulSeen, ulBuilt);
+	TEST_EQUAL(usSeenSeq, usBuildSeq);
+	TEST_EQUAL(PktQueueCount(&pstTestLink->stRxPackets), 0);
+	TEST_EQUAL(LinkErrors(pstTestLink), 0);
+	TEST_EQUAL(pstTestLink->stParser.ulSeqLost, 0);
+	TEST_EQUAL(pstTestLink->stParser.ulSkipped, 0);
+	TEST_EQUAL(pstTestLink->stRxRing.ulOverruns, 0);
+	TEST_EQUAL(pstTestLink->ulRxErrors, 0);
+	TEST_EQUAL(pstTestLink->stRxPackets.ulOverflows, 0);
+}
+
+/** ***************************************************************************
+	Name:               TestPackets
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Packets arrive with the main loop polling at random points: part way
+	through a packet, after its last byte but before the timeout, or only
+	after a few packets have queued up. Every frame comes out once, in
+	order, with the time of its packet's first byte plus its offset.
+*/
+static void TestPackets(void)
+{
+	static tTestPacket stPacket;
+	uint32_t i;
+
+	TestStart();
+	for(i = 0; i < TEST_PACKETS; i++)
+	{
+		TestBuild(&stPacket);
+		if(TestRand() & 1)
+		{
+			TestSend(&stPacket, TestRand() % stPacket.ulLen);
+			LinkPoll(pstTestLink, TestFrame);
+		}
+		TestSend(&stPacket, stPacket.ulLen - stPacket.ulSent);
+		if(TestRand() & 1)
+		{
+			LinkPoll(pstTestLink, TestFrame);
+		}
+		TestIdle();
+		if(TestRand() % 4 != 0)
+		{
+			LinkPoll(pstTestLink, TestFrame);
+		}
+	}
+	LinkPoll(pstTestLink, TestFrame);
+
+	TestCheckAll();
+	TEST_EQUAL(pstTestLink->ulIdleCount, TEST_PACKETS);
+}
+
+/** ***************************************************************************
+	Name:               TestPollWindow
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A packet has fully arrived and LinkPoll() finds the queue empty; just
+	before it masks the interrupts, the timeout queues that packet and the
+	first bytes of the next arrive and are stamped. The packet must still
+	be parsed on its own with its own time, and the frame the next one
+	starts with must survive to be completed once it has all arrived.
+*/
+static void TestPollWindow(void)
+{
+	static tTestPacket astPacket[2];
+	uint32_t i;
+
+	TestStart();
+	TestBuild(&astPacket[0]);
+	for(i = 0; i < TEST_PACKETS; i++)
+	{
+		tTestPacket *pstPacket = &astPacket[i & 1];
+		tTestPacket *pstNext = &astPacket[(i + 1) & 1];
+
+		TestSend(pstPacket, pstPacket->ulLen - pstPacket->ulSent);
+		TestBuild(pstNext);
+
+		pstWindowPacket = pstNext;
+		ulWindowLen = TestRand() % pstNext->ulLen;
+		pfnTestIrqSave = TestWindowIrq;
+		LinkPoll(pstTestLink, TestFrame);
+		TEST_EQUAL(ulWindowIrqs, i + 1);
+	}
+	TestSend(&astPacket[TEST_PACKETS & 1],
+		astPacket[TEST_PACKETS & 1].ulLen - astPacket[TEST_PACKETS & 1].ulSent);
+	TestIdle();
+	LinkPoll(pstTestLink, TestFrame);
+
+	TestCheckAll();
+	TEST_EQUAL(pstTestLink->ulIdleCount, TEST_PACKETS + 1);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,438 @@
+/** ***************************************************************************
+File Name:  test_pkt_queue.c
+
+Project:    Platform 4
+
+Purpose:    Packet descriptor queue test: full and empty, the index wrap,
+            and a producer and a consumer thread running against each other
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "pkt_queue.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* descriptors passed between the threads */
+#define TEST_THREAD_DESCS    1000000UL
+
+/* descriptors between the times the consumer lets the queue fill */
+#define TEST_FULL_PERIOD     4096
+
+
+/* Module Type Definitions */
+
+/* the two sides of the stress test, each with its own random sequence */
+typedef struct
+{
+	tPktQueue *pstQueue;
+	uint32_t ulRandState;
+	/* producer: pushes refused; consumer: descriptors not as pushed, and
+		the times it waited for the queue to fill */
+	uint32_t ulRefused;
+	uint32_t ulBad;
+	uint32_t ulReceived;
+	uint32_t ulFull;
+} tTestSide;
+
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(uint32_t *pulState);
+static void TestDesc(tPktDesc *pstDesc, uint32_t ulSeq);
+static uint32_t TestDescBad(tPktDesc const *pstDesc, uint32_t ulSeq);
+static void TestDelay(uint32_t *pulState);
+static void *TestProducer(void *pvSide);
+static void *TestConsumer(void *pvSide);
+static void TestFull(void);
+static void TestWrap(void);
+static void TestThreads(void);
+
+
+/* Module Variable Declarations */
+
+static tPktQueue stQueue;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the packet queue tests.
+*/
+int main(void)
+{
+	TestFull();
+	TestWrap();
+	TestThreads();
+	return TestResult("pkt_queue");
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence per state, so each thread has its own.
+*/
+static uint32_t TestRand(uint32_t *pulState)
+{
+	*pulState = *pulState * 1103515245UL + 12345UL;
+	return (*pulState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestDesc
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Fills every field of a descriptor from its sequence number, so a
+	descriptor read half old and half new is seen.
+*/
+static void TestDesc(tPktDesc *pstDesc, uint32_t ulSeq)
+{
+	pstDesc->pucData = (uint8_t const *)(uintptr_t)(ulSeq * 7UL);
+	pstDesc->ulLen = ulSeq;
+	pstDesc->ullTicks = ((uint64_t)ulSeq << 32) | (ulSeq ^ 0xA5A5A5A5UL);
+	pstDesc->ulStatus = ~ulSeq;
+}
+
+/** ***************************************************************************
+	Name:               TestDescBad
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             1 if a descriptor isn't the one TestDesc() made
+	Caveats / Effect:   None
+
+	Description:
+	Checks a descriptor against its sequence number.
+*/
+static uint32_t TestDescBad(tPktDesc const *pstDesc, uint32_t ulSeq)
+{
+	tPktDesc stExpected;
+
+	TestDesc(&stExpected, ulSeq);
+	return (pstDesc->pucData != stExpected.pucData)
+		|| (pstDesc->ulLen != stExpected.ulLen)
+		|| (pstDesc->ullTicks != stExpected.ullTicks)
+		|| (pstDesc->ulStatus != stExpected.ulStatus);
+}
+
+/** ***************************************************************************
+	Name:               TestDelay
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Holds a thread up for a random while now and then, so the queue is seen
+	empty, full and in between.
+*/
+static void TestDelay(uint32_t *pulState)
+{
+	uint32_t ulRand = TestRand(pulState);
+
+	if((ulRand & 0xFF) == 0)
+	{
+		sched_yield();
+	}
+	else if((ulRand & 0x0F) == 0)
+	{
+		uint32_t volatile ulSpin = ulRand >> 20;
+
+		while(ulSpin)
+		{
+			ulSpin--;
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestProducer
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             NULL
+	Caveats / Effect:   Thread
+
+	Description:
+	The ISR side: pushes the descriptors in sequence, retrying a refused one
+	once the consumer has made room.
+*/
+static void *TestProducer(void *pvSide)
+{
+	tTestSide *pstSide = pvSide;
+	tPktDesc stDesc;
+	uint32_t ulSeq;
+
+	for(ulSeq = 0; ulSeq < TEST_THREAD_DESCS; ulSeq++)
+	{
+		TestDesc(&stDesc, ulSeq);
+		while(PktQueuePush(pstSide->pstQueue, &stDesc) != 0)
+		{
+			pstSide->ulRefused++;
+			sched_yield();
+		}
+		TestDelay(&pstSide->ulRandState);
+	}
+	return NULL;
+}
+
+/** ***************************************************************************
+	Name:               TestConsumer
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             NULL
+	Caveats / Effect:   Thread
+
+	Description:
+	The main loop side: takes the descriptors in order, and checks each one
+	again after a delay, as it must stay untouched until it is popped.
+*/
+static void *TestConsumer(void *pvSide)
+{
+	tTestSide *pstSide = pvSide;
+
+	while(pstSide->ulReceived < TEST_THREAD_DESCS)
+	{
+		tPktDesc const *pstDesc = PktQueuePeek(pstSide->pstQueue);
+		uint32_t ulCount;
+
+		if(!pstDesc)
+		{
+			sched_yield();
+			continue;
+		}
+		ulCount = PktQueueCount(pstSide->pstQueue);
+		if((ulCount == 0) || (ulCount > PKT_QUEUE_SIZE))
+		{
+			pstSide->ulBad++;
+		}
+		pstSide->ulBad += TestDescBad(pstDesc, pstSide->ulReceived);
+		TestDelay(&pstSide->ulRandState);
+
+		/* now and then hold off until the producer has found the queue
+			full, while there are enough descriptors left to fill it */
+		if(((pstSide->ulReceived % TEST_FULL_PERIOD) == 0)
+			&& (pstSide->ulReceived + PKT_QUEUE_SIZE < TEST_THREAD_DESCS))
+		{
+			uint32_t const ulOverflows =
+				__atomic_load_n(&pstSide->pstQueue->ulOverflows,
+				__ATOMIC_RELAXED);
+
+			while(__atomic_load_n(&pstSide->pstQueue->ulOverflows,
+				__ATOMIC_RELAXED) == ulOverflows)
+			{
+				sched_yield();
+			}
+			pstSide->ulFull++;
+		}
+		pstSide->ulBad += TestDescBad(pstDesc, pstSide->ulReceived);
+		PktQueuePop(pstSide->pstQueue);
+		pstSide->ulReceived++;
+	}
+	return NULL;
+}
+
+/** ***************************************************************************
+	Name:               TestFull
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	An empty queue has nothing to peek, a full one refuses and counts the
+	overflow, and the high water mark stays at the most ever queued.
+*/
+static void TestFull(void)
+{
+	tPktDesc stDesc;
+	uint32_t i;
+
+	PktQueueInit(&stQueue);
+	TEST_CHECK(PktQueuePeek(&stQueue) == NULL);
+	TEST_EQUAL(PktQueueCount(&stQueue), 0);
+
+	for(i = 0; i < PKT_QUEUE_SIZE; i++)
+	{
+		TestDesc(&stDesc, i);
+		TEST_EQUAL(PktQueuePush(&stQueue, &stDesc), 0);
+		TEST_EQUAL(PktQueueCount(&stQueue), i + 1);
+	}
+	TestDesc(&stDesc, i);
+	TEST_EQUAL(PktQueuePush(&stQueue, &stDesc), -1);
+	TEST_EQUAL(PktQueuePush(&stQueue, &stDesc), -1);
+	TEST_EQUAL(stQueue.ulOverflows, 2);
+	TEST_EQUAL(stQueue.ulHighWater, PKT_QUEUE_SIZE);
+
+	for(i = 0; i < PKT_QUEUE_SIZE; i++)
+	{
+		tPktDesc const *pstDesc = PktQueuePeek(&stQueue);
+
+		TEST_CHECK(pstDesc != NULL);
+		if(pstDesc)
+		{
+			TEST_EQUAL(TestDescBad(pstDesc, i), 0);
+			TEST_CHECK(PktQueuePeek(&stQueue) == pstDesc);
+		}
+		PktQueuePop(&stQueue);
+	}
+	TEST_CHECK(PktQueuePeek(&stQueue) == NULL);
+
+	TestDesc(&stDesc, 99);
+	TEST_EQUAL(PktQueuePush(&stQueue, &stDesc), 0);
+	TEST_EQUAL(stQueue.ulHighWater, PKT_QUEUE_SIZE);
+	TEST_EQUAL(stQueue.ulOverflows, 2);
+}
+
+/** ***************************************************************************
+	Name:               TestWrap
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The free-running indices wrap past 2^32 without losing the count.
+*/
+static void TestWrap(void)
+{
+	tPktDesc stDesc;
+	uint32_t ulPushed = 0;
+	uint32_t ulPopped = 0;
+	uint32_t i;
+
+	PktQueueInit(&stQueue);
+	stQueue.ulHead = 0xFFFFFFF5UL;
+	stQueue.ulTail = 0xFFFFFFF5UL;
+
+	for(i = 0; i < 10; i++)
+	{
+		while(PktQueueCount(&stQueue) < PKT_QUEUE_SIZE - i)
+		{
+			TestDesc(&stDesc, ulPushed++);
+			TEST_EQUAL(PktQueuePush(&stQueue, &stDesc), 0);
+		}
+		while(PktQueueCount(&stQueue) > i)
+		{
+			tPktDesc const *pstDesc = PktQueuePeek(&stQueue);
+
+			TEST_CHECK(pstDesc != NULL);
+			if(pstDesc)
+			{
+				TEST_EQUAL(TestDescBad(pstDesc, ulPopped), 0);
+			}
+			PktQueuePop(&stQueue);
+			ulPopped++;
+		}
+	}
+	TEST_CHECK(stQueue.ulHead < 0x100);
+	TEST_EQUAL(PktQueueCount(&stQueue), ulPushed - ulPopped);
+	TEST_EQUAL(stQueue.ulOverflows, 0);
+}
+
+/** ***************************************************************************
+	Name:               TestThreads
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The producer and the consumer as two threads, the roles the ISR and the
+	main loop have on the target. Every descriptor arrives once, in order
+	and whole, and every refused push is counted as an overflow. The
+	consumer lets the queue fill now and then, so the producer also runs
+	against a full queue.
+*/
+static void TestThreads(void)
+{
+	tTestSide stProducer;
+	tTestSide stConsumer;
+	pthread_t stProducerThread;
+	pthread_t stConsumerThread;
+
+	PktQueueInit(&stQueue);
+	memset(&stProducer, 0, sizeof(stProducer));
+	memset(&stConsumer, 0, sizeof(stConsumer));
+	stProducer.pstQueue = &stQueue;
+	stProducer.ulRandState = 11;
+	stConsumer.pstQueue = &stQueue;
+	stConsumer.ulRandState = 22;
+
+	TEST_EQUAL(pthread_create(&stConsumerThread, NULL, TestConsumer,
+		&stConsumer), 0);
+	TEST_EQUAL(pthread_create(&stProducerThread, NULL, TestProducer,
+		&stProducer), 0);
+	TEST_EQUAL(pthread_join(stProducerThread, NULL), 0);
+	TEST_EQUAL(pthread_join(stConsumerThread, NULL), 0);
+
+	TEST_EQUAL(stConsumer.ulReceived, TEST_THREAD_DESCS);
+	TEST_EQUAL(stConsumer.ulBad, 0);
+	TEST_EQUAL(PktQueueCount(&stQueue), 0);
+	TEST_EQUAL(stQueue.ulOverflows, stProducer.ulRefused);
+	TEST_EQUAL(stConsumer.ulFull, TEST_THREAD_DESCS / TEST_FULL_PERIOD + 1);
+	TEST_CHECK(stQueue.ulOverflows >= stConsumer.ulFull);
+	TEST_EQUAL(stQueue.ulHighWater, PKT_QUEUE_SIZE);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
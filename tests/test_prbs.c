@@ -0,0 +1,469 @@
+/** ***************************************************************************
+File Name:  test_prbs.c
+
+Project:    Platform 4
+
+Purpose:    PRBS and bit error rate test: the transmitter's DMA chain sends
+            the sequence over a simulated noisy link to the checker
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "ber.h"
+#include "prbs.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+#define TEST_CHANNEL         5
+#define TEST_PER_ID          XDMAC_CHANNEL_HWID_USART1_TX
+
+/* bytes sent over the link in each run */
+#define TEST_LINK_BYTES      (1UL << 20)
+
+
+/* Module Type Definitions */
+
+/* what the link did to the stream */
+typedef struct
+{
+	/* bit errors per million bits, 0 for a clean link */
+	uint32_t ulPpm;
+	/* a byte dropped, and a byte added, at these positions (0 for none) */
+	uint32_t ulDropAt;
+	uint32_t ulAddAt;
+} tTestLink;
+
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static void TestDmaFetch(void);
+static uint32_t TestDmaSend(uint8_t *pucDst, uint32_t ulLen);
+static uint32_t TestLink(uint32_t ulOrder, tTestLink const *pstLink);
+static void TestSequence(void);
+static void TestNoisy(void);
+static void TestSlips(void);
+static void TestFormat(void);
+
+
+/* Module Variable Declarations */
+
+/* statics, as the DMA model works with 32 bit addresses */
+static tBerTx stTx;
+static tPrbsCheck stCheck;
+static uint32_t ulTestThr;
+
+/* the received stream, and the bits the link flipped in each byte */
+static uint8_t aucRx[TEST_LINK_BYTES + 16];
+static uint8_t aucFlips[TEST_LINK_BYTES + 16];
+
+static uint8_t aucSent[TEST_LINK_BYTES];
+
+static uint32_t ulRandState = 777;
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the PRBS and bit error rate tests.
+*/
+int main(void)
+{
+	TestSequence();
+	TestNoisy();
+	TestSlips();
+	TestFormat();
+	return TestResult("prbs");
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestDmaFetch
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Loads the view 1 descriptor CNDA points at, as the XDMAC does at the
+	start and at the end of each microblock; CNDA then holds the one after.
+*/
+static void TestDmaFetch(void)
+{
+	XdmacChid volatile *pstChan = &XDMAC->XDMAC_CHID[TEST_CHANNEL];
+	lld_view1 const *pstDesc =
+		(lld_view1 const *)(uintptr_t)(pstChan->XDMAC_CNDA & XDMAC_CNDA_NDA_Msk);
+
+	TEST_EQUAL(pstDesc->mbr_da, (uint32_t)(uintptr_t)&ulTestThr);
+	pstChan->XDMAC_CSA = pstDesc->mbr_sa;
+	pstChan->XDMAC_CUBC = pstDesc->mbr_ubc & XDMAC_UBC_UBLEN_Msk;
+	pstChan->XDMAC_CNDA = pstDesc->mbr_nda;
+}
+
+/** ***************************************************************************
+	Name:               TestDmaSend
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of end of block interrupts raised
+	Caveats / Effect:   None
+
+	Description:
+	Moves ulLen bytes from the transmit segments to the USART, fetching the
+	next descriptor as each segment ends.
+*/
+static uint32_t TestDmaSend(uint8_t *pucDst, uint32_t ulLen)
+{
+	XdmacChid volatile *pstChan = &XDMAC->XDMAC_CHID[TEST_CHANNEL];
+	uint32_t ulIrqs = 0;
+
+	while(ulLen--)
+	{
+		*pucDst++ = *(uint8_t const *)(uintptr_t)pstChan->XDMAC_CSA;
+		pstChan->XDMAC_CSA++;
+		if(--pstChan->XDMAC_CUBC == 0)
+		{
+			TestDmaFetch();
+			ulIrqs++;
+		}
+	}
+	return ulIrqs;
+}
+
+/** ***************************************************************************
+	Name:               TestLink
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of bytes received
+	Caveats / Effect:   None
+
+	Description:
+	Sends TEST_LINK_BYTES of the sequence from the transmitter, with its ISR
+	sometimes late by a segment, through the link and into the checker in
+	chunks of random size. Every flipped bit is recorded in aucFlips[].
+*/
+static uint32_t TestLink(uint32_t ulOrder, tTestLink const *pstLink)
+{
+	uint32_t ulRx = 0;
+	uint32_t ulSent = 0;
+	uint32_t ulIrqs = 0;
+	uint32_t i;
+
+	memset(&stTestXdmac, 0, sizeof(stTestXdmac));
+	memset(aucFlips, 0, sizeof(aucFlips));
+	TEST_EQUAL(BerTxInit(&stTx, ulOrder, TEST_CHANNEL,
+		(uint32_t)(uintptr_t)&ulTestThr, TEST_PER_ID), 0);
+	TEST_EQUAL(PrbsCheckInit(&stCheck, ulOrder), 0);
+	BerTxStart(&stTx);
+	TEST_CHECK(XDMAC->XDMAC_GE & (1UL << TEST_CHANNEL));
+	TestDmaFetch();
+
+	while(ulSent < TEST_LINK_BYTES)
+	{
+		uint32_t ulLen = TestRand() % 700 + 1;
+
+		if(ulLen > TEST_LINK_BYTES - ulSent)
+		{
+			ulLen = TEST_LINK_BYTES - ulSent;
+		}
+		ulIrqs += TestDmaSend(&aucSent[ulSent], ulLen);
+		ulSent += ulLen;
+
+		/* the ISR runs, or is held off past one more segment */
+		if(ulIrqs && ((ulIrqs > 1) || (TestRand() & 1)))
+		{
+			BerTxSegmentDone(&stTx);
+			ulIrqs = 0;
+		}
+	}
+	TEST_EQUAL(stTx.ulSegCount, TEST_LINK_BYTES / BER_TX_SEGMENT_SIZE - 1
+		+ (ulIrqs ? 0 : 1));
+
+	/* the link */
+	for(i = 0; i < TEST_LINK_BYTES; i++)
+	{
+		uint8_t ucFlip = 0;
+		uint32_t j;
+
+		if(pstLink->ulDropAt && (i == pstLink->ulDropAt))
+		{
+			continue;
+		}
+		if(pstLink->ulAddAt && (i == pstLink->ulAddAt))
+		{
+			aucRx[ulRx++] = (uint8_t)TestRand();
+		}
+		for(j = 0; j < 8; j++)
+		{
+			if(TestRand() % 1000000UL < pstLink->ulPpm)
+			{
+				ucFlip |= (uint8_t)(1 << j);
+			}
+		}
+		aucFlips[ulRx] = ucFlip;
+		aucRx[ulRx++] = aucSent[i] ^ ucFlip;
+	}
+
+	for(i = 0; i < ulRx;)
+	{
+		uint32_t ulLen = TestRand() % 300 + 1;
+
+		if(ulLen > ulRx - i)
+		{
+			ulLen = ulRx - i;
+		}
+		PrbsCheck(&stCheck, &aucRx[i], ulLen);
+		i += ulLen;
+	}
+	return ulRx;
+}
+
+/** ***************************************************************************
+	Name:               TestSequence
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The byte-wide generator must give the ITU-T O.150 sequences bit for bit,
+	LSB first, as a plain shift register started from all ones does after
+	the 32 bits the generator is seeded with, and with the period of the
+	polynomial.
+*/
+static void TestSequence(void)
+{
+	static uint32_t const aulOrder[] = { PRBS_7, PRBS_15, PRBS_23 };
+	static uint32_t const aulTap[] = { 6, 14, 18 };
+	static uint8_t aucBits[1UL << 16];
+	tPrbs stPrbs;
+	uint32_t i;
+	uint32_t j;
+
+	TEST_EQUAL(PrbsInit(&stPrbs, 9), -1);
+
+	for(i = 0; i < 3; i++)
+	{
+		uint32_t const ulN = aulOrder[i];
+		uint32_t const ulM = aulTap[i];
+		uint32_t const ulBytes = sizeof(aucBits) / 8;
+		uint32_t ulBad = 0;
+
+		for(j = 0; j < sizeof(aucBits); j++)
+		{
+			aucBits[j] = (j < ulN) ? 1 : aucBits[j - ulN] ^ aucBits[j - ulM];
+		}
+
+		TEST_EQUAL(PrbsInit(&stPrbs, ulN), 0);
+		PrbsFill(&stPrbs, aucSent, ulBytes / 2);
+		PrbsFill(&stPrbs, &aucSent[ulBytes / 2], ulBytes - ulBytes / 2);
+		for(j = 0; j + 32 < sizeof(aucBits); j++)
+		{
+			if(((aucSent[j / 8] >> (j % 8)) & 1) != aucBits[j + 32])
+			{
+				ulBad++;
+			}
+		}
+		TEST_EQUAL(ulBad, 0);
+	}
+
+	/* 2^n - 1 bits, which being odd is also the period in bytes */
+	TEST_EQUAL(PrbsInit(&stPrbs, PRBS_15), 0);
+	PrbsFill(&stPrbs, aucSent, 3 * 32767);
+	TEST_CHECK(memcmp(aucSent, &aucSent[32767], 2 * 32767) == 0);
+	TEST_EQUAL(PrbsInit(&stPrbs, PRBS_7), 0);
+	PrbsFill(&stPrbs, aucSent, 3 * 127);
+	TEST_CHECK(memcmp(aucSent, &aucSent[127], 2 * 127) == 0);
+}
+
+/** ***************************************************************************
+	Name:               TestNoisy
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Random bit errors at rates up to 1e-2. The checker locks and stays
+	locked, and its error count is exactly the number of bits the link
+	flipped in the bytes it has committed: from the end of acquisition for
+	as many bits as it counted, which is all but the last window or two.
+*/
+static void TestNoisy(void)
+{
+	static uint32_t const aulOrder[] = { PRBS_7, PRBS_15, PRBS_23 };
+	static uint32_t const aulPpm[] = { 0, 10, 1000, 10000 };
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < 3; i++)
+	{
+		for(j = 0; j < 4; j++)
+		{
+			tTestLink stLink = { aulPpm[j], 0, 0 };
+			uint32_t const ulRx = TestLink(aulOrder[i], &stLink);
+			uint32_t const ulBytes = (uint32_t)(stCheck.ullBits / 8);
+			uint64_t ullFlips = 0;
+			uint32_t k;
+
+			for(k = stCheck.ulUnlockedBytes;
+				k < stCheck.ulUnlockedBytes + ulBytes; k++)
+			{
+				ullFlips += (uint64_t)__builtin_popcount(aucFlips[k]);
+			}
+
+			TEST_EQUAL(ulRx, TEST_LINK_BYTES);
+			TEST_CHECK(stCheck.ucLocked);
+			TEST_EQUAL(stCheck.ulSlips, 0);
+			TEST_EQUAL(stCheck.ullErrors, ullFlips);
+			TEST_CHECK(ulBytes + stCheck.ulUnlockedBytes + 2 * PRBS_WINDOW_BYTES
+				> TEST_LINK_BYTES);
+			TEST_EQUAL(ulBytes % PRBS_WINDOW_BYTES, 0);
+			if(aulPpm[j] == 0)
+			{
+				TEST_EQUAL(stCheck.ulUnlockedBytes,
+					sizeof(uint32_t) + PRBS_SYNC_BYTES);
+			}
+			else
+			{
+				/* within 10% of the rate injected */
+				TEST_CHECK(stCheck.ullErrors * 1000000UL * 10
+					> stCheck.ullBits * aulPpm[j] * 9);
+				TEST_CHECK(stCheck.ullErrors * 1000000UL * 10
+					< stCheck.ullBits * aulPpm[j] * 11);
+			}
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestSlips
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A byte lost or added on an otherwise clean link is one slip each, and
+	the garbage compared while misaligned isn't counted as bit errors,
+	wherever in a window the slip falls.
+*/
+static void TestSlips(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < PRBS_WINDOW_BYTES; i += 13)
+	{
+		tTestLink stDrop = { 0, 100000 + i, 0 };
+		tTestLink stBoth = { 0, 300000 + i, 700000 + 3 * i };
+
+		TEST_EQUAL(TestLink(PRBS_23, &stDrop), TEST_LINK_BYTES - 1);
+		TEST_EQUAL(stCheck.ulSlips, 1);
+		TEST_CHECK(stCheck.ucLocked);
+		TEST_EQUAL(stCheck.ullErrors, 0);
+
+		TEST_EQUAL(TestLink(PRBS_15, &stBoth), TEST_LINK_BYTES);
+		TEST_EQUAL(stCheck.ulSlips, 2);
+		TEST_CHECK(stCheck.ucLocked);
+		TEST_EQUAL(stCheck.ullErrors, 0);
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestFormat
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The report line gives the BER in integer arithmetic, and is cut to the
+	space given.
+*/
+static void TestFormat(void)
+{
+	char acLine[160];
+	uint32_t ulLen;
+
+	memset(&stCheck, 0, sizeof(stCheck));
+	stCheck.ucLocked = 1;
+	stCheck.ullBits = 250000000ULL;
+	stCheck.ullErrors = 3125;
+	stCheck.ulSlips = 2;
+	stCheck.ulUnlockedBytes = 40;
+
+	ulLen = BerFormat(&stCheck, PRBS_23, 1000, 999, acLine, sizeof(acLine));
+	TEST_EQUAL(ulLen, strlen(acLine));
+	TEST_CHECK(strcmp(acLine, "PRBS-23 locked tx 1000 B rx 999 B Mbit 250"
+		" errors 3125 ber 1.25e-5 slips 2 unlocked 40\r\n") == 0);
+
+	stCheck.ullErrors = 0;
+	BerFormat(&stCheck, PRBS_7, 0, 0, acLine, sizeof(acLine));
+	TEST_CHECK(strstr(acLine, " ber 0.00e-0 ") != NULL);
+
+	TEST_EQUAL(BerFormat(&stCheck, PRBS_7, 0, 0, acLine, 10), 9);
+	TEST_EQUAL(strlen(acLine), 9);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
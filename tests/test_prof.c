@@ -0,0 +1,426 @@
+/** ***************************************************************************
+File Name:  test_prof.c
+
+Project:    Platform 4
+
+Purpose:    Run time statistics test: histogram buckets, run times and
+            intervals across the cycle counter wrap, reset, the report line
+            and the cost of the instrumentation points
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "prof.h"
+#include "test.h"
+#include "test_cycles.h"
+
+
+/* Module Definitions */
+
+/* cycles the counter moves on while it is read */
+#define TEST_READ_CYCLES     3
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static void TestModel(tProfSite *pstModel, uint32_t ulStart, uint32_t ulEnd);
+static void TestCompare(uint32_t ulSite, tProfSite const *pstModel);
+static void TestBuckets(void);
+static void TestRandom(void);
+static void TestReset(void);
+static void TestFormat(void);
+static void TestOverhead(void);
+
+
+/* Module Variable Declarations */
+
+/* the stand-in for DWT->CYCCNT, and how often it was read and started */
+static uint32_t ulTestCycles;
+static uint32_t ulTestReads;
+static uint32_t ulTestInits;
+
+static uint32_t ulRandState = 4242;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the run time statistics tests.
+*/
+int main(void)
+{
+	ProfInit();
+	TEST_EQUAL(ulTestInits, 1);
+
+	TestBuckets();
+	TestRandom();
+	TestReset();
+	TestFormat();
+	TestOverhead();
+	return TestResult("prof");
+}
+
+/** ***************************************************************************
+	Name:               TestCycles
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             The cycle counter
+	Caveats / Effect:   Advances the counter by TEST_READ_CYCLES
+
+	Description:
+	PROF_CYCLES() of the host build, see test_cycles.h.
+*/
+uint32_t TestCycles(void)
+{
+	uint32_t const ulCycles = ulTestCycles;
+
+	ulTestCycles += TEST_READ_CYCLES;
+	ulTestReads++;
+	return ulCycles;
+}
+
+/** ***************************************************************************
+	Name:               TestCyclesInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	PROF_CYCLES_INIT() of the host build, see test_cycles.h.
+*/
+void TestCyclesInit(void)
+{
+	ulTestInits++;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestModel
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Reference statistics: the run time and the interval are modulo 2^32, as
+	the counter wraps, and the first run of a site has no interval.
+*/
+static void TestModel(tProfSite *pstModel, uint32_t ulStart, uint32_t ulEnd)
+{
+	uint32_t const ulCycles = ulEnd - ulStart;
+	uint32_t const ulInterval = ulStart - pstModel->ulLastStart;
+	uint32_t ulBucket = 0;
+
+	while((ulBucket < PROF_BUCKETS - 1) && (ulCycles >> (ulBucket + 1)))
+	{
+		ulBucket++;
+	}
+
+	if((pstModel->ulCount == 0) || (ulCycles < pstModel->ulMin))
+	{
+		pstModel->ulMin = ulCycles;
+	}
+	if((pstModel->ulCount == 0) || (ulCycles > pstModel->ulMax))
+	{
+		pstModel->ulMax = ulCycles;
+	}
+	if((pstModel->ulCount == 1) || ((pstModel->ulCount > 1)
+		&& (ulInterval < pstModel->ulMinInterval)))
+	{
+		pstModel->ulMinInterval = ulInterval;
+	}
+	if((pstModel->ulCount > 0) && (ulInterval > pstModel->ulMaxInterval))
+	{
+		pstModel->ulMaxInterval = ulInterval;
+	}
+	pstModel->ulLastStart = ulStart;
+	pstModel->ullTotal += ulCycles;
+	pstModel->aulHist[ulBucket]++;
+	pstModel->ulCount++;
+}
+
+/** ***************************************************************************
+	Name:               TestCompare
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Checks the statistics of a site against the reference.
+*/
+static void TestCompare(uint32_t ulSite, tProfSite const *pstModel)
+{
+	tProfSite const *pstSite = ProfGet(ulSite);
+
+	TEST_EQUAL(pstSite->ulCount, pstModel->ulCount);
+	TEST_EQUAL(pstSite->ulMin, pstModel->ulMin);
+	TEST_EQUAL(pstSite->ulMax, pstModel->ulMax);
+	TEST_CHECK(pstSite->ullTotal == pstModel->ullTotal);
+	TEST_EQUAL(pstSite->ulMinInterval, pstModel->ulMinInterval);
+	TEST_EQUAL(pstSite->ulMaxInterval, pstModel->ulMaxInterval);
+	TEST_EQUAL(pstSite->ulLastStart, pstModel->ulLastStart);
+	TEST_CHECK(memcmp(pstSite->aulHist, pstModel->aulHist,
+		sizeof(pstModel->aulHist)) == 0);
+}
+
+/** ***************************************************************************
+	Name:               TestBuckets
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Both edges of every power of two bucket, and the last bucket taking
+	everything above it.
+*/
+static void TestBuckets(void)
+{
+	uint32_t i;
+
+	TEST_EQUAL(ProfBucket(0), 0);
+	TEST_EQUAL(ProfBucket(1), 0);
+	for(i = 1; i < PROF_BUCKETS; i++)
+	{
+		TEST_EQUAL(ProfBucket(1UL << i), i);
+		TEST_EQUAL(ProfBucket((2UL << i) - 1), (i < PROF_BUCKETS - 1)
+			? i : PROF_BUCKETS - 1);
+	}
+	for(i = PROF_BUCKETS; i < 32; i++)
+	{
+		TEST_EQUAL(ProfBucket(1UL << i), PROF_BUCKETS - 1);
+	}
+	TEST_EQUAL(ProfBucket(0xFFFFFFFFUL), PROF_BUCKETS - 1);
+}
+
+/** ***************************************************************************
+	Name:               TestRandom
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Records runs of every site, interleaved, with run times spread over all
+	the buckets and starts that go round the cycle counter several times,
+	including runs that span the wrap.
+*/
+static void TestRandom(void)
+{
+	static tProfSite astModel[PROF_SITES];
+	uint32_t aulNow[PROF_SITES];
+	uint32_t i;
+
+	memset(astModel, 0, sizeof(astModel));
+	for(i = 0; i < PROF_SITES; i++)
+	{
+		aulNow[i] = 0xFFFFF000UL - i * 0x10000000UL;
+	}
+
+	for(i = 0; i < 200000; i++)
+	{
+		uint32_t const ulSite = TestRand() % PROF_SITES;
+		uint32_t const ulCycles = TestRand() >> (TestRand() % 32);
+		uint32_t const ulStart = aulNow[ulSite];
+
+		ProfRecord(ulSite, ulStart, ulStart + ulCycles);
+		TestModel(&astModel[ulSite], ulStart, ulStart + ulCycles);
+		aulNow[ulSite] = ulStart + ulCycles + (TestRand() >> (TestRand() % 24));
+		if((i % 97) == 0)
+		{
+			TestCompare(ulSite, &astModel[ulSite]);
+		}
+	}
+	for(i = 0; i < PROF_SITES; i++)
+	{
+		TestCompare(i, &astModel[i]);
+		TEST_CHECK(astModel[i].aulHist[0]);
+		TEST_CHECK(astModel[i].aulHist[PROF_BUCKETS - 1]);
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestReset
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	After ProfReset() a site reports no runs, but its statistics are only
+	cleared by its next run, which then counts as the first.
+*/
+static void TestReset(void)
+{
+	tProfSite stModel;
+	char acLine[200];
+	uint32_t ulCount = ProfGet(PROF_SITE_TC3_ISR)->ulCount;
+
+	TEST_CHECK(ulCount > 0);
+	ProfReset();
+	TEST_EQUAL(ProfGet(PROF_SITE_TC3_ISR)->ulCount, ulCount);
+	ProfFormat(PROF_SITE_TC3_ISR, acLine, sizeof(acLine));
+	TEST_CHECK(strcmp(acLine, "tc3 isr    no runs\r\n") == 0);
+
+	memset(&stModel, 0, sizeof(stModel));
+	ProfRecord(PROF_SITE_TC3_ISR, 500, 600);
+	TestModel(&stModel, 500, 600);
+	TestCompare(PROF_SITE_TC3_ISR, &stModel);
+	TEST_EQUAL(ProfGet(PROF_SITE_TC3_ISR)->ucResetReq, 0);
+
+	ProfRecord(PROF_SITE_TC3_ISR, 400, 401);
+	TestModel(&stModel, 400, 401);
+	TestCompare(PROF_SITE_TC3_ISR, &stModel);
+	TEST_EQUAL(stModel.ulMinInterval, 0xFFFFFFFFUL - 99);
+}
+
+/** ***************************************************************************
+	Name:               TestFormat
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The report line, and cutting it short to the space given.
+*/
+static void TestFormat(void)
+{
+	char const *pcExpected = "xdmac isr         3 runs      1/    37/   100"
+		" cycles      1000/     2000 apart 0:1 3:1 6:1\r\n";
+	char acLine[200];
+	uint32_t i;
+
+	ProfReset();
+	ProfRecord(PROF_SITE_XDMAC_ISR, 1000, 1010);
+	ProfRecord(PROF_SITE_XDMAC_ISR, 3000, 3100);
+	ProfRecord(PROF_SITE_XDMAC_ISR, 4000, 4001);
+
+	TEST_EQUAL(ProfFormat(PROF_SITE_XDMAC_ISR, acLine, sizeof(acLine)),
+		strlen(pcExpected));
+	TEST_CHECK(strcmp(acLine, pcExpected) == 0);
+
+	for(i = 1; i < strlen(pcExpected) + 1; i++)
+	{
+		memset(acLine, 'x', sizeof(acLine));
+		TEST_EQUAL(ProfFormat(PROF_SITE_XDMAC_ISR, acLine, i), i - 1);
+		TEST_EQUAL(strlen(acLine), i - 1);
+		TEST_CHECK(strncmp(acLine, pcExpected, i - 1) == 0);
+		TEST_EQUAL(acLine[i], 'x');
+	}
+	TEST_EQUAL(ProfFormat(PROF_SITE_XDMAC_ISR, acLine, 0), 0);
+}
+
+/** ***************************************************************************
+	Name:               TestOverhead
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	An instrumented section costs two reads of the cycle counter and one
+	ProfRecord(), which doesn't read it. The run time recorded for an empty
+	section is the one read's worth that falls inside it: the floor of
+	every minimum reported.
+*/
+static void TestOverhead(void)
+{
+	tProfSite const *pstSite = ProfGet(PROF_SITE_WAKE);
+	uint32_t ulStart;
+	uint32_t i;
+
+	ProfReset();
+	ulTestReads = 0;
+	for(i = 0; i < 1000; i++)
+	{
+		PROF_START(ulStart);
+		ulTestCycles += i;
+		PROF_END(PROF_SITE_WAKE, ulStart);
+	}
+	TEST_EQUAL(ulTestReads, 2000);
+	TEST_EQUAL(pstSite->ulCount, 1000);
+	TEST_EQUAL(pstSite->ulMin, TEST_READ_CYCLES);
+	TEST_EQUAL(pstSite->ulMax, TEST_READ_CYCLES + 999);
+	TEST_EQUAL(pstSite->ulMinInterval, 2 * TEST_READ_CYCLES + 0);
+	TEST_EQUAL(pstSite->ulMaxInterval, 2 * TEST_READ_CYCLES + 998);
+
+	ulTestReads = 0;
+	ProfRecord(PROF_SITE_WAKE, 0, 1);
+	ProfBucket(12345);
+	ProfGet(PROF_SITE_WAKE);
+	TEST_EQUAL(ulTestReads, 0);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
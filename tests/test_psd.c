@@ -0,0 +1,647 @@
+/** ***************************************************************************
+File Name:  test_psd.c
+
+Project:    Platform 4
+
+Purpose:    Spectrum test: signals of known power go through the Welch
+            averaging of psd.c, the spectra the USB stream is handed are
+            checked for level and shape, and frames lost from the link or
+            spectra the host doesn't take are followed through
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "psd.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* spacing of the bins, and the samples between spectra */
+#define TEST_BIN_HZ          ((double)PSD_SAMPLE_RATE_HZ / PSD_FFT_SIZE)
+#define TEST_HOP             (PSD_FFT_SIZE - PSD_OVERLAP)
+#define TEST_PERIOD          (TEST_HOP * PSD_AVERAGES)
+
+/* samples in a frame from the link, at most */
+#define TEST_FRAME_MAX       400
+
+/* transfers the USB stream keeps for the test to complete */
+#define TEST_USB_QUEUE       8
+
+
+/* Module Type Definitions */
+
+/* the signal on the link: a sine and white Gaussian noise, in full scale */
+typedef struct
+{
+	double dAmplitude;
+	double dFreqHz;
+	double dNoise;
+} tTestSignal;
+
+/* the USB stream as psd.c sees it: whether the host has it open, what
+	UsbStreamWrite() returns, and the transfers it has taken */
+typedef struct
+{
+	uint8_t ucEnabled;
+	int iResult;
+	uint8_t *apucBuf[TEST_USB_QUEUE];
+	tUsbStreamDone apfnDone[TEST_USB_QUEUE];
+	uint32_t ulQueued;
+	/* spectra taken, and a copy of the last */
+	uint32_t ulSpectra;
+	tPsdFrame stLast;
+} tTestUsb;
+
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static double TestGauss(void);
+static void TestReset(void);
+static void TestFeed(tTestSignal const *pstSignal, uint32_t ulSamples);
+static void TestFrame(tTestSignal const *pstSignal, uint32_t ulSamples);
+static void TestComplete(void);
+static tPpsTime TestTime(uint64_t ullSample);
+static double TestPower(tPsdFrame const *pstFrame);
+static void TestCheckHeader(tPsdFrame const *pstFrame, uint32_t ulSeq,
+	uint64_t ullFirst);
+static void TestSine(void);
+static void TestNoise(void);
+static void TestGaps(void);
+static void TestDrops(void);
+
+
+/* Module Variable Declarations */
+
+static tTestUsb stUsb;
+
+/* the link: samples sent so far, the next frame sequence number, and the
+	PPS time of the first sample */
+static uint64_t ullSample;
+static uint16_t usSeq;
+static tPpsTime tStart;
+
+static uint32_t ulRandState = 8191;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the spectrum tests.
+*/
+int main(void)
+{
+	TestSine();
+	TestNoise();
+	TestGaps();
+	TestDrops();
+	return TestResult("psd");
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamIsEnabled
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             1 if the host has the stream open
+	Caveats / Effect:   None
+
+	Description:
+	Stands in for usb_stream.c.
+*/
+uint8_t UsbStreamIsEnabled(void)
+{
+	return stUsb.ucEnabled;
+}
+
+/** ***************************************************************************
+	Name:               UsbStreamWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             stUsb.iResult
+	Caveats / Effect:   None
+
+	Description:
+	Stands in for usb_stream.c: takes a spectrum, whole and in one
+	transfer, and keeps it until TestComplete().
+*/
+int UsbStreamWrite(uint8_t *pucBuf, uint32_t ulLen, uint8_t ucEnd,
+	tUsbStreamDone pfnDone)
+{
+	TEST_EQUAL(ulLen, sizeof(tPsdFrame));
+	TEST_EQUAL(ucEnd, 1);
+	TEST_CHECK(stUsb.ulQueued < TEST_USB_QUEUE);
+	if((stUsb.iResult != 0) || (stUsb.ulQueued >= TEST_USB_QUEUE))
+	{
+		return -1;
+	}
+	stUsb.apucBuf[stUsb.ulQueued] = pucBuf;
+	stUsb.apfnDone[stUsb.ulQueued] = pfnDone;
+	stUsb.ulQueued++;
+	stUsb.ulSpectra++;
+	memcpy(&stUsb.stLast, pucBuf, sizeof(stUsb.stLast));
+	return 0;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestGauss
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Normally distributed number, mean 0 and variance 1
+	Caveats / Effect:   None
+
+	Description:
+	Box-Muller, from two uniform numbers clear of 0.
+*/
+static double TestGauss(void)
+{
+	double const dU = ((double)TestRand() + 1.0) / 2147483649.0;
+	double const dV = ((double)TestRand() + 1.0) / 2147483649.0;
+
+	return sqrt(-2.0 * log(dU)) * cos(2.0 * M_PI * dV);
+}
+
+/** ***************************************************************************
+	Name:               TestReset
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Starts the spectra and the link over, with the host taking spectra.
+*/
+static void TestReset(void)
+{
+	memset(&stUsb, 0, sizeof(stUsb));
+	stUsb.ucEnabled = 1;
+	TEST_EQUAL(PsdInit(), 0);
+	ullSample = 0;
+	usSeq = (uint16_t)TestRand();
+	tStart = (tPpsTime)(100 + TestRand() % 1000) << 32;
+}
+
+/** ***************************************************************************
+	Name:               TestFeed
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Sends ulSamples of a signal over the link in frames of random length,
+	the host taking the spectra as they come.
+*/
+static void TestFeed(tTestSignal const *pstSignal, uint32_t ulSamples)
+{
+	while(ulSamples)
+	{
+		uint32_t ulCount = 1 + TestRand() % TEST_FRAME_MAX;
+
+		if(ulCount > ulSamples)
+		{
+			ulCount = ulSamples;
+		}
+		TestFrame(pstSignal, ulCount);
+		TestComplete();
+		ulSamples -= ulCount;
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestFrame
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Sends a frame of ulSamples of a signal, rounded and clipped to 16 bits,
+	now and then with an odd byte after them that must be ignored.
+*/
+static void TestFrame(tTestSignal const *pstSignal, uint32_t ulSamples)
+{
+	int16_t asData[TEST_FRAME_MAX + 1];
+	uint32_t i;
+
+	for(i = 0; i < ulSamples; i++)
+	{
+		double const dPhase = 2.0 * M_PI * pstSignal->dFreqHz
+			* (double)(ullSample + i) / (double)PSD_SAMPLE_RATE_HZ;
+		double dValue = 32768.0 * (pstSignal->dAmplitude * sin(dPhase)
+			+ pstSignal->dNoise * TestGauss());
+
+		dValue = (dValue > 32767.0) ? 32767.0 : dValue;
+		dValue = (dValue < -32768.0) ? -32768.0 : dValue;
+		asData[i] = (int16_t)lrint(dValue);
+	}
+	asData[ulSamples] = (int16_t)0x7F7F;
+
+	PsdWrite(0, usSeq++, tStart + TestTime(ullSample), asData,
+		2 * ulSamples + ((TestRand() % 4 == 0) ? 1 : 0));
+	ullSample += ulSamples;
+}
+
+/** ***************************************************************************
+	Name:               TestComplete
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The host takes every spectrum queued.
+*/
+static void TestComplete(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < stUsb.ulQueued; i++)
+	{
+		stUsb.apfnDone[i](stUsb.apucBuf[i], sizeof(tPsdFrame), 0);
+	}
+	stUsb.ulQueued = 0;
+}
+
+/** ***************************************************************************
+	Name:               TestTime
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             PPS time of a number of samples
+	Caveats / Effect:   None
+
+	Description:
+	Converts samples into a PPS time interval.
+*/
+static tPpsTime TestTime(uint64_t ullSamples)
+{
+	return (ullSamples << 32) / PSD_SAMPLE_RATE_HZ;
+}
+
+/** ***************************************************************************
+	Name:               TestPower
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Power of a spectrum, full scale squared
+	Caveats / Effect:   None
+
+	Description:
+	Integrates the density over frequency.
+*/
+static double TestPower(tPsdFrame const *pstFrame)
+{
+	double dPower = 0.0;
+	uint32_t i;
+
+	for(i = 0; i < PSD_BINS; i++)
+	{
+		dPower += (double)pstFrame->afPsd[i] * TEST_BIN_HZ;
+	}
+	return dPower;
+}
+
+/** ***************************************************************************
+	Name:               TestCheckHeader
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Checks a spectrum's header: its number, and the time of its first
+	sample, which was sample ullFirst of the link; the segments after the
+	first in the average are a whole number of hops later.
+*/
+static void TestCheckHeader(tPsdFrame const *pstFrame, uint32_t ulSeq,
+	uint64_t ullFirst)
+{
+	tPsdHeader const *pstHeader = &pstFrame->stHeader;
+
+	TEST_EQUAL(pstHeader->ulMagic, PSD_MAGIC);
+	TEST_EQUAL(pstHeader->ucVersion, PSD_VERSION);
+	TEST_EQUAL(pstHeader->ucLink, 0);
+	TEST_EQUAL(pstHeader->usBins, PSD_BINS);
+	TEST_EQUAL(pstHeader->ulSampleRateHz, PSD_SAMPLE_RATE_HZ);
+	TEST_EQUAL(pstHeader->usFftSize, PSD_FFT_SIZE);
+	TEST_EQUAL(pstHeader->usOverlap, PSD_OVERLAP);
+	TEST_EQUAL(pstHeader->usAverages, PSD_AVERAGES);
+	TEST_EQUAL(pstHeader->usReserved, 0);
+	TEST_EQUAL(pstHeader->ulSeq, ulSeq);
+
+	/* within the rounding of a PPS time per hop */
+	TEST_CHECK(pstHeader->tTime <= tStart + TestTime(ullFirst));
+	TEST_CHECK(pstHeader->tTime + PSD_AVERAGES * ulSeq + PSD_AVERAGES
+		>= tStart + TestTime(ullFirst));
+}
+
+/** ***************************************************************************
+	Name:               TestSine
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A sine centred on a bin has its power, half the square of its
+	amplitude, in that bin and the two either side, split 4:1:1 by the Hann
+	window, and nothing elsewhere but the rounding to 16 bits. A sine
+	between bins still integrates to its power. The first spectrum comes as
+	soon as its last segment is full, and each after it every
+	TEST_PERIOD samples.
+*/
+static void TestSine(void)
+{
+	tTestSignal stSignal = {0.5, 100.0 * TEST_BIN_HZ, 0.0};
+	double dPower;
+	uint32_t i;
+
+	TestReset();
+	TestFeed(&stSignal, PSD_FFT_SIZE + TEST_PERIOD - TEST_HOP - 1);
+	TEST_EQUAL(stUsb.ulSpectra, 0);
+	TestFeed(&stSignal, 1);
+	TEST_EQUAL(stUsb.ulSpectra, 1);
+	TestCheckHeader(&stUsb.stLast, 0, 0);
+
+	dPower = 0.5 * stSignal.dAmplitude * stSignal.dAmplitude;
+	TEST_CHECK(fabs(TestPower(&stUsb.stLast) / dPower - 1.0) < 1e-3);
+	TEST_CHECK(fabs(stUsb.stLast.afPsd[100] * TEST_BIN_HZ
+		/ (dPower * 4.0 / 6.0) - 1.0) < 1e-3);
+	TEST_CHECK(fabs(stUsb.stLast.afPsd[99] * TEST_BIN_HZ
+		/ (dPower / 6.0) - 1.0) < 1e-3);
+	TEST_CHECK(fabs(stUsb.stLast.afPsd[101] * TEST_BIN_HZ
+		/ (dPower / 6.0) - 1.0) < 1e-3);
+	for(i = 0; i < PSD_BINS; i++)
+	{
+		if((i < 99) || (i > 101))
+		{
+			TEST_CHECK(stUsb.stLast.afPsd[i] < 1e-9 * stUsb.stLast.afPsd[100]);
+		}
+	}
+
+	TestFeed(&stSignal, TEST_PERIOD);
+	TEST_EQUAL(stUsb.ulSpectra, 2);
+	TestCheckHeader(&stUsb.stLast, 1, TEST_PERIOD);
+	TEST_CHECK(fabs(TestPower(&stUsb.stLast) / dPower - 1.0) < 1e-3);
+
+	/* between bins, and at a tenth of full scale */
+	stSignal.dAmplitude = 0.1;
+	stSignal.dFreqHz = 1234.5;
+	dPower = 0.5 * stSignal.dAmplitude * stSignal.dAmplitude;
+	TestFeed(&stSignal, 2 * TEST_PERIOD);
+	TEST_EQUAL(stUsb.ulSpectra, 4);
+	TEST_CHECK(fabs(TestPower(&stUsb.stLast) / dPower - 1.0) < 2e-3);
+	TEST_EQUAL(PsdGet(0)->ulSamples, ullSample);
+	TEST_EQUAL(PsdGet(0)->ulGaps, 0);
+	TEST_EQUAL(PsdGet(0)->ulDropped, 0);
+}
+
+/** ***************************************************************************
+	Name:               TestNoise
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	White noise of variance s^2 has a one sided density of 2 s^2 / fs in
+	every bin but DC and half the sample rate, which have half of it. The
+	mean over the bins is close to that, and every bin is within the spread
+	an average of PSD_AVERAGES overlapping segments leaves.
+*/
+static void TestNoise(void)
+{
+	tTestSignal const stSignal = {0.0, 0.0, 0.05};
+	double const dDensity = 2.0 * stSignal.dNoise * stSignal.dNoise
+		/ PSD_SAMPLE_RATE_HZ;
+	uint32_t ulSpectrum;
+
+	TestReset();
+	TestFeed(&stSignal, PSD_FFT_SIZE - TEST_HOP);
+	for(ulSpectrum = 0; ulSpectrum < 2; ulSpectrum++)
+	{
+		double dMean = 0.0;
+		uint32_t i;
+
+		TestFeed(&stSignal, TEST_PERIOD);
+		TEST_EQUAL(stUsb.ulSpectra, ulSpectrum + 1);
+		TestCheckHeader(&stUsb.stLast, ulSpectrum,
+			(uint64_t)ulSpectrum * TEST_PERIOD);
+
+		for(i = 1; i < PSD_BINS - 1; i++)
+		{
+			dMean += stUsb.stLast.afPsd[i];
+			TEST_CHECK(fabs(stUsb.stLast.afPsd[i] / dDensity - 1.0) < 0.6);
+		}
+		dMean /= PSD_BINS - 2;
+		TEST_CHECK(fabs(dMean / dDensity - 1.0) < 0.02);
+		TEST_CHECK(fabs(TestPower(&stUsb.stLast)
+			/ (stSignal.dNoise * stSignal.dNoise) - 1.0) < 0.02);
+		TEST_CHECK(fabs(stUsb.stLast.afPsd[0] / (0.5 * dDensity) - 1.0) < 0.6);
+		TEST_CHECK(fabs(stUsb.stLast.afPsd[PSD_BINS - 1] / (0.5 * dDensity)
+			- 1.0) < 0.6);
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestGaps
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Frame sequence numbers run on through their wrap without a gap. A frame
+	lost, or one repeated, restarts the segment being filled at the frame
+	after it, so the sine either side of the gap isn't spliced into one
+	segment: the spectrum stays clean, keeps the segments averaged before
+	the gap and the time of its first sample, and comes that much later.
+*/
+static void TestGaps(void)
+{
+	tTestSignal const stSignal = {0.5, 100.0 * TEST_BIN_HZ, 0.0};
+	uint64_t ullLost;
+	uint32_t i;
+
+	TestReset();
+	usSeq = 0xFFF0;
+	TestFeed(&stSignal, 50 * TEST_FRAME_MAX);
+	TEST_CHECK(usSeq < 0x100);
+	TEST_EQUAL(PsdGet(0)->ulGaps, 0);
+
+	/* lose a frame of 100 samples, a quarter way through a segment */
+	TestFeed(&stSignal, (TEST_HOP + TEST_HOP / 4
+		- (ullSample - PSD_FFT_SIZE) % TEST_HOP) % TEST_HOP);
+	ullLost = ullSample;
+	ullSample += 100;
+	usSeq++;
+	TestFeed(&stSignal, 10);
+	TEST_EQUAL(PsdGet(0)->ulGaps, 1);
+
+	/* a repeated frame is a gap too */
+	usSeq--;
+	TestFeed(&stSignal, 10);
+	TEST_EQUAL(PsdGet(0)->ulGaps, 2);
+
+	/* the segments before the first gap are kept: the first spectrum comes
+		once the segment restarted at the repeated frame and those after it
+		make up the average */
+	for(i = 0; (i < PSD_FFT_SIZE * PSD_AVERAGES) && (stUsb.ulSpectra == 0);
+		i++)
+	{
+		TestFeed(&stSignal, 1);
+	}
+	TEST_EQUAL(stUsb.ulSpectra, 1);
+	TEST_EQUAL(ullSample - (ullLost + 100 + 10),
+		PSD_FFT_SIZE + TEST_HOP * (PSD_AVERAGES - 1
+			- (1 + (ullLost - TEST_HOP / 4 - PSD_FFT_SIZE) / TEST_HOP)));
+	TestCheckHeader(&stUsb.stLast, 0, 0);
+
+	for(i = 0; i < PSD_BINS; i++)
+	{
+		if((i < 99) || (i > 101))
+		{
+			TEST_CHECK(stUsb.stLast.afPsd[i] < 1e-9 * stUsb.stLast.afPsd[100]);
+		}
+	}
+	TEST_CHECK(fabs(TestPower(&stUsb.stLast) / 0.125 - 1.0) < 1e-3);
+	TEST_EQUAL(PsdGet(0)->ulSamples, ullSample - 100);
+}
+
+/** ***************************************************************************
+	Name:               TestDrops
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A host that stops taking spectra holds up PSD_OUT_BUFS of them; the
+	rest are dropped and counted, and the numbers of those that go out show
+	the gap. So are spectra finished with the stream closed, or that the
+	stream refuses, whose buffer is then free again at once.
+*/
+static void TestDrops(void)
+{
+	tTestSignal const stSignal = {0.25, 3000.0, 0.01};
+	uint32_t i;
+
+	TestReset();
+	TestFeed(&stSignal, PSD_FFT_SIZE - TEST_HOP);
+
+	/* the host stalls */
+	for(i = 0; i < PSD_OUT_BUFS + 3; i++)
+	{
+		while(PsdGet(0)->ulSpectra == i)
+		{
+			TestFrame(&stSignal, 1 + TestRand() % TEST_FRAME_MAX);
+		}
+	}
+	TEST_EQUAL(stUsb.ulSpectra, PSD_OUT_BUFS);
+	TEST_EQUAL(stUsb.ulQueued, PSD_OUT_BUFS);
+	TEST_EQUAL(PsdGet(0)->ulDropped, 3);
+
+	/* and takes them again */
+	TestComplete();
+	TestFeed(&stSignal, TEST_PERIOD);
+	TEST_EQUAL(stUsb.ulSpectra, PSD_OUT_BUFS + 1);
+	TEST_EQUAL(stUsb.stLast.stHeader.ulSeq, PSD_OUT_BUFS + 3);
+	TEST_CHECK(fabs(TestPower(&stUsb.stLast)
+		/ (0.5 * 0.25 * 0.25 + 0.01 * 0.01) - 1.0) < 0.02);
+
+	/* the stream closed */
+	stUsb.ucEnabled = 0;
+	TestFeed(&stSignal, TEST_PERIOD);
+	TEST_EQUAL(stUsb.ulSpectra, PSD_OUT_BUFS + 1);
+	TEST_EQUAL(PsdGet(0)->ulDropped, 4);
+
+	/* the stream refuses, for longer than there are buffers */
+	stUsb.ucEnabled = 1;
+	stUsb.iResult = -1;
+	TestFeed(&stSignal, (PSD_OUT_BUFS + 1) * TEST_PERIOD);
+	TEST_EQUAL(PsdGet(0)->ulDropped, 4 + PSD_OUT_BUFS + 1);
+	stUsb.iResult = 0;
+	TestFeed(&stSignal, TEST_PERIOD);
+	TEST_EQUAL(stUsb.ulSpectra, PSD_OUT_BUFS + 2);
+	TEST_EQUAL(stUsb.stLast.stHeader.ulSeq, PsdGet(0)->ulSpectra - 1);
+	TEST_EQUAL(PsdGet(0)->ulSpectra, PsdGet(0)->ulDropped + stUsb.ulSpectra);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,916 @@
+/** ***************************************************************************
+File Name:  test_qlog.c
+
+Project:    Platform 4
+
+Purpose:    Flash log test: the log runs on a simulated serial NOR flash
+            standing in for qspi.c, whose erases and page programs a reset
+            can tear part way, and is read back after every restart
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "crc.h"
+#include "qlog.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* simulated flash: few sectors, so the log goes round them often */
+#define TEST_SECTORS         8
+#define TEST_FLASH_SIZE      (TEST_SECTORS * QSPI_SECTOR_SIZE)
+
+/* flash operation in progress */
+#define TEST_OP_NONE         0
+#define TEST_OP_ERASE        1
+#define TEST_OP_PROGRAM      2
+
+/* polls an erase and a page program take, at most */
+#define TEST_ERASE_POLLS     60
+#define TEST_PROGRAM_POLLS   20
+
+/* records the tests write, by number; the payload holds the number and
+	the record's time, and then a pattern */
+#define TEST_IDS             (1UL << 19)
+#define TEST_ID_HEADER       12
+
+/* what became of a record */
+#define TEST_ID_NONE         0   /* never written, or dropped */
+#define TEST_ID_STAGED       1   /* taken by QlogWrite() */
+#define TEST_ID_DURABLE      2   /* its page program finished */
+#define TEST_ID_CUT          3   /* staged when a reset came, so it may be
+                                    in a torn page */
+
+/* a second of PPS time */
+#define TEST_SECOND          (1ULL << 32)
+
+
+/* Module Type Definitions */
+
+/* the flash: its contents, the erases each sector has had, and the
+	operation in progress with what it writes */
+typedef struct
+{
+	uint8_t aucData[TEST_FLASH_SIZE];
+	uint32_t aulErases[TEST_SECTORS];
+	uint8_t ucOp;
+	uint32_t ulAddr;
+	uint32_t ulLen;
+	uint8_t aucProgram[QSPI_PAGE_SIZE];
+	uint32_t ulPolls;
+	/* one past the newest record each sector holds */
+	uint32_t aulEnd[TEST_SECTORS];
+} tTestFlash;
+
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static void TestFlashInit(void);
+static void TestFlashFinish(void);
+static void TestCut(uint32_t ulTear);
+static void TestStart(void);
+static int TestWrite(uint32_t ulLen);
+static void TestPoll(tPpsTime tStep);
+static void TestDrain(void);
+static uint32_t TestCheckLog(void);
+static void TestBlank(void);
+static void TestTornProgram(void);
+static void TestTornErase(void);
+static void TestPowerCuts(void);
+
+
+/* Module Variable Declarations */
+
+static tTestFlash stFlash;
+static tQspi stQspi = {.ucReady = 1, .ulSize = TEST_FLASH_SIZE};
+
+/* record states, the next record number, and records below which are gone
+	with the sector erases */
+static uint8_t aucIdState[TEST_IDS];
+static uint32_t ulNextId;
+static uint32_t ulGoneBelow;
+
+static tPpsTime tNow;
+
+static uint32_t ulRandState = 4099;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the flash log tests.
+*/
+int main(void)
+{
+	CrcInit();
+	TestBlank();
+	TestTornProgram();
+	TestTornErase();
+	TestPowerCuts();
+	return TestResult("qlog");
+}
+
+/** ***************************************************************************
+	Name:               QspiGet
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Flash state
+	Caveats / Effect:   None
+
+	Description:
+	Stands in for qspi.c: a flash that answered, TEST_SECTORS sectors big.
+*/
+tQspi const *QspiGet(void)
+{
+	return &stQspi;
+}
+
+/** ***************************************************************************
+	Name:               QspiRead
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 on success, -1 with an operation in progress
+	Caveats / Effect:   None
+
+	Description:
+	Reads the simulated flash. The log must not read while the flash is
+	busy, nor outside the flash.
+*/
+int QspiRead(uint32_t ulAddr, void *pvData, uint32_t ulLen)
+{
+	TEST_CHECK(stFlash.ucOp == TEST_OP_NONE);
+	TEST_CHECK(ulAddr + ulLen <= TEST_FLASH_SIZE);
+	if((stFlash.ucOp != TEST_OP_NONE) || (ulAddr + ulLen > TEST_FLASH_SIZE))
+	{
+		return -1;
+	}
+	memcpy(pvData, &stFlash.aucData[ulAddr], ulLen);
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QspiErase
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0
+	Caveats / Effect:   None
+
+	Description:
+	Starts erasing a sector, which takes a random number of polls. Whatever
+	the sector held is gone from here on, even if the erase is torn.
+*/
+int QspiErase(uint32_t ulAddr)
+{
+	uint32_t const ulSector = ulAddr / QSPI_SECTOR_SIZE;
+
+	TEST_CHECK(stFlash.ucOp == TEST_OP_NONE);
+	TEST_EQUAL(ulAddr % QSPI_SECTOR_SIZE, 0);
+	TEST_CHECK(ulSector < TEST_SECTORS);
+	if(stFlash.aulEnd[ulSector] > ulGoneBelow)
+	{
+		ulGoneBelow = stFlash.aulEnd[ulSector];
+	}
+	stFlash.aulEnd[ulSector] = 0;
+	stFlash.ucOp = TEST_OP_ERASE;
+	stFlash.ulAddr = ulSector * QSPI_SECTOR_SIZE;
+	stFlash.ulPolls = TestRand() % TEST_ERASE_POLLS;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QspiProgram
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0
+	Caveats / Effect:   None
+
+	Description:
+	Starts programming up to a page, which takes a random number of polls.
+	The data is copied, as the XDMAC would have it read.
+*/
+int QspiProgram(uint32_t ulAddr, void const *pvData, uint32_t ulLen)
+{
+	TEST_CHECK(stFlash.ucOp == TEST_OP_NONE);
+	TEST_CHECK(ulLen > 0);
+	TEST_CHECK((ulAddr % QSPI_PAGE_SIZE) + ulLen <= QSPI_PAGE_SIZE);
+	TEST_CHECK(ulAddr + ulLen <= TEST_FLASH_SIZE);
+	stFlash.ucOp = TEST_OP_PROGRAM;
+	stFlash.ulAddr = ulAddr;
+	stFlash.ulLen = ulLen;
+	memcpy(stFlash.aucProgram, pvData, ulLen);
+	stFlash.ulPolls = TestRand() % TEST_PROGRAM_POLLS;
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               QspiPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 when done, QSPI_BUSY while the flash is busy
+	Caveats / Effect:   None
+
+	Description:
+	Counts down the operation in progress and carries it out at the end.
+*/
+int QspiPoll(void)
+{
+	if(stFlash.ucOp == TEST_OP_NONE)
+	{
+		return 0;
+	}
+	if(stFlash.ulPolls > 0)
+	{
+		stFlash.ulPolls--;
+		return QSPI_BUSY;
+	}
+	TestFlashFinish();
+	return 0;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestFlashInit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Forgets every record written so far
+
+	Description:
+	A flash that is erased but for random bytes where the sector headers
+	go, as if something else had used it.
+*/
+static void TestFlashInit(void)
+{
+	uint32_t i;
+	uint32_t j;
+
+	memset(&stFlash, 0, sizeof(stFlash));
+	memset(stFlash.aucData, 0xFF, sizeof(stFlash.aucData));
+	for(i = 0; i < TEST_SECTORS; i++)
+	{
+		for(j = 0; j < 64; j++)
+		{
+			stFlash.aucData[i * QSPI_SECTOR_SIZE + j] = (uint8_t)TestRand();
+		}
+	}
+	memset(aucIdState, TEST_ID_NONE, sizeof(aucIdState));
+	ulNextId = 0;
+	ulGoneBelow = 0;
+	tNow = 1000 * TEST_SECOND;
+}
+
+/** ***************************************************************************
+	Name:               TestFlashFinish
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Carries out the operation in progress. A program can only clear bits,
+	and the log never programs a byte twice. The records a page program
+	holds become durable; they are found by the layout of qlog.h.
+*/
+static void TestFlashFinish(void)
+{
+	uint32_t i;
+
+	if(stFlash.ucOp == TEST_OP_ERASE)
+	{
+		memset(&stFlash.aucData[stFlash.ulAddr], 0xFF, QSPI_SECTOR_SIZE);
+		stFlash.aulErases[stFlash.ulAddr / QSPI_SECTOR_SIZE]++;
+	}
+	else if(stFlash.ucOp == TEST_OP_PROGRAM)
+	{
+		uint8_t const *pucRecord = stFlash.aucProgram;
+		uint32_t ulOffset = 0;
+
+		for(i = 0; i < stFlash.ulLen; i++)
+		{
+			TEST_EQUAL(stFlash.aucData[stFlash.ulAddr + i], 0xFF);
+			stFlash.aucData[stFlash.ulAddr + i] &= stFlash.aucProgram[i];
+		}
+
+		/* a sector header is programmed on its own, at the sector start */
+		while((stFlash.ulAddr % QSPI_SECTOR_SIZE != 0)
+			&& (ulOffset + QLOG_RECORD_HEADER + 4 <= stFlash.ulLen)
+			&& (pucRecord[ulOffset + 3] == QLOG_RECORD_SYNC))
+		{
+			uint32_t const ulLen = (uint32_t)pucRecord[ulOffset]
+				| ((uint32_t)pucRecord[ulOffset + 1] << 8);
+			uint32_t ulId;
+
+			memcpy(&ulId, &pucRecord[ulOffset + QLOG_RECORD_HEADER],
+				sizeof(ulId));
+			TEST_CHECK(ulId < ulNextId);
+			TEST_EQUAL(aucIdState[ulId], TEST_ID_STAGED);
+			aucIdState[ulId] = TEST_ID_DURABLE;
+			stFlash.aulEnd[stFlash.ulAddr / QSPI_SECTOR_SIZE] = ulId + 1;
+			ulOffset += QLOG_RECORD_HEADER + ((ulLen + 3) & ~3UL);
+		}
+	}
+	stFlash.ucOp = TEST_OP_NONE;
+}
+
+/** ***************************************************************************
+	Name:               TestCut
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   The log has to be started again
+
+	Description:
+	A reset. An erase in progress is left with some of its bytes erased; a
+	program in progress has done its first ulTear bytes, the last of them
+	with only some of its bits cleared.
+*/
+static void TestCut(uint32_t ulTear)
+{
+	uint32_t i;
+
+	if(stFlash.ucOp == TEST_OP_ERASE)
+	{
+		for(i = 0; i < QSPI_SECTOR_SIZE; i++)
+		{
+			if(TestRand() % 2)
+			{
+				stFlash.aucData[stFlash.ulAddr + i] = 0xFF;
+			}
+		}
+	}
+	else if(stFlash.ucOp == TEST_OP_PROGRAM)
+	{
+		for(i = 0; (i < ulTear) && (i < stFlash.ulLen); i++)
+		{
+			uint8_t ucByte = stFlash.aucProgram[i];
+
+			if(i == ulTear - 1)
+			{
+				ucByte |= (uint8_t)TestRand();
+			}
+			stFlash.aucData[stFlash.ulAddr + i] &= ucByte;
+		}
+	}
+	stFlash.ucOp = TEST_OP_NONE;
+
+	/* records staged in memory are lost, but for any the torn page holds */
+	for(i = ulGoneBelow; i < ulNextId; i++)
+	{
+		if(aucIdState[i] == TEST_ID_STAGED)
+		{
+			aucIdState[i] = TEST_ID_CUT;
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Starts the log, which mustn't touch the flash before the first poll.
+*/
+static void TestStart(void)
+{
+	TEST_EQUAL(QlogStart(), 0);
+	TEST_EQUAL(QlogGet()->ulSectors, TEST_SECTORS);
+	TEST_EQUAL(stFlash.ucOp, TEST_OP_NONE);
+}
+
+/** ***************************************************************************
+	Name:               TestWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Result of QlogWrite()
+	Caveats / Effect:   None
+
+	Description:
+	Writes the next record, with ulLen bytes of payload.
+*/
+static int TestWrite(uint32_t ulLen)
+{
+	uint8_t aucData[QLOG_MAX_PAYLOAD + 1];
+	uint32_t const ulId = ulNextId++;
+	uint32_t i;
+	int iResult;
+
+	TEST_CHECK(ulId < TEST_IDS);
+	memcpy(&aucData[0], &ulId, sizeof(ulId));
+	memcpy(&aucData[4], &tNow, sizeof(tNow));
+	for(i = TEST_ID_HEADER; i < ulLen; i++)
+	{
+		aucData[i] = (uint8_t)(ulId + i);
+	}
+	iResult = QlogWrite((uint8_t)(QLOG_TYPE_BOOT + ulId % 3), tNow, aucData,
+		ulLen);
+	if(ulLen > QLOG_MAX_PAYLOAD)
+	{
+		TEST_EQUAL(iResult, -1);
+	}
+	aucIdState[ulId] = (iResult == 0) ? TEST_ID_STAGED : TEST_ID_NONE;
+	return iResult;
+}
+
+/** ***************************************************************************
+	Name:               TestPoll
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Moves time on by tStep and polls the log.
+*/
+static void TestPoll(tPpsTime tStep)
+{
+	tNow += tStep;
+	QlogPoll(tNow);
+}
+
+/** ***************************************************************************
+	Name:               TestDrain
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Polls until every record staged is in the flash and the flash is idle.
+*/
+static void TestDrain(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < 100000; i++)
+	{
+		TestPoll(TEST_SECOND);
+		if((QlogGet()->ulFull == 0) && (stFlash.ucOp == TEST_OP_NONE))
+		{
+			TestPoll(QLOG_FLUSH_SECONDS * TEST_SECOND);
+			if((QlogGet()->ulFull == 0) && (stFlash.ucOp == TEST_OP_NONE))
+			{
+				break;
+			}
+		}
+	}
+	for(i = ulGoneBelow; i < ulNextId; i++)
+	{
+		if(aucIdState[i] == TEST_ID_STAGED)
+		{
+			TEST_EQUAL(aucIdState[i], TEST_ID_DURABLE);
+			break;
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestCheckLog
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of records read
+	Caveats / Effect:   The flash must be idle
+
+	Description:
+	Reads the whole log back. Records come oldest first, whole, each one
+	written; none durable is missing, short of those in sectors since
+	erased.
+*/
+static uint32_t TestCheckLog(void)
+{
+	tQlogCursor stCursor;
+	tQlogRecord stRecord;
+	uint32_t ulNext = ulGoneBelow;
+	uint32_t ulRead = 0;
+	int iResult;
+
+	QlogReadStart(&stCursor);
+	while((iResult = QlogRead(&stCursor, &stRecord)) == 1)
+	{
+		uint32_t ulId;
+		tPpsTime tTime;
+		uint32_t i;
+
+		TEST_CHECK(stRecord.usLen >= TEST_ID_HEADER);
+		memcpy(&ulId, &stRecord.aucData[0], sizeof(ulId));
+		memcpy(&tTime, &stRecord.aucData[4], sizeof(tTime));
+		if(!TEST_CHECK((ulId < ulNextId) && (aucIdState[ulId] != TEST_ID_NONE)))
+		{
+			break;
+		}
+		TEST_EQUAL(stRecord.ucType, QLOG_TYPE_BOOT + ulId % 3);
+		TEST_CHECK(stRecord.tTime == tTime);
+		for(i = TEST_ID_HEADER; i < stRecord.usLen; i++)
+		{
+			if(stRecord.aucData[i] != (uint8_t)(ulId + i))
+			{
+				TEST_CHECK(stRecord.aucData[i] == (uint8_t)(ulId + i));
+				break;
+			}
+		}
+
+		/* oldest first, skipping nothing durable */
+		if(ulId >= ulGoneBelow)
+		{
+			TEST_CHECK(ulId >= ulNext);
+			for(; ulNext < ulId; ulNext++)
+			{
+				if(aucIdState[ulNext] == TEST_ID_DURABLE)
+				{
+					TEST_EQUAL(ulNext, ulId);
+					break;
+				}
+			}
+			ulNext = ulId + 1;
+		}
+		ulRead++;
+	}
+	TEST_EQUAL(iResult, 0);
+	for(; ulNext < ulNextId; ulNext++)
+	{
+		if(aucIdState[ulNext] == TEST_ID_DURABLE)
+		{
+			TEST_EQUAL(ulNext, ulNextId);
+			break;
+		}
+	}
+	return ulRead;
+}
+
+/** ***************************************************************************
+	Name:               TestBlank
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A log on a flash it has never used starts at the beginning, reads back
+	empty, and then holds what is written to it. A sector header in the
+	wrong sector, as a log of another size would have left, is ignored. A
+	record too long for a page is dropped, and none is read while the flash
+	is busy.
+*/
+static void TestBlank(void)
+{
+	static uint32_t const ulZero = 0;
+	tQlogCursor stCursor;
+	tQlogRecord stRecord;
+	tQlogSector stHeader;
+	uint32_t i;
+	uint32_t j;
+
+	TestFlashInit();
+	stHeader.ulMagic = QLOG_SECTOR_MAGIC;
+	stHeader.ulSeq = 3 + TEST_SECTORS + 1;
+	stHeader.ulErases = 5;
+	stHeader.ulCrc = Crc32(Crc32(CRC32_INIT, &stHeader, 12), &ulZero, 4);
+	memcpy(&stFlash.aucData[3 * QSPI_SECTOR_SIZE], &stHeader,
+		sizeof(stHeader));
+
+	TEST_EQUAL(QlogWrite(QLOG_TYPE_BOOT, tNow, "", 0), -1);
+	TestStart();
+	TEST_EQUAL(QlogGet()->ulSeq, 0);
+	TEST_EQUAL(QlogGet()->ulPage, 0);
+	TEST_EQUAL(TestCheckLog(), 0);
+
+	/* a restart with only the first sector header in the flash */
+	for(i = 0; (i < 1000) && (QlogGet()->ulErases < 2); i++)
+	{
+		TestPoll(TEST_SECOND / 100);
+	}
+	TEST_EQUAL(QlogGet()->ulErases, 2);
+	TestCut(0);
+	TestStart();
+	TEST_EQUAL(QlogGet()->ulSeq, 0);
+	TEST_EQUAL(QlogGet()->ulPage, 0);
+
+	for(i = 0; i < 100; i++)
+	{
+		TEST_EQUAL(TestWrite(TEST_ID_HEADER + i % 40), 0);
+		for(j = 0; j < 20; j++)
+		{
+			TestPoll(TEST_SECOND / 100);
+		}
+	}
+	TEST_EQUAL(TestWrite(QLOG_MAX_PAYLOAD + 1), -1);
+	TEST_EQUAL(TestWrite(QLOG_MAX_PAYLOAD), 0);
+	TEST_EQUAL(QlogGet()->ulDropped, 1);
+
+	while(stFlash.ucOp == TEST_OP_NONE)
+	{
+		TestPoll(TEST_SECOND);
+	}
+	QlogReadStart(&stCursor);
+	TEST_EQUAL(QlogRead(&stCursor, &stRecord), -1);
+
+	TestDrain();
+	TEST_EQUAL(TestCheckLog(), 101);
+	TEST_EQUAL(QlogGet()->ulRecords, 101);
+	TEST_EQUAL(QlogGet()->ulErrors, 0);
+
+	/* and after a restart */
+	TestCut(0);
+	TestStart();
+	TEST_EQUAL(TestCheckLog(), 101);
+}
+
+/** ***************************************************************************
+	Name:               TestTornProgram
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A reset cuts a page program short, at every length it could have got
+	to. The records programmed whole before the cut are read back, the rest
+	of the page is not, and the log carries on in the next page.
+*/
+static void TestTornProgram(void)
+{
+	uint32_t ulTear;
+
+	for(ulTear = 0; ulTear <= QSPI_PAGE_SIZE; ulTear += 7)
+	{
+		uint32_t ulAddr;
+		uint32_t ulPage;
+		uint32_t ulSeq;
+		uint32_t ulRead;
+		uint32_t ulDone;
+		uint32_t ulWhole;
+		uint32_t i;
+
+		TestFlashInit();
+		TestStart();
+		for(i = 0; i < 20; i++)
+		{
+			TEST_EQUAL(TestWrite(TEST_ID_HEADER + i % 20), 0);
+		}
+		TestDrain();
+
+		/* five records of 32 bytes in the next page */
+		for(i = 0; i < 5; i++)
+		{
+			TEST_EQUAL(TestWrite(16), 0);
+		}
+		while(stFlash.ucOp != TEST_OP_PROGRAM)
+		{
+			TestPoll(TEST_SECOND);
+		}
+		ulSeq = QlogGet()->ulSeq;
+		ulPage = QlogGet()->ulPage;
+		TEST_EQUAL(stFlash.ulLen, 5 * 32);
+		ulAddr = stFlash.ulAddr;
+		TestCut(ulTear);
+
+		/* the last byte torn may have come out right, or not at all */
+		for(ulDone = 0; (ulDone < 5 * 32)
+			&& (stFlash.aucData[ulAddr + ulDone] == stFlash.aucProgram[ulDone]);
+			ulDone++)
+		{
+		}
+		ulWhole = ulDone / 32;
+
+		TestStart();
+		ulRead = TestCheckLog();
+		TEST_EQUAL(ulRead, 20 + ulWhole);
+		TEST_EQUAL(QlogGet()->ulSeq, ulSeq);
+		TEST_EQUAL(QlogGet()->ulPage,
+			(stFlash.aucData[ulAddr] == 0xFF) ? ulPage - 1 : ulPage);
+
+		for(i = 0; i < 10; i++)
+		{
+			TEST_EQUAL(TestWrite(TEST_ID_HEADER + i), 0);
+		}
+		TestDrain();
+		TEST_EQUAL(TestCheckLog(), ulRead + 10);
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestTornErase
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Once the log has gone round, a reset cuts short the erase of its oldest
+	sector. After the restart the rest of the log reads back, the same
+	sector is erased again first, and it takes the erase count of the
+	sector before it.
+*/
+static void TestTornErase(void)
+{
+	uint32_t ulSector;
+	uint32_t ulBefore;
+	tQlogSector stHeader;
+	uint32_t i;
+
+	TestFlashInit();
+	TestStart();
+	while(stFlash.aulErases[0] < 2)
+	{
+		TestWrite(TEST_ID_HEADER + TestRand() % 100);
+		TestPoll(TEST_SECOND / 4);
+	}
+	TestDrain();
+
+	/* write on until the next erase starts */
+	while(stFlash.ucOp != TEST_OP_ERASE)
+	{
+		TestWrite(TEST_ID_HEADER + TestRand() % 100);
+		TestPoll(TEST_SECOND / 4);
+	}
+	ulSector = stFlash.ulAddr / QSPI_SECTOR_SIZE;
+	ulBefore = (ulSector + TEST_SECTORS - 1) % TEST_SECTORS;
+	TestCut(0);
+
+	TestStart();
+	TEST_CHECK(TestCheckLog() > 0);
+	TestPoll(0);
+	TEST_EQUAL(stFlash.ucOp, TEST_OP_ERASE);
+	TEST_EQUAL(stFlash.ulAddr, ulSector * QSPI_SECTOR_SIZE);
+	TestDrain();
+
+	memcpy(&stHeader, &stFlash.aucData[ulSector * QSPI_SECTOR_SIZE],
+		sizeof(stHeader));
+	TEST_EQUAL(stHeader.ulMagic, QLOG_SECTOR_MAGIC);
+	TEST_EQUAL(stHeader.ulSeq % TEST_SECTORS, ulSector);
+	memcpy(&stHeader, &stFlash.aucData[ulBefore * QSPI_SECTOR_SIZE],
+		sizeof(stHeader));
+	i = stHeader.ulErases;
+	memcpy(&stHeader, &stFlash.aucData[ulSector * QSPI_SECTOR_SIZE],
+		sizeof(stHeader));
+	TEST_EQUAL(stHeader.ulErases, i);
+
+	for(i = 0; i < 50; i++)
+	{
+		TestWrite(TEST_ID_HEADER + i);
+		TestPoll(TEST_SECOND / 4);
+	}
+	TestDrain();
+	TestCheckLog();
+}
+
+/** ***************************************************************************
+	Name:               TestPowerCuts
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Hundreds of runs of random length, each ended by a reset wherever the
+	flash is, and read back after each restart. Now and then a run drains
+	the log first, so all it wrote must come back. Records go in faster
+	than the flash takes them at times, so some are dropped. Throughout,
+	the sectors wear evenly, and the erase counts in their headers keep up.
+*/
+static void TestPowerCuts(void)
+{
+	uint32_t ulBoot;
+	uint32_t ulMin = UINT32_MAX;
+	uint32_t ulMax = 0;
+	uint32_t ulDropped = 0;
+	uint32_t ulRead = 0;
+	uint32_t i;
+
+	TestFlashInit();
+	for(ulBoot = 0; ulBoot < 300; ulBoot++)
+	{
+		uint32_t const ulSteps = TestRand() % 3000;
+
+		TestStart();
+		ulRead += TestCheckLog();
+		for(i = 0; i < ulSteps; i++)
+		{
+			if(TestRand() % 3 == 0)
+			{
+				TestWrite(TEST_ID_HEADER + TestRand() % 60);
+			}
+			TestPoll(TEST_SECOND / (1 + TestRand() % 20));
+		}
+		if(TestRand() % 2)
+		{
+			TestDrain();
+		}
+		ulDropped += QlogGet()->ulDropped;
+		TestCut(TestRand() % (QSPI_PAGE_SIZE + 40));
+	}
+	TestStart();
+	TestCheckLog();
+
+	for(i = 0; i < TEST_SECTORS; i++)
+	{
+		tQlogSector stHeader;
+
+		memcpy(&stHeader, &stFlash.aucData[i * QSPI_SECTOR_SIZE],
+			sizeof(stHeader));
+		TEST_CHECK(stHeader.ulErases <= stFlash.aulErases[i]);
+		TEST_CHECK(stHeader.ulErases + 3 >= stFlash.aulErases[i]);
+		if(stFlash.aulErases[i] < ulMin)
+		{
+			ulMin = stFlash.aulErases[i];
+		}
+		if(stFlash.aulErases[i] > ulMax)
+		{
+			ulMax = stFlash.aulErases[i];
+		}
+	}
+	/* a sector whose header program was cut short is erased once more */
+	TEST_CHECK(ulMin > 50);
+	TEST_CHECK(ulMax - ulMin <= 2);
+	TEST_CHECK(QlogGet()->ulMaxErases - QlogGet()->ulMinErases <= 2);
+	TEST_CHECK(ulDropped > 0);
+	TEST_CHECK(ulRead > 100 * ulBoot);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,543 @@
+/** ***************************************************************************
+File Name:  test_rx_ring.c
+
+Project:    Platform 4
+
+Purpose:    Receive ring test: a register model of the XDMAC walking the
+            descriptor chain streams frames through the ring and parser
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "crc.h"
+#include "frame.h"
+#include "rx_ring.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+#define TEST_CHANNEL         3
+#define TEST_PER_ID          XDMAC_CHANNEL_HWID_USART1_RX
+
+/* frames in the test stream, and the largest burst the DMA writes between
+	two passes of the main loop; below RX_RING_SIZE - RX_RING_SEGMENT_SIZE
+	nothing may be lost */
+#define TEST_FRAMES          3000
+#define TEST_MAX_BURST       (RX_RING_SIZE - RX_RING_SEGMENT_SIZE)
+
+/* segments completed before the test starts: a lap count that puts the
+	free-running byte counters 64 segments short of wrapping through 2^32 */
+#define TEST_SEG_START       ((1UL << 23) - 64)
+
+
+/* Module Type Definitions */
+
+/* the DMA side of the model */
+typedef struct
+{
+	/* bytes written, free-running like the ring's counters */
+	uint32_t ulWritten;
+	/* the current microblock ran out and the next descriptor hasn't been
+		fetched yet, which the hardware takes a few cycles over */
+	uint8_t ucFetchDue;
+	/* end of block interrupts raised and not yet taken */
+	uint32_t ulIrqPending;
+} tTestDma;
+
+
+/* Module Function Declarations */
+
+static void TestDmaStart(void);
+static void TestDmaFetch(void);
+static void TestDmaWrite(uint8_t const *pucData, uint32_t ulLen);
+static void TestDmaIrq(void);
+static uint32_t TestRand(void);
+static uint32_t TestBuildStream(void);
+static void TestDrain(void);
+static void TestStart(void);
+static void TestChain(void);
+static void TestStream(void);
+static void TestOverrun(void);
+
+
+/* Module Variable Declarations */
+
+/* statics, as the ring and descriptors pass through 32 bit DMA addresses */
+static tRxRing stRing;
+static tFrameParser stParser;
+static tTestDma stDma;
+static uint32_t ulTestRhr;
+
+/* the transmitted byte stream */
+static uint8_t aucStream[TEST_FRAMES * (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)];
+static uint8_t aucPayload[FRAME_MAX_PAYLOAD];
+
+/* frames seen by TestDrain(), and the sequence numbers of the first and
+	last */
+static uint32_t ulSeen;
+static uint16_t usFirstSeq;
+static uint16_t usLastSeq;
+static uint32_t ulBadPayloads;
+
+static uint32_t ulRandState = 12345;
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the receive ring tests.
+*/
+int main(void)
+{
+	CrcInit();
+	TestChain();
+	TestStream();
+	TestOverrun();
+	return TestResult("rx_ring");
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestDmaStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   RxRingStart() must have been called
+
+	Description:
+	Models the channel being enabled: the first descriptor is fetched from
+	the address RxRingStart() wrote to CNDA.
+*/
+static void TestDmaStart(void)
+{
+	memset(&stDma, 0, sizeof(stDma));
+	TEST_CHECK(XDMAC->XDMAC_GE & (1UL << TEST_CHANNEL));
+	TestDmaFetch();
+}
+
+/** ***************************************************************************
+	Name:               TestDmaFetch
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Loads the view 1 descriptor CNDA points at. As on the hardware, CNDA
+	then holds the descriptor after the one being executed.
+*/
+static void TestDmaFetch(void)
+{
+	XdmacChid volatile *pstChan = &XDMAC->XDMAC_CHID[TEST_CHANNEL];
+	lld_view1 const *pstDesc =
+		(lld_view1 const *)(uintptr_t)(pstChan->XDMAC_CNDA & XDMAC_CNDA_NDA_Msk);
+
+	TEST_EQUAL(pstDesc->mbr_sa, (uint32_t)(uintptr_t)&ulTestRhr);
+	pstChan->XDMAC_CDA = pstDesc->mbr_da;
+	pstChan->XDMAC_CUBC = pstDesc->mbr_ubc & XDMAC_UBC_UBLEN_Msk;
+	pstChan->XDMAC_CNDA = pstDesc->mbr_nda;
+	pstChan->XDMAC_CC |= XDMAC_CC_INITD;
+	stDma.ucFetchDue = 0;
+}
+
+/** ***************************************************************************
+	Name:               TestDmaWrite
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Moves received bytes into memory through the current descriptor. The
+	end of a microblock raises the interrupt, which is only taken when
+	TestDmaIrq() is called, and the next descriptor is fetched when the next
+	byte arrives, so the ring sees both in-between states.
+*/
+static void TestDmaWrite(uint8_t const *pucData, uint32_t ulLen)
+{
+	XdmacChid volatile *pstChan = &XDMAC->XDMAC_CHID[TEST_CHANNEL];
+
+	while(ulLen--)
+	{
+		if(stDma.ucFetchDue)
+		{
+			TestDmaFetch();
+		}
+		*(uint8_t *)(uintptr_t)pstChan->XDMAC_CDA = *pucData++;
+		pstChan->XDMAC_CDA++;
+		stDma.ulWritten++;
+		if(--pstChan->XDMAC_CUBC == 0)
+		{
+			stDma.ulIrqPending++;
+			stDma.ucFetchDue = 1;
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestDmaIrq
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Takes the pending end of block interrupts, as the XDMAC ISR would.
+*/
+static void TestDmaIrq(void)
+{
+	while(stDma.ulIrqPending)
+	{
+		stDma.ulIrqPending--;
+		RxRingSegmentDone(&stRing);
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestBuildStream
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Length of the stream
+	Caveats / Effect:   None
+
+	Description:
+	Frames with consecutive sequence numbers and payloads of every length
+	up to FRAME_MAX_PAYLOAD, each filled from its sequence number so the
+	receiver can check it.
+*/
+static uint32_t TestBuildStream(void)
+{
+	uint32_t ulLen = 0;
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < TEST_FRAMES; i++)
+	{
+		uint32_t const ulPayload = (i * 37) % (FRAME_MAX_PAYLOAD + 1);
+
+		for(j = 0; j < ulPayload; j++)
+		{
+			aucPayload[j] = (uint8_t)(i * 7 + j);
+		}
+		ulLen += FrameBuild(&aucStream[ulLen], (uint16_t)i, aucPayload,
+			ulPayload);
+	}
+	return ulLen;
+}
+
+/** ***************************************************************************
+	Name:               TestDrain
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The main program loop's side, as in LinkFeed(): parses everything the
+	DMA has written and checks each frame against TestBuildStream().
+*/
+static void TestDrain(void)
+{
+	for(;;)
+	{
+		uint8_t const *pucData;
+		uint32_t const ulLen = RxRingPeek(&stRing, &pucData);
+
+		RxRingConsume(&stRing, FrameParserFeed(&stParser, pucData, ulLen));
+		if(FrameParserReady(&stParser))
+		{
+			uint16_t const usSeq = FrameGetSeq(&stParser);
+			uint8_t const *pucPayload = FrameGetPayload(&stParser);
+			uint32_t const ulPayload = FrameGetLength(&stParser);
+			uint32_t j;
+
+			if(ulPayload != (usSeq * 37UL) % (FRAME_MAX_PAYLOAD + 1))
+			{
+				ulBadPayloads++;
+			}
+			for(j = 0; j < ulPayload; j++)
+			{
+				if(pucPayload[j] != (uint8_t)(usSeq * 7 + j))
+				{
+					ulBadPayloads++;
+					break;
+				}
+			}
+			if(ulSeen++ == 0)
+			{
+				usFirstSeq = usSeq;
+			}
+			usLastSeq = usSeq;
+		}
+		else if(ulLen == 0)
+		{
+			break;
+		}
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestStart
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Starts the ring and the DMA model with the free-running counters just
+	short of wrapping. The ring starts on a whole lap, so the counters agree
+	with the descriptor the DMA is on.
+*/
+static void TestStart(void)
+{
+	memset(&stTestXdmac, 0, sizeof(stTestXdmac));
+	TEST_EQUAL(RxRingInit(&stRing, TEST_CHANNEL,
+		(uint32_t)(uintptr_t)&ulTestRhr, TEST_PER_ID), 0);
+	RxRingStart(&stRing);
+	TestDmaStart();
+
+	stRing.ulSegCount = TEST_SEG_START;
+	stRing.ulReadCount = TEST_SEG_START * RX_RING_SEGMENT_SIZE;
+	stDma.ulWritten = stRing.ulReadCount;
+
+	FrameParserInit(&stParser);
+	ulSeen = 0;
+	usFirstSeq = 0;
+	usLastSeq = 0;
+	ulBadPayloads = 0;
+}
+
+/** ***************************************************************************
+	Name:               TestChain
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The descriptors form one circle over the ring's segments, and the
+	channel is set up for a byte wide peripheral to memory transfer.
+*/
+static void TestChain(void)
+{
+	XdmacChid volatile *pstChan = &XDMAC->XDMAC_CHID[TEST_CHANNEL];
+	uint32_t i;
+
+	TestStart();
+	for(i = 0; i < RX_RING_SEGMENTS; i++)
+	{
+		lld_view1 const *pstDesc = &stRing.pastDesc[i];
+
+		TEST_EQUAL(pstDesc->mbr_nda, (uint32_t)(uintptr_t)
+			&stRing.pastDesc[(i + 1) % RX_RING_SEGMENTS]);
+		TEST_EQUAL(pstDesc->mbr_da, (uint32_t)(uintptr_t)
+			&stRing.aucData[i * RX_RING_SEGMENT_SIZE]);
+		TEST_EQUAL(pstDesc->mbr_ubc & XDMAC_UBC_UBLEN_Msk,
+			RX_RING_SEGMENT_SIZE);
+		TEST_CHECK(pstDesc->mbr_ubc & XDMAC_UBC_NDE_FETCH_EN);
+	}
+	TEST_EQUAL(pstChan->XDMAC_CC & XDMAC_CC_PERID_Msk,
+		XDMAC_CC_PERID(TEST_PER_ID));
+	TEST_EQUAL(pstChan->XDMAC_CC & XDMAC_CC_DWIDTH_Msk, XDMAC_CC_DWIDTH_BYTE);
+	TEST_CHECK(pstChan->XDMAC_CC & XDMAC_CC_DAM_INCREMENTED_AM);
+
+	/* the DMA is at the start of segment 0 */
+	TEST_EQUAL(RxRingGetWriteOffset(&stRing), 0);
+	TEST_EQUAL(RxRingGetWriteCount(&stRing), stDma.ulWritten);
+}
+
+/** ***************************************************************************
+	Name:               TestStream
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Streams the frames back to back in bursts of random size, with the
+	interrupts sometimes taken before the main loop runs and sometimes
+	after, through the counter wrap. While the main loop keeps up every
+	frame arrives intact and in order, and the write count always matches
+	what the DMA has written.
+*/
+static void TestStream(void)
+{
+	uint32_t const ulStream = TestBuildStream();
+	uint32_t ulSent = 0;
+	uint32_t ulWraps = 0;
+
+	TestStart();
+	while(ulSent < ulStream)
+	{
+		uint32_t ulBurst = TestRand() % TEST_MAX_BURST + 1;
+		uint32_t const ulBefore = stDma.ulWritten;
+
+		if(ulBurst > ulStream - ulSent)
+		{
+			ulBurst = ulStream - ulSent;
+		}
+		TestDmaWrite(&aucStream[ulSent], ulBurst);
+		ulSent += ulBurst;
+		if(stDma.ulWritten < ulBefore)
+		{
+			ulWraps++;
+		}
+
+		/* a lagging segment count only puts the write count ahead of it */
+		if(TestRand() & 1)
+		{
+			TestDmaIrq();
+		}
+		TEST_EQUAL(RxRingGetWriteCount(&stRing), stDma.ulWritten);
+		TestDrain();
+		TestDmaIrq();
+		TEST_EQUAL(stRing.ulReadCount, stDma.ulWritten);
+	}
+
+	TEST_EQUAL(ulWraps, 1);
+	TEST_EQUAL(ulSeen, TEST_FRAMES);
+	TEST_EQUAL(usLastSeq, TEST_FRAMES - 1);
+	TEST_EQUAL(ulBadPayloads, 0);
+	TEST_EQUAL(stParser.ulSeqLost, 0);
+	TEST_EQUAL(stParser.ulCrcErrors, 0);
+	TEST_EQUAL(stParser.ulSkipped, 0);
+	TEST_EQUAL(stRing.ulOverruns, 0);
+	TEST_EQUAL(stRing.ulLostBytes, 0);
+}
+
+/** ***************************************************************************
+	Name:               TestOverrun
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The main loop stalls while the DMA laps it, and gets back before the
+	last end of block interrupt is taken. The next peek reports one overrun
+	and skips exactly the bytes up to two segments past the one the ISR
+	count says is being written, the oldest that can still be intact. From
+	the first frame that starts after that every frame is received, intact.
+*/
+static void TestOverrun(void)
+{
+	uint32_t const ulStream = TestBuildStream();
+	uint32_t const ulHalf = ulStream / 2;
+	uint32_t ulLost;
+	uint32_t ulSent;
+	uint32_t ulFrame;
+	uint32_t ulOffset;
+
+	TestStart();
+
+	/* a stall longer than the ring, with the DMA into the segment after
+		the last one the ISR has counted */
+	TestDmaWrite(aucStream, ulHalf);
+	TEST_CHECK(stDma.ulIrqPending > 1);
+	stDma.ulIrqPending--;
+	TestDmaIrq();
+	stDma.ulIrqPending = 1;
+	ulLost = stRing.ulSegCount * RX_RING_SEGMENT_SIZE
+		+ 2 * RX_RING_SEGMENT_SIZE - RX_RING_SIZE - stRing.ulReadCount;
+	TestDrain();
+	TEST_EQUAL(stRing.ulOverruns, 1);
+	TEST_EQUAL(stRing.ulLostBytes, ulLost);
+	TEST_EQUAL(stRing.ulReadCount, stDma.ulWritten);
+
+	/* the first whole frame in what was kept */
+	for(ulFrame = 0, ulOffset = 0; ulOffset < ulLost; ulFrame++)
+	{
+		ulOffset += (ulFrame * 37) % (FRAME_MAX_PAYLOAD + 1) + FRAME_OVERHEAD;
+	}
+
+	/* then the main loop keeps up again */
+	for(ulSent = ulHalf; ulSent < ulStream;)
+	{
+		uint32_t ulBurst = TestRand() % 1000 + 1;
+
+		if(ulBurst > ulStream - ulSent)
+		{
+			ulBurst = ulStream - ulSent;
+		}
+		TestDmaWrite(&aucStream[ulSent], ulBurst);
+		ulSent += ulBurst;
+		TestDmaIrq();
+		TestDrain();
+	}
+
+	TEST_EQUAL(stRing.ulOverruns, 1);
+	TEST_EQUAL(usLastSeq, TEST_FRAMES - 1);
+	TEST_EQUAL(ulBadPayloads, 0);
+	TEST_EQUAL(usFirstSeq, ulFrame);
+	TEST_EQUAL(ulSeen, TEST_FRAMES - ulFrame);
+	TEST_EQUAL(stParser.ulSeqLost, 0);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,605 @@
+/** ***************************************************************************
+File Name:  test_tsync.c
+
+Project:    Platform 4
+
+Purpose:    Time sync test: a master and a slave with offset clocks run the
+            exchange over a simulated link with different delays each way,
+            jitter, late stamps, loss and a busy transmitter
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "tsync.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+/* messages on their way over the link */
+#define TEST_FLIGHT          16
+
+/* the main loop polls every ms */
+#define TEST_POLL_NS         1000000ULL
+
+/* true time the simulation starts at, clear of 0 for a slave behind */
+#define TEST_START_NS        (1000ULL * 1000000000ULL)
+
+/* rounding allowed on a result: each difference of two times is truncated
+	to a whole ns */
+#define TEST_ROUND_NS        3
+
+
+/* Module Type Definitions */
+
+/* what the link does to the messages, each of the chances in percent */
+typedef struct
+{
+	/* delay master to slave and slave to master, and a random extra delay
+		of up to ulJitterNs on every message */
+	uint32_t ulDelayMsNs;
+	uint32_t ulDelaySmNs;
+	uint32_t ulJitterNs;
+	/* a message held up by ulLateNs, lost, or delivered a whole exchange
+		interval late, into the next exchange */
+	uint32_t ulLatePct;
+	uint32_t ulLateNs;
+	uint32_t ulLossPct;
+	uint32_t ulStalePct;
+	/* the transmitter is busy and refuses a message */
+	uint32_t ulBusyPct;
+} tTestLink;
+
+/* one end of the link: its clock is true time plus llOffsetNs, running
+	lDriftPpb fast */
+typedef struct
+{
+	tTsync stSync;
+	int64_t llOffsetNs;
+	int32_t lDriftPpb;
+	uint32_t ulIndex;
+	/* results checked so far */
+	uint32_t ulSeen;
+} tTestEnd;
+
+/* a message on the link */
+typedef struct
+{
+	uint64_t ullArriveNs;
+	uint32_t ulTo;
+	uint32_t ulLen;
+	uint8_t aucMsg[TSYNC_MSG_MAX];
+} tTestMsg;
+
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static uint64_t TestPps(int64_t llNs);
+static int64_t TestLocalNs(tTestEnd const *pstEnd, uint64_t ullTrueNs);
+static int TestSend(void *pvContext, uint8_t const *pucMsg, uint32_t ulLen,
+	uint64_t *pullTxTime);
+static void TestDeliver(uint64_t ullUntilNs);
+static void TestCheckResult(tTestEnd *pstEnd);
+static uint32_t TestRun(tTestLink const *pstLink, int64_t llOffsetNs,
+	int32_t lDriftPpb, int32_t lAsymmetryNs, uint32_t ulSeconds,
+	int64_t llBoundNs);
+static void TestDiff(void);
+static void TestExact(void);
+static void TestAsymmetry(void);
+static void TestJitter(void);
+static void TestLossy(void);
+static void TestDrift(void);
+
+
+/* Module Variable Declarations */
+
+/* the two ends, the master first */
+static tTestEnd astEnd[2];
+
+static tTestLink const *pstTestLink;
+static tTestMsg astFlight[TEST_FLIGHT];
+static uint32_t ulFlight;
+
+/* true time of the simulation */
+static uint64_t ullNowNs;
+
+/* how far a result may be from the true offset */
+static int64_t llTestBoundNs;
+
+static uint32_t ulRandState = 2020;
+
+
+/* Global Variables (Must be justified!) */
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the time sync tests.
+*/
+int main(void)
+{
+	TestDiff();
+	TestExact();
+	TestAsymmetry();
+	TestJitter();
+	TestLossy();
+	TestDrift();
+	return TestResult("tsync");
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestPps
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             A time in ns as a PPS time (tPpsTime)
+	Caveats / Effect:   llNs must not be negative
+
+	Description:
+	Seconds and fraction apart, so nothing overflows.
+*/
+static uint64_t TestPps(int64_t llNs)
+{
+	uint64_t const ullSec = (uint64_t)llNs / 1000000000ULL;
+	uint64_t const ullRem = (uint64_t)llNs % 1000000000ULL;
+
+	return (ullSec << 32) + (ullRem << 32) / 1000000000ULL;
+}
+
+/** ***************************************************************************
+	Name:               TestLocalNs
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             The clock of one end at a true time, in ns
+	Caveats / Effect:   None
+
+	Description:
+	The drift counts from the start of the simulation.
+*/
+static int64_t TestLocalNs(tTestEnd const *pstEnd, uint64_t ullTrueNs)
+{
+	int64_t const llRun = (int64_t)(ullTrueNs - TEST_START_NS);
+
+	return (int64_t)ullTrueNs + pstEnd->llOffsetNs
+		+ llRun * pstEnd->lDriftPpb / 1000000000;
+}
+
+/** ***************************************************************************
+	Name:               TestSend
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0, or -1 if the transmitter is busy
+	Caveats / Effect:   None
+
+	Description:
+	The transmit hook of both ends: stamps the message with the sender's
+	clock and puts it on the link, which decides when it arrives, if ever.
+*/
+static int TestSend(void *pvContext, uint8_t const *pucMsg, uint32_t ulLen,
+	uint64_t *pullTxTime)
+{
+	tTestEnd const *pstEnd = pvContext;
+	tTestLink const *pstLink = pstTestLink;
+	tTestMsg *pstMsg;
+	uint64_t ullDelayNs;
+
+	TEST_CHECK(ulLen <= TSYNC_MSG_MAX);
+	TEST_CHECK(TsyncIsMessage(pucMsg, ulLen));
+	if((TestRand() % 100) < pstLink->ulBusyPct)
+	{
+		return -1;
+	}
+	*pullTxTime = TestPps(TestLocalNs(pstEnd, ullNowNs));
+
+	if((TestRand() % 100) < pstLink->ulLossPct)
+	{
+		return 0;
+	}
+	ullDelayNs = (pstEnd->ulIndex == 0) ? pstLink->ulDelayMsNs
+		: pstLink->ulDelaySmNs;
+	if(pstLink->ulJitterNs)
+	{
+		ullDelayNs += TestRand() % (pstLink->ulJitterNs + 1);
+	}
+	if((TestRand() % 100) < pstLink->ulLatePct)
+	{
+		ullDelayNs += pstLink->ulLateNs;
+	}
+	if((TestRand() % 100) < pstLink->ulStalePct)
+	{
+		/* just ahead of the same message of the next exchange */
+		ullDelayNs += TSYNC_INTERVAL_MS * 1000000ULL - TestRand() % 20000;
+	}
+
+	TEST_CHECK(ulFlight < TEST_FLIGHT);
+	if(ulFlight == TEST_FLIGHT)
+	{
+		return 0;
+	}
+	pstMsg = &astFlight[ulFlight++];
+	pstMsg->ullArriveNs = ullNowNs + ullDelayNs;
+	pstMsg->ulTo = 1 - pstEnd->ulIndex;
+	pstMsg->ulLen = ulLen;
+	memcpy(pstMsg->aucMsg, pucMsg, ulLen);
+	return 0;
+}
+
+/** ***************************************************************************
+	Name:               TestDeliver
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Advances the true time to each arrival
+
+	Description:
+	Hands every message arriving before ullUntilNs to its end, in the order
+	they arrive, stamped with the receiver's clock. A receiver may answer
+	straight away, which can add a message to the flight.
+*/
+static void TestDeliver(uint64_t ullUntilNs)
+{
+	for(;;)
+	{
+		tTestMsg stMsg;
+		uint32_t ulFirst = 0;
+		uint32_t i;
+
+		for(i = 1; i < ulFlight; i++)
+		{
+			if(astFlight[i].ullArriveNs < astFlight[ulFirst].ullArriveNs)
+			{
+				ulFirst = i;
+			}
+		}
+		if((ulFlight == 0) || (astFlight[ulFirst].ullArriveNs >= ullUntilNs))
+		{
+			return;
+		}
+
+		stMsg = astFlight[ulFirst];
+		astFlight[ulFirst] = astFlight[--ulFlight];
+		ullNowNs = stMsg.ullArriveNs;
+		TsyncReceive(&astEnd[stMsg.ulTo].stSync, stMsg.aucMsg, stMsg.ulLen,
+			TestPps(TestLocalNs(&astEnd[stMsg.ulTo], ullNowNs)));
+		TestCheckResult(&astEnd[stMsg.ulTo]);
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestCheckResult
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Checks a new result of one end, once the delay filter has settled over
+	the first ten exchanges: it must be within llTestBoundNs of the true
+	offset of the slave's clock at that moment.
+*/
+static void TestCheckResult(tTestEnd *pstEnd)
+{
+	tTsync const *pstSync = &pstEnd->stSync;
+	int64_t llError;
+
+	if(pstSync->ulExchanges == pstEnd->ulSeen)
+	{
+		return;
+	}
+	pstEnd->ulSeen = pstSync->ulExchanges;
+	if(pstEnd->ulSeen <= 10)
+	{
+		return;
+	}
+
+	llError = pstSync->llOffsetNs - (TestLocalNs(&astEnd[1], ullNowNs)
+		- TestLocalNs(&astEnd[0], ullNowNs));
+	if(llError < 0)
+	{
+		llError = -llError;
+	}
+	TEST_CHECK(llError <= llTestBoundNs);
+}
+
+/** ***************************************************************************
+	Name:               TestRun
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Number of exchanges completed by the slave
+	Caveats / Effect:   None
+
+	Description:
+	Runs a master and a slave whose clock is llOffsetNs ahead for ulSeconds,
+	both told the link asymmetry is lAsymmetryNs, checking every result
+	against llBoundNs (see TestCheckResult()). Over a link that delivers every
+	message both ends finish with the same result.
+*/
+static uint32_t TestRun(tTestLink const *pstLink, int64_t llOffsetNs,
+	int32_t lDriftPpb, int32_t lAsymmetryNs, uint32_t ulSeconds,
+	int64_t llBoundNs)
+{
+	uint64_t const ullEndNs = TEST_START_NS + ulSeconds * 1000000000ULL;
+	uint32_t i;
+
+	memset(astEnd, 0, sizeof(astEnd));
+	astEnd[1].llOffsetNs = llOffsetNs;
+	astEnd[1].lDriftPpb = lDriftPpb;
+	for(i = 0; i < 2; i++)
+	{
+		astEnd[i].ulIndex = i;
+		TsyncInit(&astEnd[i].stSync, (i == 0) ? TSYNC_MASTER : TSYNC_SLAVE,
+			lAsymmetryNs, TestSend, &astEnd[i]);
+	}
+	pstTestLink = pstLink;
+	llTestBoundNs = llBoundNs;
+	ulFlight = 0;
+	ullNowNs = TEST_START_NS;
+
+	while(ullNowNs < ullEndNs)
+	{
+		TestDeliver(ullNowNs + TEST_POLL_NS);
+		ullNowNs = (ullNowNs / TEST_POLL_NS + 1) * TEST_POLL_NS;
+		for(i = 0; i < 2; i++)
+		{
+			TsyncPoll(&astEnd[i].stSync,
+				TestPps(TestLocalNs(&astEnd[i], ullNowNs)));
+			TestCheckResult(&astEnd[i]);
+		}
+	}
+
+	/* the master's result comes from the same four times as the slave's */
+	if((pstLink->ulLossPct == 0) && (pstLink->ulStalePct == 0))
+	{
+		TEST_EQUAL(astEnd[0].stSync.llOffsetNs, astEnd[1].stSync.llOffsetNs);
+		TEST_EQUAL(astEnd[0].stSync.llDelayNs, astEnd[1].stSync.llDelayNs);
+		TEST_EQUAL(astEnd[0].stSync.ulExchanges,
+			astEnd[1].stSync.ulExchanges);
+	}
+	return astEnd[1].stSync.ulExchanges;
+}
+
+/** ***************************************************************************
+	Name:               TestDiff
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Differences of PPS times in ns either way round, with the fraction
+	floored.
+*/
+static void TestDiff(void)
+{
+	TEST_EQUAL(TsyncDiffNs(1ULL << 32, 0), 1000000000LL);
+	TEST_EQUAL(TsyncDiffNs(0, 1ULL << 32), -1000000000LL);
+	TEST_EQUAL(TsyncDiffNs(0x80000000ULL, 0), 500000000LL);
+	TEST_EQUAL(TsyncDiffNs(0, 0x80000000ULL), -500000000LL);
+	TEST_EQUAL(TsyncDiffNs(1, 0), 0);
+	TEST_EQUAL(TsyncDiffNs(0, 1), -1);
+	TEST_EQUAL(TsyncDiffNs(TestPps(TEST_START_NS + 4321),
+		TestPps(TEST_START_NS)), 4320);
+	TEST_EQUAL(TsyncDiffNs(5000ULL << 32, 3ULL << 32), 4997000000000LL);
+}
+
+/** ***************************************************************************
+	Name:               TestExact
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A clean link whose asymmetry is known: the offset, whether the slave is
+	ahead or behind by a fraction of a second or many seconds, and the mean
+	path delay come out to the ns. Every exchange completes.
+*/
+static void TestExact(void)
+{
+	static int64_t const allOffsets[] = {
+		0, 1, -1, 123456789LL, -987654321LL, 37000000001LL, -500000000000LL
+	};
+	tTestLink stLink = { 4000, 4600, 0, 0, 0, 0, 0, 0 };
+	uint32_t i;
+
+	for(i = 0; i < sizeof(allOffsets) / sizeof(allOffsets[0]); i++)
+	{
+		TEST_EQUAL(TestRun(&stLink, allOffsets[i], 0, -600, 30,
+			TEST_ROUND_NS), 30);
+		TEST_CHECK(astEnd[1].stSync.ucValid);
+		TEST_CHECK((astEnd[1].stSync.llDelayNs >= 4300 - TEST_ROUND_NS)
+			&& (astEnd[1].stSync.llDelayNs <= 4300 + TEST_ROUND_NS));
+		TEST_EQUAL(astEnd[0].stSync.ulTimeouts, 0);
+		TEST_EQUAL(astEnd[1].stSync.ulTimeouts, 0);
+		TEST_EQUAL(astEnd[1].stSync.ulRejected, 0);
+	}
+}
+
+/** ***************************************************************************
+	Name:               TestAsymmetry
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The exchange only measures the mean path delay. Told the asymmetry, the
+	offset is exact; told nothing, it is out by exactly half the
+	asymmetry, whichever way round the link is slower.
+*/
+static void TestAsymmetry(void)
+{
+	tTestLink stSlowOut = { 9000, 3000, 0, 0, 0, 0, 0, 0 };
+	tTestLink stSlowBack = { 3000, 9000, 0, 0, 0, 0, 0, 0 };
+	int64_t llOffset;
+
+	TEST_EQUAL(TestRun(&stSlowOut, 250000, 0, 6000, 20, TEST_ROUND_NS), 20);
+	TEST_EQUAL(TestRun(&stSlowBack, 250000, 0, -6000, 20, TEST_ROUND_NS), 20);
+
+	TEST_EQUAL(TestRun(&stSlowOut, 250000, 0, 0, 20, 3000 + TEST_ROUND_NS),
+		20);
+	llOffset = astEnd[1].stSync.llOffsetNs;
+	TEST_CHECK((llOffset >= 253000 - TEST_ROUND_NS)
+		&& (llOffset <= 253000 + TEST_ROUND_NS));
+
+	TEST_EQUAL(TestRun(&stSlowBack, 250000, 0, 0, 20, 3000 + TEST_ROUND_NS),
+		20);
+	llOffset = astEnd[1].stSync.llOffsetNs;
+	TEST_CHECK((llOffset >= 247000 - TEST_ROUND_NS)
+		&& (llOffset <= 247000 + TEST_ROUND_NS));
+}
+
+/** ***************************************************************************
+	Name:               TestJitter
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Random delay on every message, and now and then a message held up far
+	beyond the gate: the late exchanges are rejected rather than pulling
+	the delay filter up, and every result stays within the jitter of the
+	true offset.
+*/
+static void TestJitter(void)
+{
+	tTestLink stLink = { 4000, 4600, 400, 0, 0, 0, 0, 0 };
+	tTestLink stLate = { 4000, 4600, 400, 5, 50000, 0, 0, 0 };
+	uint32_t ulExchanges;
+
+	TEST_EQUAL(TestRun(&stLink, -3000000000LL, 0, -600, 200,
+		800 + TEST_ROUND_NS), 200);
+	TEST_EQUAL(astEnd[1].stSync.ulRejected, 0);
+
+	ulExchanges = TestRun(&stLate, -3000000000LL, 0, -600, 200,
+		800 + TEST_ROUND_NS);
+	TEST_CHECK(astEnd[1].stSync.ulRejected > 10);
+	TEST_EQUAL(ulExchanges + astEnd[1].stSync.ulRejected, 200);
+	TEST_CHECK((astEnd[1].stSync.llDelayNs > 4300)
+		&& (astEnd[1].stSync.llDelayNs < 4700));
+}
+
+/** ***************************************************************************
+	Name:               TestLossy
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Lost messages, messages turning up during the next exchange and a
+	transmitter that is often busy. Exchanges that lose a message time out
+	and the next ones carry on; a message from an old exchange is never
+	taken for part of the current one, so every result is still right.
+*/
+static void TestLossy(void)
+{
+	tTestLink stLink = { 4000, 4600, 100, 0, 0, 3, 3, 30 };
+	uint32_t ulExchanges;
+
+	ulExchanges = TestRun(&stLink, 77777777LL, 0, -600, 500,
+		200 + TEST_ROUND_NS);
+	TEST_CHECK(ulExchanges > 300);
+	TEST_CHECK(astEnd[0].stSync.ulTimeouts > 10);
+	TEST_CHECK(astEnd[1].stSync.ulTimeouts > 10);
+	TEST_CHECK(astEnd[0].stSync.ulExchanges > ulExchanges);
+
+	/* the master accounts for every exchange it started, bar the last */
+	TEST_CHECK(astEnd[0].stSync.ulExchanges + astEnd[0].stSync.ulRejected
+		+ astEnd[0].stSync.ulTimeouts >= 499);
+}
+
+/** ***************************************************************************
+	Name:               TestDrift
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	A slave clock running 50 ppm fast. The master sends FOLLOW_UP on its
+	next poll, so an exchange spans about a ms, over which the slave gains
+	50 ns; the result is the offset of the moment to within twice that.
+*/
+static void TestDrift(void)
+{
+	tTestLink stLink = { 4000, 4600, 0, 0, 0, 0, 0, 0 };
+
+	TEST_EQUAL(TestRun(&stLink, 1000, 50000, -600, 100, 100 + TEST_ROUND_NS),
+		100);
+	TEST_CHECK(astEnd[1].stSync.llOffsetNs > 1000 + 98 * 50000);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,735 @@
+/** ***************************************************************************
+File Name:  test_usb_stream.c
+
+Project:    Platform 4
+
+Purpose:    Vendor bulk streaming interface test: the composite descriptors
+            as a host would parse them, and the transfer queues against a
+            mocked device driver (udd)
+
+Program:    Host Interface tests
+
+Compiler:   gcc, see tests/Makefile
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+******************************************************************************/
+
+/* System Include Files */
+#include <stdint.h>
+#include <string.h>
+
+/* Local Include Files */
+#include "conf_usb.h"
+#include "usb_stream.h"
+#include "test.h"
+
+
+/* Module Definitions */
+
+#define TEST_EVENTS          64
+
+/* endpoint numbers the mock driver keeps state for */
+#define TEST_EPS             16
+
+#define TEST_RUN             1
+#define TEST_DONE            2
+
+
+/* Module Type Definitions */
+
+/* a call into the driver, or a completion reported to the application */
+typedef struct
+{
+	uint8_t ucType;
+	uint8_t ucEp;
+	uint8_t ucEnd;
+	uint8_t *pucBuf;
+	uint32_t ulLen;
+	int iStatus;
+} tTestEvent;
+
+/* mocked driver state of one endpoint */
+typedef struct
+{
+	uint8_t ucBusy;
+	uint8_t *pucBuf;
+	uint32_t ulLen;
+	udd_callback_trans_t pfnCallback;
+} tTestEp;
+
+
+/* Module Function Declarations */
+
+static uint32_t TestRand(void);
+static void TestReset(void);
+static void TestEvent(uint8_t ucType, uint8_t ucEp, uint8_t ucEnd,
+	uint8_t *pucBuf, uint32_t ulLen, int iStatus);
+static void TestDone(uint8_t *pucBuf, uint32_t ulLen, int iStatus);
+static void TestComplete(udd_ep_id_t ucEp, udd_ep_status_t status,
+	uint32_t ulLen);
+static void TestCheckEvent(uint32_t ulIndex, uint8_t ucType, uint8_t *pucBuf,
+	uint32_t ulLen, int iStatus);
+static void TestConfig(usb_conf_desc_t const *pstConf, uint16_t usBulkSize);
+static void TestDescriptors(void);
+static void TestDisabled(void);
+static void TestChain(void);
+static void TestRandom(void);
+static void TestAbort(void);
+static void TestHalted(void);
+static void TestOut(void);
+
+
+/* Module Variable Declarations */
+
+static tTestEvent astEvents[TEST_EVENTS];
+static uint32_t ulEvents;
+
+static tTestEp astEps[TEST_EPS];
+
+/* what the next udd_ep_run() returns */
+static bool bRunResult;
+
+static uint8_t aucBuf[8][1024];
+
+static uint32_t ulRandState = 8008;
+
+
+/* Global Variables (Must be justified!) */
+
+/* the CDC interfaces in udi_composite_desc.c; their code isn't under test */
+UDC_DESC_STORAGE udi_api_t udi_api_cdc_comm;
+UDC_DESC_STORAGE udi_api_t udi_api_cdc_data;
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if every check passed
+	Caveats / Effect:   None
+
+	Description:
+	Runs the streaming interface tests.
+*/
+int main(void)
+{
+	TestDescriptors();
+	TestDisabled();
+	TestChain();
+	TestRandom();
+	TestAbort();
+	TestHalted();
+	TestOut();
+	return TestResult("usb_stream");
+}
+
+/** ***************************************************************************
+	Name:               udd_ep_run
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             bRunResult
+	Caveats / Effect:   Mock of the driver
+
+	Description:
+	Records the call. The driver refuses a job on an endpoint that is already
+	running one, which the interface must never ask it to do.
+*/
+bool udd_ep_run(udd_ep_id_t ep, bool b_shortpacket, uint8_t *buf,
+	iram_size_t buf_size, udd_callback_trans_t callback)
+{
+	tTestEp *pstEp = &astEps[ep & 0x0F];
+
+	TestEvent(TEST_RUN, ep, b_shortpacket, buf, buf_size, 0);
+	TEST_CHECK(!pstEp->ucBusy);
+	if(!bRunResult || pstEp->ucBusy)
+	{
+		return false;
+	}
+	pstEp->ucBusy = 1;
+	pstEp->pucBuf = buf;
+	pstEp->ulLen = buf_size;
+	pstEp->pfnCallback = callback;
+	return true;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               TestRand
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Pseudo random number, 0 to 2^31 - 1
+	Caveats / Effect:   None
+
+	Description:
+	A fixed sequence, so a failure repeats.
+*/
+static uint32_t TestRand(void)
+{
+	ulRandState = ulRandState * 1103515245UL + 12345UL;
+	return (ulRandState >> 1) & 0x7FFFFFFFUL;
+}
+
+/** ***************************************************************************
+	Name:               TestReset
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Has the host select the configuration again, with the driver idle.
+*/
+static void TestReset(void)
+{
+	memset(astEps, 0, sizeof(astEps));
+	ulEvents = 0;
+	bRunResult = true;
+	TEST_CHECK(udi_api_stream.enable());
+	TEST_EQUAL(UsbStreamIsEnabled(), 1);
+}
+
+/** ***************************************************************************
+	Name:               TestEvent
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Appends to the event log.
+*/
+static void TestEvent(uint8_t ucType, uint8_t ucEp, uint8_t ucEnd,
+	uint8_t *pucBuf, uint32_t ulLen, int iStatus)
+{
+	tTestEvent *pstEvent;
+
+	TEST_CHECK(ulEvents < TEST_EVENTS);
+	if(ulEvents == TEST_EVENTS)
+	{
+		return;
+	}
+	pstEvent = &astEvents[ulEvents++];
+	pstEvent->ucType = ucType;
+	pstEvent->ucEp = ucEp;
+	pstEvent->ucEnd = ucEnd;
+	pstEvent->pucBuf = pucBuf;
+	pstEvent->ulLen = ulLen;
+	pstEvent->iStatus = iStatus;
+}
+
+/** ***************************************************************************
+	Name:               TestDone
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The application's completion callback.
+*/
+static void TestDone(uint8_t *pucBuf, uint32_t ulLen, int iStatus)
+{
+	TestEvent(TEST_DONE, 0, 0, pucBuf, ulLen, iStatus);
+}
+
+/** ***************************************************************************
+	Name:               TestComplete
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Plays the driver's interrupt at the end of the job running on an
+	endpoint.
+*/
+static void TestComplete(udd_ep_id_t ucEp, udd_ep_status_t status,
+	uint32_t ulLen)
+{
+	tTestEp *pstEp = &astEps[ucEp & 0x0F];
+
+	TEST_CHECK(pstEp->ucBusy);
+	if(!pstEp->ucBusy)
+	{
+		return;
+	}
+	pstEp->ucBusy = 0;
+	pstEp->pfnCallback(status, ulLen, ucEp);
+}
+
+/** ***************************************************************************
+	Name:               TestCheckEvent
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Checks one entry of the event log.
+*/
+static void TestCheckEvent(uint32_t ulIndex, uint8_t ucType, uint8_t *pucBuf,
+	uint32_t ulLen, int iStatus)
+{
+	TEST_CHECK(ulIndex < ulEvents);
+	if(ulIndex >= ulEvents)
+	{
+		return;
+	}
+	TEST_EQUAL(astEvents[ulIndex].ucType, ucType);
+	TEST_CHECK(astEvents[ulIndex].pucBuf == pucBuf);
+	TEST_EQUAL(astEvents[ulIndex].ulLen, ulLen);
+	TEST_EQUAL(astEvents[ulIndex].iStatus, iStatus);
+}
+
+/** ***************************************************************************
+	Name:               TestConfig
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Walks a configuration descriptor the way a host does, by bLength, and
+	checks the composite: the IAD groups the CDC interfaces 0 and 1, the
+	vendor interface 2 has the two bulk endpoints, every endpoint address is
+	used once and every bulk endpoint has the packet size of the speed.
+*/
+static void TestConfig(usb_conf_desc_t const *pstConf, uint16_t usBulkSize)
+{
+	uint8_t const *pucDesc = (uint8_t const *)pstConf;
+	uint16_t usTotal = le16_to_cpu(pstConf->wTotalLength);
+	uint8_t aucIfaces[USB_DEVICE_NB_INTERFACE] = { 0 };
+	uint8_t aucEps[32] = { 0 };
+	usb_iface_desc_t const *pstIface = NULL;
+	uint32_t ulIfaceEps = 0;
+	uint32_t ulIads = 0;
+	uint32_t ulStreamEps = 0;
+	uint32_t ulPos = 0;
+
+	TEST_EQUAL(pstConf->bLength, sizeof(usb_conf_desc_t));
+	TEST_EQUAL(pstConf->bDescriptorType, USB_DT_CONFIGURATION);
+	TEST_EQUAL(pstConf->bNumInterfaces, USB_DEVICE_NB_INTERFACE);
+
+	while(ulPos < usTotal)
+	{
+		uint8_t const *pucThis = &pucDesc[ulPos];
+
+		TEST_CHECK(pucThis[0] >= 2);
+		if(pucThis[0] < 2)
+		{
+			return;
+		}
+		ulPos += pucThis[0];
+
+		if(pucThis[1] == USB_DT_IAD)
+		{
+			usb_iad_desc_t const *pstIad = (usb_iad_desc_t const *)pucThis;
+
+			ulIads++;
+			TEST_EQUAL(pstIad->bFirstInterface, UDI_CDC_COMM_IFACE_NUMBER_0);
+			TEST_EQUAL(pstIad->bInterfaceCount, 2);
+			TEST_EQUAL(aucIfaces[UDI_CDC_COMM_IFACE_NUMBER_0], 0);
+		}
+		else if(pucThis[1] == USB_DT_INTERFACE)
+		{
+			if(pstIface)
+			{
+				TEST_EQUAL(ulIfaceEps, pstIface->bNumEndpoints);
+			}
+			pstIface = (usb_iface_desc_t const *)pucThis;
+			ulIfaceEps = 0;
+			TEST_CHECK(pstIface->bInterfaceNumber < USB_DEVICE_NB_INTERFACE);
+			if(pstIface->bInterfaceNumber < USB_DEVICE_NB_INTERFACE)
+			{
+				aucIfaces[pstIface->bInterfaceNumber]++;
+			}
+		}
+		else if(pucThis[1] == USB_DT_ENDPOINT)
+		{
+			usb_ep_desc_t const *pstEp = (usb_ep_desc_t const *)pucThis;
+			uint8_t ucAddr = pstEp->bEndpointAddress;
+
+			TEST_CHECK(pstIface != NULL);
+			ulIfaceEps++;
+			aucEps[(ucAddr & 0x0F) | ((ucAddr & USB_EP_DIR_IN) ? 16 : 0)]++;
+			if(pstEp->bmAttributes == USB_EP_TYPE_BULK)
+			{
+				TEST_EQUAL(le16_to_cpu(pstEp->wMaxPacketSize), usBulkSize);
+			}
+			if(pstIface
+				&& (pstIface->bInterfaceNumber == USB_STREAM_IFACE_NUMBER))
+			{
+				ulStreamEps++;
+				TEST_EQUAL(pstIface->bInterfaceClass, CLASS_VENDOR_SPECIFIC);
+				TEST_EQUAL(pstEp->bmAttributes, USB_EP_TYPE_BULK);
+				TEST_CHECK((ucAddr == USB_STREAM_EP_IN)
+					|| (ucAddr == USB_STREAM_EP_OUT));
+			}
+		}
+	}
+	TEST_EQUAL(ulPos, usTotal);
+	if(pstIface)
+	{
+		TEST_EQUAL(ulIfaceEps, pstIface->bNumEndpoints);
+	}
+	TEST_EQUAL(ulIads, 1);
+	TEST_EQUAL(ulStreamEps, 2);
+	TEST_EQUAL(aucIfaces[0], 1);
+	TEST_EQUAL(aucIfaces[1], 1);
+	TEST_EQUAL(aucIfaces[2], 1);
+	for(ulPos = 0; ulPos < sizeof(aucEps); ulPos++)
+	{
+		TEST_CHECK(aucEps[ulPos] <= 1);
+	}
+	TEST_EQUAL(aucEps[16 | (USB_STREAM_EP_IN & 0x0F)], 1);
+	TEST_EQUAL(aucEps[USB_STREAM_EP_OUT & 0x0F], 1);
+}
+
+/** ***************************************************************************
+	Name:               TestDescriptors
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The descriptors the device core sends, from udi_composite_desc.c. The
+	device uses the IAD class codes and the composite PID, whose INF entry
+	binds only MI_00 to the CDC driver.
+*/
+static void TestDescriptors(void)
+{
+	usb_dev_desc_t const *pstDev = udc_config.confdev_lsfs;
+
+	TEST_EQUAL(sizeof(tUsbStreamDesc),
+		sizeof(usb_iface_desc_t) + 2 * sizeof(usb_ep_desc_t));
+	TEST_EQUAL(sizeof(tUsbStreamDesc), 23);
+
+	TEST_EQUAL(pstDev->bDescriptorType, USB_DT_DEVICE);
+	TEST_EQUAL(pstDev->bDeviceClass, 0xEF);
+	TEST_EQUAL(pstDev->bDeviceSubClass, 0x02);
+	TEST_EQUAL(pstDev->bDeviceProtocol, 0x01);
+	TEST_EQUAL(le16_to_cpu(pstDev->idVendor), USB_VID_ATMEL);
+	TEST_EQUAL(le16_to_cpu(pstDev->idProduct),
+		USB_PID_ATMEL_ASF_VENDOR_CLASS);
+	TEST_CHECK(le16_to_cpu(pstDev->idProduct) != USB_PID_ATMEL_ASF_CDC);
+
+	TestConfig(udc_config.conf_lsfs[0].desc, USB_STREAM_EPS_FS_SIZE);
+	TestConfig(udc_config.conf_hs[0].desc, USB_STREAM_EPS_HS_SIZE);
+
+	TEST_CHECK(udc_config.conf_lsfs[0].udi_apis[USB_STREAM_IFACE_NUMBER]
+		== &udi_api_stream);
+	TEST_CHECK(udc_config.conf_hs[0].udi_apis[USB_STREAM_IFACE_NUMBER]
+		== &udi_api_stream);
+}
+
+/** ***************************************************************************
+	Name:               TestDisabled
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Nothing reaches the driver until the host selects the configuration, or
+	after it deselects it. The interface has no requests and no alternate
+	settings.
+*/
+static void TestDisabled(void)
+{
+	ulEvents = 0;
+	bRunResult = true;
+	TEST_EQUAL(UsbStreamIsEnabled(), 0);
+	TEST_EQUAL(UsbStreamWrite(aucBuf[0], 10, 1, TestDone), -1);
+	TEST_EQUAL(UsbStreamRead(aucBuf[1], 512, TestDone), -1);
+	TEST_EQUAL(ulEvents, 0);
+
+	TEST_CHECK(!udi_api_stream.setup());
+	TEST_EQUAL(udi_api_stream.getsetting(), 0);
+
+	TestReset();
+	udi_api_stream.disable();
+	TEST_EQUAL(UsbStreamIsEnabled(), 0);
+	TEST_EQUAL(UsbStreamWrite(aucBuf[0], 10, 1, TestDone), -1);
+	TEST_EQUAL(ulEvents, 0);
+}
+
+/** ***************************************************************************
+	Name:               TestChain
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Only the first of a queue of IN jobs goes to the driver. Each completion
+	starts the next job before reporting, so the endpoint is never idle
+	while the application runs; a full queue refuses a job.
+*/
+static void TestChain(void)
+{
+	uint32_t i;
+
+	TestReset();
+	for(i = 0; i < USB_STREAM_JOBS; i++)
+	{
+		TEST_EQUAL(UsbStreamWrite(aucBuf[i], 100 + i, (uint8_t)(i & 1),
+			TestDone), 0);
+	}
+	TEST_EQUAL(UsbStreamWrite(aucBuf[i], 1, 1, TestDone), -1);
+	TEST_EQUAL(ulEvents, 1);
+	TestCheckEvent(0, TEST_RUN, aucBuf[0], 100, 0);
+	TEST_EQUAL(astEvents[0].ucEp, USB_STREAM_EP_IN);
+	TEST_EQUAL(astEvents[0].ucEnd, 0);
+
+	for(i = 0; i + 1 < USB_STREAM_JOBS; i++)
+	{
+		ulEvents = 0;
+		TestComplete(USB_STREAM_EP_IN, UDD_EP_TRANSFER_OK, 100 + i);
+		TEST_EQUAL(ulEvents, 2);
+		TestCheckEvent(0, TEST_RUN, aucBuf[i + 1], 100 + i + 1, 0);
+		TEST_EQUAL(astEvents[0].ucEnd, (i + 1) & 1);
+		TestCheckEvent(1, TEST_DONE, aucBuf[i], 100 + i, 0);
+	}
+
+	/* the last job leaves the endpoint idle, so the next starts at once */
+	ulEvents = 0;
+	TestComplete(USB_STREAM_EP_IN, UDD_EP_TRANSFER_OK, 7);
+	TEST_EQUAL(ulEvents, 1);
+	TestCheckEvent(0, TEST_DONE, aucBuf[USB_STREAM_JOBS - 1], 7, 0);
+	TEST_EQUAL(UsbStreamWrite(aucBuf[5], 5, 1, NULL), 0);
+	TEST_EQUAL(ulEvents, 2);
+	TestCheckEvent(1, TEST_RUN, aucBuf[5], 5, 0);
+
+	/* a job without a callback completes silently */
+	TestComplete(USB_STREAM_EP_IN, UDD_EP_TRANSFER_OK, 5);
+	TEST_EQUAL(ulEvents, 2);
+}
+
+/** ***************************************************************************
+	Name:               TestRandom
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	Submits and completes IN jobs in random order, many times round the
+	queue. The driver always runs the oldest job, and the jobs complete in
+	the order they were queued.
+*/
+static void TestRandom(void)
+{
+	uint32_t ulSubmitted = 0;
+	uint32_t ulCompleted = 0;
+	uint32_t i;
+
+	TestReset();
+	for(i = 0; i < 20000; i++)
+	{
+		uint32_t ulQueued = ulSubmitted - ulCompleted;
+
+		ulEvents = 0;
+		if(TestRand() & 1)
+		{
+			int iResult = UsbStreamWrite(aucBuf[ulSubmitted % 8],
+				ulSubmitted, 1, TestDone);
+
+			if(ulQueued == USB_STREAM_JOBS)
+			{
+				TEST_EQUAL(iResult, -1);
+				TEST_EQUAL(ulEvents, 0);
+				continue;
+			}
+			TEST_EQUAL(iResult, 0);
+			TEST_EQUAL(ulEvents, (ulQueued == 0) ? 1 : 0);
+			ulSubmitted++;
+		}
+		else if(ulQueued)
+		{
+			TestComplete(USB_STREAM_EP_IN, UDD_EP_TRANSFER_OK, ulCompleted);
+			TEST_EQUAL(ulEvents, (ulQueued > 1) ? 2 : 1);
+			if(ulQueued > 1)
+			{
+				TestCheckEvent(0, TEST_RUN, aucBuf[(ulCompleted + 1) % 8],
+					ulCompleted + 1, 0);
+			}
+			TestCheckEvent(ulEvents - 1, TEST_DONE, aucBuf[ulCompleted % 8],
+				ulCompleted, 0);
+			ulCompleted++;
+		}
+		else
+		{
+			TEST_CHECK(!astEps[USB_STREAM_EP_IN & 0x0F].ucBusy);
+		}
+	}
+	TEST_CHECK(ulCompleted > 1000);
+}
+
+/** ***************************************************************************
+	Name:               TestAbort
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	An aborted job, as when the host deselects the configuration, fails the
+	jobs queued behind it without starting them, and leaves the queue empty.
+*/
+static void TestAbort(void)
+{
+	TestReset();
+	TEST_EQUAL(UsbStreamWrite(aucBuf[0], 10, 1, TestDone), 0);
+	TEST_EQUAL(UsbStreamWrite(aucBuf[1], 11, 1, TestDone), 0);
+	TEST_EQUAL(UsbStreamWrite(aucBuf[2], 12, 1, TestDone), 0);
+
+	udi_api_stream.disable();
+	ulEvents = 0;
+	TestComplete(USB_STREAM_EP_IN, UDD_EP_TRANSFER_ABORT, 4);
+	TEST_EQUAL(ulEvents, 3);
+	TestCheckEvent(0, TEST_DONE, aucBuf[0], 4, -1);
+	TestCheckEvent(1, TEST_DONE, aucBuf[1], 0, -1);
+	TestCheckEvent(2, TEST_DONE, aucBuf[2], 0, -1);
+
+	/* a new configuration starts with empty queues */
+	TestReset();
+	TEST_EQUAL(UsbStreamWrite(aucBuf[3], 13, 1, TestDone), 0);
+	TEST_EQUAL(ulEvents, 1);
+	TestCheckEvent(0, TEST_RUN, aucBuf[3], 13, 0);
+}
+
+/** ***************************************************************************
+	Name:               TestHalted
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	The driver refuses a job when the endpoint is halted. On an idle
+	endpoint the job is refused to the caller and not kept; for a job
+	started from a completion, that completion and the rest of the queue
+	fail.
+*/
+static void TestHalted(void)
+{
+	TestReset();
+	bRunResult = false;
+	TEST_EQUAL(UsbStreamWrite(aucBuf[0], 10, 1, TestDone), -1);
+	TEST_EQUAL(ulEvents, 1);
+
+	bRunResult = true;
+	ulEvents = 0;
+	TEST_EQUAL(UsbStreamWrite(aucBuf[1], 11, 1, TestDone), 0);
+	TEST_EQUAL(UsbStreamWrite(aucBuf[2], 12, 1, TestDone), 0);
+	TEST_EQUAL(UsbStreamWrite(aucBuf[3], 13, 1, TestDone), 0);
+	TEST_EQUAL(ulEvents, 1);
+	TestCheckEvent(0, TEST_RUN, aucBuf[1], 11, 0);
+
+	bRunResult = false;
+	ulEvents = 0;
+	TestComplete(USB_STREAM_EP_IN, UDD_EP_TRANSFER_OK, 11);
+	TEST_EQUAL(ulEvents, 4);
+	TestCheckEvent(0, TEST_RUN, aucBuf[2], 12, 0);
+	TestCheckEvent(1, TEST_DONE, aucBuf[1], 11, -1);
+	TestCheckEvent(2, TEST_DONE, aucBuf[2], 0, -1);
+	TestCheckEvent(3, TEST_DONE, aucBuf[3], 0, -1);
+
+	bRunResult = true;
+	ulEvents = 0;
+	TEST_EQUAL(UsbStreamWrite(aucBuf[4], 14, 1, TestDone), 0);
+	TEST_EQUAL(ulEvents, 1);
+	TestCheckEvent(0, TEST_RUN, aucBuf[4], 14, 0);
+}
+
+/** ***************************************************************************
+	Name:               TestOut
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   None
+
+	Description:
+	OUT jobs go to their own endpoint without a short packet request, are
+	not held up by a full IN queue, and report the length the host sent.
+*/
+static void TestOut(void)
+{
+	uint32_t i;
+
+	TestReset();
+	for(i = 0; i < USB_STREAM_JOBS; i++)
+	{
+		TEST_EQUAL(UsbStreamWrite(aucBuf[i], 64, 1, TestDone), 0);
+	}
+
+	ulEvents = 0;
+	TEST_EQUAL(UsbStreamRead(aucBuf[6], 1024, TestDone), 0);
+	TEST_EQUAL(UsbStreamRead(aucBuf[7], 512, TestDone), 0);
+	TEST_EQUAL(ulEvents, 1);
+	TestCheckEvent(0, TEST_RUN, aucBuf[6], 1024, 0);
+	TEST_EQUAL(astEvents[0].ucEp, USB_STREAM_EP_OUT);
+	TEST_EQUAL(astEvents[0].ucEnd, 0);
+
+	ulEvents = 0;
+	TestComplete(USB_STREAM_EP_OUT, UDD_EP_TRANSFER_OK, 300);
+	TEST_EQUAL(ulEvents, 2);
+	TestCheckEvent(0, TEST_RUN, aucBuf[7], 512, 0);
+	TEST_EQUAL(astEvents[0].ucEp, USB_STREAM_EP_OUT);
+	TestCheckEvent(1, TEST_DONE, aucBuf[6], 300, 0);
+
+	/* the IN queue is unchanged */
+	ulEvents = 0;
+	TestComplete(USB_STREAM_EP_IN, UDD_EP_TRANSFER_OK, 64);
+	TEST_EQUAL(ulEvents, 2);
+	TestCheckEvent(0, TEST_RUN, aucBuf[1], 64, 0);
+	TEST_EQUAL(astEvents[0].ucEp, USB_STREAM_EP_IN);
+	TestCheckEvent(1, TEST_DONE, aucBuf[0], 64, 0);
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/
@@ -0,0 +1,372 @@
+/** ***************************************************************************
+File Name:  stream_reader.c
+
+Project:    Platform 4
+
+Purpose:    Linux host reader for the Host Interface vendor bulk streaming
+            interface, through usbfs
+
+Program:    Host Interface tools
+
+Compiler:   gcc -O2 -Wall -o stream_reader stream_reader.c
+
+Author:     Tristan Losier, October 17, 2026
+
+            Copyright (C) Ocean Sonics Ltd, Nova Scotia, Canada.
+            Copying in whole or in part without prior written permission of
+            Ocean Sonics is prohibited.
+
+Modified:   $Id$
+
+Usage:      stream_reader [/dev/bus/usb/BBB/DDD] > data.bin
+
+            Without a device path the first device with the Host Interface
+            VID/PID is used. Data read from the bulk IN endpoint is written to
+            stdout and the throughput is reported on stderr once a second.
+            The user needs write access to the usbfs node (udev rule or root).
+
+******************************************************************************/
+
+/* System Include Files */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/usbdevice_fs.h>
+#include <linux/usb/ch9.h>
+
+
+/* Module Definitions */
+
+/* must match conf_usb.h and usb_stream.h of the firmware */
+#define STREAM_VID          0x03EB
+#define STREAM_PID          0x2423
+#define STREAM_IFACE        2
+#define STREAM_EP_IN        0x84
+
+/* number of bulk IN requests kept queued in the kernel, and their size. The
+	size is a multiple of the high speed packet size, so the device's
+	streams that don't end transfers with short packets fill every one */
+#define STREAM_URBS         8
+#define STREAM_URB_SIZE     (64 * 1024)
+
+
+/* Module Type Definitions */
+
+/* Module Function Declarations */
+
+static int StreamOpen(char const *pszPath);
+static int StreamFind(char *pszPath, size_t ulSize);
+static int StreamSubmit(int iFd, struct usbdevfs_urb *pstUrb);
+static void StreamStop(int iSignal);
+static double StreamNow(void);
+
+
+/* Module Variable Declarations */
+
+static struct usbdevfs_urb astUrb[STREAM_URBS];
+static volatile sig_atomic_t iStop = 0;
+
+
+/* Global Function Implementations */
+
+/** ***************************************************************************
+	Name:               main
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0, or 1 on error
+	Caveats / Effect:   None
+
+	Description:
+	Claims the streaming interface, keeps STREAM_URBS bulk IN requests
+	outstanding and copies completed data to stdout until interrupted or the
+	device goes away.
+*/
+int main(int argc, char *argv[])
+{
+	char szPath[600];
+	unsigned int uiIface = STREAM_IFACE;
+	unsigned long long ullTotal = 0;
+	unsigned long long ullLast = 0;
+	double dLast;
+	int iFd;
+	int i;
+
+	if(argc > 1)
+	{
+		snprintf(szPath, sizeof(szPath), "%s", argv[1]);
+	}
+	else if(StreamFind(szPath, sizeof(szPath)) != 0)
+	{
+		fprintf(stderr, "no device %04x:%04x found\n", STREAM_VID, STREAM_PID);
+		return 1;
+	}
+
+	iFd = StreamOpen(szPath);
+	if(iFd < 0)
+	{
+		return 1;
+	}
+	if(ioctl(iFd, USBDEVFS_CLAIMINTERFACE, &uiIface) < 0)
+	{
+		fprintf(stderr, "%s: claim interface %u: %s\n", szPath, uiIface,
+			strerror(errno));
+		close(iFd);
+		return 1;
+	}
+
+	signal(SIGINT, StreamStop);
+	signal(SIGTERM, StreamStop);
+
+	for(i = 0; i < STREAM_URBS; i++)
+	{
+		astUrb[i].buffer = malloc(STREAM_URB_SIZE);
+		if(!astUrb[i].buffer || (StreamSubmit(iFd, &astUrb[i]) != 0))
+		{
+			fprintf(stderr, "%s: submit: %s\n", szPath, strerror(errno));
+			iStop = 1;
+			break;
+		}
+	}
+
+	dLast = StreamNow();
+	while(!iStop)
+	{
+		struct usbdevfs_urb *pstUrb = NULL;
+		double dNow;
+
+		/* blocks until the oldest request completes */
+		if(ioctl(iFd, USBDEVFS_REAPURB, &pstUrb) < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			fprintf(stderr, "%s: reap: %s\n", szPath, strerror(errno));
+			break;
+		}
+		if(pstUrb->status != 0)
+		{
+			fprintf(stderr, "%s: transfer: %s\n", szPath,
+				strerror(-pstUrb->status));
+			break;
+		}
+
+		if(pstUrb->actual_length > 0)
+		{
+			if(fwrite(pstUrb->buffer, 1, pstUrb->actual_length, stdout)
+				!= (size_t)pstUrb->actual_length)
+			{
+				break;
+			}
+			ullTotal += pstUrb->actual_length;
+		}
+		if(StreamSubmit(iFd, pstUrb) != 0)
+		{
+			fprintf(stderr, "%s: submit: %s\n", szPath, strerror(errno));
+			break;
+		}
+
+		dNow = StreamNow();
+		if(dNow - dLast >= 1.0)
+		{
+			fprintf(stderr, "%llu bytes, %.3f MB/s\n", ullTotal,
+				(double)(ullTotal - ullLast) / (dNow - dLast) / 1e6);
+			ullLast = ullTotal;
+			dLast = dNow;
+		}
+	}
+
+	/* cancel and collect the requests still queued */
+	for(i = 0; i < STREAM_URBS; i++)
+	{
+		ioctl(iFd, USBDEVFS_DISCARDURB, &astUrb[i]);
+	}
+	for(;;)
+	{
+		struct usbdevfs_urb *pstUrb = NULL;
+
+		if(ioctl(iFd, USBDEVFS_REAPURBNDELAY, &pstUrb) < 0)
+		{
+			break;
+		}
+	}
+	ioctl(iFd, USBDEVFS_RELEASEINTERFACE, &uiIface);
+	close(iFd);
+
+	fprintf(stderr, "%llu bytes\n", ullTotal);
+	return 0;
+}
+
+
+/* Module Function Implementations */
+
+/** ***************************************************************************
+	Name:               StreamOpen
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             File descriptor, or -1 on error
+	Caveats / Effect:   None
+
+	Description:
+	Opens a usbfs device node.
+*/
+static int StreamOpen(char const *pszPath)
+{
+	int iFd = open(pszPath, O_RDWR);
+
+	if(iFd < 0)
+	{
+		fprintf(stderr, "%s: %s\n", pszPath, strerror(errno));
+	}
+	return iFd;
+}
+
+/** ***************************************************************************
+	Name:               StreamFind
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0 if found, -1 otherwise
+	Caveats / Effect:   None
+
+	Description:
+	Walks /dev/bus/usb for the first device whose descriptor carries the
+	firmware's VID/PID. Reading a usbfs node returns the device descriptor
+	followed by the configuration descriptors.
+*/
+static int StreamFind(char *pszPath, size_t ulSize)
+{
+	DIR *pstBusDir = opendir("/dev/bus/usb");
+	struct dirent *pstBus;
+	int iFound = -1;
+
+	if(!pstBusDir)
+	{
+		return -1;
+	}
+
+	while((iFound != 0) && ((pstBus = readdir(pstBusDir)) != NULL))
+	{
+		char szBus[300];
+		DIR *pstDevDir;
+		struct dirent *pstDev;
+
+		if(pstBus->d_name[0] == '.')
+		{
+			continue;
+		}
+		snprintf(szBus, sizeof(szBus), "/dev/bus/usb/%s", pstBus->d_name);
+		pstDevDir = opendir(szBus);
+		if(!pstDevDir)
+		{
+			continue;
+		}
+
+		while((iFound != 0) && ((pstDev = readdir(pstDevDir)) != NULL))
+		{
+			struct usb_device_descriptor stDesc;
+			int iFd;
+
+			if(pstDev->d_name[0] == '.')
+			{
+				continue;
+			}
+			snprintf(pszPath, ulSize, "%s/%s", szBus, pstDev->d_name);
+			iFd = open(pszPath, O_RDONLY);
+			if(iFd < 0)
+			{
+				continue;
+			}
+			if((read(iFd, &stDesc, sizeof(stDesc)) == (ssize_t)sizeof(stDesc))
+				&& (stDesc.idVendor == STREAM_VID)
+				&& (stDesc.idProduct == STREAM_PID))
+			{
+				iFound = 0;
+			}
+			close(iFd);
+		}
+		closedir(pstDevDir);
+	}
+	closedir(pstBusDir);
+
+	return iFound;
+}
+
+/** ***************************************************************************
+	Name:               StreamSubmit
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             0, or -1 on error (errno set)
+	Caveats / Effect:   None
+
+	Description:
+	(Re)queues a bulk IN request on the streaming endpoint.
+*/
+static int StreamSubmit(int iFd, struct usbdevfs_urb *pstUrb)
+{
+	void *pvBuf = pstUrb->buffer;
+
+	memset(pstUrb, 0, sizeof(*pstUrb));
+	pstUrb->type = USBDEVFS_URB_TYPE_BULK;
+	pstUrb->endpoint = STREAM_EP_IN;
+	pstUrb->buffer = pvBuf;
+	pstUrb->buffer_length = STREAM_URB_SIZE;
+
+	return (ioctl(iFd, USBDEVFS_SUBMITURB, pstUrb) < 0) ? -1 : 0;
+}
+
+/** ***************************************************************************
+	Name:               StreamStop
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             None
+	Caveats / Effect:   Signal handler
+
+	Description:
+	Ends the read loop.
+*/
+static void StreamStop(int iSignal)
+{
+	(void)iSignal;
+	iStop = 1;
+}
+
+/** ***************************************************************************
+	Name:               StreamNow
+
+	Creator:            Tristan Losier
+	Last Changed By:    Tristan Losier
+
+	Output:             Monotonic time in seconds
+	Caveats / Effect:   None
+
+	Description:
+	Time base for the throughput report.
+*/
+static double StreamNow(void)
+{
+	struct timespec stNow;
+
+	clock_gettime(CLOCK_MONOTONIC, &stNow);
+	return (double)stNow.tv_sec + (double)stNow.tv_nsec / 1e9;
+}
+
+
+/***********************  E N D   O F   F I L E  *****************************/